@@ -0,0 +1,1907 @@
+// Implements a console application which benchmarks the runtime support code used
+// by the generated sources.  Run with no arguments to run every benchmark, or
+// pass the names of the benchmarks to run.
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "XorCompress.h"
+#include "ArrowIPC.h"
+#include "ColumnKernels.h"
+#include "LzCompress.h"
+#include "Crc32c.h"
+
+#ifdef SCHEMA_CODEGEN_HAVE_LEVELDB
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/filter_policy.h"
+#include "leveldb/options.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/slice_transform.h"
+#include "leveldb/statistics.h"
+#include "leveldb/table.h"
+#include "leveldb/table_builder.h"
+#include "leveldb/write_batch.h"
+#include "StatisticsJson.h"
+#include "ObjectLog.h"
+#include "ShardedDB.h"
+#endif
+
+namespace
+{
+
+class Timer
+{
+public:
+    Timer(void)
+    {
+        reset();
+    }
+    void reset(void)
+    {
+        mStart = std::chrono::high_resolution_clock::now();
+    }
+    // Returns elapsed time in seconds
+    double elapsed(void) const
+    {
+        auto now = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration< double >(now - mStart).count();
+    }
+private:
+    std::chrono::high_resolution_clock::time_point mStart;
+};
+
+// Small deterministic random number generator so runs are comparable
+class Random
+{
+public:
+    Random(uint64_t seed) : mState(seed ? seed : 1)
+    {
+    }
+    uint64_t next(void)
+    {
+        mState ^= mState << 13;
+        mState ^= mState >> 7;
+        mState ^= mState << 17;
+        return mState;
+    }
+    // Returns a value in the range 0-1
+    double uniform(void)
+    {
+        return double(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+private:
+    uint64_t mState;
+};
+
+template< typename T >
+void benchmarkXorSeries(const char *name, const std::vector< T > &series)
+{
+    const uint32_t iterations = 10;
+    std::string blob;
+    Timer encodeTimer;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        XOR_COMPRESS::encode(series.data(), series.size(), blob);
+    }
+    double encodeTime = encodeTimer.elapsed() / iterations;
+
+    std::vector< T > decoded;
+    Timer decodeTimer;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        XOR_COMPRESS::decode(blob.data(), blob.size(), decoded);
+    }
+    double decodeTime = decodeTimer.elapsed() / iterations;
+
+    bool ok = decoded.size() == series.size() && memcmp(decoded.data(), series.data(), series.size() * sizeof(T)) == 0;
+    double samples = double(series.size());
+    double rawBytes = samples * sizeof(T);
+    printf("%-28s : %6.3f bytes/sample (%5.2f%% of raw) encode %8.2f MB/s decode %8.2f Msamples/s (%7.2f MB/s) %s\n",
+        name,
+        double(blob.size()) / samples,
+        100.0 * double(blob.size()) / rawBytes,
+        rawBytes / encodeTime / (1024 * 1024),
+        samples / decodeTime / 1e6,
+        rawBytes / decodeTime / (1024 * 1024),
+        ok ? "round-trip ok" : "** ROUND-TRIP FAILED **");
+}
+
+void benchmarkXor(void)
+{
+    const size_t sampleCount = 1000000;
+    Random r(12345);
+
+    // A bitcoin denominated value which changes in whole satoshis on some samples
+    std::vector< double > satoshis;
+    {
+        double value = 1234.5;
+        for (size_t i = 0; i < sampleCount; i++)
+        {
+            if (r.uniform() < 0.3)
+            {
+                value += floor((r.uniform() - 0.5) * 20000.0) * 1e-8;
+            }
+            satoshis.push_back(value);
+        }
+    }
+    // A counter which increases slowly
+    std::vector< double > counter;
+    {
+        double value = 0;
+        for (size_t i = 0; i < sampleCount; i++)
+        {
+            value += double(r.next() % 4);
+            counter.push_back(value);
+        }
+    }
+    // Noisy measurements; the worst case for this codec
+    std::vector< double > noise;
+    for (size_t i = 0; i < sampleCount; i++)
+    {
+        noise.push_back(100.0 + r.uniform());
+    }
+    std::vector< float > floats;
+    {
+        float value = 50.0f;
+        for (size_t i = 0; i < sampleCount; i++)
+        {
+            if (r.uniform() < 0.2)
+            {
+                value += 0.25f * float(int32_t(r.next() % 5) - 2);
+            }
+            floats.push_back(value);
+        }
+    }
+    benchmarkXorSeries("xor double (satoshi walk)", satoshis);
+    benchmarkXorSeries("xor double (slow counter)", counter);
+    benchmarkXorSeries("xor double (random noise)", noise);
+    benchmarkXorSeries("xor float (quarter steps)", floats);
+}
+
+// Writes and reads back a million row record batch of the column types the
+// generated Arrow code uses.
+void benchmarkArrow(void)
+{
+    const uint64_t rowCount = 1000000;
+    const uint32_t iterations = 10;
+    Random r(6789);
+    std::vector< std::string > symbols;
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        symbols.push_back("SYM" + std::to_string(i));
+    }
+    std::vector< std::string > sides;
+    sides.push_back("Buy");
+    sides.push_back("Sell");
+    std::vector< double > prices;
+    std::vector< uint32_t > symbolIndex;
+    for (uint64_t i = 0; i < rowCount; i++)
+    {
+        prices.push_back(100.0 + r.uniform());
+        symbolIndex.push_back(uint32_t(r.next() % symbols.size()));
+    }
+
+    std::string stream;
+    Timer writeTimer;
+    for (uint32_t it = 0; it < iterations; it++)
+    {
+        stream.clear();
+        ARROW_IPC::StreamWriter w(stream);
+        uint32_t price = w.addField("price", ARROW_IPC::ColumnType::float64, false);
+        uint32_t id = w.addField("id", ARROW_IPC::ColumnType::int64, true);
+        uint32_t symbol = w.addField("symbol", ARROW_IPC::ColumnType::utf8, false);
+        uint32_t side = w.addDictionaryField("side", sides, false);
+        w.beginRecordBatch(rowCount);
+        double *priceColumn = static_cast< double * >(w.getColumn(price));
+        int64_t *idColumn = static_cast< int64_t * >(w.getColumn(id));
+        int32_t *sideColumn = static_cast< int32_t * >(w.getColumn(side));
+        for (uint64_t i = 0; i < rowCount; i++)
+        {
+            priceColumn[i] = prices[i];
+            if ((i % 10) == 0)
+            {
+                w.setNull(id, i);
+            }
+            else
+            {
+                idColumn[i] = int64_t(i);
+            }
+            const std::string &s = symbols[symbolIndex[i]];
+            w.appendString(symbol, s.c_str(), s.size());
+            sideColumn[i] = int32_t(i & 1);
+        }
+        w.endRecordBatch();
+        w.finish();
+    }
+    double writeTime = writeTimer.elapsed() / iterations;
+
+    double sum = 0;
+    size_t stringBytes = 0;
+    uint64_t rows = 0;
+    Timer readTimer;
+    for (uint32_t it = 0; it < iterations; it++)
+    {
+        ARROW_IPC::StreamReader reader(stream.data(), stream.size());
+        reader.readSchema();
+        uint32_t price = uint32_t(reader.findField("price"));
+        uint32_t id = uint32_t(reader.findField("id"));
+        uint32_t symbol = uint32_t(reader.findField("symbol"));
+        uint32_t side = uint32_t(reader.findField("side"));
+        while (reader.nextRecordBatch())
+        {
+            for (uint64_t i = 0; i < reader.getRowCount(); i++)
+            {
+                sum += reader.getValue< double >(price, i);
+                if (!reader.isNull(id, i))
+                {
+                    sum += double(reader.getValue< int64_t >(id, i));
+                }
+                size_t len;
+                reader.getString(symbol, i, len);
+                stringBytes += len;
+                sum += double(reader.getDictionaryIndex(side, i));
+            }
+            rows += reader.getRowCount();
+        }
+    }
+    double readTime = readTimer.elapsed() / iterations;
+    printf("%-28s : %6.2f bytes/row write %8.2f Mrows/s (%8.2f MB/s) read %8.2f Mrows/s %s\n",
+        "arrow stream (4 columns)",
+        double(stream.size()) / double(rowCount),
+        double(rowCount) / writeTime / 1e6,
+        double(stream.size()) / writeTime / (1024 * 1024),
+        double(rowCount) / readTime / 1e6,
+        (rows == rowCount * iterations && sum > 0 && stringBytes) ? "ok" : "** READ FAILED **");
+}
+
+// A record shaped like the ones reporting code aggregates one field of
+struct StatsRecord
+{
+    uint64_t    id{0};
+    double      value{0};
+    uint32_t    count{0};
+    std::string name;
+    double      weight{0};
+};
+
+// Compares aggregating one field of an array of structs against the column kernels
+void benchmarkColumns(void)
+{
+    const size_t rowCount = 4000000;
+    const uint32_t iterations = 10;
+    Random r(4242);
+    std::vector< StatsRecord > records(rowCount);
+    std::vector< double > values(rowCount);
+    std::vector< uint32_t > counts(rowCount);
+    for (size_t i = 0; i < rowCount; i++)
+    {
+        records[i].value = values[i] = r.uniform() * 1000.0;
+        records[i].count = counts[i] = uint32_t(r.next() % 100);
+    }
+
+    double structSum = 0;
+    double structMin = 0;
+    size_t structCount = 0;
+    Timer structTimer;
+    for (uint32_t it = 0; it < iterations; it++)
+    {
+        double s = 0;
+        double m = records[0].value;
+        size_t c = 0;
+        for (auto &i : records)
+        {
+            s += i.value;
+            m = i.value < m ? i.value : m;
+            c += i.count > 50 ? 1 : 0;
+        }
+        structSum += s;
+        structMin = m;
+        structCount = c;
+    }
+    double structTime = structTimer.elapsed() / iterations;
+
+    double columnSum = 0;
+    double columnMin = 0;
+    size_t columnCount = 0;
+    Timer columnTimer;
+    for (uint32_t it = 0; it < iterations; it++)
+    {
+        columnSum += COLUMN_KERNELS::sum(values.data(), values.size());
+        columnMin = COLUMN_KERNELS::minimum(values.data(), values.size());
+        columnCount = COLUMN_KERNELS::countIf(counts.data(), counts.size(), [](uint32_t v) { return v > 50; });
+    }
+    double columnTime = columnTimer.elapsed() / iterations;
+
+    bool ok = fabs(structSum - columnSum) <= 1e-6 * fabs(structSum) && structMin == columnMin && structCount == columnCount;
+    printf("%-28s : array of structs %8.2f Mrows/s columns %8.2f Mrows/s (%5.2fx) %s\n",
+        "sum/min/countIf",
+        double(rowCount) / structTime / 1e6,
+        double(rowCount) / columnTime / 1e6,
+        structTime / columnTime,
+        ok ? "results match" : "** RESULTS DIFFER **");
+}
+
+void benchmarkLzCorpus(const char *name, const std::string &corpus)
+{
+    const uint32_t iterations = 10;
+    std::string frame;
+    Timer compressTimer;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        LZ_COMPRESS::compressFrame(corpus.data(), corpus.size(), frame);
+    }
+    double compressTime = compressTimer.elapsed() / iterations;
+
+    std::string decoded;
+    Timer decompressTimer;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        LZ_COMPRESS::decompressFrame(frame.data(), frame.size(), decoded);
+    }
+    double decompressTime = decompressTimer.elapsed() / iterations;
+
+    double rawBytes = double(corpus.size());
+    printf("%-28s : ratio %5.2f (%5.2f%% of raw) compress %6.3f GB/s decompress %6.3f GB/s %s\n",
+        name,
+        rawBytes / double(frame.size()),
+        100.0 * double(frame.size()) / rawBytes,
+        rawBytes / compressTime / 1e9,
+        rawBytes / decompressTime / 1e9,
+        decoded == corpus ? "round-trip ok" : "** ROUND-TRIP FAILED **");
+}
+
+// Compresses record shaped corpora: JSON lines like the generated NDJSON
+// output, fixed width binary records and incompressible noise.
+void benchmarkLz(void)
+{
+    const size_t recordCount = 500000;
+    static const char *symbols[] = { "BTC-USD", "ETH-USD", "SOL-USD", "XRP-USD", "ADA-USD" };
+    static const char *sides[] = { "Buy", "Sell", "Hold" };
+    Random r(777);
+
+    std::string ndjson;
+    std::string binary;
+    uint64_t timestamp = 1700000000000;
+    double price = 42000.0;
+    char line[256];
+    for (size_t i = 0; i < recordCount; i++)
+    {
+        timestamp += r.next() % 50;
+        price += floor((r.uniform() - 0.5) * 200.0) * 0.01;
+        uint32_t quantity = uint32_t(r.next() % 1000);
+        uint32_t symbol = uint32_t(r.next() % 5);
+        uint32_t side = uint32_t(r.next() % 3);
+        int len = snprintf(line, sizeof(line),
+            "{\"id\":%llu,\"timestamp\":%llu,\"symbol\":\"%s\",\"price\":%.2f,\"quantity\":%u,\"side\":\"%s\"}\n",
+            (unsigned long long)i, (unsigned long long)timestamp, symbols[symbol], price, quantity, sides[side]);
+        ndjson.append(line, size_t(len));
+
+        uint64_t id = i;
+        binary.append(reinterpret_cast< const char * >(&id), sizeof(id));
+        binary.append(reinterpret_cast< const char * >(&timestamp), sizeof(timestamp));
+        binary.append(reinterpret_cast< const char * >(&price), sizeof(price));
+        binary.append(reinterpret_cast< const char * >(&quantity), sizeof(quantity));
+        binary.append(reinterpret_cast< const char * >(&symbol), sizeof(symbol));
+    }
+    std::string noise;
+    for (size_t i = 0; i < binary.size(); i += sizeof(uint64_t))
+    {
+        uint64_t v = r.next();
+        noise.append(reinterpret_cast< const char * >(&v), sizeof(v));
+    }
+    benchmarkLzCorpus("lz ndjson records", ndjson);
+    benchmarkLzCorpus("lz binary records", binary);
+    benchmarkLzCorpus("lz random noise", noise);
+}
+
+// Checksums buffers of the sizes seen in log records, table blocks and
+// compaction output with the table implementation and the dispatched one
+void benchmarkCrc32c(void)
+{
+    const size_t total = size_t(1) << 28;
+    std::string data;
+    Random r(4242);
+    while (data.size() < (1 << 20))
+    {
+        uint64_t v = r.next();
+        data.append(reinterpret_cast< const char * >(&v), sizeof(v));
+    }
+    printf("crc32 instruction: %s\n", CRC32C::isAccelerated() ? "yes" : "no");
+    static const size_t sizes[] = { 64, 256, 4096, 65536, 1 << 20 };
+    for (size_t size : sizes)
+    {
+        size_t rounds = total / size;
+        uint32_t portable = 0;
+        Timer portableTimer;
+        for (size_t i = 0; i < rounds; i++)
+        {
+            portable ^= CRC32C::extendPortable(uint32_t(i), data.data(), size);
+        }
+        double portableTime = portableTimer.elapsed();
+
+        uint32_t dispatched = 0;
+        Timer dispatchedTimer;
+        for (size_t i = 0; i < rounds; i++)
+        {
+            dispatched ^= CRC32C::extend(uint32_t(i), data.data(), size);
+        }
+        double dispatchedTime = dispatchedTimer.elapsed();
+
+        char name[64];
+        snprintf(name, sizeof(name), "crc32c %zu bytes", size);
+        printf("%-28s : portable %6.2f GB/s extend %6.2f GB/s (%5.2fx) %s\n",
+            name,
+            double(total) / portableTime / 1e9,
+            double(total) / dispatchedTime / 1e9,
+            portableTime / dispatchedTime,
+            portable == dispatched ? "results match" : "** RESULTS DIFFER **");
+    }
+}
+
+#ifdef SCHEMA_CODEGEN_HAVE_LEVELDB
+
+// Looks up 'keys' in batches with one MultiGet per batch and with a Get per key
+void benchmarkMultiGetKeys(leveldb::DB *db, const char *name, const std::vector< std::string > &keyStrings, uint32_t batchSize)
+{
+    std::vector< leveldb::Slice > keys(keyStrings.begin(), keyStrings.end());
+    size_t batchCount = keys.size() / batchSize;
+    std::vector< std::string > getValues(keys.size());
+    std::vector< std::string > multiValues(keys.size());
+    std::vector< leveldb::Status > statuses(keys.size());
+    leveldb::ReadOptions readOptions;
+
+    Timer getTimer;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        if (!db->Get(readOptions, keys[i], &getValues[i]).ok())
+        {
+            getValues[i].clear();
+        }
+    }
+    double getTime = getTimer.elapsed();
+
+    Timer multiTimer;
+    for (size_t b = 0; b < batchCount; b++)
+    {
+        size_t first = b * batchSize;
+        db->MultiGet(readOptions, batchSize, &keys[first], &multiValues[first], &statuses[first]);
+    }
+    double multiTime = multiTimer.elapsed();
+
+    bool same = true;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        same = same && (statuses[i].ok() ? multiValues[i] == getValues[i] : getValues[i].empty());
+    }
+
+    double lookups = double(keys.size());
+    printf("%-28s : Get %8.0f ns/key MultiGet %8.0f ns/key (%5.2fx) %s\n",
+        name,
+        getTime / lookups * 1e9,
+        multiTime / lookups * 1e9,
+        getTime / multiTime,
+        same ? "results match" : "** RESULTS DIFFER **");
+}
+
+// Batches of 256 keys, a quarter of them missing, spread over the whole
+// database and clustered in a small range of it.
+void benchmarkMultiGet(void)
+{
+    const uint32_t recordCount = 500000;
+    const uint32_t batchSize = 256;
+    const uint32_t batchCount = 2000;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_multiget";
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.compression = leveldb::kLzCompression;
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+
+    Random r(31);
+    char key[32];
+    std::string value;
+    leveldb::WriteBatch batch;
+    for (uint32_t i = 0; i < recordCount; i++)
+    {
+        // Only even keys are written, so odd keys are misses
+        snprintf(key, sizeof(key), "record%010u", i * 2);
+        value.clear();
+        for (uint32_t j = 0; j < 12; j++)
+        {
+            uint64_t v = r.next();
+            value.append(reinterpret_cast< const char * >(&v), sizeof(v));
+        }
+        batch.Put(key, value);
+        if (batch.ApproximateSize() > (1 << 20))
+        {
+            db->Write(leveldb::WriteOptions(), &batch);
+            batch.Clear();
+        }
+    }
+    db->Write(leveldb::WriteOptions(), &batch);
+    db->CompactRange(nullptr, nullptr);
+
+    std::vector< std::string > spread(size_t(batchCount) * batchSize);
+    std::vector< std::string > clustered(spread.size());
+    uint32_t clusterStart = 0;
+    for (size_t i = 0; i < spread.size(); i++)
+    {
+        // each clustered batch falls within 8192 keys
+        if (i % batchSize == 0)
+        {
+            clusterStart = uint32_t(r.next() % (recordCount * 2 - 8192));
+        }
+        uint32_t k = uint32_t(r.next() % (recordCount * 2));
+        uint32_t c = clusterStart + uint32_t(r.next() % 8192);
+        // three quarters of the lookups hit
+        uint32_t hit = (r.next() % 4) ? ~1u : ~0u;
+        uint32_t miss = (hit == ~0u) ? 1u : 0u;
+        snprintf(key, sizeof(key), "record%010u", (k & hit) | miss);
+        spread[i] = key;
+        snprintf(key, sizeof(key), "record%010u", (c & hit) | miss);
+        clustered[i] = key;
+    }
+    benchmarkMultiGetKeys(db, "multiget spread", spread, batchSize);
+    benchmarkMultiGetKeys(db, "multiget clustered", clustered, batchSize);
+
+    delete db;
+    leveldb::DestroyDB(path, options);
+}
+
+// Produces the records [first, last) of the ingest benchmark in key order
+class RecordSource : public leveldb::IngestSource
+{
+public:
+    RecordSource(uint32_t first, uint32_t last)
+        : mNext(first), mLast(last), mRandom(first)
+    {
+    }
+    bool Next(leveldb::Slice *key, leveldb::Slice *value) override
+    {
+        if (mNext == mLast)
+        {
+            return false;
+        }
+        snprintf(mKey, sizeof(mKey), "record%010u", mNext++);
+        mValue.clear();
+        for (uint32_t j = 0; j < 12; j++)
+        {
+            uint64_t v = mRandom.next();
+            mValue.append(reinterpret_cast< const char * >(&v), sizeof(v));
+        }
+        *key = mKey;
+        *value = mValue;
+        return true;
+    }
+
+private:
+    uint32_t    mNext;
+    uint32_t    mLast;
+    Random      mRandom;
+    char        mKey[32];
+    std::string mValue;
+};
+
+// Loads the same records with WriteBatch commits followed by a full
+// compaction, and with one DB::Ingest of four disjoint key ranges.
+void benchmarkIngest(void)
+{
+    const uint32_t recordCount = 2000000;
+    const uint32_t sourceCount = 4;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_ingest";
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.compression = leveldb::kLzCompression;
+
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+    Timer writeTimer;
+    RecordSource all(0, recordCount);
+    leveldb::IngestSource *source = &all;
+    // The base class applies the pairs through WriteBatch commits
+    s = db->leveldb::DB::Ingest(leveldb::IngestOptions(), 1, &source);
+    db->CompactRange(nullptr, nullptr);
+    double writeTime = writeTimer.elapsed();
+    delete db;
+    leveldb::DestroyDB(path, options);
+    if (!s.ok())
+    {
+        printf("** WARNING ** write failed: %s\n", s.ToString().c_str());
+        return;
+    }
+
+    db = nullptr;
+    s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+    Timer ingestTimer;
+    std::vector< std::unique_ptr< RecordSource > > ranges;
+    std::vector< leveldb::IngestSource * > sources;
+    for (uint32_t i = 0; i < sourceCount; i++)
+    {
+        ranges.emplace_back(new RecordSource(recordCount / sourceCount * i, recordCount / sourceCount * (i + 1)));
+        sources.push_back(ranges.back().get());
+    }
+    leveldb::IngestOptions ingestOptions;
+    ingestOptions.max_threads = int(sourceCount);
+    s = db->Ingest(ingestOptions, int(sourceCount), sources.data());
+    double ingestTime = ingestTimer.elapsed();
+
+    std::string value;
+    bool found = s.ok() && db->Get(leveldb::ReadOptions(), "record0001234567", &value).ok() && value.size() == 96;
+    delete db;
+    leveldb::DestroyDB(path, options);
+
+    printf("%-28s : WriteBatch + compaction %8.0f records/s Ingest %8.0f records/s (%5.2fx) %s\n",
+        "ingest",
+        recordCount / writeTime,
+        recordCount / ingestTime,
+        writeTime / ingestTime,
+        found ? "records found" : "** RECORDS MISSING **");
+}
+
+// Writes random keys from several threads into a database with a small
+// write buffer, so that compactions fall behind unless they run in parallel
+void benchmarkCompactionConfig(int backgroundCompactions, int subcompactions)
+{
+    const uint32_t recordCount = 1000000;
+    const uint32_t threadCount = 4;
+    const uint32_t batchSize = 100;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_compaction";
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.compression = leveldb::kLzCompression;
+    options.write_buffer_size = 1 << 20;
+    options.max_background_compactions = backgroundCompactions;
+    options.max_subcompactions = subcompactions;
+
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+
+    Timer timer;
+    std::vector< std::thread > writers;
+    std::vector< leveldb::Status > statuses(threadCount);
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        writers.emplace_back([db, t, &statuses]()
+        {
+            Random r(t + 1);
+            leveldb::WriteBatch batch;
+            char key[32];
+            std::string value;
+            for (uint32_t i = 0; i < recordCount / threadCount / batchSize && statuses[t].ok(); i++)
+            {
+                batch.Clear();
+                for (uint32_t j = 0; j < batchSize; j++)
+                {
+                    snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % (recordCount * 4)));
+                    value.clear();
+                    for (uint32_t k = 0; k < 12; k++)
+                    {
+                        uint64_t v = r.next();
+                        value.append(reinterpret_cast< const char * >(&v), sizeof(v));
+                    }
+                    batch.Put(key, value);
+                }
+                statuses[t] = db->Write(leveldb::WriteOptions(), &batch);
+            }
+        });
+    }
+    for (std::thread &writer : writers)
+    {
+        writer.join();
+    }
+    double writeTime = timer.elapsed();
+
+    std::string stalls;
+    db->GetProperty("leveldb.write-stalls", &stalls);
+    long long delayed = 0, memtableWaits = 0, level0Waits = 0;
+    double stallTime = 0;
+    sscanf(stalls.c_str(), "Delayed writes: %lld Memtable waits: %lld Level-0 waits: %lld Stall time(sec): %lf",
+        &delayed, &memtableWaits, &level0Waits, &stallTime);
+    std::string level0;
+    db->GetProperty("leveldb.num-files-at-level0", &level0);
+    delete db;
+    leveldb::DestroyDB(path, options);
+
+    bool ok = true;
+    for (const leveldb::Status &status : statuses)
+    {
+        ok = ok && status.ok();
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "compaction %d threads x %d", backgroundCompactions, subcompactions);
+    printf("%-28s : %8.0f records/s delayed %6lld waits %4lld stalled %6.2f s level-0 files %3s %s\n",
+        name,
+        recordCount / writeTime,
+        delayed,
+        memtableWaits + level0Waits,
+        stallTime,
+        level0.c_str(),
+        ok ? "" : "** WRITE FAILED **");
+}
+
+void benchmarkCompaction(void)
+{
+    benchmarkCompactionConfig(1, 1);
+    benchmarkCompactionConfig(4, 1);
+    benchmarkCompactionConfig(4, 4);
+}
+
+// Writes small batches from several threads into a write buffer large enough
+// that nothing is flushed, so that the memtable inserts dominate
+void benchmarkMemtableConfig(uint32_t threadCount, bool concurrent)
+{
+    const uint32_t recordCount = 800000;
+    const uint32_t batchSize = 10;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_memtable";
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.write_buffer_size = 256 << 20;
+    options.allow_concurrent_memtable_write = concurrent;
+
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+
+    Timer timer;
+    std::vector< std::thread > writers;
+    std::vector< leveldb::Status > statuses(threadCount);
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        writers.emplace_back([db, t, threadCount, &statuses]()
+        {
+            Random r(t + 1);
+            leveldb::WriteBatch batch;
+            char key[32];
+            char value[64];
+            for (uint32_t i = 0; i < recordCount / threadCount / batchSize && statuses[t].ok(); i++)
+            {
+                batch.Clear();
+                for (uint32_t j = 0; j < batchSize; j++)
+                {
+                    snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % (recordCount * 4)));
+                    snprintf(value, sizeof(value), "%016llx%016llx", (unsigned long long)r.next(), (unsigned long long)r.next());
+                    batch.Put(key, value);
+                }
+                statuses[t] = db->Write(leveldb::WriteOptions(), &batch);
+            }
+        });
+    }
+    for (std::thread &writer : writers)
+    {
+        writer.join();
+    }
+    double writeTime = timer.elapsed();
+    delete db;
+    leveldb::DestroyDB(path, options);
+
+    bool ok = true;
+    for (const leveldb::Status &status : statuses)
+    {
+        ok = ok && status.ok();
+    }
+    char name[64];
+    snprintf(name, sizeof(name), "memtable %u threads %s", threadCount, concurrent ? "concurrent" : "leader");
+    printf("%-32s : %8.0f records/s %s\n", name, recordCount / writeTime, ok ? "" : "** WRITE FAILED **");
+}
+
+void benchmarkMemtable(void)
+{
+    const uint32_t threadCounts[] = { 1, 4, 8 };
+    for (uint32_t threadCount : threadCounts)
+    {
+        benchmarkMemtableConfig(threadCount, false);
+        benchmarkMemtableConfig(threadCount, true);
+    }
+}
+
+// A table file which copies every read into the caller's buffer like pread,
+// even where the real file is memory mapped, and counts the reads
+class CountingFile : public leveldb::RandomAccessFile
+{
+public:
+    CountingFile(leveldb::RandomAccessFile *file, std::atomic< uint64_t > &reads, std::atomic< uint64_t > &bytes)
+        : mFile(file), mReads(reads), mBytes(bytes)
+    {
+    }
+    ~CountingFile(void) override
+    {
+        delete mFile;
+    }
+    leveldb::Status Read(uint64_t offset, size_t n, leveldb::Slice *result, char *scratch) const override
+    {
+        leveldb::Status s = mFile->Read(offset, n, result, scratch);
+        if (s.ok() && result->data() != scratch)
+        {
+            memcpy(scratch, result->data(), result->size());
+            *result = leveldb::Slice(scratch, result->size());
+        }
+        mReads++;
+        mBytes += result->size();
+        return s;
+    }
+private:
+    leveldb::RandomAccessFile   *mFile;
+    std::atomic< uint64_t >     &mReads;
+    std::atomic< uint64_t >     &mBytes;
+};
+
+class CountingEnv : public leveldb::EnvWrapper
+{
+public:
+    CountingEnv(void) : leveldb::EnvWrapper(leveldb::Env::Default())
+    {
+    }
+    leveldb::Status NewRandomAccessFile(const std::string &fname, leveldb::RandomAccessFile **result) override
+    {
+        leveldb::Status s = target()->NewRandomAccessFile(fname, result);
+        if (s.ok())
+        {
+            *result = new CountingFile(*result, mReads, mBytes);
+        }
+        return s;
+    }
+
+    std::atomic< uint64_t > mReads{0};
+    std::atomic< uint64_t > mBytes{0};
+};
+
+// Scans the keys from 'begin' to 'end' once and reports the time taken and the
+// reads which reached the table files
+void benchmarkScanPass(leveldb::DB *db, CountingEnv &env, const char *name, const std::string &begin, const std::string &end, size_t readahead)
+{
+    leveldb::Slice bound(end);
+    leveldb::ReadOptions options;
+    options.fill_cache = false;
+    options.readahead_size = readahead;
+    options.iterate_upper_bound = &bound;
+
+    uint64_t reads = env.mReads;
+    uint64_t bytes = env.mBytes;
+    Timer timer;
+    leveldb::Iterator *it = db->NewIterator(options);
+    uint64_t count = 0;
+    uint64_t checksum = 0;
+    for (it->Seek(begin); it->Valid(); it->Next())
+    {
+        checksum += uint8_t(it->value()[0]);
+        count++;
+    }
+    bool ok = it->status().ok();
+    delete it;
+    double scanTime = timer.elapsed();
+    reads = env.mReads - reads;
+    bytes = env.mBytes - bytes;
+    printf("%-34s : %8.0f records/s %7llu reads %9.1f KB/read %s\n",
+        name,
+        count / scanTime,
+        (unsigned long long)reads,
+        reads ? bytes / 1024.0 / reads : 0.0,
+        ok ? "" : "** SCAN FAILED **");
+    (void)checksum;
+}
+
+// Full scans of a compacted database, block by block and with readahead
+void benchmarkScan(void)
+{
+    const uint32_t recordCount = 500000;
+
+    CountingEnv env;
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_scan";
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.compression = leveldb::kLzCompression;
+    options.env = &env;
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+
+    Random r(17);
+    char key[32];
+    std::string value;
+    leveldb::WriteBatch batch;
+    for (uint32_t i = 0; i < recordCount && s.ok(); i++)
+    {
+        snprintf(key, sizeof(key), "record%010u", i);
+        value.clear();
+        for (uint32_t j = 0; j < 12; j++)
+        {
+            uint64_t v = r.next();
+            value.append(reinterpret_cast< const char * >(&v), sizeof(v));
+        }
+        batch.Put(key, value);
+        if (batch.ApproximateSize() > (1 << 20))
+        {
+            s = db->Write(leveldb::WriteOptions(), &batch);
+            batch.Clear();
+        }
+    }
+    if (s.ok())
+    {
+        s = db->Write(leveldb::WriteOptions(), &batch);
+    }
+    db->CompactRange(nullptr, nullptr);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not fill '%s': %s\n", path.c_str(), s.ToString().c_str());
+        delete db;
+        return;
+    }
+
+    const std::string first = "record";
+    const std::string last = "recordz";
+    benchmarkScanPass(db, env, "full scan block by block", first, last, 0);
+    benchmarkScanPass(db, env, "full scan readahead 256KB", first, last, 256 << 10);
+    benchmarkScanPass(db, env, "full scan readahead 1MB", first, last, 1 << 20);
+
+    delete db;
+    leveldb::DestroyDB(path, options);
+}
+
+// Writes and reads back records with and without Options::statistics
+double benchmarkStatisticsPass(leveldb::Statistics *statistics, double *getTime)
+{
+    const uint32_t recordCount = 200000;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_statistics";
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.statistics = statistics;
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        *getTime = 0;
+        return 0;
+    }
+
+    Random r(47);
+    char key[32];
+    char value[100];
+    Timer putTimer;
+    for (uint32_t i = 0; i < recordCount; i++)
+    {
+        snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % recordCount));
+        snprintf(value, sizeof(value), "%016llx%016llx%016llx", (unsigned long long)r.next(), (unsigned long long)r.next(), (unsigned long long)r.next());
+        db->Put(leveldb::WriteOptions(), key, value);
+    }
+    double putTime = putTimer.elapsed();
+
+    std::string found;
+    Timer timer;
+    for (uint32_t i = 0; i < recordCount; i++)
+    {
+        snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % recordCount));
+        db->Get(leveldb::ReadOptions(), key, &found);
+    }
+    *getTime = timer.elapsed();
+
+    delete db;
+    leveldb::DestroyDB(path, options);
+    return putTime;
+}
+
+void benchmarkStatistics(void)
+{
+    const double operations = 200000;
+    leveldb::Statistics statistics;
+    double plainGet = 0;
+    double plainPut = benchmarkStatisticsPass(nullptr, &plainGet);
+    double statsGet = 0;
+    double statsPut = benchmarkStatisticsPass(&statistics, &statsGet);
+    printf("%-28s : Put %8.0f ns/op Get %8.0f ns/op\n", "statistics off", plainPut / operations * 1e9, plainGet / operations * 1e9);
+    printf("%-28s : Put %8.0f ns/op Get %8.0f ns/op\n", "statistics on", statsPut / operations * 1e9, statsGet / operations * 1e9);
+
+    leveldb::Statistics::HistogramData get = statistics.GetHistogram(leveldb::Statistics::kGetMicros);
+    printf("%-28s : median %6.1f us p99 %6.1f us max %llu us\n", "get latency", get.median, get.p99, (unsigned long long)get.max);
+    printf("%s\n", STATISTICS_JSON::toJson(statistics).c_str());
+}
+
+// Appends records to an object log from 'threadCount' threads and returns the
+// appends per second
+double benchmarkLogAppend(const std::string &path, uint32_t threadCount, uint32_t recordCount, bool sync, OBJECT_LOG::Stats *stats)
+{
+    leveldb::Env::Default()->RemoveFile(path);
+    OBJECT_LOG::LogWriter writer;
+    OBJECT_LOG::Options options;
+    options.mSync = sync;
+    if (!writer.open(path, options))
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), writer.getLastError().c_str());
+        return 0;
+    }
+    std::atomic< bool > failed(false);
+    Timer timer;
+    std::vector< std::thread > threads;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&, t]()
+        {
+            Random r(t + 1);
+            char record[128];
+            for (uint32_t i = t; i < recordCount; i += threadCount)
+            {
+                size_t len = 64 + size_t(r.next() % 64);
+                memset(record, int('a' + i % 26), len);
+                memcpy(record, &i, sizeof(i));
+                if (!writer.append(record, len))
+                {
+                    failed = true;
+                    return;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+    writer.sync();
+    double elapsed = timer.elapsed();
+    *stats = writer.getStats();
+    if (failed)
+    {
+        printf("** WARNING ** append failed: %s\n", writer.getLastError().c_str());
+    }
+    return recordCount / elapsed;
+}
+
+void benchmarkLog(void)
+{
+    const uint32_t syncCount = 2000;
+    const uint32_t recordCount = 2000000;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_object.log";
+
+    OBJECT_LOG::Stats stats;
+    for (uint32_t threadCount : { 1u, 4u })
+    {
+        char name[64];
+        double rate = benchmarkLogAppend(path, threadCount, syncCount, true, &stats);
+        snprintf(name, sizeof(name), "synced append %u thread%s", threadCount, threadCount > 1 ? "s" : "");
+        printf("%-28s : %10.0f records/s %6.1f records/sync\n", name, rate, stats.mSyncs ? double(stats.mRecords) / stats.mSyncs : 0.0);
+    }
+    double rate = benchmarkLogAppend(path, 1, recordCount, false, &stats);
+    printf("%-28s : %10.0f records/s\n", "append", rate);
+
+    // Replays the unsynced log, which the page cache still holds
+    OBJECT_LOG::LogReader reader;
+    if (!reader.open(path))
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), reader.getLastError().c_str());
+        return;
+    }
+    Timer timer;
+    const char *data;
+    size_t len;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    while (reader.next(data, len))
+    {
+        records++;
+        bytes += len;
+    }
+    double elapsed = timer.elapsed();
+    reader.close();
+    leveldb::Env::Default()->RemoveFile(path);
+    printf("%-28s : %10.0f records/s %8.1f MB/s %s\n",
+        "replay",
+        records / elapsed,
+        bytes / elapsed / (1024 * 1024),
+        records == recordCount && reader.ok() ? "all records read" : "** RECORDS MISSING **");
+}
+
+// Builds one filter over 'keyCount' keys and probes it with keys which were
+// added and keys which were not
+void benchmarkBloomFilter(const leveldb::FilterPolicy *policy, const char *policyName, uint32_t keyCount)
+{
+    const uint32_t probeCount = 2000000;
+
+    // Random keys; the hash leveldb uses mixes keys which differ only in their
+    // last few digits poorly, which would swamp the difference between filters
+    Random r(46);
+    std::vector< std::string > keys(keyCount);
+    std::vector< leveldb::Slice > slices(keyCount);
+    char key[32];
+    for (uint32_t i = 0; i < keyCount; i++)
+    {
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long)r.next());
+        keys[i] = key;
+        slices[i] = keys[i];
+    }
+    std::string filter;
+    policy->CreateFilter(slices.data(), int(keyCount), &filter);
+
+    // Alternately a key which was added and a new random key
+    std::vector< std::string > probes(probeCount);
+    for (uint32_t i = 0; i < probeCount; i++)
+    {
+        if (i & 1)
+        {
+            snprintf(key, sizeof(key), "%016llx", (unsigned long long)r.next());
+            probes[i] = key;
+        }
+        else
+        {
+            probes[i] = keys[r.next() % keyCount];
+        }
+    }
+    uint64_t present = 0;
+    uint64_t falsePositives = 0;
+    Timer timer;
+    for (uint32_t i = 0; i < probeCount; i += 2)
+    {
+        present += policy->KeyMayMatch(probes[i], filter);
+    }
+    double presentTime = timer.elapsed();
+    timer.reset();
+    for (uint32_t i = 1; i < probeCount; i += 2)
+    {
+        falsePositives += policy->KeyMayMatch(probes[i], filter);
+    }
+    double missingTime = timer.elapsed();
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s %uk keys", policyName, keyCount / 1000);
+    printf("%-28s : %7.1f KB present %6.1f ns missing %6.1f ns false positives %5.2f%% %s\n",
+        name,
+        filter.size() / 1024.0,
+        presentTime / (probeCount / 2) * 1e9,
+        missingTime / (probeCount / 2) * 1e9,
+        100.0 * falsePositives / (probeCount / 2),
+        present == probeCount / 2 ? "" : "** KEYS MISSING **");
+}
+
+// Looks up keys which are not in a compacted database, so that only the
+// filters keep the lookups out of the data blocks
+void benchmarkBloomTable(const leveldb::FilterPolicy *policy, const char *policyName)
+{
+    const uint32_t recordCount = 1000000;
+    const uint32_t lookupCount = 1000000;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_bloom";
+    leveldb::Statistics statistics;
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.filter_policy = policy;
+    options.statistics = &statistics;
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+    char key[32];
+    char value[32];
+    leveldb::WriteBatch batch;
+    for (uint32_t i = 0; i < recordCount && s.ok(); i++)
+    {
+        snprintf(key, sizeof(key), "record%010u", i * 2);
+        snprintf(value, sizeof(value), "%016x", i);
+        batch.Put(key, value);
+        if (batch.ApproximateSize() > (1 << 20))
+        {
+            s = db->Write(leveldb::WriteOptions(), &batch);
+            batch.Clear();
+        }
+    }
+    if (s.ok())
+    {
+        s = db->Write(leveldb::WriteOptions(), &batch);
+    }
+    db->CompactRange(nullptr, nullptr);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not fill '%s': %s\n", path.c_str(), s.ToString().c_str());
+        delete db;
+        return;
+    }
+
+    Random r(46);
+    std::string found;
+    uint64_t hits = 0;
+    statistics.Reset();
+    Timer timer;
+    for (uint32_t i = 0; i < lookupCount; i++)
+    {
+        snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % recordCount) * 2 + 1);
+        hits += db->Get(leveldb::ReadOptions(), key, &found).ok();
+    }
+    double elapsed = timer.elapsed();
+    uint64_t blocks = statistics.Get(leveldb::Statistics::kBlockCacheHits) + statistics.Get(leveldb::Statistics::kBlockCacheMisses);
+    delete db;
+    leveldb::DestroyDB(path, options);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s missing Get", policyName);
+    printf("%-28s : %6.0f ns/op %6.2f data blocks read per 100 lookups %s\n",
+        name,
+        elapsed / lookupCount * 1e9,
+        100.0 * blocks / lookupCount,
+        hits == 0 ? "" : "** UNEXPECTED HITS **");
+}
+
+void benchmarkBloom(void)
+{
+    std::unique_ptr< const leveldb::FilterPolicy > standard(leveldb::NewBloomFilterPolicy(10));
+    std::unique_ptr< const leveldb::FilterPolicy > blocked(leveldb::NewBlockedBloomFilterPolicy(10));
+    for (uint32_t keyCount : { 10000u, 1000000u, 10000000u })
+    {
+        benchmarkBloomFilter(standard.get(), "standard", keyCount);
+        benchmarkBloomFilter(blocked.get(), "blocked", keyCount);
+    }
+    benchmarkBloomTable(nullptr, "no filter");
+    benchmarkBloomTable(standard.get(), "standard");
+    benchmarkBloomTable(blocked.get(), "blocked");
+}
+
+// Scans the records of 'scanCount' random entities, the ones with odd numbers
+// missing from the database, and reports the reads which reached the table files
+void benchmarkPrefixPass(leveldb::DB *db, CountingEnv &env, const char *name, uint32_t entityCount, bool usePrefix)
+{
+    const uint32_t scanCount = 20000;
+
+    Random r(48);
+    uint64_t reads = env.mReads;
+    uint64_t count = 0;
+    bool ok = true;
+    char prefix[32];
+    char end[32];
+    Timer timer;
+    for (uint32_t i = 0; i < scanCount; i++)
+    {
+        uint32_t entity = uint32_t(r.next() % entityCount);
+        snprintf(prefix, sizeof(prefix), "entity%06u/", entity);
+        snprintf(end, sizeof(end), "entity%06u0", entity);
+        leveldb::Slice prefixSlice(prefix);
+        leveldb::Slice bound(end);
+        leveldb::ReadOptions options;
+        options.fill_cache = false;
+        options.iterate_upper_bound = &bound;
+        if (usePrefix)
+        {
+            options.iterate_prefix = &prefixSlice;
+        }
+        leveldb::Iterator *it = db->NewIterator(options);
+        for (it->Seek(prefixSlice); it->Valid(); it->Next())
+        {
+            count++;
+        }
+        ok = ok && it->status().ok();
+        delete it;
+    }
+    double elapsed = timer.elapsed();
+    reads = env.mReads - reads;
+    printf("%-28s : %8.1f us/scan %6.2f reads/scan %6.1f records/scan %s\n",
+        name,
+        elapsed / scanCount * 1e6,
+        double(reads) / scanCount,
+        double(count) / scanCount,
+        ok ? "" : "** SCAN FAILED **");
+}
+
+// Short scans of one entity each in a database which was never compacted in
+// full, so that every level may hold some of an entity's records
+void benchmarkPrefix(void)
+{
+    const uint32_t entityCount = 20000;
+    const uint32_t recordCount = 1000000;
+
+    CountingEnv env;
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_prefix";
+    std::unique_ptr< const leveldb::FilterPolicy > policy(leveldb::NewBloomFilterPolicy(10));
+    std::unique_ptr< const leveldb::SliceTransform > extractor(leveldb::NewFixedPrefixTransform(strlen("entity000000/")));
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.filter_policy = policy.get();
+    options.prefix_extractor = extractor.get();
+    options.env = &env;
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+
+    // Only the entities with even numbers have records
+    Random r(48);
+    char key[48];
+    char value[100];
+    leveldb::WriteBatch batch;
+    for (uint32_t i = 0; i < recordCount && s.ok(); i++)
+    {
+        snprintf(key, sizeof(key), "entity%06u/record%010u", uint32_t(r.next() % (entityCount / 2)) * 2, i);
+        snprintf(value, sizeof(value), "%016llx%016llx%016llx", (unsigned long long)r.next(), (unsigned long long)r.next(), (unsigned long long)r.next());
+        batch.Put(key, value);
+        if (batch.ApproximateSize() > (1 << 20))
+        {
+            s = db->Write(leveldb::WriteOptions(), &batch);
+            batch.Clear();
+        }
+    }
+    if (s.ok())
+    {
+        s = db->Write(leveldb::WriteOptions(), &batch);
+    }
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not fill '%s': %s\n", path.c_str(), s.ToString().c_str());
+        delete db;
+        return;
+    }
+
+    benchmarkPrefixPass(db, env, "entity scan upper bound", entityCount, false);
+    benchmarkPrefixPass(db, env, "entity scan prefix filter", entityCount, true);
+
+    delete db;
+    leveldb::DestroyDB(path, options);
+}
+
+// Seeks to random keys of one table file, whose blocks are memory mapped.
+// The table is small enough to stay in the CPU caches, so that the time goes
+// into searching the blocks rather than into fetching them.  The keys carry
+// the 8-byte trailer of the database's internal keys, which the hash index
+// expects.
+void benchmarkBlockHashPass(bool hashIndex, size_t blockSize)
+{
+    const uint32_t recordCount = 50000;
+    const uint32_t lookupCount = 2000000;
+
+    leveldb::Env *env = leveldb::Env::Default();
+    std::string path;
+    env->GetTestDirectory(&path);
+    path += "/schema_codegen_blockhash.ldb";
+    leveldb::Options options;
+    options.block_size = blockSize;
+    options.data_block_hash_index = hashIndex;
+    options.compression = leveldb::kNoCompression;
+
+    const char trailer[8] = { 1, 1, 0, 0, 0, 0, 0, 0 };
+    char key[32];
+    char value[32];
+    leveldb::WritableFile *file = nullptr;
+    leveldb::Status s = env->NewWritableFile(path, &file);
+    if (s.ok())
+    {
+        leveldb::TableBuilder builder(options, file);
+        for (uint32_t i = 0; i < recordCount; i++)
+        {
+            snprintf(key, sizeof(key), "record%010u", i);
+            memcpy(key + 16, trailer, sizeof(trailer));
+            snprintf(value, sizeof(value), "%016x", i);
+            builder.Add(leveldb::Slice(key, 24), value);
+        }
+        s = builder.Finish();
+        if (s.ok())
+        {
+            s = file->Close();
+        }
+        delete file;
+    }
+    uint64_t size = 0;
+    leveldb::RandomAccessFile *input = nullptr;
+    leveldb::Table *table = nullptr;
+    if (s.ok())
+    {
+        s = env->GetFileSize(path, &size);
+    }
+    if (s.ok())
+    {
+        s = env->NewRandomAccessFile(path, &input);
+    }
+    if (s.ok())
+    {
+        s = leveldb::Table::Open(options, input, size, &table);
+    }
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not build '%s': %s\n", path.c_str(), s.ToString().c_str());
+        delete input;
+        return;
+    }
+
+    // The best of three passes
+    double elapsed = 0;
+    uint64_t hits = 0;
+    leveldb::Iterator *it = table->NewIterator(leveldb::ReadOptions());
+    for (int pass = 0; pass < 3; pass++)
+    {
+        Random r(48);
+        hits = 0;
+        Timer timer;
+        for (uint32_t i = 0; i < lookupCount; i++)
+        {
+            snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % recordCount));
+            memcpy(key + 16, trailer, sizeof(trailer));
+            leveldb::Slice target(key, 24);
+            it->Seek(target);
+            hits += it->Valid() && it->key() == target;
+        }
+        double passTime = timer.elapsed();
+        elapsed = pass == 0 ? passTime : std::min(elapsed, passTime);
+    }
+    delete it;
+    delete table;
+    delete input;
+    env->RemoveFile(path);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s %zuKB blocks", hashIndex ? "hash index" : "binary search", blockSize >> 10);
+    printf("%-28s : %6.0f ns/seek %s\n",
+        name,
+        elapsed / lookupCount * 1e9,
+        hits == lookupCount ? "" : "** KEYS MISSING **");
+}
+
+void benchmarkBlockHash(void)
+{
+    for (size_t blockSize : { size_t(4) << 10, size_t(16) << 10 })
+    {
+        benchmarkBlockHashPass(false, blockSize);
+        benchmarkBlockHashPass(true, blockSize);
+    }
+}
+
+// Writes batches of random keys from several threads into a sharded database
+// and then scans it in key order through the merging iterator
+void benchmarkShardedConfig(uint32_t shardCount, uint32_t threadCount, bool sync)
+{
+    const uint32_t recordCount = sync ? 20000 : 800000;
+    const uint32_t batchSize = 10;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_sharded";
+    leveldb::Options options;
+    options.create_if_missing = true;
+    SHARDED_DB::Options shardedOptions;
+    shardedOptions.mShards = shardCount;
+    shardedOptions.mSync = sync;
+
+    for (uint32_t shard = 0; shard < shardCount; shard++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/shard-%03u", shard);
+        leveldb::DestroyDB(path + name, options);
+    }
+    leveldb::Env::Default()->RemoveFile(path + "/SHARDS");
+    SHARDED_DB::ShardedDB db;
+    if (!db.open(path, options, shardedOptions))
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), db.getLastError().c_str());
+        return;
+    }
+
+    Timer timer;
+    std::vector< std::thread > writers;
+    std::atomic< bool > ok(true);
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        writers.emplace_back([&db, t, threadCount, recordCount, &ok]()
+        {
+            Random r(t + 1);
+            SHARDED_DB::ShardedBatch batch(db);
+            char key[32];
+            char value[64];
+            for (uint32_t i = 0; i < recordCount / threadCount / batchSize && ok; i++)
+            {
+                batch.clear();
+                for (uint32_t j = 0; j < batchSize; j++)
+                {
+                    snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % (recordCount * 4)));
+                    snprintf(value, sizeof(value), "%016llx%016llx", (unsigned long long)r.next(), (unsigned long long)r.next());
+                    batch.put(key, value);
+                }
+                if (!db.write(batch))
+                {
+                    ok = false;
+                }
+            }
+        });
+    }
+    for (std::thread &writer : writers)
+    {
+        writer.join();
+    }
+    double writeTime = timer.elapsed();
+
+    timer.reset();
+    uint64_t scanned = 0;
+    const SHARDED_DB::Snapshot *snapshot = db.getSnapshot();
+    leveldb::Iterator *it = db.newIterator(snapshot);
+    std::string last;
+    for (it->SeekToFirst(); it->Valid(); it->Next())
+    {
+        if (it->key().compare(last) <= 0)
+        {
+            ok = false;
+        }
+        last.assign(it->key().data(), it->key().size());
+        scanned++;
+    }
+    delete it;
+    db.releaseSnapshot(snapshot);
+    double scanTime = timer.elapsed();
+    db.close();
+
+    for (uint32_t shard = 0; shard < shardCount; shard++)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/shard-%03u", shard);
+        leveldb::DestroyDB(path + name, options);
+    }
+    leveldb::Env::Default()->RemoveFile(path + "/SHARDS");
+    leveldb::Env::Default()->RemoveDir(path);
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s%u shard%s %u thread%s", sync ? "synced " : "", shardCount, shardCount > 1 ? "s" : "", threadCount, threadCount > 1 ? "s" : "");
+    printf("%-28s : %9.0f records/s %9.0f scanned/s %s\n", name, recordCount / writeTime, scanned / scanTime, ok ? "" : "** WRITE FAILED **");
+}
+
+void benchmarkSharded(void)
+{
+    for (uint32_t shardCount : { 1u, 4u, 8u })
+    {
+        benchmarkShardedConfig(shardCount, 1, false);
+        benchmarkShardedConfig(shardCount, 8, false);
+    }
+    for (uint32_t shardCount : { 1u, 4u })
+    {
+        benchmarkShardedConfig(shardCount, 4, true);
+    }
+}
+
+// A disk of limited bandwidth shared by all the files of a database.  Appends
+// are queued like dirty pages waiting for writeback and return at once; a
+// read waits for the transfers queued before it and then for its own, and a
+// sync waits until the queue has drained.
+class SimulatedDisk
+{
+public:
+    explicit SimulatedDisk(double bytesPerSecond) : mBytesPerSecond(bytesPerSecond), mBusyUntil(std::chrono::steady_clock::now())
+    {
+    }
+    // Queues 'n' bytes and returns the time the transfer ends
+    std::chrono::steady_clock::time_point transfer(size_t n)
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        mBusyUntil = std::max(mBusyUntil, std::chrono::steady_clock::now()) + std::chrono::microseconds(uint64_t(n / mBytesPerSecond * 1e6));
+        return mBusyUntil;
+    }
+    std::chrono::steady_clock::time_point drained(void)
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        return mBusyUntil;
+    }
+private:
+    const double                            mBytesPerSecond;
+    std::mutex                              mMutex;
+    std::chrono::steady_clock::time_point   mBusyUntil;
+};
+
+class SimulatedDiskFile : public leveldb::RandomAccessFile
+{
+public:
+    SimulatedDiskFile(leveldb::RandomAccessFile *file, SimulatedDisk &disk) : mFile(file), mDisk(disk)
+    {
+    }
+    ~SimulatedDiskFile(void) override
+    {
+        delete mFile;
+    }
+    leveldb::Status Read(uint64_t offset, size_t n, leveldb::Slice *result, char *scratch) const override
+    {
+        std::this_thread::sleep_until(mDisk.transfer(n));
+        return mFile->Read(offset, n, result, scratch);
+    }
+private:
+    leveldb::RandomAccessFile   *mFile;
+    SimulatedDisk               &mDisk;
+};
+
+class SimulatedDiskWritableFile : public leveldb::WritableFile
+{
+public:
+    SimulatedDiskWritableFile(leveldb::WritableFile *file, SimulatedDisk &disk) : mFile(file), mDisk(disk)
+    {
+    }
+    ~SimulatedDiskWritableFile(void) override
+    {
+        delete mFile;
+    }
+    leveldb::Status Append(const leveldb::Slice &data) override
+    {
+        mDisk.transfer(data.size());
+        return mFile->Append(data);
+    }
+    leveldb::Status Close(void) override
+    {
+        return mFile->Close();
+    }
+    leveldb::Status Flush(void) override
+    {
+        return mFile->Flush();
+    }
+    leveldb::Status Sync(void) override
+    {
+        std::this_thread::sleep_until(mDisk.drained());
+        return mFile->Sync();
+    }
+private:
+    leveldb::WritableFile   *mFile;
+    SimulatedDisk           &mDisk;
+};
+
+class SimulatedDiskEnv : public leveldb::EnvWrapper
+{
+public:
+    explicit SimulatedDiskEnv(double bytesPerSecond) : leveldb::EnvWrapper(leveldb::Env::Default()), mDisk(bytesPerSecond)
+    {
+    }
+    leveldb::Status NewRandomAccessFile(const std::string &fname, leveldb::RandomAccessFile **result) override
+    {
+        leveldb::Status s = target()->NewRandomAccessFile(fname, result);
+        if (s.ok())
+        {
+            *result = new SimulatedDiskFile(*result, mDisk);
+        }
+        return s;
+    }
+    leveldb::Status NewWritableFile(const std::string &fname, leveldb::WritableFile **result) override
+    {
+        leveldb::Status s = target()->NewWritableFile(fname, result);
+        if (s.ok())
+        {
+            *result = new SimulatedDiskWritableFile(*result, mDisk);
+        }
+        return s;
+    }
+private:
+    SimulatedDisk   mDisk;
+};
+
+// Reads random keys from one thread while another overwrites keys at a steady
+// pace the compactions can keep up with, and reports the latency of the reads.
+// The database lives on a simulated disk, which compactions that write as
+// fast as they can keep busy for long stretches.
+void benchmarkRateLimitPass(leveldb::RateLimiter *limiter, const char *name)
+{
+    const uint32_t keyCount = 200000;
+    const double seconds = 5.0;
+    const uint32_t writesPerSecond = 5000;
+    const uint32_t readsPerSecond = 2000;
+    const double diskBytesPerSecond = 64 << 20;
+
+    std::string path;
+    leveldb::Env::Default()->GetTestDirectory(&path);
+    path += "/schema_codegen_ratelimit";
+    leveldb::Statistics statistics;
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.write_buffer_size = 1 << 20;
+    options.statistics = &statistics;
+    options.rate_limiter = limiter;
+    SimulatedDiskEnv env(diskBytesPerSecond);
+    options.env = &env;
+    std::unique_ptr< const leveldb::FilterPolicy > policy(leveldb::NewBloomFilterPolicy(10));
+    options.filter_policy = policy.get();
+
+    leveldb::DestroyDB(path, options);
+    leveldb::DB *db = nullptr;
+    leveldb::Status s = leveldb::DB::Open(options, path, &db);
+    if (!s.ok())
+    {
+        printf("** WARNING ** could not open '%s': %s\n", path.c_str(), s.ToString().c_str());
+        return;
+    }
+
+    char key[32];
+    std::string value(100, 'v');
+    for (uint32_t i = 0; i < keyCount && s.ok(); i++)
+    {
+        snprintf(key, sizeof(key), "record%010u", i);
+        s = db->Put(leveldb::WriteOptions(), key, value);
+    }
+    db->CompactRange(nullptr, nullptr);
+    statistics.Reset();
+
+    std::atomic< bool > stop(false);
+    std::atomic< uint64_t > written(0);
+    std::thread writer([&]()
+    {
+        Random r(1);
+        char writeKey[32];
+        std::string writeValue(100, 'w');
+        Timer pace;
+        while (!stop)
+        {
+            // Writes in bursts of 100 and sleeps until the next one is due
+            for (uint32_t i = 0; i < 100; i++)
+            {
+                snprintf(writeKey, sizeof(writeKey), "record%010u", uint32_t(r.next() % keyCount));
+                if (!db->Put(leveldb::WriteOptions(), writeKey, writeValue).ok())
+                {
+                    return;
+                }
+            }
+            written += 100;
+            double due = double(written) / writesPerSecond;
+            double now = pace.elapsed();
+            if (due > now)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(uint64_t((due - now) * 1e6)));
+            }
+        }
+    });
+
+    Random r(2);
+    Timer timer;
+    uint64_t reads = 0;
+    uint64_t found = 0;
+    std::string result;
+    while (timer.elapsed() < seconds)
+    {
+        snprintf(key, sizeof(key), "record%010u", uint32_t(r.next() % keyCount));
+        found += db->Get(leveldb::ReadOptions(), key, &result).ok() ? 1 : 0;
+        reads++;
+        // The reads are paced too, so that they do not keep the disk busy themselves
+        double due = double(reads) / readsPerSecond;
+        double now = timer.elapsed();
+        if (due > now)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(uint64_t((due - now) * 1e6)));
+        }
+    }
+    stop = true;
+    writer.join();
+    double elapsed = timer.elapsed();
+
+    leveldb::Statistics::HistogramData get = statistics.GetHistogram(leveldb::Statistics::kGetMicros);
+    printf("%-28s : Get median %6.1f us p99 %7.1f us max %6llu us, %5.0f writes/s, throttled %6.3f s %s\n",
+        name,
+        get.median,
+        get.p99,
+        (unsigned long long)get.max,
+        written / elapsed,
+        statistics.Get(leveldb::Statistics::kRateLimitMicros) / 1e6,
+        found == reads ? "" : "** KEYS MISSING **");
+    delete db;
+    leveldb::DestroyDB(path, options);
+}
+
+void benchmarkRateLimit(void)
+{
+    benchmarkRateLimitPass(nullptr, "unlimited");
+    for (int64_t rate : { int64_t(32) << 20, int64_t(16) << 20 })
+    {
+        std::unique_ptr< leveldb::RateLimiter > limiter(leveldb::NewTokenBucketRateLimiter(rate));
+        char name[64];
+        snprintf(name, sizeof(name), "limited to %lld MB/s", (long long)(rate >> 20));
+        benchmarkRateLimitPass(limiter.get(), name);
+    }
+}
+
+#endif
+
+struct Benchmark
+{
+    const char  *mName;
+    void        (*mFunction)(void);
+};
+
+Benchmark gBenchmarks[] =
+{
+    { "xor", benchmarkXor },
+    { "arrow", benchmarkArrow },
+    { "columns", benchmarkColumns },
+    { "lz", benchmarkLz },
+    { "crc32c", benchmarkCrc32c },
+#ifdef SCHEMA_CODEGEN_HAVE_LEVELDB
+    { "multiget", benchmarkMultiGet },
+    { "ingest", benchmarkIngest },
+    { "compaction", benchmarkCompaction },
+    { "memtable", benchmarkMemtable },
+    { "scan", benchmarkScan },
+    { "statistics", benchmarkStatistics },
+    { "log", benchmarkLog },
+    { "bloom", benchmarkBloom },
+    { "prefix", benchmarkPrefix },
+    { "blockhash", benchmarkBlockHash },
+    { "sharded", benchmarkSharded },
+    { "ratelimit", benchmarkRateLimit },
+#endif
+};
+
+}
+
+int main(int argc, const char **argv)
+{
+    const size_t count = sizeof(gBenchmarks) / sizeof(gBenchmarks[0]);
+    for (size_t i = 0; i < count; i++)
+    {
+        bool run = argc < 2;
+        for (int j = 1; j < argc; j++)
+        {
+            if (strcmp(argv[j], gBenchmarks[i].mName) == 0)
+            {
+                run = true;
+            }
+        }
+        if (run)
+        {
+            printf("Running benchmark: %s\n", gBenchmarks[i].mName);
+            gBenchmarks[i].mFunction();
+        }
+    }
+    return 0;
+}
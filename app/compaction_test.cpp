@@ -0,0 +1,387 @@
+// Implements a console application which tests the parallel compactions and
+// subcompactions of the vendored leveldb against an in-memory model.  Run with
+// no arguments to run every test, or pass the names of the tests to run.
+// Returns non-zero if a check failed.
+#include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "db/db_impl.h"
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/write_batch.h"
+#include "test_harness.h"
+
+namespace
+{
+
+typedef std::map< std::string, std::string > Model;
+
+const int WRITER_THREADS = 4;
+// Enough data that level 1 outgrows its 10MB, so compactions out of level 1
+// run next to the ones out of level 0
+const int KEYS = 60000;
+const int OPERATIONS_PER_THREAD = 20000;
+
+std::string makeKey(int k)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "key%08d", k);
+    return key;
+}
+
+// Values of a few hundred bytes, so the tiny write buffers fill quickly
+std::string makeValue(int thread, int op, uint32_t seed)
+{
+    std::string value = std::to_string(thread) + ":" + std::to_string(op) + ":";
+    value.append(150 + seed % 300, char('a' + seed % 26));
+    return value;
+}
+
+// Small buffers and files so that a few megabytes make several levels, and a
+// rate limiter so that compactions run long enough to overlap
+leveldb::Options makeOptions(leveldb::RateLimiter *limiter)
+{
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.write_buffer_size = 64 << 10;
+    options.max_file_size = 64 << 10;
+    options.block_size = 1024;
+    options.max_background_compactions = 4;
+    options.max_subcompactions = 4;
+    options.rate_limiter = limiter;
+    return options;
+}
+
+// Watches the compactions of a database through the compaction inputs hook:
+// a file must never be an input of two running compactions, and level-0
+// files must only be read by one compaction at a time
+class InputsChecker
+{
+public:
+    explicit InputsChecker(leveldb::DB *db) : mDB(static_cast< leveldb::DBImpl * >(db))
+    {
+        mDB->TEST_SetCompactionInputsHook([this](bool picked, int level, const std::vector< uint64_t > &files)
+        {
+            onInputs(picked, level, files);
+        });
+    }
+
+    ~InputsChecker(void)
+    {
+        mDB->TEST_SetCompactionInputsHook(nullptr);
+    }
+
+    int getCompactions(void) const
+    {
+        return mCompactions;
+    }
+
+    int getMostRunning(void) const
+    {
+        return mMostRunning;
+    }
+
+private:
+    // Called with the database mutex held
+    void onInputs(bool picked, int level, const std::vector< uint64_t > &files)
+    {
+        if (picked)
+        {
+            for (uint64_t f : files)
+            {
+                CHECK(mBusy.insert(f).second);
+            }
+            if (level == 0)
+            {
+                CHECK(!mLevel0Busy);
+                mLevel0Busy = true;
+            }
+            mRunning++;
+            mCompactions++;
+            if (mRunning > mMostRunning)
+            {
+                mMostRunning = mRunning;
+            }
+        }
+        else
+        {
+            for (uint64_t f : files)
+            {
+                CHECK(mBusy.erase(f) == 1);
+            }
+            if (level == 0)
+            {
+                mLevel0Busy = false;
+            }
+            mRunning--;
+        }
+    }
+
+    leveldb::DBImpl         *mDB;
+    std::set< uint64_t >    mBusy;      // input files of the running compactions
+    bool                    mLevel0Busy{false};
+    int                     mRunning{0};
+    int                     mMostRunning{0};
+    int                     mCompactions{0};
+};
+
+// Compares every key of the database, by iteration and by Get, with 'model'
+void checkContents(leveldb::DB *db, const Model &model)
+{
+    leveldb::Iterator *it = db->NewIterator(leveldb::ReadOptions());
+    Model::const_iterator expected = model.begin();
+    size_t mismatches = 0;
+    for (it->SeekToFirst(); it->Valid(); it->Next(), ++expected)
+    {
+        if (expected == model.end() || it->key().ToString() != expected->first || it->value().ToString() != expected->second)
+        {
+            mismatches++;
+            break;
+        }
+    }
+    CHECK_OK(it->status());
+    CHECK(expected == model.end());
+    delete it;
+
+    std::string value;
+    for (int k = 0; k < KEYS; k++)
+    {
+        std::string key = makeKey(k);
+        leveldb::Status s = db->Get(leveldb::ReadOptions(), key, &value);
+        Model::const_iterator found = model.find(key);
+        if (found == model.end() ? !s.IsNotFound() : (!s.ok() || value != found->second))
+        {
+            mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+// Writer threads put, delete and batch-update their own share of the keys
+// while the compactions run in parallel; the contents must then match the
+// model.  The database is reopened with the same and with single-threaded
+// settings, and must recover the same contents.
+void testParallelCompactions(const std::string &dbname)
+{
+    std::unique_ptr< leveldb::RateLimiter > limiter(leveldb::NewTokenBucketRateLimiter(8 << 20));
+    leveldb::Options options = makeOptions(limiter.get());
+    leveldb::DestroyDB(dbname, options);
+
+    leveldb::DB *db = nullptr;
+    CHECK_OK(leveldb::DB::Open(options, dbname, &db));
+    if (db == nullptr)
+    {
+        return;
+    }
+
+    // Every thread starts with its share of the keys loaded
+    Model models[WRITER_THREADS];
+    leveldb::WriteBatch load;
+    for (int k = 0; k < KEYS; k++)
+    {
+        std::string key = makeKey(k);
+        std::string value = makeValue(-1, k, uint32_t(k));
+        load.Put(key, value);
+        models[k % WRITER_THREADS][key] = value;
+        if (load.ApproximateSize() >= (1 << 20))
+        {
+            CHECK_OK(db->Write(leveldb::WriteOptions(), &load));
+            load.Clear();
+        }
+    }
+    CHECK_OK(db->Write(leveldb::WriteOptions(), &load));
+
+    int compactions = 0;
+    int mostRunning = 0;
+    {
+        InputsChecker checker(db);
+        std::atomic< int > errors{0};
+        std::vector< std::thread > writers;
+        for (int t = 0; t < WRITER_THREADS; t++)
+        {
+            writers.emplace_back([t, db, &models, &errors]()
+            {
+                Model &model = models[t];
+                uint32_t seed = 12345u + uint32_t(t);
+                for (int op = 0; op < OPERATIONS_PER_THREAD; op++)
+                {
+                    seed = seed * 1103515245u + 12345u;
+                    // Thread t owns the keys k with k % WRITER_THREADS == t
+                    int k = int((seed >> 8) % (KEYS / WRITER_THREADS)) * WRITER_THREADS + t;
+                    std::string key = makeKey(k);
+                    leveldb::Status s;
+                    switch ((seed >> 4) % 8)
+                    {
+                        case 0:
+                            s = db->Delete(leveldb::WriteOptions(), key);
+                            model.erase(key);
+                            break;
+                        case 1:
+                        {
+                            leveldb::WriteBatch batch;
+                            for (int i = 0; i < 8; i++)
+                            {
+                                std::string batchKey = makeKey((k + i * WRITER_THREADS) % KEYS);
+                                std::string value = makeValue(t, op, seed + uint32_t(i));
+                                batch.Put(batchKey, value);
+                                model[batchKey] = value;
+                            }
+                            s = db->Write(leveldb::WriteOptions(), &batch);
+                            break;
+                        }
+                        default:
+                        {
+                            std::string value = makeValue(t, op, seed);
+                            s = db->Put(leveldb::WriteOptions(), key, value);
+                            model[key] = value;
+                            break;
+                        }
+                    }
+                    if (!s.ok())
+                    {
+                        errors++;
+                    }
+                }
+            });
+        }
+        for (std::thread &writer : writers)
+        {
+            writer.join();
+        }
+        CHECK(errors == 0);
+
+        // Let the background jobs finish the work the writes left behind
+        db->CompactRange(nullptr, nullptr);
+        compactions = checker.getCompactions();
+        mostRunning = checker.getMostRunning();
+    }
+    printf("  %d compactions, at most %d at once\n", compactions, mostRunning);
+    CHECK(mostRunning > 1);
+
+    Model model;
+    for (const Model &m : models)
+    {
+        model.insert(m.begin(), m.end());
+    }
+    checkContents(db, model);
+    std::string stalls;
+    CHECK(db->GetProperty("leveldb.write-stalls", &stalls));
+    delete db;
+
+    // Recovery replays the manifest edits the parallel jobs applied
+    db = nullptr;
+    CHECK_OK(leveldb::DB::Open(options, dbname, &db));
+    if (db != nullptr)
+    {
+        checkContents(db, model);
+        delete db;
+    }
+    leveldb::Options single = makeOptions(nullptr);
+    single.max_background_compactions = 1;
+    single.max_subcompactions = 1;
+    db = nullptr;
+    CHECK_OK(leveldb::DB::Open(single, dbname, &db));
+    if (db != nullptr)
+    {
+        checkContents(db, model);
+        delete db;
+    }
+    leveldb::DestroyDB(dbname, options);
+}
+
+// A snapshot taken halfway keeps its view through the parallel compactions,
+// which must not drop the overwritten values it still sees
+void testSnapshot(const std::string &dbname)
+{
+    leveldb::Options options = makeOptions(nullptr);
+    leveldb::DestroyDB(dbname, options);
+    leveldb::DB *db = nullptr;
+    CHECK_OK(leveldb::DB::Open(options, dbname, &db));
+    if (db == nullptr)
+    {
+        return;
+    }
+
+    Model before;
+    for (int k = 0; k < KEYS; k++)
+    {
+        std::string key = makeKey(k);
+        std::string value = makeValue(0, k, uint32_t(k));
+        CHECK_OK(db->Put(leveldb::WriteOptions(), key, value));
+        before[key] = value;
+    }
+    const leveldb::Snapshot *snapshot = db->GetSnapshot();
+    Model after;
+    {
+        InputsChecker checker(db);
+        std::vector< std::thread > writers;
+        for (int t = 0; t < WRITER_THREADS; t++)
+        {
+            writers.emplace_back([t, db]()
+            {
+                for (int k = t; k < KEYS; k += WRITER_THREADS)
+                {
+                    std::string key = makeKey(k);
+                    if (k % 3 == 0)
+                    {
+                        db->Delete(leveldb::WriteOptions(), key);
+                    }
+                    else
+                    {
+                        db->Put(leveldb::WriteOptions(), key, makeValue(1, k, uint32_t(k) * 7u));
+                    }
+                }
+            });
+        }
+        for (std::thread &writer : writers)
+        {
+            writer.join();
+        }
+        db->CompactRange(nullptr, nullptr);
+    }
+    for (int k = 0; k < KEYS; k++)
+    {
+        if (k % 3 != 0)
+        {
+            after[makeKey(k)] = makeValue(1, k, uint32_t(k) * 7u);
+        }
+    }
+
+    checkContents(db, after);
+    leveldb::ReadOptions read;
+    read.snapshot = snapshot;
+    leveldb::Iterator *it = db->NewIterator(read);
+    Model::const_iterator expected = before.begin();
+    bool same = true;
+    for (it->SeekToFirst(); it->Valid() && same; it->Next(), ++expected)
+    {
+        same = expected != before.end() && it->key().ToString() == expected->first && it->value().ToString() == expected->second;
+    }
+    CHECK(same && expected == before.end());
+    delete it;
+    db->ReleaseSnapshot(snapshot);
+    delete db;
+    leveldb::DestroyDB(dbname, options);
+}
+
+const TEST_HARNESS::Test gTests[] =
+{
+    { "parallel", testParallelCompactions },
+    { "snapshot", testSnapshot },
+};
+
+} // end of anonymous namespace
+
+int main(int argc, const char **argv)
+{
+    return TEST_HARNESS::run(argc, argv, "compaction_test_", gTests);
+}
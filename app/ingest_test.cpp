@@ -0,0 +1,241 @@
+// Implements a console application which tests the bulk ingest of the
+// vendored leveldb against an in-memory model.  Run with no arguments to run
+// every test, or pass the names of the tests to run.  Returns non-zero if a
+// check failed.
+#include <stdio.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "leveldb/change_iterator.h"
+#include "leveldb/db.h"
+#include "leveldb/iterator.h"
+#include "leveldb/options.h"
+#include "leveldb/write_batch.h"
+#include "test_harness.h"
+
+namespace
+{
+
+typedef std::map< std::string, std::string > Model;
+
+const int KEYS = 3000;
+
+std::string makeKey(const char *prefix, int k)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%s%06d", prefix, k);
+    return key;
+}
+
+// A run of pairs held in memory
+class VectorSource : public leveldb::IngestSource
+{
+public:
+    void add(const std::string &key, const std::string &value)
+    {
+        mPairs.emplace_back(key, value);
+    }
+
+    bool Next(leveldb::Slice *key, leveldb::Slice *value) override
+    {
+        if (mNext == mPairs.size())
+        {
+            return false;
+        }
+        *key = mPairs[mNext].first;
+        *value = mPairs[mNext].second;
+        mNext++;
+        return true;
+    }
+
+private:
+    std::vector< std::pair< std::string, std::string > >    mPairs;
+    size_t                                                  mNext{0};
+};
+
+// Compares every key of the database, by iteration and by Get, with 'model'
+void checkContents(leveldb::DB *db, const Model &model, const leveldb::Snapshot *snapshot = nullptr)
+{
+    leveldb::ReadOptions options;
+    options.snapshot = snapshot;
+    leveldb::Iterator *it = db->NewIterator(options);
+    Model::const_iterator expected = model.begin();
+    bool same = true;
+    for (it->SeekToFirst(); it->Valid() && same; it->Next(), ++expected)
+    {
+        same = expected != model.end() && it->key().ToString() == expected->first && it->value().ToString() == expected->second;
+    }
+    CHECK_OK(it->status());
+    CHECK(same && expected == model.end());
+    delete it;
+
+    size_t mismatches = 0;
+    std::string value;
+    for (const Model::value_type &pair : model)
+    {
+        leveldb::Status s = db->Get(options, pair.first, &value);
+        mismatches += !s.ok() || value != pair.second;
+    }
+    CHECK(mismatches == 0);
+}
+
+int filesAtLevel(leveldb::DB *db, int level)
+{
+    std::string count;
+    CHECK(db->GetProperty("leveldb.num-files-at-level" + std::to_string(level), &count));
+    return std::stoi(count);
+}
+
+// Counts the updates of a write batch
+class UpdateCounter : public leveldb::WriteBatch::Handler
+{
+public:
+    void Put(const leveldb::Slice &, const leveldb::Slice &) override
+    {
+        mCount++;
+    }
+
+    void Delete(const leveldb::Slice &) override
+    {
+        mCount++;
+    }
+
+    uint64_t mCount{0};
+};
+
+// The sequence number after the last update in the change feed
+uint64_t feedEnd(leveldb::DB *db)
+{
+    leveldb::ChangeIterator *it = nullptr;
+    CHECK_OK(db->NewChangeIterator(0, &it));
+    uint64_t end = 0;
+    for (; it != nullptr && it->Valid(); it->Next())
+    {
+        UpdateCounter counter;
+        it->batch().Iterate(&counter);
+        end = it->sequence() + counter.mCount;
+    }
+    delete it;
+    return end;
+}
+
+// Ingests over keys in the tables and in the memtable, which the ingested
+// values must replace, then into an empty key range, which must go below
+// level 0, and reopens the database
+void testIngest(const std::string &dbname)
+{
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.change_feed_size = 1 << 20;
+    leveldb::DestroyDB(dbname, options);
+
+    leveldb::DB *db = nullptr;
+    CHECK_OK(leveldb::DB::Open(options, dbname, &db));
+    if (db == nullptr)
+    {
+        return;
+    }
+
+    // The first two thirds in table files, the last two thirds in the
+    // memtable
+    Model model;
+    for (int k = 0; k < KEYS * 2 / 3; k++)
+    {
+        std::string key = makeKey("key", k);
+        CHECK_OK(db->Put(leveldb::WriteOptions(), key, "table"));
+        model[key] = "table";
+    }
+    db->CompactRange(nullptr, nullptr);
+    for (int k = KEYS / 3; k < KEYS; k++)
+    {
+        std::string key = makeKey("key", k);
+        CHECK_OK(db->Put(leveldb::WriteOptions(), key, "mem"));
+        model[key] = "mem";
+    }
+    const uint64_t before = feedEnd(db);
+    leveldb::ChangeIterator *tail = nullptr;
+    CHECK_OK(db->NewChangeIterator(before, &tail));
+    const leveldb::Snapshot *snapshot = db->GetSnapshot();
+    const Model old = model;
+
+    // Every other key, in two sources built in parallel
+    VectorSource low, high;
+    for (int k = 0; k < KEYS; k += 2)
+    {
+        std::string key = makeKey("key", k);
+        std::string value = "ingested" + std::to_string(k);
+        (k < KEYS / 2 ? low : high).add(key, value);
+        model[key] = value;
+    }
+    leveldb::IngestSource *sources[] = { &low, &high };
+    CHECK_OK(db->Ingest(leveldb::IngestOptions(), 2, sources));
+    checkContents(db, model);
+    checkContents(db, old, snapshot);
+    db->ReleaseSnapshot(snapshot);
+
+    // The feed does not hold the ingested pairs, so readers behind them
+    // learn that they missed updates
+    CHECK(tail != nullptr && !tail->Wait(0) && tail->status().IsNotFound());
+    delete tail;
+    leveldb::ChangeIterator *it = nullptr;
+    CHECK_OK(db->NewChangeIterator(1, &it));
+    CHECK(it != nullptr && !it->Valid() && it->status().IsNotFound());
+    delete it;
+
+    // Every ingested pair shares one sequence number, so the next write
+    // follows it
+    CHECK_OK(db->Put(leveldb::WriteOptions(), makeKey("key", 1), "after"));
+    model[makeKey("key", 1)] = "after";
+    CHECK(feedEnd(db) == before + 2);
+
+    // Nothing overlaps a new key range, so it goes to the last level
+    const int LAST_LEVEL = 6;
+    const int level0 = filesAtLevel(db, 0);
+    VectorSource fresh;
+    for (int k = 0; k < KEYS; k++)
+    {
+        std::string key = makeKey("new", k);
+        fresh.add(key, "fresh");
+        model[key] = "fresh";
+    }
+    leveldb::IngestSource *freshSources[] = { &fresh };
+    CHECK_OK(db->Ingest(leveldb::IngestOptions(), 1, freshSources));
+    CHECK(filesAtLevel(db, LAST_LEVEL) > 0);
+    CHECK(filesAtLevel(db, 0) == level0);
+    checkContents(db, model);
+
+    // Sources whose key ranges overlap fail and change nothing
+    VectorSource first, second;
+    first.add(makeKey("key", 10), "bad");
+    first.add(makeKey("key", 20), "bad");
+    second.add(makeKey("key", 15), "bad");
+    leveldb::IngestSource *overlapping[] = { &first, &second };
+    CHECK(db->Ingest(leveldb::IngestOptions(), 2, overlapping).IsInvalidArgument());
+    checkContents(db, model);
+    delete db;
+
+    // The ingested files and their placement are in the manifest
+    db = nullptr;
+    CHECK_OK(leveldb::DB::Open(options, dbname, &db));
+    if (db != nullptr)
+    {
+        checkContents(db, model);
+        CHECK(filesAtLevel(db, LAST_LEVEL) > 0);
+        delete db;
+    }
+    leveldb::DestroyDB(dbname, options);
+}
+
+const TEST_HARNESS::Test gTests[] =
+{
+    { "ingest", testIngest },
+};
+
+} // end of anonymous namespace
+
+int main(int argc, const char **argv)
+{
+    return TEST_HARNESS::run(argc, argv, "ingest_test_", gTests);
+}
@@ -0,0 +1,194 @@
+// Implements a console application which tests the batched MultiGet of the
+// vendored leveldb against Get.  Run with no arguments to run every test, or
+// pass the names of the tests to run.  Returns non-zero if a check failed.
+#include <stdio.h>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "leveldb/db.h"
+#include "leveldb/env.h"
+#include "leveldb/options.h"
+#include "test_harness.h"
+
+namespace
+{
+
+// Holds back the background work scheduled while it is held, so that an
+// immutable memtable stays unflushed while the test reads it
+class HeldEnv : public leveldb::EnvWrapper
+{
+public:
+    HeldEnv(void) : leveldb::EnvWrapper(leveldb::Env::Default())
+    {
+    }
+
+    void Schedule(void (*function)(void *arg), void *arg) override
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        if (mHeld)
+        {
+            mWork.emplace_back(function, arg);
+            return;
+        }
+        target()->Schedule(function, arg);
+    }
+
+    void hold(void)
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        mHeld = true;
+    }
+
+    // Schedules the work held back and stops holding
+    void release(void)
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        mHeld = false;
+        for (const Work &work : mWork)
+        {
+            target()->Schedule(work.first, work.second);
+        }
+        mWork.clear();
+    }
+
+    size_t getHeld(void)
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        return mWork.size();
+    }
+
+private:
+    typedef std::pair< void (*)(void *), void * > Work;
+
+    std::mutex          mMutex;
+    bool                mHeld{false};
+    std::vector< Work > mWork;
+};
+
+std::string makeKey(const char *prefix, int k)
+{
+    char key[32];
+    snprintf(key, sizeof(key), "%s%04d", prefix, k);
+    return key;
+}
+
+// Looks up 'keys' with MultiGet, starting from stale statuses and values, and
+// compares every result with Get
+void checkMultiGet(leveldb::DB *db, const std::vector< std::string > &keys, const leveldb::ReadOptions &options)
+{
+    std::vector< leveldb::Slice > slices(keys.begin(), keys.end());
+    std::vector< std::string > values(keys.size(), "stale");
+    std::vector< leveldb::Status > statuses(keys.size(), leveldb::Status::NotFound("stale"));
+    db->MultiGet(options, keys.size(), slices.data(), values.data(), statuses.data());
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        std::string value;
+        leveldb::Status s = db->Get(options, keys[i], &value);
+        bool same = s.ok() ? statuses[i].ok() && values[i] == value : statuses[i].IsNotFound() == s.IsNotFound() && statuses[i].ToString() != "NotFound: stale";
+        if (!same)
+        {
+            printf("  %s: MultiGet %s '%s', Get %s '%s'\n", keys[i].c_str(), statuses[i].ToString().c_str(), values[i].c_str(), s.ToString().c_str(), value.c_str());
+            mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+// Keys in the tables, in the immutable memtable and in the memtable, some
+// overwritten or deleted by a newer layer, some missing, and some repeated,
+// are looked up before and after the memtables are compacted
+void testLayers(const std::string &dbname)
+{
+    HeldEnv env;
+    leveldb::Options options;
+    options.create_if_missing = true;
+    options.write_buffer_size = 64 << 10;
+    options.env = &env;
+    leveldb::DestroyDB(dbname, options);
+
+    leveldb::DB *db = nullptr;
+    CHECK_OK(leveldb::DB::Open(options, dbname, &db));
+    if (db == nullptr)
+    {
+        return;
+    }
+
+    std::vector< std::string > keys;
+    const int KEYS = 40;
+    for (int k = 0; k < KEYS; k++)
+    {
+        CHECK_OK(db->Put(leveldb::WriteOptions(), makeKey("table", k), "table" + std::to_string(k)));
+        keys.push_back(makeKey("table", k));
+    }
+    db->CompactRange(nullptr, nullptr);
+    const leveldb::Snapshot *tables = db->GetSnapshot();
+
+    // Below the write buffer size, then over it with one large value, so the
+    // next write turns these into the immutable memtable
+    env.hold();
+    for (int k = 0; k < KEYS; k++)
+    {
+        std::string value(1000, char('a' + k % 26));
+        CHECK_OK(db->Put(leveldb::WriteOptions(), makeKey("imm", k), value));
+        keys.push_back(makeKey("imm", k));
+        if (k % 4 == 0)
+        {
+            CHECK_OK(db->Put(leveldb::WriteOptions(), makeKey("table", k), "imm" + std::to_string(k)));
+        }
+        else if (k % 4 == 1)
+        {
+            CHECK_OK(db->Delete(leveldb::WriteOptions(), makeKey("table", k)));
+        }
+    }
+    CHECK_OK(db->Put(leveldb::WriteOptions(), "imm-filler", std::string(20 << 10, 'f')));
+    for (int k = 0; k < KEYS; k++)
+    {
+        CHECK_OK(db->Put(leveldb::WriteOptions(), makeKey("mem", k), "mem" + std::to_string(k)));
+        keys.push_back(makeKey("mem", k));
+        if (k % 4 == 2)
+        {
+            CHECK_OK(db->Put(leveldb::WriteOptions(), makeKey("imm", k), "mem" + std::to_string(k)));
+        }
+        else if (k % 4 == 3)
+        {
+            CHECK_OK(db->Delete(leveldb::WriteOptions(), makeKey("table", k)));
+            CHECK_OK(db->Delete(leveldb::WriteOptions(), makeKey("imm", k)));
+        }
+    }
+    // The memtable flush is held back, so the middle layer is still immutable
+    CHECK(env.getHeld() > 0);
+    for (int k = 0; k < KEYS; k += 7)
+    {
+        keys.push_back(makeKey("missing", k));
+        keys.push_back(keys[size_t(k) * 2]);
+    }
+
+    checkMultiGet(db, keys, leveldb::ReadOptions());
+    leveldb::ReadOptions old;
+    old.snapshot = tables;
+    checkMultiGet(db, keys, old);
+
+    env.release();
+    db->CompactRange(nullptr, nullptr);
+    checkMultiGet(db, keys, leveldb::ReadOptions());
+    checkMultiGet(db, keys, old);
+    db->ReleaseSnapshot(tables);
+    delete db;
+    leveldb::DestroyDB(dbname, options);
+}
+
+const TEST_HARNESS::Test gTests[] =
+{
+    { "layers", testLayers },
+};
+
+} // end of anonymous namespace
+
+int main(int argc, const char **argv)
+{
+    return TEST_HARNESS::run(argc, argv, "multiget_test_", gTests);
+}
@@ -0,0 +1,141 @@
+// Implements a console application which tests the concurrent inserts of the
+// vendored leveldb's arena and skiplist, which back the concurrent memtable
+// writes.  Run with no arguments to run every test, or pass the names of the
+// tests to run.  Returns non-zero if a check failed.
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "db/skiplist.h"
+#include "util/arena.h"
+#include "test_harness.h"
+
+namespace
+{
+
+const int THREADS = 8;
+const int INSERTS_PER_THREAD = 20000;
+
+struct KeyComparator
+{
+    int operator()(const uint64_t &a, const uint64_t &b) const
+    {
+        return a < b ? -1 : (a > b ? 1 : 0);
+    }
+};
+
+// Runs 'body(t)' on THREADS threads, started together
+template < typename Body >
+void runThreads(Body body)
+{
+    std::atomic< bool > start{false};
+    std::vector< std::thread > threads;
+    for (int t = 0; t < THREADS; t++)
+    {
+        threads.emplace_back([t, &start, &body]()
+        {
+            while (!start.load())
+            {
+                std::this_thread::yield();
+            }
+            body(t);
+        });
+    }
+    start = true;
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+// Every thread allocates blocks of assorted sizes, some larger than a quarter
+// block, and fills them with its own byte; no block may overlap another
+void testArena(const std::string &)
+{
+    leveldb::Arena arena;
+    std::vector< std::vector< std::pair< char *, size_t > > > allocations(THREADS);
+    runThreads([&arena, &allocations](int t)
+    {
+        uint32_t seed = 1u + uint32_t(t);
+        for (int i = 0; i < INSERTS_PER_THREAD; i++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            size_t size = (seed >> 16) % 7 == 0 ? 1025 + (seed >> 8) % 3000 : 1 + (seed >> 8) % 100;
+            char *p = arena.AllocateConcurrently(size);
+            memset(p, 'A' + t, size);
+            allocations[t].emplace_back(p, size);
+        }
+    });
+
+    size_t total = 0;
+    size_t misaligned = 0;
+    size_t overwritten = 0;
+    for (int t = 0; t < THREADS; t++)
+    {
+        for (const std::pair< char *, size_t > &allocation : allocations[t])
+        {
+            total += allocation.second;
+            misaligned += (reinterpret_cast< uintptr_t >(allocation.first) & 7) != 0;
+            overwritten += std::count(allocation.first, allocation.first + allocation.second, char('A' + t)) != ptrdiff_t(allocation.second);
+        }
+    }
+    CHECK(misaligned == 0);
+    CHECK(overwritten == 0);
+    CHECK(arena.MemoryUsage() >= total);
+}
+
+// Every thread inserts its own keys, in a scattered order; the list must then
+// hold every key once, in order
+void testSkipList(const std::string &)
+{
+    leveldb::Arena arena;
+    leveldb::SkipList< uint64_t, KeyComparator > list(KeyComparator(), &arena);
+    runThreads([&list](int t)
+    {
+        // Thread t inserts the keys k with k % THREADS == t
+        for (int i = 0; i < INSERTS_PER_THREAD; i++)
+        {
+            uint64_t k = (uint64_t(i) * 7919u) % INSERTS_PER_THREAD;
+            list.InsertConcurrently(k * THREADS + uint64_t(t));
+        }
+    });
+
+    leveldb::SkipList< uint64_t, KeyComparator >::Iterator it(&list);
+    uint64_t expected = 0;
+    bool ordered = true;
+    for (it.SeekToFirst(); it.Valid() && ordered; it.Next(), expected++)
+    {
+        ordered = it.key() == expected;
+    }
+    CHECK(ordered);
+    CHECK(expected == uint64_t(THREADS) * INSERTS_PER_THREAD);
+
+    // Every level links the nodes in order, so seeks land on their key
+    size_t missed = 0;
+    for (uint64_t k = 0; k < uint64_t(THREADS) * INSERTS_PER_THREAD; k += 97)
+    {
+        it.Seek(k);
+        missed += !it.Valid() || it.key() != k;
+        missed += !list.Contains(k);
+    }
+    CHECK(missed == 0);
+    CHECK(!list.Contains(uint64_t(THREADS) * INSERTS_PER_THREAD));
+}
+
+const TEST_HARNESS::Test gTests[] =
+{
+    { "arena", testArena },
+    { "skiplist", testSkipList },
+};
+
+} // end of anonymous namespace
+
+int main(int argc, const char **argv)
+{
+    return TEST_HARNESS::run(argc, argv, "skiplist_test_", gTests);
+}
@@ -0,0 +1,81 @@
+// Declares the checks and the test runner shared by the leveldb test
+// applications.  A failed check prints its location and is counted; run()
+// returns non-zero if any check failed.
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "leveldb/env.h"
+#include "leveldb/status.h"
+
+namespace TEST_HARNESS
+{
+
+inline int &failures(void)
+{
+    static int count = 0;
+    return count;
+}
+
+struct Test
+{
+    const char  *mName;
+    void        (*mRun)(const std::string &dbname);
+};
+
+// Runs the tests named on the command line, or every test if there are none.
+// Each test gets a database path in the Env's test directory made of 'prefix'
+// and its name.
+template < size_t N >
+int run(int argc, const char **argv, const char *prefix, const Test (&tests)[N])
+{
+    std::string dir;
+    leveldb::Env::Default()->GetTestDirectory(&dir);
+    for (const Test &test : tests)
+    {
+        bool selected = argc < 2;
+        for (int i = 1; i < argc; i++)
+        {
+            selected = selected || strcmp(argv[i], test.mName) == 0;
+        }
+        if (!selected)
+        {
+            continue;
+        }
+        int before = failures();
+        printf("%s\n", test.mName);
+        test.mRun(dir + "/" + prefix + test.mName);
+        printf("  %s\n", failures() == before ? "ok" : "FAILED");
+    }
+    return failures() == 0 ? 0 : 1;
+}
+
+} // end of TEST_HARNESS namespace
+
+#define CHECK(cond) \
+    do \
+    { \
+        if (!(cond)) \
+        { \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            fflush(stdout); \
+            TEST_HARNESS::failures()++; \
+        } \
+    } while (0)
+
+#define CHECK_OK(s) \
+    do \
+    { \
+        leveldb::Status _s = (s); \
+        if (!_s.ok()) \
+        { \
+            printf("%s:%d: %s\n", __FILE__, __LINE__, _s.ToString().c_str()); \
+            fflush(stdout); \
+            TEST_HARNESS::failures()++; \
+        } \
+    } while (0)
+
+#endif
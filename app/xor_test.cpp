@@ -0,0 +1,199 @@
+// Implements a console application which tests the round trip of the XOR
+// (Gorilla) codec of the generated code on edge values.  Run with no arguments
+// to run every test, or pass the names of the tests to run.  Returns non-zero
+// if a check failed.
+#include <stdint.h>
+#include <string.h>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "XorCompress.h"
+#include "test_harness.h"
+
+namespace
+{
+
+template < typename T, typename W >
+T fromBits(W bits)
+{
+    T value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// Encodes 'values', decodes them back and compares them bit for bit, so that
+// NaN payloads and the sign of zero count; returns the size of the blob
+template < typename T >
+size_t checkRoundTrip(const std::vector< T > &values)
+{
+    std::string blob;
+    XOR_COMPRESS::encode(values.data(), values.size(), blob);
+    std::vector< T > decoded;
+    bool ok = XOR_COMPRESS::decode(blob.data(), blob.size(), decoded);
+    CHECK(ok);
+    CHECK(decoded.size() == values.size());
+    CHECK(decoded.size() == values.size() && memcmp(decoded.data(), values.data(), values.size() * sizeof(T)) == 0);
+
+    // The JSON form carries the blob as base64
+    std::string text;
+    std::string back;
+    XOR_COMPRESS::base64Encode(blob.data(), blob.size(), text);
+    CHECK(XOR_COMPRESS::base64Decode(text.data(), text.size(), back) && back == blob);
+    return blob.size();
+}
+
+// A series whose XORs with the previous value are 'patterns', starting at
+// 'first'
+template < typename T, typename W >
+std::vector< T > xorSeries(W first, const std::vector< W > &patterns)
+{
+    std::vector< T > values;
+    W word = first;
+    values.push_back(fromBits< T >(word));
+    for (W pattern : patterns)
+    {
+        word ^= pattern;
+        values.push_back(fromBits< T >(word));
+    }
+    return values;
+}
+
+void testDouble(const std::string &)
+{
+    typedef std::numeric_limits< double > Limits;
+    checkRoundTrip(std::vector< double >());
+    checkRoundTrip(std::vector< double >(1, -0.0));
+
+    // NaNs with assorted payloads and signs, zeros of both signs, infinities,
+    // the extremes and denormals, each next to very different neighbours
+    std::vector< double > special =
+    {
+        0.0, -0.0, 0.0, Limits::quiet_NaN(), -Limits::quiet_NaN(),
+        fromBits< double >(uint64_t(0x7ff0000000000001)),
+        fromBits< double >(uint64_t(0x7ff8dead0000beef)),
+        fromBits< double >(uint64_t(0xfff0000000000001)),
+        Limits::infinity(), -Limits::infinity(), Limits::max(), -Limits::max(),
+        Limits::min(), Limits::denorm_min(), -Limits::denorm_min(),
+        fromBits< double >(uint64_t(0x000fffffffffffff)),
+        fromBits< double >(uint64_t(0x800fffffffffffff)), Limits::denorm_min(),
+        Limits::epsilon(), 1.0, -1.0, 0.1, -0.0
+    };
+    checkRoundTrip(special);
+
+    // Identical values cost one bit each
+    std::vector< double > same(10000, 3.14159);
+    size_t size = checkRoundTrip(same);
+    CHECK(size == 4 + 8 + (same.size() - 1 + 7) / 8);
+    std::vector< double > nans(100, Limits::quiet_NaN());
+    nans.insert(nans.end(), 100, -0.0);
+    nans.insert(nans.end(), 100, Limits::denorm_min());
+    checkRoundTrip(nans);
+
+    // The window of meaningful bits: a new one, reuses inside it, one that
+    // needs more trailing bits, one that needs more leading bits, the full
+    // 64 bits, and more than 31 leading zeros, which are capped
+    checkRoundTrip(xorSeries< double, uint64_t >(0x4000000000000000, {
+        0x00ff000000000000, 0x0018000000000000, 0x00f0000000000000,
+        0x0000000000000f00, 0x0000000000000100, 0x0ff0000000000000,
+        0x8000000000000001, 0x0000000000000001, 0x4000000000000000,
+        0x0000000000000001, 0x0000000100000000, 0x0000000000000002,
+        0x00000000000f0000, 0x0000000000010000, 0x000000000000f000 }));
+
+    // Every single bit, which walks the window across the whole word
+    std::vector< uint64_t > bits;
+    for (uint32_t i = 0; i < 64; i++)
+    {
+        bits.push_back(uint64_t(1) << i);
+        bits.push_back(uint64_t(1) << (63 - i));
+    }
+    checkRoundTrip(xorSeries< double, uint64_t >(0, bits));
+
+    // A slowly changing series and random bit patterns
+    std::vector< double > walk;
+    std::vector< uint64_t > noise;
+    uint64_t seed = 42;
+    double price = 100.0;
+    for (int i = 0; i < 10000; i++)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        price += double(int64_t(seed >> 40) % 200 - 100) / 100.0;
+        walk.push_back(price);
+        noise.push_back(seed >> (seed & 63));
+    }
+    checkRoundTrip(walk);
+    checkRoundTrip(xorSeries< double, uint64_t >(0, noise));
+}
+
+void testFloat(const std::string &)
+{
+    typedef std::numeric_limits< float > Limits;
+    checkRoundTrip(std::vector< float >());
+    checkRoundTrip(std::vector< float >(1, -0.0f));
+
+    std::vector< float > special =
+    {
+        0.0f, -0.0f, 0.0f, Limits::quiet_NaN(), -Limits::quiet_NaN(),
+        fromBits< float >(uint32_t(0x7f800001)), fromBits< float >(uint32_t(0x7fc0beef)),
+        Limits::infinity(), -Limits::infinity(), Limits::max(), -Limits::max(),
+        Limits::min(), Limits::denorm_min(), -Limits::denorm_min(),
+        fromBits< float >(uint32_t(0x007fffff)), fromBits< float >(uint32_t(0x807fffff)),
+        Limits::epsilon(), 1.0f, -1.0f, 0.1f
+    };
+    checkRoundTrip(special);
+
+    std::vector< float > same(10000, 2.5f);
+    size_t size = checkRoundTrip(same);
+    CHECK(size == 4 + 4 + (same.size() - 1 + 7) / 8);
+
+    checkRoundTrip(xorSeries< float, uint32_t >(0x40000000, {
+        0x00ff0000, 0x00180000, 0x00f00000, 0x00000f00, 0x00000100,
+        0x0ff00000, 0x80000001, 0x00000001, 0x40000000, 0x00000002 }));
+
+    std::vector< uint32_t > bits;
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        bits.push_back(uint32_t(1) << i);
+        bits.push_back(uint32_t(1) << (31 - i));
+    }
+    checkRoundTrip(xorSeries< float, uint32_t >(0, bits));
+}
+
+// A truncated or inconsistent blob fails to decode rather than returning
+// made up values
+void testCorrupt(const std::string &)
+{
+    std::vector< double > values;
+    for (int i = 0; i < 100; i++)
+    {
+        values.push_back(i * 0.37);
+    }
+    std::string blob;
+    XOR_COMPRESS::encode(values.data(), values.size(), blob);
+    std::vector< double > decoded;
+    size_t failures = 0;
+    for (size_t len = 0; len < blob.size(); len++)
+    {
+        failures += !XOR_COMPRESS::decode(blob.data(), len, decoded) && decoded.empty();
+    }
+    CHECK(failures == blob.size());
+
+    // A count far beyond what the bits can hold
+    std::string inflated = blob;
+    inflated[3] = char(0x7f);
+    CHECK(!XOR_COMPRESS::decode(inflated.data(), inflated.size(), decoded));
+}
+
+const TEST_HARNESS::Test gTests[] =
+{
+    { "double", testDouble },
+    { "float", testFloat },
+    { "corrupt", testCorrupt },
+};
+
+} // end of anonymous namespace
+
+int main(int argc, const char **argv)
+{
+    return TEST_HARNESS::run(argc, argv, "xor_test_", gTests);
+}
@@ -0,0 +1,199 @@
+#ifndef ARROW_IPC_H
+#define ARROW_IPC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// A small, dependency free writer and reader for the Apache Arrow IPC stream
+// format (https://arrow.apache.org/docs/format/Columnar.html#ipc-streaming-format).
+// Only flat schemas are supported: booleans, integers, floating point, UTF8
+// strings and dictionary encoded UTF8 strings (which is how enums are stored).
+// The generated 'serializeArrow'/'deserializeArrow' methods are built on top of this.
+namespace ARROW_IPC
+{
+
+enum class ColumnType
+{
+    unsupported,    // present in the stream but not supported by this reader
+    boolean,
+    int8,
+    int16,
+    int32,
+    int64,
+    uint8,
+    uint16,
+    uint32,
+    uint64,
+    float32,
+    float64,
+    utf8,
+    dictionary,     // UTF8 values stored once in a dictionary batch; int32 indices per row
+};
+
+// Returns the width in bytes of a fixed width column, or zero
+uint32_t getColumnWidth(ColumnType type);
+
+// Writes an Arrow IPC stream.  Declare every field, then for each record batch
+// call 'beginRecordBatch', fill in the column buffers and call 'endRecordBatch'.
+// The schema and dictionaries are written before the first record batch.
+class StreamWriter
+{
+public:
+    // The stream is appended to 'dest'
+    StreamWriter(std::string &dest);
+
+    // Declare a field; returns the field index
+    uint32_t addField(const char *name, ColumnType type, bool nullable);
+    // Declare a dictionary encoded UTF8 field with a fixed set of values
+    uint32_t addDictionaryField(const char *name, const std::vector< std::string > &values, bool nullable);
+
+    void beginRecordBatch(uint64_t rowCount);
+    // Returns the zero initialized data buffer for a fixed width or dictionary
+    // (int32 index) column; it holds one value per row.
+    void *getColumn(uint32_t field);
+    // Bit packed boolean values
+    void setBool(uint32_t field, uint64_t row, bool value);
+    // UTF8 values must be appended for every row in order (use an empty string for nulls)
+    void appendString(uint32_t field, const char *str, size_t len);
+    // Marks a row as null; only valid for nullable fields
+    void setNull(uint32_t field, uint64_t row);
+    void endRecordBatch(void);
+
+    // Writes the end of stream marker
+    void finish(void);
+
+private:
+    struct Field
+    {
+        std::string                 mName;
+        ColumnType                  mType{ColumnType::unsupported};
+        bool                        mNullable{false};
+        std::vector< std::string >  mDictionary;
+        int64_t                     mDictionaryId{0};
+        // Per record batch buffers
+        std::vector< uint64_t >     mValidity;
+        std::vector< uint64_t >     mData;      // uint64_t storage keeps every column 8 byte aligned
+        std::vector< int32_t >      mOffsets;
+        std::string                 mStrings;
+        uint64_t                    mNullCount{0};
+    };
+
+    void writeSchema(void);
+    void writeMessage(uint8_t headerType, const std::string &flatBuffer, const std::string &body);
+
+    std::string             &mDest;
+    std::vector< Field >    mFields;
+    uint64_t                mRowCount{0};
+    bool                    mSchemaWritten{false};
+    bool                    mFinished{false};
+};
+
+// Reads an Arrow IPC stream.  The reader does not copy the input; it must
+// stay valid while the reader is in use.
+class StreamReader
+{
+public:
+    StreamReader(const void *data, size_t len);
+
+    // Reads the schema message; returns false if the stream is invalid or uses
+    // a layout this reader does not understand (nested types, compression).
+    bool readSchema(void);
+
+    uint32_t getFieldCount(void) const
+    {
+        return uint32_t(mFields.size());
+    }
+    const char *getFieldName(uint32_t field) const
+    {
+        return mFields[field].mName.c_str();
+    }
+    ColumnType getFieldType(uint32_t field) const
+    {
+        return mFields[field].mType;
+    }
+    // Returns the index of the named field or -1
+    int32_t findField(const char *name) const;
+
+    // Advances to the next record batch (applying any dictionary batches on the
+    // way).  Returns false at the end of the stream or on error; see isValid().
+    bool nextRecordBatch(void);
+    bool isValid(void) const
+    {
+        return mValid;
+    }
+
+    uint64_t getRowCount(void) const
+    {
+        return mRowCount;
+    }
+    bool isNull(uint32_t field, uint64_t row) const
+    {
+        const Column &c = mColumns[field];
+        return c.mValidity && !((c.mValidity[row >> 3] >> (row & 7)) & 1);
+    }
+    // Fixed width value; 'T' must match the column width
+    template< typename T >
+    T getValue(uint32_t field, uint64_t row) const
+    {
+        T ret;
+        memcpy(&ret, mColumns[field].mData + row * sizeof(T), sizeof(T));
+        return ret;
+    }
+    bool getBool(uint32_t field, uint64_t row) const
+    {
+        return ((mColumns[field].mData[row >> 3] >> (row & 7)) & 1) != 0;
+    }
+    // Returns nullptr if the offsets are corrupt
+    const char *getString(uint32_t field, uint64_t row, size_t &len) const;
+
+    // Dictionary encoded columns
+    int64_t getDictionaryIndex(uint32_t field, uint64_t row) const;
+    uint32_t getDictionaryCount(uint32_t field) const;
+    const std::string &getDictionaryValue(uint32_t field, uint32_t index) const
+    {
+        return mDictionaries[mFields[field].mDictionarySlot][index];
+    }
+
+private:
+    struct Field
+    {
+        std::string mName;
+        ColumnType  mType{ColumnType::unsupported};
+        uint32_t    mBufferCount{0};
+        uint32_t    mIndexWidth{4};         // dictionary index width in bytes
+        bool        mIndexSigned{true};
+        int64_t     mDictionaryId{-1};
+        uint32_t    mDictionarySlot{0};
+    };
+    struct Column
+    {
+        const uint8_t   *mValidity{nullptr};
+        const uint8_t   *mData{nullptr};
+        const uint8_t   *mOffsets{nullptr};
+        uint64_t        mDataLength{0};
+    };
+
+    bool nextMessage(uint8_t &headerType, const uint8_t *&meta, uint32_t &metaLen, const uint8_t *&body, uint64_t &bodyLen);
+    bool fail(void)
+    {
+        mValid = false;
+        return false;
+    }
+
+    const uint8_t                               *mData{nullptr};
+    size_t                                      mLength{0};
+    size_t                                      mPosition{0};
+    bool                                        mValid{true};
+    uint64_t                                    mRowCount{0};
+    std::vector< Field >                        mFields;
+    std::vector< Column >                       mColumns;
+    std::vector< int64_t >                      mDictionaryIds;
+    std::vector< std::vector< std::string > >   mDictionaries;
+};
+
+} // end of ARROW_IPC namespace
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef BULK_INGEST_H
+#define BULK_INGEST_H
+
+#include <stddef.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "leveldb/db.h"
+
+// Bulk loading through leveldb's DB::Ingest.  A SortedRun collects the keys
+// of one run of database entries together with the position of the record
+// each entry comes from; the values are encoded only while the run is being
+// written, on the thread which builds its table files, so a load never holds
+// a second encoded copy of the records in memory.  A large run is split into
+// slices with disjoint key ranges, which DB::Ingest writes in parallel.
+//
+// The generated '<Class>Store::ingest' builds one run for the records and one
+// for every secondary index and ingests them together.
+namespace BULK_INGEST
+{
+
+class RunSlice;
+
+class SortedRun
+{
+public:
+    // Sets 'value' to the value of the entry added for 'record'; called from
+    // several threads at once
+    typedef std::function< void (size_t record, std::string &value) > ValueFunction;
+
+    // Slices are never smaller than this, unless the run is
+    static const size_t MIN_SLICE_ENTRIES = 1 << 16;
+
+    explicit SortedRun(ValueFunction valueFunction);
+
+    void reserve(size_t count);
+    void add(std::string key, size_t record);
+    // Sorts the entries by key (bytewise, as leveldb's default comparator);
+    // of several entries with the same key only the one added last is kept
+    void sort(void);
+
+    size_t size(void) const;
+    // The key and the record of the i'th entry; entry order is key order once sorted
+    const std::string &getKey(size_t i) const;
+    size_t getRecord(size_t i) const;
+
+    // Appends up to 'parts' slices covering the sorted run to 'slices'; the
+    // run must outlive them
+    void split(size_t parts, std::vector< std::unique_ptr< RunSlice > > &slices) const;
+
+private:
+    friend class RunSlice;
+
+    struct Entry
+    {
+        std::string mKey;
+        size_t      mRecord;
+    };
+
+    ValueFunction           mValueFunction;
+    std::vector< Entry >    mEntries;
+};
+
+// The entries [begin, end) of a sorted run, as a source for DB::Ingest
+class RunSlice : public leveldb::IngestSource
+{
+public:
+    RunSlice(const SortedRun &run, size_t begin, size_t end);
+
+    bool Next(leveldb::Slice *key, leveldb::Slice *value) override;
+
+private:
+    const SortedRun &mRun;
+    size_t          mNext;
+    size_t          mEnd;
+    std::string     mValue;
+};
+
+} // end of BULK_INGEST namespace
+
+#endif
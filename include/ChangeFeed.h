@@ -0,0 +1,76 @@
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <stdint.h>
+#include <deque>
+#include <string>
+
+namespace leveldb
+{
+    class ChangeIterator;
+    class DB;
+}
+
+// Reads the writes committed to a leveldb database in sequence order through
+// its change feed (leveldb::DB::NewChangeIterator), keeping only the keys under
+// one store prefix.  Every put and erase is one change; the index entries a
+// store writes with its records live under other prefixes and are skipped.
+//
+// A reader resumes from a sequence number: the last one it has read is
+// reported by getSequence, and a new reader started there delivers what came
+// after.  The database only keeps the newest batches in memory, so a reader
+// which falls too far behind, or which resumes after the database was
+// reopened, fails and must read the store itself to catch up.
+//
+// The generated '<Class>ChangeFeed' wraps this class for one record type.
+namespace CHANGE_FEED
+{
+
+struct Change
+{
+    std::string mKey;           // without the store prefix
+    std::string mValue;         // empty for an erase
+    uint64_t    mSequence{0};
+    bool        mErased{false};
+};
+
+class ChangeReader
+{
+public:
+    // Starts with the first write after 'sequence'; 0 starts with the oldest
+    // write the feed still holds
+    ChangeReader(leveldb::DB *db, const std::string &prefix, uint64_t sequence);
+    ~ChangeReader(void);
+
+    // Stores the next change in 'change', waiting up to 'timeoutMicros' for a
+    // write to be committed.  Returns false if none came, or if the reader
+    // failed (see ok)
+    bool next(Change &change, uint64_t timeoutMicros = 0);
+    // The sequence number of the last write read, including the writes to
+    // other prefixes which were skipped
+    uint64_t getSequence(void) const;
+    // False if the database keeps no change feed or no longer holds the writes
+    // this reader is waiting for
+    bool ok(void) const;
+    const std::string &getLastError(void) const;
+
+private:
+    class Collector;
+
+    ChangeReader(const ChangeReader &) = delete;
+    ChangeReader &operator=(const ChangeReader &) = delete;
+
+    bool readBatch(void);
+
+    leveldb::ChangeIterator *mIterator{nullptr};
+    std::string             mPrefix;
+    uint64_t                mSequence{0};
+    uint64_t                mBatchLast{0};  // sequence of the last write of the batch read into mPending
+    std::deque< Change >    mPending;
+    bool                    mOk{true};
+    std::string             mLastError;
+};
+
+} // end of CHANGE_FEED namespace
+
+#endif
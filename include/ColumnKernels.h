@@ -0,0 +1,139 @@
+#ifndef COLUMN_KERNELS_H
+#define COLUMN_KERNELS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Reductions over a contiguous column of numbers; used by the generated
+// '<Class>Columns' containers.  The generic versions keep four independent
+// accumulators so the compiler can vectorize them; float and double have
+// explicit SSE2 versions (compiled in ColumnKernels.cpp) since floating point
+// reductions are not auto-vectorized without relaxed math flags.
+//
+// 'minimum' and 'maximum' require a non-empty column.  The result is
+// unspecified if the column contains NaN values.
+namespace COLUMN_KERNELS
+{
+
+// The type a column is summed into
+template< typename T >
+struct SumOf
+{
+    typedef int64_t Type;
+};
+template<> struct SumOf< uint8_t > { typedef uint64_t Type; };
+template<> struct SumOf< uint16_t > { typedef uint64_t Type; };
+template<> struct SumOf< uint32_t > { typedef uint64_t Type; };
+template<> struct SumOf< uint64_t > { typedef uint64_t Type; };
+template<> struct SumOf< float > { typedef double Type; };
+template<> struct SumOf< double > { typedef double Type; };
+
+double sum(const double *values, size_t count);
+double sum(const float *values, size_t count);   // accumulated in double precision
+double minimum(const double *values, size_t count);
+float minimum(const float *values, size_t count);
+double maximum(const double *values, size_t count);
+float maximum(const float *values, size_t count);
+
+template< typename T >
+typename SumOf< T >::Type sum(const T *values, size_t count)
+{
+    typedef typename SumOf< T >::Type S;
+    S s0 = 0;
+    S s1 = 0;
+    S s2 = 0;
+    S s3 = 0;
+    size_t i = 0;
+    const size_t blocked = count & ~size_t(3);
+    for (; i < blocked; i += 4)
+    {
+        s0 += S(values[i]);
+        s1 += S(values[i + 1]);
+        s2 += S(values[i + 2]);
+        s3 += S(values[i + 3]);
+    }
+    for (; i < count; i++)
+    {
+        s0 += S(values[i]);
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+template< typename T >
+T minimum(const T *values, size_t count)
+{
+    T m0 = values[0];
+    T m1 = values[0];
+    T m2 = values[0];
+    T m3 = values[0];
+    size_t i = 0;
+    const size_t blocked = count & ~size_t(3);
+    for (; i < blocked; i += 4)
+    {
+        m0 = values[i] < m0 ? values[i] : m0;
+        m1 = values[i + 1] < m1 ? values[i + 1] : m1;
+        m2 = values[i + 2] < m2 ? values[i + 2] : m2;
+        m3 = values[i + 3] < m3 ? values[i + 3] : m3;
+    }
+    for (; i < count; i++)
+    {
+        m0 = values[i] < m0 ? values[i] : m0;
+    }
+    m0 = m1 < m0 ? m1 : m0;
+    m2 = m3 < m2 ? m3 : m2;
+    return m2 < m0 ? m2 : m0;
+}
+
+template< typename T >
+T maximum(const T *values, size_t count)
+{
+    T m0 = values[0];
+    T m1 = values[0];
+    T m2 = values[0];
+    T m3 = values[0];
+    size_t i = 0;
+    const size_t blocked = count & ~size_t(3);
+    for (; i < blocked; i += 4)
+    {
+        m0 = values[i] > m0 ? values[i] : m0;
+        m1 = values[i + 1] > m1 ? values[i + 1] : m1;
+        m2 = values[i + 2] > m2 ? values[i + 2] : m2;
+        m3 = values[i + 3] > m3 ? values[i + 3] : m3;
+    }
+    for (; i < count; i++)
+    {
+        m0 = values[i] > m0 ? values[i] : m0;
+    }
+    m0 = m1 > m0 ? m1 : m0;
+    m2 = m3 > m2 ? m3 : m2;
+    return m2 > m0 ? m2 : m0;
+}
+
+// Counts the values for which 'predicate' returns true.  The count is
+// accumulated without branches so simple comparisons vectorize.
+template< typename T, typename Predicate >
+size_t countIf(const T *values, size_t count, Predicate predicate)
+{
+    size_t c0 = 0;
+    size_t c1 = 0;
+    size_t c2 = 0;
+    size_t c3 = 0;
+    size_t i = 0;
+    const size_t blocked = count & ~size_t(3);
+    for (; i < blocked; i += 4)
+    {
+        c0 += predicate(values[i]) ? 1 : 0;
+        c1 += predicate(values[i + 1]) ? 1 : 0;
+        c2 += predicate(values[i + 2]) ? 1 : 0;
+        c3 += predicate(values[i + 3]) ? 1 : 0;
+    }
+    for (; i < count; i++)
+    {
+        c0 += predicate(values[i]) ? 1 : 0;
+    }
+    return (c0 + c1) + (c2 + c3);
+}
+
+} // end of COLUMN_KERNELS namespace
+
+#endif
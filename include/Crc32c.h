@@ -0,0 +1,46 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// CRC-32C (Castagnoli), the checksum used by leveldb and by the optional
+// checksums of the generated packed and NDJSON record framings.
+//
+// On x86-64 CPUs with SSE4.2 the crc32 instruction is used; the choice is made
+// at run time, so the code needs no special compiler flags.  Buffers of a few
+// hundred bytes or more are split in three equal streams whose crc32
+// instructions run interleaved, and the three results are combined with
+// precomputed tables.  Other CPUs use a slicing-by-8 table implementation.
+namespace CRC32C
+{
+
+// Returns the CRC-32C of the concatenation of A and 'data', where 'crc' is the
+// CRC-32C of A (zero for an empty A)
+uint32_t extend(uint32_t crc, const void *data, size_t len);
+
+inline uint32_t value(const void *data, size_t len)
+{
+    return extend(0, data, len);
+}
+
+// True if 'extend' uses the crc32 instruction on this CPU
+bool isAccelerated(void);
+
+// 'extend' using the crc32 instruction; returns zero if the CPU lacks it
+uint32_t extendAccelerated(uint32_t crc, const void *data, size_t len);
+
+// 'extend' using the table implementation, whatever the CPU
+uint32_t extendPortable(uint32_t crc, const void *data, size_t len);
+
+// Checksums of the generated NDJSON lines: a tab and the CRC-32C of the text
+// before it as 8 lowercase hex digits.  'appendLineChecksum' adds one to a
+// line (without its newline).  'checkLineChecksum' verifies and removes one
+// if the line ends with it; it returns false only on a mismatch.
+void appendLineChecksum(std::string &line);
+bool checkLineChecksum(std::string &line);
+
+} // end of CRC32C namespace
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef GROUP_COMMIT_H
+#define GROUP_COMMIT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace leveldb
+{
+    class DB;
+    class WriteBatch;
+}
+
+// Group commit for dirty records.  Updates are queued as shared pointers to
+// immutable snapshots of the record; a background thread wakes up every flush
+// interval (or as soon as a full batch is waiting), keeps only the newest
+// update of every key and writes the survivors with a few large leveldb
+// WriteBatch commits.  Marking a record dirty costs a short lock and a pointer
+// push; the encoding and the write happen on the flusher thread.  The keys of
+// a flush cycle are locked with KEY_LOCKS until their records are committed.
+//
+// The generated '<Class>Flusher' wraps this class for one record type.
+namespace GROUP_COMMIT
+{
+
+struct Options
+{
+    uint32_t    mFlushIntervalMs{50};       // longest time an update waits before it is written
+    size_t      mMaxBatchRecords{1024};     // records per WriteBatch; a full batch wakes the flusher early
+    size_t      mMaxBatchBytes{1 << 20};    // a WriteBatch is committed once it grows past this size
+    bool        mSync{false};               // every WriteBatch waits until it is on disk
+};
+
+struct Metrics
+{
+    uint64_t    mEnqueued{0};       // updates marked dirty
+    uint64_t    mCoalesced{0};      // updates dropped because a newer update of the same key was written with them
+    uint64_t    mWritten{0};        // records written
+    uint64_t    mBatches{0};        // WriteBatch commits
+    uint64_t    mBytes{0};          // approximate size of the committed batches
+    uint64_t    mErrors{0};         // failed commits; their records are retried with the next flush
+    uint64_t    mLargestBatch{0};   // most records in one WriteBatch
+    uint64_t    mFlushes{0};        // flush cycles which wrote anything
+    uint64_t    mFlushMicros{0};    // total time spent coalescing, encoding and writing
+    uint64_t    mMaxFlushMicros{0}; // longest flush cycle
+    size_t      mPending{0};        // updates waiting for the next flush
+};
+
+class GroupCommitter
+{
+public:
+    // Appends the record's key (without any store prefix) to 'key'
+    typedef std::function< void (const void *record, std::string &key) > KeyFunction;
+    // Adds the record to 'batch'; on failure sets 'error' and returns false
+    typedef std::function< bool (const std::string &key, const void *record, leveldb::WriteBatch &batch, std::string &error) > WriteFunction;
+    // Called on the flusher thread for every key once its record is in the database
+    typedef std::function< void (const std::string &key) > CommittedFunction;
+
+    // 'keyFunction' may be empty if every update is marked dirty with an explicit
+    // key; 'committedFunction' may be empty
+    GroupCommitter(leveldb::DB *db, const Options &options, KeyFunction keyFunction, WriteFunction writeFunction, CommittedFunction committedFunction = nullptr);
+    // Writes everything still pending and stops the flusher thread
+    ~GroupCommitter(void);
+
+    // Queues a record which is written under its own key
+    void markDirty(std::shared_ptr< const void > record);
+    // Queues a record which is written under 'key'
+    void markDirty(std::string key, std::shared_ptr< const void > record);
+
+    // Blocks until every update queued before the call has been written.
+    // Returns false if a commit failed; see getLastError.
+    bool flush(void);
+    // Writes everything still pending and stops the flusher thread; records
+    // marked dirty afterwards are written by the destructor
+    void stop(void);
+
+    Metrics getMetrics(void) const;
+    std::string getLastError(void) const;
+
+private:
+    struct Entry
+    {
+        std::string                     mKey;
+        std::shared_ptr< const void >   mRecord;
+    };
+
+    GroupCommitter(const GroupCommitter &) = delete;
+    GroupCommitter &operator=(const GroupCommitter &) = delete;
+
+    void run(void);
+    bool write(std::vector< Entry > &work, std::vector< Entry > &failed);
+    bool commit(leveldb::WriteBatch &batch, size_t count);
+    void enqueue(Entry &&entry);
+
+    leveldb::DB                 *mDB;
+    Options                     mOptions;
+    KeyFunction                 mKeyFunction;
+    WriteFunction               mWriteFunction;
+    CommittedFunction           mCommittedFunction;
+
+    mutable std::mutex          mMutex;
+    std::condition_variable     mWake;      // wakes the flusher thread
+    std::condition_variable     mDone;      // signalled after every flush cycle
+    std::vector< Entry >        mPending;
+    uint64_t                    mFlushRequest{0};
+    uint64_t                    mFlushDone{0};
+    bool                        mFlushOk{true};
+    bool                        mStop{false};
+    bool                        mRunning{false};
+    Metrics                     mMetrics;
+    std::string                 mLastError;
+    std::thread                 mThread;
+};
+
+} // end of GROUP_COMMIT namespace
+
+#endif
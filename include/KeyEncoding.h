@@ -0,0 +1,304 @@
+#ifndef KEY_ENCODING_H
+#define KEY_ENCODING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+// Order preserving key encoding; comparing two encoded keys with memcmp (as
+// leveldb's default bytewise comparator does) orders them the same way as
+// comparing the original values member by member.
+//
+// Unsigned integers are stored big-endian at their natural width, signed
+// integers the same way with the sign bit flipped.  Floats and doubles are
+// stored as their bits with the sign bit flipped for positive values and every
+// bit flipped for negative ones.  Bools are one byte and enums a u32 ordinal.
+// Strings are escaped so that a zero byte becomes 0x00 0xFF and are terminated
+// by 0x00 0x01, which keeps a string ordered before any longer string it is a
+// prefix of.  A composite key is the concatenation of its members.
+namespace KEY_ENCODING
+{
+
+template< typename T >
+inline void putBigEndian(std::string &out, T v)
+{
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++)
+    {
+        bytes[i] = char(uint8_t(v >> (8 * (sizeof(T) - 1 - i))));
+    }
+    out.append(bytes, sizeof(T));
+}
+
+inline void putKey(std::string &out, uint8_t v)
+{
+    putBigEndian< uint8_t >(out, v);
+}
+
+inline void putKey(std::string &out, uint16_t v)
+{
+    putBigEndian< uint16_t >(out, v);
+}
+
+inline void putKey(std::string &out, uint32_t v)
+{
+    putBigEndian< uint32_t >(out, v);
+}
+
+inline void putKey(std::string &out, uint64_t v)
+{
+    putBigEndian< uint64_t >(out, v);
+}
+
+inline void putKey(std::string &out, int8_t v)
+{
+    putBigEndian< uint8_t >(out, uint8_t(uint8_t(v) ^ 0x80u));
+}
+
+inline void putKey(std::string &out, int16_t v)
+{
+    putBigEndian< uint16_t >(out, uint16_t(uint16_t(v) ^ 0x8000u));
+}
+
+inline void putKey(std::string &out, int32_t v)
+{
+    putBigEndian< uint32_t >(out, uint32_t(v) ^ 0x80000000u);
+}
+
+inline void putKey(std::string &out, int64_t v)
+{
+    putBigEndian< uint64_t >(out, uint64_t(v) ^ 0x8000000000000000ull);
+}
+
+inline void putKey(std::string &out, bool v)
+{
+    out.push_back(v ? 1 : 0);
+}
+
+inline void putKey(std::string &out, float v)
+{
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits = (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+    putBigEndian< uint32_t >(out, bits);
+}
+
+inline void putKey(std::string &out, double v)
+{
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits = (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+    putBigEndian< uint64_t >(out, bits);
+}
+
+inline void putKey(std::string &out, const std::string &v)
+{
+    const char *scan = v.data();
+    const char *end = scan + v.size();
+    while (scan < end)
+    {
+        const char *zero = static_cast< const char * >(memchr(scan, 0, size_t(end - scan)));
+        if (zero == nullptr)
+        {
+            out.append(scan, size_t(end - scan));
+            break;
+        }
+        out.append(scan, size_t(zero - scan));
+        out.push_back(char(0));
+        out.push_back(char(0xFF));
+        scan = zero + 1;
+    }
+    out.push_back(char(0));
+    out.push_back(char(1));
+}
+
+// Turns 'key' into the smallest key which is greater than every key starting
+// with it; used as the exclusive end of a prefix scan.  Returns false if no
+// such key exists (the key is empty or all 0xFF bytes).
+inline bool prefixSuccessor(std::string &key)
+{
+    while (!key.empty())
+    {
+        uint8_t c = uint8_t(key.back());
+        if (c != 0xFF)
+        {
+            key.back() = char(c + 1);
+            return true;
+        }
+        key.pop_back();
+    }
+    return false;
+}
+
+// Decodes the order preserving encoding; every method returns false if the
+// data is truncated or malformed.
+class Reader
+{
+public:
+    Reader(const void *data, size_t len)
+        : mData(static_cast< const uint8_t * >(data)), mLen(len)
+    {
+    }
+
+    template< typename T >
+    bool getBigEndian(T &v)
+    {
+        if (mLen - mOffset < sizeof(T))
+        {
+            return false;
+        }
+        T r = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            r = T((r << 8) | mData[mOffset + i]);
+        }
+        mOffset += sizeof(T);
+        v = r;
+        return true;
+    }
+
+    bool getKey(uint8_t &v)
+    {
+        return getBigEndian< uint8_t >(v);
+    }
+
+    bool getKey(uint16_t &v)
+    {
+        return getBigEndian< uint16_t >(v);
+    }
+
+    bool getKey(uint32_t &v)
+    {
+        return getBigEndian< uint32_t >(v);
+    }
+
+    bool getKey(uint64_t &v)
+    {
+        return getBigEndian< uint64_t >(v);
+    }
+
+    bool getKey(int8_t &v)
+    {
+        uint8_t u;
+        if (!getBigEndian< uint8_t >(u))
+        {
+            return false;
+        }
+        v = int8_t(uint8_t(u ^ 0x80u));
+        return true;
+    }
+
+    bool getKey(int16_t &v)
+    {
+        uint16_t u;
+        if (!getBigEndian< uint16_t >(u))
+        {
+            return false;
+        }
+        v = int16_t(uint16_t(u ^ 0x8000u));
+        return true;
+    }
+
+    bool getKey(int32_t &v)
+    {
+        uint32_t u;
+        if (!getBigEndian< uint32_t >(u))
+        {
+            return false;
+        }
+        v = int32_t(u ^ 0x80000000u);
+        return true;
+    }
+
+    bool getKey(int64_t &v)
+    {
+        uint64_t u;
+        if (!getBigEndian< uint64_t >(u))
+        {
+            return false;
+        }
+        v = int64_t(u ^ 0x8000000000000000ull);
+        return true;
+    }
+
+    bool getKey(bool &v)
+    {
+        uint8_t u;
+        if (!getBigEndian< uint8_t >(u) || u > 1)
+        {
+            return false;
+        }
+        v = u != 0;
+        return true;
+    }
+
+    bool getKey(float &v)
+    {
+        uint32_t bits;
+        if (!getBigEndian< uint32_t >(bits))
+        {
+            return false;
+        }
+        bits = (bits & 0x80000000u) ? (bits & ~0x80000000u) : ~bits;
+        memcpy(&v, &bits, sizeof(v));
+        return true;
+    }
+
+    bool getKey(double &v)
+    {
+        uint64_t bits;
+        if (!getBigEndian< uint64_t >(bits))
+        {
+            return false;
+        }
+        bits = (bits & 0x8000000000000000ull) ? (bits & ~0x8000000000000000ull) : ~bits;
+        memcpy(&v, &bits, sizeof(v));
+        return true;
+    }
+
+    bool getKey(std::string &v)
+    {
+        v.clear();
+        while (mOffset < mLen)
+        {
+            const uint8_t *begin = mData + mOffset;
+            const uint8_t *zero = static_cast< const uint8_t * >(memchr(begin, 0, mLen - mOffset));
+            if (zero == nullptr || size_t(zero - mData) + 1 >= mLen)
+            {
+                return false;
+            }
+            v.append(reinterpret_cast< const char * >(begin), size_t(zero - begin));
+            mOffset = size_t(zero - mData) + 2;
+            if (zero[1] == 1)
+            {
+                return true;
+            }
+            if (zero[1] != 0xFF)
+            {
+                return false;
+            }
+            v.push_back(char(0));
+        }
+        return false;
+    }
+
+    bool atEnd(void) const
+    {
+        return mOffset == mLen;
+    }
+
+    size_t getOffset(void) const
+    {
+        return mOffset;
+    }
+
+private:
+    const uint8_t   *mData;
+    size_t          mLen;
+    size_t          mOffset{0};
+};
+
+} // end of KEY_ENCODING namespace
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef KEY_LOCKS_H
+#define KEY_LOCKS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+// Striped locks which serialize the writers of a record key within the
+// process.  The generated stores of classes with secondary indexes read the
+// record they replace and write its index updates under the lock of the key,
+// and GROUP_COMMIT::GroupCommitter holds the locks of the keys it writes, so
+// two writers of one key never both remove the same old index entries.
+//
+// A key maps to one of a fixed number of mutexes by a hash of its bytes, so
+// unrelated keys share a mutex now and then.  A LockSet takes its mutexes in
+// stripe order, so two LockSets never wait for each other.
+namespace KEY_LOCKS
+{
+
+class LockSet
+{
+public:
+    LockSet(void) = default;
+    // Adds 'key' and locks it
+    explicit LockSet(const std::string &key);
+    // Unlocks the keys if they are locked
+    ~LockSet(void);
+
+    // Adds the stripe of a key; keys are only added while the set is unlocked
+    void add(const void *key, size_t len);
+    void add(const std::string &key)
+    {
+        add(key.data(), key.size());
+    }
+    // Locks the stripes of every key added
+    void lock(void);
+    void unlock(void);
+    // Unlocks and forgets the keys
+    void clear(void);
+
+private:
+    LockSet(const LockSet &) = delete;
+    LockSet &operator=(const LockSet &) = delete;
+
+    std::vector< uint32_t > mStripes;
+    bool                    mLocked{false};
+};
+
+} // end of KEY_LOCKS namespace
+
+#endif
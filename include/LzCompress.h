@@ -0,0 +1,82 @@
+#ifndef LZ_COMPRESS_H
+#define LZ_COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+// A small, fast LZ77 style block compressor in the spirit of LZ4; it trades
+// ratio for speed and needs no external library.
+//
+// Block layout: the uncompressed length as a varint (7 bits per byte, least
+// significant group first) followed by a sequence of commands.  Each command
+// is a token byte whose high nibble is the literal length and low nibble the
+// match length minus 4 (a nibble of 15 is extended by following bytes which
+// are added until one is not 255), the literal bytes, then a 2 byte
+// little-endian match offset (1-65535).  The final command has literals only.
+//
+// Frame layout (for streams of arbitrary size): the magic "LZF1" followed by
+// blocks, each a 4 byte little-endian header and the payload.  The low 31 bits
+// of the header are the payload size; the top bit marks a block stored
+// uncompressed.  A header of zero ends the frame.  Blocks are compressed
+// independently and hold at most LZ_COMPRESS_FRAME_BLOCK_SIZE bytes.
+namespace LZ_COMPRESS
+{
+
+#define LZ_COMPRESS_FRAME_BLOCK_SIZE (256 * 1024)
+
+// Worst case size of a compressed block
+size_t compressBound(size_t len);
+
+// Compresses a block; the result is appended to 'dest'.  Returns the number
+// of bytes appended.
+size_t compress(const void *src, size_t len, std::string &dest);
+
+// Reads the uncompressed length from the block header
+bool getUncompressedLength(const void *src, size_t len, size_t &result);
+
+// Decompresses a block into 'dest' which must be exactly the uncompressed
+// length.  Returns false if the block is corrupt.
+bool decompress(const void *src, size_t len, char *dest, size_t destLen);
+
+// Decompresses a block; 'dest' is replaced
+bool decompress(const void *src, size_t len, std::string &dest);
+
+// Returns true if the data starts with the frame magic
+bool isFrame(const void *src, size_t len);
+
+// Writes a compressed frame incrementally; data is buffered and compressed a
+// block at a time.
+class FrameWriter
+{
+public:
+    // The frame is appended to 'dest'
+    FrameWriter(std::string &dest);
+    ~FrameWriter(void);
+
+    void write(const void *data, size_t len);
+    void write(const std::string &str)
+    {
+        write(str.data(), str.size());
+    }
+    // Flushes the final block and writes the end marker
+    void finish(void);
+
+private:
+    void flushBlock(void);
+
+    std::string &mDest;
+    std::string mBuffer;
+    bool        mFinished{false};
+};
+
+// Compresses an entire buffer as one frame; 'dest' is replaced
+void compressFrame(const void *src, size_t len, std::string &dest);
+
+// Decompresses a frame; 'dest' is replaced.  Returns false if the frame is
+// corrupt or truncated.
+bool decompressFrame(const void *src, size_t len, std::string &dest);
+
+} // end of LZ_COMPRESS namespace
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef OBJECT_CACHE_H
+#define OBJECT_CACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <memory>
+#include "leveldb/slice.h"
+
+namespace leveldb
+{
+    class Cache;
+}
+
+// A cache of decoded records on top of leveldb's sharded LRU cache.  Values
+// are shared pointers to immutable objects, so a hit is a hash lookup and a
+// reference count increment; entries are charged by the memory they hold.
+//
+// A write invalidates its key after the database has been updated.  A reader
+// which missed takes the version before reading the database and inserts its
+// result with it; if any invalidation happened in between, the entry is
+// dropped again so a stale record is never left behind.
+//
+// The generated '<Class>Cache' wraps this class for one record type.
+namespace OBJECT_CACHE
+{
+
+struct Stats
+{
+    uint64_t    mHits{0};
+    uint64_t    mMisses{0};
+    uint64_t    mInserts{0};
+    uint64_t    mInvalidations{0};
+    size_t      mCharge{0};     // memory charged by the entries in the cache
+    size_t      mCapacity{0};
+
+    double hitRate(void) const
+    {
+        uint64_t lookups = mHits + mMisses;
+        return lookups ? double(mHits) / double(lookups) : 0;
+    }
+};
+
+class ObjectCache
+{
+public:
+    // 'capacity' is the total charge the cache may hold, in bytes
+    explicit ObjectCache(size_t capacity);
+    ~ObjectCache(void);
+
+    // Returns the cached object or nullptr; counts a hit or a miss
+    std::shared_ptr< const void > lookup(const leveldb::Slice &key);
+    // Taken before reading the database after a miss
+    uint64_t getVersion(void) const;
+    // Caches an object read after 'getVersion' returned 'version'
+    void insert(const leveldb::Slice &key, std::shared_ptr< const void > value, size_t charge, uint64_t version);
+    // Drops the object cached for 'key'; call after the database is written
+    void invalidate(const leveldb::Slice &key);
+    // Drops every entry which is not in use
+    void prune(void);
+
+    Stats getStats(void) const;
+
+private:
+    ObjectCache(const ObjectCache &) = delete;
+    ObjectCache &operator=(const ObjectCache &) = delete;
+
+    leveldb::Cache              *mCache;
+    size_t                      mCapacity;
+    std::atomic< uint64_t >     mVersion{0};
+    std::atomic< uint64_t >     mHits{0};
+    std::atomic< uint64_t >     mMisses{0};
+    std::atomic< uint64_t >     mInserts{0};
+    std::atomic< uint64_t >     mInvalidations{0};
+};
+
+} // end of OBJECT_CACHE namespace
+
+#endif
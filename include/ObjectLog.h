@@ -0,0 +1,233 @@
+#ifndef OBJECT_LOG_H
+#define OBJECT_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace leveldb
+{
+    class SequentialFile;
+    class WritableFile;
+    namespace log
+    {
+        class Reader;
+        class Writer;
+    }
+}
+
+// An append-only file of records in leveldb's log format: 32KB blocks, records
+// split into fragments at block boundaries and a CRC-32C on every fragment.
+// There is no memtable, index or compaction; a record is appended once and read
+// back in order.
+//
+// Appends from several threads are committed in groups: the first waiting
+// thread writes the records of every thread queued behind it and syncs the
+// file once for all of them.  Once a group fails, every append fails until the
+// log is reopened.  Opening a log for appending reads only the tail of the
+// file, in a window that grows until it holds a complete record, and cuts off
+// a record torn by a crash, so new records follow the last complete one.  A
+// reader skips damaged fragments and counts the bytes it dropped.
+//
+// ObjectLogWriter and ObjectLogReader store generated objects in the packed
+// binary layout (toPackedBytes and fromPackedBytes, see "Packed" in the README).
+namespace OBJECT_LOG
+{
+
+struct Options
+{
+    bool    mSync{true};    // an append returns once its record is on disk
+};
+
+struct Stats
+{
+    uint64_t    mRecords{0};        // records appended
+    uint64_t    mBytes{0};          // payload bytes appended
+    uint64_t    mGroups{0};         // groups of appends written together
+    uint64_t    mSyncs{0};          // file syncs
+    uint64_t    mTruncatedBytes{0}; // torn bytes cut off the end of the file by open
+};
+
+class LogWriter
+{
+public:
+    LogWriter(void);
+    ~LogWriter(void);
+
+    // Opens 'path' for appending, creating it if needed.  An incomplete record at
+    // the end of the file is cut off first.
+    bool open(const std::string &path, const Options &options = Options());
+    // Must not race with append
+    void close(void);
+    // Appends one record; thread safe.  Appends made while another thread is
+    // writing wait and are written and synced together with the next group.
+    bool append(const void *data, size_t len);
+    // Flushes the records appended so far and syncs the file
+    bool sync(void);
+
+    Stats getStats(void) const;
+    std::string getLastError(void) const;
+
+private:
+    struct Waiter;
+
+    LogWriter(const LogWriter &) = delete;
+    LogWriter &operator=(const LogWriter &) = delete;
+
+    bool recover(const std::string &path, uint64_t &end);
+    bool commit(const void *data, size_t len, bool sync);
+
+    Options                         mOptions;
+    leveldb::WritableFile           *mFile{nullptr};
+    leveldb::log::Writer            *mWriter{nullptr};
+
+    mutable std::mutex              mMutex;
+    std::deque< Waiter * >          mQueue;     // the front waiter writes for the others
+    bool                            mFailed{false}; // a write failed, so the end of the file is unknown
+    Stats                           mStats;
+    std::string                     mLastError;
+};
+
+class LogReader
+{
+public:
+    LogReader(void);
+    ~LogReader(void);
+
+    // Opens 'path' at its first record
+    bool open(const std::string &path);
+    void close(void);
+    // Returns the next record, which stays valid until the next call; false at
+    // the end of the log or on a read error (see ok)
+    bool next(const char *&data, size_t &len);
+    // Payload bytes skipped because their fragments were damaged or torn
+    uint64_t getDroppedBytes(void) const;
+    bool ok(void) const;
+    const std::string &getLastError(void) const;
+
+private:
+    class Reporter;
+    class BufferedFile;
+
+    LogReader(const LogReader &) = delete;
+    LogReader &operator=(const LogReader &) = delete;
+
+    BufferedFile                    *mFile{nullptr};
+    Reporter                        *mReporter{nullptr};
+    leveldb::log::Reader            *mReader{nullptr};
+    std::string                     mScratch;   // reused for records which span blocks
+    std::string                     mLastError;
+};
+
+// Appends objects in the packed binary layout.  Thread safe.
+template< typename T >
+class ObjectLogWriter
+{
+public:
+    bool open(const std::string &path, const Options &options = Options())
+    {
+        return mLog.open(path, options);
+    }
+
+    void close(void)
+    {
+        mLog.close();
+    }
+
+    bool append(const T &v)
+    {
+        // one encode buffer per thread, reused between appends
+        static thread_local std::string record;
+        record.clear();
+        toPackedBytes(v, record);
+        return mLog.append(record.data(), record.size());
+    }
+
+    bool sync(void)
+    {
+        return mLog.sync();
+    }
+
+    Stats getStats(void) const
+    {
+        return mLog.getStats();
+    }
+
+    std::string getLastError(void) const
+    {
+        return mLog.getLastError();
+    }
+
+private:
+    LogWriter   mLog;
+};
+
+// Replays a log of objects in the packed binary layout.  Every record is
+// decoded into the same object, so the buffers of its strings and arrays are
+// reused.  Use one reader per thread.
+template< typename T >
+class ObjectLogReader
+{
+public:
+    bool open(const std::string &path)
+    {
+        mDecodeError = false;
+        return mLog.open(path);
+    }
+
+    void close(void)
+    {
+        mLog.close();
+    }
+
+    // Decodes the next object; false at the end of the log or on an error (see ok)
+    bool next(void)
+    {
+        const char *data;
+        size_t len;
+        if ( mDecodeError || !mLog.next(data, len) )
+        {
+            return false;
+        }
+        if ( !fromPackedBytes(data, len, mValue) )
+        {
+            mDecodeError = true;
+            return false;
+        }
+        return true;
+    }
+
+    // The object read by the last successful next
+    const T &value(void) const
+    {
+        return mValue;
+    }
+
+    uint64_t getDroppedBytes(void) const
+    {
+        return mLog.getDroppedBytes();
+    }
+
+    bool ok(void) const
+    {
+        return !mDecodeError && mLog.ok();
+    }
+
+    std::string getLastError(void) const
+    {
+        return mDecodeError ? std::string("Corruption: invalid record in object log") : mLog.getLastError();
+    }
+
+private:
+    LogReader   mLog;
+    T           mValue;
+    bool        mDecodeError{false};
+};
+
+} // end of OBJECT_LOG namespace
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef PACKED_BYTES_H
+#define PACKED_BYTES_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "Crc32c.h"
+
+// Helpers for the fixed little-endian packed binary layout written by the
+// generated 'toPackedBytes' and read by 'fromPackedBytes' (and by the
+// matching generated Python 'to_bytes'/'from_bytes').
+//
+// Layout: scalars are stored at their natural width, bool and the optional
+// presence flag as one byte, enums as a u32, strings as a u32 byte length
+// followed by UTF-8 bytes and arrays as a u32 element count followed by the
+// elements.  Nested classes are stored inline, base class members first.
+// A record written with a checksum is followed by the CRC-32C of its bytes as
+// a u32.
+namespace PACKED_BYTES
+{
+
+inline bool isLittleEndian(void)
+{
+    const uint16_t v = 1;
+    uint8_t b;
+    memcpy(&b, &v, 1);
+    return b == 1;
+}
+
+// Appends a scalar in little-endian order
+template< typename T >
+inline void put(std::string &out, T v)
+{
+    char bytes[sizeof(T)];
+    memcpy(bytes, &v, sizeof(T));
+    if (!isLittleEndian())
+    {
+        for (size_t i = 0; i < sizeof(T) / 2; i++)
+        {
+            char c = bytes[i];
+            bytes[i] = bytes[sizeof(T) - 1 - i];
+            bytes[sizeof(T) - 1 - i] = c;
+        }
+    }
+    out.append(bytes, sizeof(T));
+}
+
+inline void putBool(std::string &out, bool v)
+{
+    out.push_back(v ? 1 : 0);
+}
+
+inline void putCount(std::string &out, size_t count)
+{
+    put< uint32_t >(out, uint32_t(count));
+}
+
+inline void putString(std::string &out, const std::string &str)
+{
+    putCount(out, str.size());
+    out.append(str);
+}
+
+// Appends an array of scalars; on little-endian hosts this is one copy
+template< typename T >
+inline void putArray(std::string &out, const std::vector< T > &values)
+{
+    putCount(out, values.size());
+    if (isLittleEndian())
+    {
+        if (!values.empty())
+        {
+            out.append(reinterpret_cast< const char * >(values.data()), values.size() * sizeof(T));
+        }
+    }
+    else
+    {
+        for (auto &i : values)
+        {
+            put< T >(out, i);
+        }
+    }
+}
+
+// Reads the packed layout; every method returns false if the data is truncated
+class Reader
+{
+public:
+    Reader(const void *data, size_t len, size_t offset)
+        : mData(static_cast< const uint8_t * >(data)), mLen(len), mOffset(offset)
+    {
+    }
+
+    template< typename T >
+    bool get(T &v)
+    {
+        if (mOffset > mLen || mLen - mOffset < sizeof(T))
+        {
+            return false;
+        }
+        uint8_t bytes[sizeof(T)];
+        memcpy(bytes, mData + mOffset, sizeof(T));
+        if (!isLittleEndian())
+        {
+            for (size_t i = 0; i < sizeof(T) / 2; i++)
+            {
+                uint8_t c = bytes[i];
+                bytes[i] = bytes[sizeof(T) - 1 - i];
+                bytes[sizeof(T) - 1 - i] = c;
+            }
+        }
+        memcpy(&v, bytes, sizeof(T));
+        mOffset += sizeof(T);
+        return true;
+    }
+
+    bool getBool(bool &v)
+    {
+        uint8_t b;
+        if (!get< uint8_t >(b))
+        {
+            return false;
+        }
+        v = b != 0;
+        return true;
+    }
+
+    // Reads an element count; fails if the remaining data cannot hold that
+    // many elements of at least 'minElementSize' bytes.
+    bool getCount(uint32_t &count, size_t minElementSize)
+    {
+        return get< uint32_t >(count) && (minElementSize == 0 || count <= (mLen - mOffset) / minElementSize);
+    }
+
+    bool getString(std::string &str)
+    {
+        uint32_t len;
+        if (!getCount(len, 1))
+        {
+            return false;
+        }
+        str.assign(reinterpret_cast< const char * >(mData + mOffset), len);
+        mOffset += len;
+        return true;
+    }
+
+    template< typename T >
+    bool getArray(std::vector< T > &values)
+    {
+        uint32_t count;
+        if (!getCount(count, sizeof(T)))
+        {
+            return false;
+        }
+        values.resize(count);
+        if (isLittleEndian())
+        {
+            if (count)
+            {
+                memcpy(&values[0], mData + mOffset, count * sizeof(T));
+            }
+            mOffset += count * sizeof(T);
+            return true;
+        }
+        for (auto &i : values)
+        {
+            get< T >(i);
+        }
+        return true;
+    }
+
+    size_t getOffset(void) const
+    {
+        return mOffset;
+    }
+
+private:
+    const uint8_t   *mData;
+    size_t          mLen;
+    size_t          mOffset;
+};
+
+// Appends the CRC-32C of everything in 'out' from 'start' on
+inline void putChecksum(std::string &out, size_t start)
+{
+    put< uint32_t >(out, CRC32C::value(out.data() + start, out.size() - start));
+}
+
+// Checks the CRC-32C which ends a record of 'len' bytes; on success 'len' is
+// reduced to the record without it
+inline bool stripChecksum(const void *data, size_t &len)
+{
+    if (len < sizeof(uint32_t))
+    {
+        return false;
+    }
+    const uint8_t *p = static_cast< const uint8_t * >(data) + len - sizeof(uint32_t);
+    uint32_t stored = uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    len -= sizeof(uint32_t);
+    return CRC32C::value(data, len) == stored;
+}
+
+} // end of PACKED_BYTES namespace
+
+#endif
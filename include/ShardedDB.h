@@ -0,0 +1,170 @@
+#ifndef SHARDED_DB_H
+#define SHARDED_DB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "leveldb/db.h"
+#include "leveldb/write_batch.h"
+
+// Spreads the keys of one logical database over several independent leveldb
+// databases ("shards") by a hash of the key.  Each shard has its own log,
+// memtable, write queue and background compactions, so writers to different
+// shards never wait for each other.  The shards live in directories
+// 'shard-000', 'shard-001', ... under the database directory, which also
+// records their number; a key always hashes to the same shard, so the number
+// is fixed when the database is created.
+//
+// A ShardedBatch keeps one leveldb WriteBatch per shard.  The parts of a batch
+// which spans several shards are written in parallel by a pool of write
+// threads when the batch is synced or large, and one after the other by the
+// calling thread otherwise.  Every part is atomic, but the batch as a whole is
+// not: a crash in the middle of a write can keep the parts of some shards and
+// lose the others.
+//
+// A Snapshot holds one leveldb snapshot per shard, all taken while no write is
+// in progress, so it sees every write that finished before it and none of the
+// writes that started after it.  An iterator merges the shards back into key
+// order.
+namespace SHARDED_DB
+{
+
+struct Options
+{
+    uint32_t    mShards{4};                 // shards of a new database; 0 opens an existing one with its own number
+    bool        mSync{false};               // every write waits until it is on disk
+    uint32_t    mWriteThreads{0};           // threads writing the parts of a batch in parallel; 0 for one per shard but one
+    size_t      mParallelBytes{64 << 10};   // unsynced batches at least this large are written in parallel too
+    bool        mOwnCompactions{true};      // shards compact on threads of their own instead of queuing on the Env's one background thread
+};
+
+class ShardedDB;
+
+// Updates for a sharded database, sorted by shard as they are added
+class ShardedBatch
+{
+public:
+    explicit ShardedBatch(const ShardedDB &db);
+
+    void put(const leveldb::Slice &key, const leveldb::Slice &value);
+    void erase(const leveldb::Slice &key);
+    void clear(void);
+    bool empty(void) const;
+    // Size of the batches of all shards
+    size_t getApproximateSize(void) const;
+
+private:
+    friend class ShardedDB;
+
+    leveldb::WriteBatch &getBatch(const leveldb::Slice &key);
+
+    const ShardedDB                     &mDB;
+    std::vector< leveldb::WriteBatch >  mBatches;   // one per shard
+    std::vector< uint32_t >             mTouched;   // the shards with updates, in the order they were first updated
+};
+
+// One leveldb snapshot per shard; see ShardedDB::getSnapshot
+class Snapshot
+{
+private:
+    friend class ShardedDB;
+
+    Snapshot(void) = default;
+    Snapshot(const Snapshot &) = delete;
+    Snapshot &operator=(const Snapshot &) = delete;
+
+    std::vector< const leveldb::Snapshot * > mShards;
+};
+
+class ShardedDB
+{
+public:
+    ShardedDB(void);
+    // Closes the shards; no write may be in progress and every snapshot must
+    // have been released
+    ~ShardedDB(void);
+
+    // Opens the database in the directory 'path', creating it and its shards if
+    // 'dbOptions.create_if_missing' is set.  'dbOptions' applies to every
+    // shard; a block cache, filter policy or statistics object in it is shared.
+    bool open(const std::string &path, const leveldb::Options &dbOptions, const Options &options = Options());
+    void close(void);
+
+    uint32_t getShardCount(void) const;
+    // The shard holding 'key'
+    uint32_t getShard(const leveldb::Slice &key) const;
+    // The database of one shard, e.g. for its properties or CompactRange
+    leveldb::DB *getShardDB(uint32_t shard) const;
+
+    bool put(const leveldb::Slice &key, const leveldb::Slice &value);
+    bool erase(const leveldb::Slice &key);
+    // Writes every part of 'batch'; on failure the shards written so far keep
+    // their parts
+    bool write(ShardedBatch &batch);
+
+    // Returns false if the key is missing or the read failed (see getLastError)
+    bool get(const leveldb::Slice &key, std::string &value, const Snapshot *snapshot = nullptr);
+    // A merging iterator over all the shards, in the order of the comparator of
+    // 'dbOptions'; the caller deletes it
+    leveldb::Iterator *newIterator(const Snapshot *snapshot = nullptr, bool fillCache = true) const;
+
+    // Briefly holds back new writes and waits for those in progress, then takes
+    // a snapshot of every shard
+    const Snapshot *getSnapshot(void);
+    void releaseSnapshot(const Snapshot *snapshot);
+
+    std::string getLastError(void) const;
+
+private:
+    struct Task;
+    struct Group;
+    // A count of the writes in progress on its own cache line; writers pick one
+    // by their first shard so that they seldom share it
+    struct WriterSlot
+    {
+        std::atomic< uint32_t > mWriters{0};
+        char                    mPad[64 - sizeof(std::atomic< uint32_t >)];
+    };
+
+    ShardedDB(const ShardedDB &) = delete;
+    ShardedDB &operator=(const ShardedDB &) = delete;
+
+    bool openShardCount(const std::string &path, const Options &options, uint32_t &shards);
+    void beginWrite(WriterSlot &slot);
+    void endWrite(WriterSlot &slot);
+    bool writeShard(uint32_t shard, leveldb::WriteBatch *batch);
+    bool writeParallel(ShardedBatch &batch);
+    void runWriter(void);
+    void setLastError(const leveldb::Status &s);
+
+    Options                             mOptions;
+    const leveldb::Comparator           *mComparator{nullptr};
+    std::vector< leveldb::DB * >        mShards;
+    std::unique_ptr< WriterSlot[] >     mSlots;
+
+    // A snapshot sets mSnapshotting and waits until no writer slot counts a
+    // write; writers which see the flag wait on mSnapshotDone
+    std::atomic< bool >                 mSnapshotting{false};
+    std::mutex                          mSnapshotMutex;
+    std::condition_variable             mSnapshotDone;
+
+    std::mutex                          mPoolMutex;
+    std::condition_variable             mPoolWake;
+    std::deque< Task >                  mTasks;
+    std::vector< std::thread >          mWriters;
+    bool                                mStopWriters{false};
+
+    mutable std::mutex                  mErrorMutex;
+    std::string                         mLastError;
+};
+
+} // end of SHARDED_DB namespace
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef STATISTICS_JSON_H
+#define STATISTICS_JSON_H
+
+#include <string>
+#include "leveldb/statistics.h"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+// Writes a leveldb::Statistics object as JSON with any rapidjson writer:
+//
+//  {
+//    "tickers": { "block_cache_hits": 10, ... },
+//    "histograms": { "get_micros": { "count": 3, "sum": 12, "min": 2,
+//                    "max": 6, "average": 4, "median": 4, "p95": 6,
+//                    "p99": 6 }, ... },
+//    "levels": [ { "level": 0, "compactions": 2, "micros": 800,
+//                  "bytes_read": 0, "bytes_written": 4096 }, ... ]
+//  }
+//
+// Every ticker, histogram and level is written, including those still zero.
+namespace STATISTICS_JSON
+{
+
+template< typename Writer >
+void writeHistogram(Writer &writer, const leveldb::Statistics::HistogramData &h)
+{
+    writer.StartObject();
+    writer.Key("count");
+    writer.Uint64(h.count);
+    writer.Key("sum");
+    writer.Uint64(h.sum);
+    writer.Key("min");
+    writer.Uint64(h.min);
+    writer.Key("max");
+    writer.Uint64(h.max);
+    writer.Key("average");
+    writer.Double(h.average);
+    writer.Key("median");
+    writer.Double(h.median);
+    writer.Key("p95");
+    writer.Double(h.p95);
+    writer.Key("p99");
+    writer.Double(h.p99);
+    writer.EndObject();
+}
+
+template< typename Writer >
+void write(Writer &writer, const leveldb::Statistics &stats)
+{
+    writer.StartObject();
+
+    writer.Key("tickers");
+    writer.StartObject();
+    for (int t = 0; t < leveldb::Statistics::kNumTickers; t++)
+    {
+        leveldb::Statistics::Ticker ticker = leveldb::Statistics::Ticker(t);
+        writer.Key(leveldb::Statistics::TickerName(ticker));
+        writer.Uint64(stats.Get(ticker));
+    }
+    writer.EndObject();
+
+    writer.Key("histograms");
+    writer.StartObject();
+    for (int i = 0; i < leveldb::Statistics::kNumHistograms; i++)
+    {
+        leveldb::Statistics::Histogram histogram = leveldb::Statistics::Histogram(i);
+        writer.Key(leveldb::Statistics::HistogramName(histogram));
+        writeHistogram(writer, stats.GetHistogram(histogram));
+    }
+    writer.EndObject();
+
+    writer.Key("levels");
+    writer.StartArray();
+    for (int level = 0; level < leveldb::Statistics::kNumLevels; level++)
+    {
+        leveldb::Statistics::LevelStats l = stats.GetLevelStats(level);
+        writer.StartObject();
+        writer.Key("level");
+        writer.Int(level);
+        writer.Key("compactions");
+        writer.Uint64(l.compactions);
+        writer.Key("micros");
+        writer.Uint64(l.micros);
+        writer.Key("bytes_read");
+        writer.Uint64(l.bytes_read);
+        writer.Key("bytes_written");
+        writer.Uint64(l.bytes_written);
+        writer.EndObject();
+    }
+    writer.EndArray();
+
+    writer.EndObject();
+}
+
+// Returns the statistics as a JSON document; 'pretty' indents it.
+inline std::string toJson(const leveldb::Statistics &stats, bool pretty = false)
+{
+    rapidjson::StringBuffer strbuf;
+    if (pretty)
+    {
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(strbuf);
+        write(writer, stats);
+    }
+    else
+    {
+        rapidjson::Writer<rapidjson::StringBuffer> writer(strbuf);
+        write(writer, stats);
+    }
+    return std::string(strbuf.GetString(), strbuf.GetSize());
+}
+
+}
+
+#endif
@@ -0,0 +1,335 @@
+#ifndef XOR_COMPRESS_H
+#define XOR_COMPRESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Gorilla style XOR compression for slowly changing floating point time series.
+// Each value is XOR'd with the previous one; identical values cost a single bit
+// and values which differ only in a few mantissa bits store just the meaningful
+// bits between the leading and trailing zeros of the XOR.
+//
+// The binary blob layout is a 4 byte little-endian sample count followed by the
+// bit stream (most significant bit first).  The blob is what the generated code
+// stores in binary outputs; the JSON serializer writes it as a base64 string.
+namespace XOR_COMPRESS
+{
+
+// Number of bits used to store the leading zero count of a XOR value
+#define XOR_COMPRESS_LEADING_BITS 5
+
+template< typename T, typename W, uint32_t LENGTH_BITS >
+class Encoder
+{
+public:
+    enum
+    {
+        WORD_BITS = sizeof(W) * 8
+    };
+
+    // Appends the compressed stream to 'dest'
+    Encoder(std::string &dest) : mDest(dest)
+    {
+        mHeader = mDest.size();
+        mDest.append(4, 0);
+    }
+
+    void add(T value)
+    {
+        W word;
+        memcpy(&word, &value, sizeof(word));
+        if (mCount == 0)
+        {
+            writeBits(word, WORD_BITS);
+        }
+        else
+        {
+            W x = word ^ mPrevious;
+            if (x == 0)
+            {
+                writeBits(0, 1);
+            }
+            else
+            {
+                uint32_t leading = countLeading(x);
+                uint32_t trailing = countTrailing(x);
+                if (leading > 31)
+                {
+                    leading = 31;
+                }
+                if (mLeading <= WORD_BITS && leading >= mLeading && trailing >= mTrailing)
+                {
+                    // Meaningful bits fit inside the previous window
+                    writeBits(2, 2);
+                    writeBits(uint64_t(x >> mTrailing), WORD_BITS - mLeading - mTrailing);
+                }
+                else
+                {
+                    mLeading = leading;
+                    mTrailing = trailing;
+                    uint32_t meaningful = WORD_BITS - leading - trailing;
+                    writeBits(3, 2);
+                    writeBits(leading, XOR_COMPRESS_LEADING_BITS);
+                    // A full width value is stored as zero
+                    writeBits(meaningful == WORD_BITS ? 0 : meaningful, LENGTH_BITS);
+                    writeBits(uint64_t(x >> trailing), meaningful);
+                }
+            }
+        }
+        mPrevious = word;
+        mCount++;
+    }
+
+    // Flushes the final partial byte and patches the sample count.
+    void finish(void)
+    {
+        if (mFinished)
+        {
+            return;
+        }
+        mFinished = true;
+        if (mBitCount)
+        {
+            mDest.push_back(char((mBitBuffer << (8 - mBitCount)) & 0xFF));
+            mBitCount = 0;
+        }
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            mDest[mHeader + i] = char((mCount >> (i * 8)) & 0xFF);
+        }
+    }
+
+    uint32_t getCount(void) const
+    {
+        return mCount;
+    }
+
+private:
+    // 'x' is never zero
+    static uint32_t countLeading(W x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return uint32_t(__builtin_clzll(uint64_t(x))) - (64 - WORD_BITS);
+#else
+        uint32_t ret = 0;
+        W mask = W(1) << (WORD_BITS - 1);
+        while (!(x & mask))
+        {
+            mask >>= 1;
+            ret++;
+        }
+        return ret;
+#endif
+    }
+
+    static uint32_t countTrailing(W x)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return uint32_t(__builtin_ctzll(uint64_t(x)));
+#else
+        uint32_t ret = 0;
+        while (!(x & 1))
+        {
+            x >>= 1;
+            ret++;
+        }
+        return ret;
+#endif
+    }
+
+    void writeBits(uint64_t bits, uint32_t count)
+    {
+        if (count > 32)
+        {
+            writeBits(bits >> 32, count - 32);
+            count = 32;
+        }
+        mBitBuffer = (mBitBuffer << count) | (bits & ((uint64_t(1) << count) - 1));
+        mBitCount += count;
+        while (mBitCount >= 8)
+        {
+            mBitCount -= 8;
+            mDest.push_back(char((mBitBuffer >> mBitCount) & 0xFF));
+        }
+    }
+
+    std::string &mDest;
+    size_t      mHeader{0};
+    W           mPrevious{0};
+    uint64_t    mBitBuffer{0};
+    uint32_t    mBitCount{0};
+    uint32_t    mLeading{0xFFFFFFFF};
+    uint32_t    mTrailing{0};
+    uint32_t    mCount{0};
+    bool        mFinished{false};
+};
+
+template< typename T, typename W, uint32_t LENGTH_BITS >
+class Decoder
+{
+public:
+    enum
+    {
+        WORD_BITS = sizeof(W) * 8
+    };
+
+    // The decoder does not copy 'data'; it must stay valid while decoding.
+    Decoder(const void *data, size_t len)
+    {
+        const uint8_t *scan = static_cast< const uint8_t * >(data);
+        if (scan && len >= 4)
+        {
+            mCount = uint32_t(scan[0]) | (uint32_t(scan[1]) << 8) | (uint32_t(scan[2]) << 16) | (uint32_t(scan[3]) << 24);
+            mData = scan + 4;
+            mEnd = scan + len;
+            // Every sample after the first costs at least one bit
+            mValid = mCount == 0 || uint64_t(mCount - 1) <= uint64_t(len - 4) * 8;
+        }
+    }
+
+    // Returns the number of samples stored in the blob
+    uint32_t getCount(void) const
+    {
+        return mCount;
+    }
+
+    // Returns false when the stream is exhausted or corrupt; check isValid()
+    // to tell the two apart.
+    bool next(T &value)
+    {
+        if (!mValid || mIndex >= mCount)
+        {
+            return false;
+        }
+        uint64_t bits = 0;
+        if (mIndex == 0)
+        {
+            if (!readBits(WORD_BITS, bits))
+            {
+                return fail();
+            }
+            mPrevious = W(bits);
+        }
+        else
+        {
+            if (!readBits(1, bits))
+            {
+                return fail();
+            }
+            if (bits)
+            {
+                if (!readBits(1, bits))
+                {
+                    return fail();
+                }
+                if (bits)
+                {
+                    uint64_t leading;
+                    uint64_t meaningful;
+                    if (!readBits(XOR_COMPRESS_LEADING_BITS, leading) || !readBits(LENGTH_BITS, meaningful))
+                    {
+                        return fail();
+                    }
+                    if (meaningful == 0)
+                    {
+                        meaningful = WORD_BITS;
+                    }
+                    if (leading + meaningful > WORD_BITS)
+                    {
+                        return fail();
+                    }
+                    mLeading = uint32_t(leading);
+                    mMeaningful = uint32_t(meaningful);
+                }
+                else if (mMeaningful == 0)
+                {
+                    return fail(); // reuse of a window which was never defined
+                }
+                if (!readBits(mMeaningful, bits))
+                {
+                    return fail();
+                }
+                mPrevious ^= W(bits << (WORD_BITS - mLeading - mMeaningful));
+            }
+        }
+        memcpy(&value, &mPrevious, sizeof(value));
+        mIndex++;
+        return true;
+    }
+
+    bool isValid(void) const
+    {
+        return mValid;
+    }
+
+private:
+    bool fail(void)
+    {
+        mValid = false;
+        return false;
+    }
+
+    bool readBits(uint32_t count, uint64_t &bits)
+    {
+        if (count > 32)
+        {
+            uint64_t high;
+            if (!readBits(count - 32, high))
+            {
+                return false;
+            }
+            uint64_t low;
+            if (!readBits(32, low))
+            {
+                return false;
+            }
+            bits = (high << 32) | low;
+            return true;
+        }
+        while (mBitCount < count)
+        {
+            if (mData == mEnd)
+            {
+                return false;
+            }
+            mBitBuffer = (mBitBuffer << 8) | *mData++;
+            mBitCount += 8;
+        }
+        mBitCount -= count;
+        bits = (mBitBuffer >> mBitCount) & ((uint64_t(1) << count) - 1);
+        return true;
+    }
+
+    const uint8_t   *mData{nullptr};
+    const uint8_t   *mEnd{nullptr};
+    W               mPrevious{0};
+    uint64_t        mBitBuffer{0};
+    uint32_t        mBitCount{0};
+    uint32_t        mLeading{0};
+    uint32_t        mMeaningful{0};
+    uint32_t        mCount{0};
+    uint32_t        mIndex{0};
+    bool            mValid{false};
+};
+
+typedef Encoder< double, uint64_t, 6 > DoubleEncoder;
+typedef Decoder< double, uint64_t, 6 > DoubleDecoder;
+typedef Encoder< float, uint32_t, 5 > FloatEncoder;
+typedef Decoder< float, uint32_t, 5 > FloatDecoder;
+
+// Convenience methods which encode/decode an entire array; 'blob' and 'values' are replaced.
+void encode(const double *values, size_t count, std::string &blob);
+void encode(const float *values, size_t count, std::string &blob);
+bool decode(const void *blob, size_t len, std::vector< double > &values);
+bool decode(const void *blob, size_t len, std::vector< float > &values);
+
+// Base64 helpers used to embed the compressed blob inside JSON
+void base64Encode(const void *data, size_t len, std::string &out);
+bool base64Decode(const char *str, size_t len, std::string &out);
+
+} // end of XOR_COMPRESS namespace
+
+#endif
@@ -0,0 +1,66 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A ChangeIterator reads the write batches committed to a DB in sequence
+// order, from the change feed the DB keeps in memory when
+// Options::change_feed_size is non-zero (see DB::NewChangeIterator()).
+// Reaching the newest batch does not end the iteration: Wait() blocks until
+// the next batch is committed, so a reader can tail the database.
+//
+// A ChangeIterator must not be used by several threads at once, and must
+// be deleted before the DB it was created from.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_CHANGE_ITERATOR_H_
+#define STORAGE_LEVELDB_INCLUDE_CHANGE_ITERATOR_H_
+
+#include <cstdint>
+
+#include "leveldb/export.h"
+#include "leveldb/status.h"
+
+namespace leveldb {
+
+class WriteBatch;
+
+class LEVELDB_EXPORT ChangeIterator {
+ public:
+  ChangeIterator() = default;
+
+  ChangeIterator(const ChangeIterator&) = delete;
+  ChangeIterator& operator=(const ChangeIterator&) = delete;
+
+  virtual ~ChangeIterator();
+
+  // True if the iterator is positioned at a batch.  False once it has read
+  // every batch committed so far, or after an error.
+  virtual bool Valid() const = 0;
+
+  // Moves to the batch after the current one, if it has been committed.
+  // REQUIRES: Valid()
+  virtual void Next() = 0;
+
+  // If the iterator is not valid, waits up to "timeout_micros" for the next
+  // batch to be committed and positions at it.  Returns Valid().
+  virtual bool Wait(uint64_t timeout_micros) = 0;
+
+  // The sequence number of the first update of the current batch; the
+  // others follow it in the order of the batch.
+  // REQUIRES: Valid()
+  virtual uint64_t sequence() const = 0;
+
+  // The current batch.  Replay it with WriteBatch::Iterate().  It remains
+  // valid until the iterator is moved or deleted.
+  // REQUIRES: Valid()
+  virtual const WriteBatch& batch() const = 0;
+
+  // NotFound if the next batch to read is no longer kept by the change feed,
+  // because newer batches pushed it out or DB::Ingest() loaded data which
+  // the feed does not hold.  The reader has missed updates and must read the
+  // database itself to catch up.
+  virtual Status status() const = 0;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_CHANGE_ITERATOR_H_
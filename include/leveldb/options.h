@@ -0,0 +1,292 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
+#define STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
+
+#include <cstddef>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Cache;
+class Comparator;
+class Env;
+class FilterPolicy;
+class Logger;
+class RateLimiter;
+class Slice;
+class SliceTransform;
+class Snapshot;
+class Statistics;
+
+// DB contents are stored in a set of blocks, each of which holds a
+// sequence of key,value pairs.  Each block may be compressed before
+// being stored in a file.  The following enum describes which
+// compression method (if any) is used to compress a block.
+enum CompressionType {
+  // NOTE: do not change the values of existing entries, as these are
+  // part of the persistent format on disk.
+  kNoCompression = 0x0,
+  kSnappyCompression = 0x1,
+  kZstdCompression = 0x2,
+  // The in-tree LZ block compressor (LzCompress.h); needs no external library
+  kLzCompression = 0x3,
+};
+
+// Options to control the behavior of a database (passed to DB::Open)
+struct LEVELDB_EXPORT Options {
+  // Create an Options object with default values for all fields.
+  Options();
+
+  // -------------------
+  // Parameters that affect behavior
+
+  // Comparator used to define the order of keys in the table.
+  // Default: a comparator that uses lexicographic byte-wise ordering
+  //
+  // REQUIRES: The client must ensure that the comparator supplied
+  // here has the same name and orders keys *exactly* the same as the
+  // comparator provided to previous open calls on the same DB.
+  const Comparator* comparator;
+
+  // If true, the database will be created if it is missing.
+  bool create_if_missing = false;
+
+  // If true, an error is raised if the database already exists.
+  bool error_if_exists = false;
+
+  // If true, the implementation will do aggressive checking of the
+  // data it is processing and will stop early if it detects any
+  // errors.  This may have unforeseen ramifications: for example, a
+  // corruption of one DB entry may cause a large number of entries to
+  // become unreadable or for the entire DB to become unopenable.
+  bool paranoid_checks = false;
+
+  // Use the specified object to interact with the environment,
+  // e.g. to read/write files, schedule background work, etc.
+  // Default: Env::Default()
+  Env* env;
+
+  // Any internal progress/error information generated by the db will
+  // be written to info_log if it is non-null, or to a file stored
+  // in the same directory as the DB contents if info_log is null.
+  Logger* info_log = nullptr;
+
+  // -------------------
+  // Parameters that affect performance
+
+  // Amount of data to build up in memory (backed by an unsorted log
+  // on disk) before converting to a sorted on-disk file.
+  //
+  // Larger values increase performance, especially during bulk loads.
+  // Up to two write buffers may be held in memory at the same time,
+  // so you may wish to adjust this parameter to control memory usage.
+  // Also, a larger write buffer will result in a longer recovery time
+  // the next time the database is opened.
+  size_t write_buffer_size = 4 * 1024 * 1024;
+
+  // Number of open files that can be used by the DB.  You may need to
+  // increase this if your database has a large working set (budget
+  // one open file per 2MB of working set).
+  int max_open_files = 1000;
+
+  // Control over blocks (user data is stored in a set of blocks, and
+  // a block is the unit of reading from disk).
+
+  // If non-null, use the specified cache for blocks.
+  // If null, leveldb will automatically create and use an 8MB internal cache.
+  Cache* block_cache = nullptr;
+
+  // Approximate size of user data packed per block.  Note that the
+  // block size specified here corresponds to uncompressed data.  The
+  // actual size of the unit read from disk may be smaller if
+  // compression is enabled.  This parameter can be changed dynamically.
+  size_t block_size = 4 * 1024;
+
+  // Number of keys between restart points for delta encoding of keys.
+  // This parameter can be changed dynamically.  Most clients should
+  // leave this parameter alone.
+  int block_restart_interval = 16;
+
+  // If true, every data block of the table files written by the database
+  // ends with a hash index from user keys to restart points, so that a
+  // lookup goes straight to the restart interval holding its key instead
+  // of binary searching the restart points.  It takes about 2 bytes per
+  // distinct user key in a block.  Blocks without the index are read as
+  // before; releases without this option cannot read blocks which have it.
+  // Only for tables of internal keys, as written by the database.
+  bool data_block_hash_index = false;
+
+  // Leveldb will write up to this amount of bytes to a file before
+  // switching to a new one.
+  // Most clients should leave this parameter alone.  However if your
+  // filesystem is more efficient with larger files, you could
+  // consider increasing the value.  The downside will be longer
+  // compactions and hence longer latency/performance hiccups.
+  // Another reason to increase this parameter might be when you are
+  // initially populating a large database.
+  size_t max_file_size = 2 * 1024 * 1024;
+
+  // Number of background threads that may flush memtables and compact
+  // table files at the same time.  Compactions that run together never
+  // share an input file, and at most one of them reads level-0, so they
+  // work on different levels or on disjoint key ranges.  A full memtable
+  // is flushed by an idle thread while compactions run, which keeps
+  // writers from stalling behind a long compaction.
+  //
+  // With the default of 1 all background work runs one job at a time on
+  // the Env's background thread; larger values start a thread per job.
+  int max_background_compactions = 1;
+
+  // Number of threads that one large compaction may be split across.  The
+  // input is cut at file boundaries into key ranges of about equal size,
+  // each of which is merged into its own output files.
+  int max_subcompactions = 1;
+
+  // If true, the writers whose batches are committed together each insert
+  // their own batch into the memtable, in parallel, once the group's log
+  // record is written.  Otherwise the thread that writes the log record
+  // inserts the whole group.  Helps when many threads write at once.
+  bool allow_concurrent_memtable_write = false;
+
+  // Compress blocks using the specified compression algorithm.  This
+  // parameter can be changed dynamically.
+  //
+  // Default: kSnappyCompression, which gives lightweight but fast
+  // compression.
+  //
+  // Typical speeds of kSnappyCompression on an Intel(R) Core(TM)2 2.4GHz:
+  //    ~200-500MB/s compression
+  //    ~400-800MB/s decompression
+  // Note that these speeds are significantly faster than most
+  // persistent storage speeds, and therefore it is typically never
+  // worth switching to kNoCompression.  Even if the input data is
+  // incompressible, the kSnappyCompression implementation will
+  // efficiently detect that and will switch to uncompressed mode.
+  //
+  // kLzCompression is always available and behaves similarly; use it
+  // when the library is built without snappy.
+  CompressionType compression = kSnappyCompression;
+
+  // Compression level for zstd.
+  // Currently only the range [-5,22] is supported. Default is 1.
+  int zstd_compression_level = 1;
+
+  // EXPERIMENTAL: If true, append to existing MANIFEST and log files
+  // when a database is opened.  This can significantly speed up open.
+  //
+  // Default: currently false, but may become true later.
+  bool reuse_logs = false;
+
+  // If non-null, use the specified filter policy to reduce disk reads.
+  // Many applications will benefit from passing the result of
+  // NewBloomFilterPolicy() here.
+  const FilterPolicy* filter_policy = nullptr;
+
+  // If non-null together with filter_policy, the filters of each table also
+  // hold the prefixes of its keys, and each table keeps one more filter of
+  // all its prefixes, so that a scan with ReadOptions::iterate_prefix skips
+  // the tables and blocks holding no key with that prefix.  Tables written
+  // without it, or with a transform of another name, are read in full.
+  const SliceTransform* prefix_extractor = nullptr;
+
+  // If non-null, the database counts cache hits, bytes, compactions and
+  // write stalls in *statistics and times its Get() and Write() calls (see
+  // leveldb/statistics.h).  Must outlive the database.
+  Statistics* statistics = nullptr;
+
+  // If non-null, compactions request the bytes they read from their input
+  // tables and write to their output tables from *rate_limiter first (see
+  // leveldb/rate_limiter.h), which caps their bandwidth.  While level-0
+  // holds more files than trigger a compaction, each extra file halves the
+  // bytes charged, and once writes are being slowed down by level-0 the
+  // compactions are not throttled at all.  Must outlive the database.
+  RateLimiter* rate_limiter = nullptr;
+
+  // If non-zero, the database keeps up to this many bytes of the write
+  // batches it most recently committed in memory, and DB::NewChangeIterator()
+  // reads them in sequence order.  Batches still in the log when the
+  // database is opened are included.  Default: 0, no change feed.
+  size_t change_feed_size = 0;
+};
+
+// Options that control read operations
+struct LEVELDB_EXPORT ReadOptions {
+  // If true, all data read from underlying storage will be
+  // verified against corresponding checksums.
+  bool verify_checksums = false;
+
+  // Should the data read for this iteration be cached in memory?
+  // Callers may wish to set this field to false for bulk scans.
+  bool fill_cache = true;
+
+  // If "snapshot" is non-null, read as of the supplied snapshot
+  // (which must belong to the DB that is being read and which must
+  // not have been released).  If "snapshot" is null, use an implicit
+  // snapshot of the state at the beginning of this read operation.
+  const Snapshot* snapshot = nullptr;
+
+  // If non-null, an iterator ends before the first key at or after
+  // *iterate_upper_bound, and a forward scan does not read the table
+  // blocks or files that lie entirely beyond it.  DB::NewIterator() copies
+  // the key, so it only needs to remain valid during that call.  Ignored
+  // by Get() and MultiGet().
+  const Slice* iterate_upper_bound = nullptr;
+
+  // If non-zero, an iterator reads table files that are not memory mapped
+  // in chunks of this many bytes rather than one block at a time, which
+  // turns a sequential scan into a few large reads.  Each open table file
+  // of the iterator holds a buffer of this size.
+  size_t readahead_size = 0;
+
+  // If non-null, an iterator only returns the keys which start with
+  // *iterate_prefix.  When *iterate_prefix is in the domain of
+  // Options::prefix_extractor, the iterator does not read the table files
+  // or blocks whose filters show they hold no key with its prefix.  The keys
+  // starting with a prefix must be adjacent and follow the prefix itself, as
+  // they do with the default comparator.  DB::NewIterator() copies the
+  // prefix.  Ignored by Get() and MultiGet().
+  const Slice* iterate_prefix = nullptr;
+
+  // If non-null, an iterator requests the bytes of every block it reads from
+  // a table file from *rate_limiter first.  Blocks found in the block cache
+  // are not charged.  Ignored by Get() and MultiGet().
+  RateLimiter* rate_limiter = nullptr;
+};
+
+// Options that control write operations
+struct LEVELDB_EXPORT WriteOptions {
+  WriteOptions() = default;
+
+  // If true, the write will be flushed from the operating system
+  // buffer cache (by calling WritableFile::Sync()) before the write
+  // is considered complete.  If this flag is true, writes will be
+  // slower.
+  //
+  // If this flag is false, and the machine crashes, some recent
+  // writes may be lost.  Note that if it is just the process that
+  // crashes (i.e., the machine does not reboot), no writes will be
+  // lost even if sync==false.
+  //
+  // In other words, a DB write with sync==false has similar
+  // crash semantics as the "write()" system call.  A DB write
+  // with sync==true has similar crash semantics to a "write()"
+  // system call followed by "fsync()".
+  bool sync = false;
+};
+
+// Options that control DB::Ingest
+struct LEVELDB_EXPORT IngestOptions {
+  IngestOptions() = default;
+
+  // Number of threads that build table files.  Each source is built by
+  // one thread, so more threads than sources do not help.
+  int max_threads = 4;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_OPTIONS_H_
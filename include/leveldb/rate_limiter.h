@@ -0,0 +1,58 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A RateLimiter caps the bandwidth of background I/O.  With
+// Options::rate_limiter set, compactions charge every block they read from
+// their input tables and every byte they append to their output tables
+// before doing the I/O, so that they leave the disk to the foreground reads.
+// Memtable flushes are not charged, since delaying them stalls writers.
+//
+// One limiter may be shared by several databases, which then share its
+// bandwidth.  All methods are thread-safe.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+#define STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Env;
+
+class LEVELDB_EXPORT RateLimiter {
+ public:
+  virtual ~RateLimiter();
+
+  // Blocks until "bytes" more may be transferred without exceeding the
+  // rate.  A request larger than the burst size is granted in full, and the
+  // requests after it wait until the rate catches up.
+  virtual void Request(size_t bytes) = 0;
+
+  virtual int64_t GetBytesPerSecond() const = 0;
+
+  // Changes the rate; requests already waiting keep their wait.
+  // REQUIRES: bytes_per_second > 0
+  virtual void SetBytesPerSecond(int64_t bytes_per_second) = 0;
+
+  // Bytes requested so far.
+  virtual uint64_t GetTotalBytes() const = 0;
+
+  // Total time requests spent waiting.
+  virtual uint64_t GetThrottledMicros() const = 0;
+};
+
+// Return a new token bucket limiter which grants "bytes_per_second" and
+// lets up to a tenth of a second's worth of bytes through at once after an
+// idle spell.  It reads the clock of "env", Env::Default() if null.  The
+// caller must delete the result after any database that uses it has been
+// closed.
+LEVELDB_EXPORT RateLimiter* NewTokenBucketRateLimiter(int64_t bytes_per_second,
+                                                      Env* env = nullptr);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_RATE_LIMITER_H_
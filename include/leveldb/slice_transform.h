@@ -0,0 +1,49 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A SliceTransform maps a key to its prefix.  With Options::prefix_extractor
+// and Options::filter_policy set, every table stores the prefixes of its keys
+// in its filters, so that a scan of one prefix (ReadOptions::iterate_prefix)
+// can skip the tables and blocks which hold no key with that prefix.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
+#define STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
+
+#include <cstddef>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class Slice;
+
+class LEVELDB_EXPORT SliceTransform {
+ public:
+  virtual ~SliceTransform();
+
+  // The name of the transform.  Tables record the name with their prefix
+  // filters, and only use them while the database is opened with a
+  // transform of the same name, so a transform which maps keys differently
+  // must have a different name.
+  virtual const char* Name() const = 0;
+
+  // Returns the prefix of "key", which must be in the domain.  The result
+  // is a leading part of "key" and points into it.
+  virtual Slice Transform(const Slice& key) const = 0;
+
+  // True if "key" has a prefix.  If a key is in the domain, so is every key
+  // that starts with it, and they share its prefix.  Keys outside the
+  // domain are left out of the filters.
+  virtual bool InDomain(const Slice& key) const = 0;
+};
+
+// Return a new transform whose prefix is the first "prefix_length" bytes of
+// a key; shorter keys are outside its domain.  The caller must delete the
+// result after any database that uses it has been closed.
+LEVELDB_EXPORT const SliceTransform* NewFixedPrefixTransform(
+    size_t prefix_length);
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_SLICE_TRANSFORM_H_
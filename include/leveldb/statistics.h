@@ -0,0 +1,137 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+//
+// A Statistics object counts what a database does: cache hits and misses,
+// bytes read and written, compactions and write stalls, and the latency of
+// Get/Put/Write calls.  Set Options::statistics to collect them; with the
+// default of null no counter is touched and no clock is read.
+//
+// One object may be shared by several databases.  All methods are
+// thread-safe; the counters are relaxed atomics, so a snapshot taken while
+// the database is busy may mix slightly different points in time.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+#define STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "leveldb/export.h"
+
+namespace leveldb {
+
+class LEVELDB_EXPORT Statistics {
+ public:
+  enum Ticker {
+    kBlockCacheHits,    // Data blocks found in Options::block_cache
+    kBlockCacheMisses,  // Data blocks read from a table file
+    kTableCacheHits,    // Table lookups served by the open table cache
+    kTableCacheMisses,  // Table files opened
+    kBlockBytesRead,    // Bytes of data blocks read from table files
+    kBytesRead,         // Bytes of values returned by Get()
+    kBytesWritten,      // Bytes of write batches passed to Write()
+    kWriteStalls,       // Writes delayed or stopped by MakeRoomForWrite()
+    kWriteStallMicros,  // Time those writes waited
+    kRateLimitedBytes,  // Compaction I/O charged to Options::rate_limiter
+    kRateLimitMicros,   // Time compactions waited for it
+    kNumTickers
+  };
+
+  enum Histogram {
+    kGetMicros,
+    kPutMicros,    // Put() and Delete(); also counted in kWriteMicros
+    kWriteMicros,  // Every Write(), including those of Put() and Delete()
+    kFlushMicros,  // Memtable flushes to level 0
+    kCompactionMicros,
+    kNumHistograms
+  };
+
+  // Same as config::kNumLevels.
+  static const int kNumLevels = 7;
+
+  struct HistogramData {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;  // 0 if count is 0
+    uint64_t max;
+    double average;
+    double median;
+    double p95;
+    double p99;
+  };
+
+  // Compactions (and flushes for level 0) that wrote to one level.
+  struct LevelStats {
+    uint64_t compactions;
+    uint64_t micros;
+    uint64_t bytes_read;
+    uint64_t bytes_written;
+  };
+
+  Statistics();
+
+  Statistics(const Statistics&) = delete;
+  Statistics& operator=(const Statistics&) = delete;
+
+  ~Statistics();
+
+  void Record(Ticker ticker, uint64_t count = 1) {
+    tickers_[ticker].fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void Measure(Histogram histogram, uint64_t value);
+
+  // Adds a compaction into "level" which read and wrote the given bytes to
+  // the level's totals.  Does not touch kFlushMicros or kCompactionMicros.
+  void RecordCompaction(int level, uint64_t micros, uint64_t bytes_read,
+                        uint64_t bytes_written);
+
+  uint64_t Get(Ticker ticker) const {
+    return tickers_[ticker].load(std::memory_order_relaxed);
+  }
+
+  HistogramData GetHistogram(Histogram histogram) const;
+
+  LevelStats GetLevelStats(int level) const;
+
+  // Sets every counter back to zero.  Updates that race with Reset() may be
+  // lost or kept.
+  void Reset();
+
+  // Names used when exporting, e.g. "block_cache_hits" and "get_micros".
+  static const char* TickerName(Ticker ticker);
+  static const char* HistogramName(Histogram histogram);
+
+ private:
+  // Values below 4 get a bucket each; each power of two above that is split
+  // into 4 buckets, so a percentile is off by at most 25%.
+  static const int kNumBuckets = 4 + 62 * 4;
+
+  struct HistogramImpl {
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> min;
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> buckets[kNumBuckets];
+  };
+
+  struct LevelImpl {
+    std::atomic<uint64_t> compactions;
+    std::atomic<uint64_t> micros;
+    std::atomic<uint64_t> bytes_read;
+    std::atomic<uint64_t> bytes_written;
+  };
+
+  static int BucketFor(uint64_t value);
+  static uint64_t BucketLimit(int bucket);
+  static double Percentile(const uint64_t* buckets, uint64_t count,
+                           uint64_t min, uint64_t max, double p);
+
+  std::atomic<uint64_t> tickers_[kNumTickers];
+  HistogramImpl histograms_[kNumHistograms];
+  LevelImpl levels_[kNumLevels];
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_STATISTICS_H_
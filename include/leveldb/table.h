@@ -0,0 +1,114 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_INCLUDE_TABLE_H_
+#define STORAGE_LEVELDB_INCLUDE_TABLE_H_
+
+#include <cstdint>
+
+#include "leveldb/export.h"
+#include "leveldb/iterator.h"
+
+namespace leveldb {
+
+class Block;
+class BlockHandle;
+class Footer;
+struct Options;
+class RandomAccessFile;
+struct ReadOptions;
+class TableCache;
+
+// A Table is a sorted map from strings to strings.  Tables are
+// immutable and persistent.  A Table may be safely accessed from
+// multiple threads without external synchronization.
+class LEVELDB_EXPORT Table {
+ public:
+  // Attempt to open the table that is stored in bytes [0..file_size)
+  // of "file", and read the metadata entries necessary to allow
+  // retrieving data from the table.
+  //
+  // If successful, returns ok and sets "*table" to the newly opened
+  // table.  The client should delete "*table" when no longer needed.
+  // If there was an error while initializing the table, sets "*table"
+  // to nullptr and returns a non-ok status.  Does not take ownership of
+  // "*source", but the client must ensure that "source" remains live
+  // for the duration of the returned table's lifetime.
+  //
+  // *file must remain live while this Table is in use.
+  static Status Open(const Options& options, RandomAccessFile* file,
+                     uint64_t file_size, Table** table);
+
+  Table(const Table&) = delete;
+  Table& operator=(const Table&) = delete;
+
+  ~Table();
+
+  // Returns a new iterator over the table contents.
+  // The result of NewIterator() is initially invalid (caller must
+  // call one of the Seek methods on the iterator before using it).
+  //
+  // A ReadOptions::iterate_upper_bound is compared with the table's keys
+  // using options.comparator: moving forward, the iterator becomes invalid
+  // instead of reading a block whose keys are all at or after the bound.
+  // With a ReadOptions::readahead_size, blocks missing from the cache are
+  // read in chunks of that size, and with a ReadOptions::rate_limiter the
+  // reads are requested from it first.
+  //
+  // With a ReadOptions::iterate_prefix, which must be in the form of the
+  // table's keys, the iterator only has to return the keys starting with it:
+  // if the table was built with the filters of options.prefix_extractor,
+  // the table and its blocks whose filters rule the prefix out look empty.
+  Iterator* NewIterator(const ReadOptions&) const;
+
+  // Given a key, return an approximate byte offset in the file where
+  // the data for that key begins (or would begin if the key were
+  // present in the file).  The returned value is in terms of file
+  // bytes, and so includes effects like compression of the underlying data.
+  // E.g., the approximate offset of the last key in the table will
+  // be close to the file length.
+  uint64_t ApproximateOffsetOf(const Slice& key) const;
+
+ private:
+  friend class TableCache;
+  struct Rep;
+
+  static Iterator* BlockReader(void*, const ReadOptions&, const Slice&);
+  static Iterator* IteratorFileBlockReader(void*, const ReadOptions&,
+                                           const Slice&);
+  static Iterator* ReadBlockFrom(Table* table, RandomAccessFile* file,
+                                 const ReadOptions& options,
+                                 const Slice& index_value);
+
+  explicit Table(Rep* rep) : rep_(rep) {}
+
+  // Calls (*handle_result)(arg, ...) with the entry found after a call
+  // to Seek(key).  May not make such a call if filter policy says
+  // that key is not present.
+  Status InternalGet(const ReadOptions&, const Slice& key, void* arg,
+                     void (*handle_result)(void* arg, const Slice& k,
+                                           const Slice& v));
+
+  // Like InternalGet() for "n" keys in increasing order: each index entry
+  // is found once and each data block read once for all the keys in it.
+  // statuses[i] receives the status of keys[i], and args[i] is passed to
+  // handle_result with the entry found for it.
+  void InternalMultiGet(const ReadOptions&, int n, const Slice* keys,
+                        void* const* args, Status* statuses,
+                        void (*handle_result)(void* arg, const Slice& k,
+                                              const Slice& v));
+
+  void ReadMeta(const Footer& footer);
+  void ReadFilter(const Slice& filter_handle_value);
+  void ReadPrefixFilter(const Slice& filter_handle_value);
+  // Sets "*prefix" to the extractor prefix of a scan limited to
+  // options.iterate_prefix; false if the scan cannot be pruned.
+  bool ScanPrefix(const ReadOptions& options, Slice* prefix) const;
+
+  Rep* const rep_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_INCLUDE_TABLE_H_
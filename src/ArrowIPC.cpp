@@ -0,0 +1,1217 @@
+// Implements the Arrow IPC stream writer and reader.  The Arrow metadata is
+// stored as flatbuffers; rather than depending on the flatbuffers library this
+// file contains a minimal builder and a bounds checked table reader which only
+// handle the handful of tables the format needs.
+#include "ArrowIPC.h"
+#include <memory>
+
+namespace ARROW_IPC
+{
+
+// Message header union ids
+#define ARROW_HEADER_SCHEMA 1
+#define ARROW_HEADER_DICTIONARY_BATCH 2
+#define ARROW_HEADER_RECORD_BATCH 3
+
+// Type union ids
+#define ARROW_TYPE_NULL 1
+#define ARROW_TYPE_INT 2
+#define ARROW_TYPE_FLOATING_POINT 3
+#define ARROW_TYPE_BINARY 4
+#define ARROW_TYPE_UTF8 5
+#define ARROW_TYPE_BOOL 6
+#define ARROW_TYPE_DECIMAL 7
+#define ARROW_TYPE_DATE 8
+#define ARROW_TYPE_TIME 9
+#define ARROW_TYPE_TIMESTAMP 10
+#define ARROW_TYPE_INTERVAL 11
+#define ARROW_TYPE_FIXED_SIZE_BINARY 15
+#define ARROW_TYPE_DURATION 18
+#define ARROW_TYPE_LARGE_BINARY 19
+#define ARROW_TYPE_LARGE_UTF8 20
+
+// MetadataVersion V5
+#define ARROW_METADATA_VERSION 4
+
+#define ARROW_CONTINUATION 0xFFFFFFFF
+
+namespace
+{
+
+inline uint64_t alignTo8(uint64_t v)
+{
+    return (v + 7) & ~uint64_t(7);
+}
+
+inline void appendU16(std::string &dest, uint16_t v)
+{
+    dest.push_back(char(v & 0xFF));
+    dest.push_back(char(v >> 8));
+}
+
+inline void appendU32(std::string &dest, uint32_t v)
+{
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        dest.push_back(char((v >> (i * 8)) & 0xFF));
+    }
+}
+
+inline void appendU64(std::string &dest, uint64_t v)
+{
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        dest.push_back(char((v >> (i * 8)) & 0xFF));
+    }
+}
+
+inline void patchU32(std::string &dest, size_t pos, uint32_t v)
+{
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        dest[pos + i] = char((v >> (i * 8)) & 0xFF);
+    }
+}
+
+inline void padTo(std::string &dest, size_t alignment)
+{
+    while (dest.size() % alignment)
+    {
+        dest.push_back(0);
+    }
+}
+
+inline uint16_t readU16(const uint8_t *p)
+{
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+inline uint32_t readU32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline uint64_t readU64(const uint8_t *p)
+{
+    return uint64_t(readU32(p)) | (uint64_t(readU32(p + 4)) << 32);
+}
+
+// A flatbuffer object under construction.  Objects form a tree which is
+// serialized front to back: a table is written before the children it
+// references and the offsets are patched once the children are placed.
+class FlatObject
+{
+public:
+    enum class Kind
+    {
+        table,
+        string,
+        tableVector,
+        structVector,
+    };
+    struct TableField
+    {
+        uint16_t    mId;
+        uint8_t     mSize;
+        uint64_t    mValue;
+        FlatObject  *mChild;
+    };
+
+    Kind                        mKind{Kind::table};
+    std::vector< TableField >   mFields;
+    std::vector< FlatObject * > mChildren;
+    std::string                 mBytes;
+    uint32_t                    mCount{0};
+};
+
+class FlatBuilder
+{
+public:
+    FlatObject *createTable(void)
+    {
+        return create(FlatObject::Kind::table);
+    }
+    FlatObject *createString(const std::string &str)
+    {
+        FlatObject *ret = create(FlatObject::Kind::string);
+        ret->mBytes = str;
+        return ret;
+    }
+    FlatObject *createTableVector(void)
+    {
+        return create(FlatObject::Kind::tableVector);
+    }
+    // Struct vector elements are appended to 'mBytes' by the caller
+    FlatObject *createStructVector(void)
+    {
+        return create(FlatObject::Kind::structVector);
+    }
+
+    static void addScalar(FlatObject *table, uint16_t id, uint8_t size, uint64_t value)
+    {
+        FlatObject::TableField f = { id, size, value, nullptr };
+        table->mFields.push_back(f);
+    }
+    static void addChild(FlatObject *table, uint16_t id, FlatObject *child)
+    {
+        FlatObject::TableField f = { id, 4, 0, child };
+        table->mFields.push_back(f);
+    }
+
+    // Serializes the tree rooted at 'root', padded to 8 bytes
+    void finish(FlatObject *root, std::string &out)
+    {
+        out.clear();
+        appendU32(out, 0);
+        uint32_t pos = write(root, out);
+        patchU32(out, 0, pos);
+        padTo(out, 8);
+    }
+
+private:
+    FlatObject *create(FlatObject::Kind kind)
+    {
+        std::unique_ptr< FlatObject > obj(new FlatObject);
+        obj->mKind = kind;
+        mObjects.push_back(std::move(obj));
+        return mObjects.back().get();
+    }
+
+    // Writes 'obj' and returns its position, which is what offsets point at
+    uint32_t write(FlatObject *obj, std::string &out)
+    {
+        uint32_t ret = 0;
+        switch (obj->mKind)
+        {
+            case FlatObject::Kind::table:
+                ret = writeTable(obj, out);
+                break;
+            case FlatObject::Kind::string:
+                padTo(out, 4);
+                ret = uint32_t(out.size());
+                appendU32(out, uint32_t(obj->mBytes.size()));
+                out += obj->mBytes;
+                out.push_back(0);
+                break;
+            case FlatObject::Kind::tableVector:
+                {
+                    padTo(out, 4);
+                    ret = uint32_t(out.size());
+                    appendU32(out, uint32_t(obj->mChildren.size()));
+                    out.append(obj->mChildren.size() * 4, 0);
+                    for (size_t i = 0; i < obj->mChildren.size(); i++)
+                    {
+                        uint32_t slot = ret + 4 + uint32_t(i) * 4;
+                        uint32_t child = write(obj->mChildren[i], out);
+                        patchU32(out, slot, child - slot);
+                    }
+                }
+                break;
+            case FlatObject::Kind::structVector:
+                // The elements (which contain 64 bit values) must be 8 byte aligned
+                padTo(out, 4);
+                if ((out.size() + 4) % 8)
+                {
+                    appendU32(out, 0);
+                }
+                ret = uint32_t(out.size());
+                appendU32(out, obj->mCount);
+                out += obj->mBytes;
+                break;
+        }
+        return ret;
+    }
+
+    uint32_t writeTable(FlatObject *obj, std::string &out)
+    {
+        // Lay out the fields largest first so each one is naturally aligned
+        std::vector< FlatObject::TableField > fields;
+        for (uint8_t size = 8; size; size >>= 1)
+        {
+            for (auto &f : obj->mFields)
+            {
+                if (f.mSize == size)
+                {
+                    fields.push_back(f);
+                }
+            }
+        }
+        uint16_t idCount = 0;
+        for (auto &f : fields)
+        {
+            if (f.mId + 1 > idCount)
+            {
+                idCount = uint16_t(f.mId + 1);
+            }
+        }
+        std::vector< uint16_t > fieldOffsets(fields.size());
+        std::vector< uint16_t > vtable(idCount, 0);
+        uint32_t tableSize = 4; // the soffset to the vtable
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            tableSize = (tableSize + fields[i].mSize - 1) & ~uint32_t(fields[i].mSize - 1);
+            fieldOffsets[i] = uint16_t(tableSize);
+            vtable[fields[i].mId] = uint16_t(tableSize);
+            tableSize += fields[i].mSize;
+        }
+        tableSize = (tableSize + 3) & ~uint32_t(3);
+
+        // The vtable precedes the table, which starts on an 8 byte boundary
+        padTo(out, 2);
+        if (((out.size() + 4 + idCount * 2) % 8) != 0)
+        {
+            size_t vtablePos = alignTo8(out.size() + 4 + idCount * 2) - (4 + idCount * 2);
+            out.append(vtablePos - out.size(), 0);
+        }
+        uint32_t vtablePos = uint32_t(out.size());
+        appendU16(out, uint16_t(4 + idCount * 2));
+        appendU16(out, uint16_t(tableSize));
+        for (auto v : vtable)
+        {
+            appendU16(out, v);
+        }
+        uint32_t tablePos = uint32_t(out.size());
+        appendU32(out, tablePos - vtablePos);
+        out.append(tableSize - 4, 0);
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            if (fields[i].mChild == nullptr)
+            {
+                for (uint32_t j = 0; j < fields[i].mSize; j++)
+                {
+                    out[tablePos + fieldOffsets[i] + j] = char((fields[i].mValue >> (j * 8)) & 0xFF);
+                }
+            }
+        }
+        for (size_t i = 0; i < fields.size(); i++)
+        {
+            if (fields[i].mChild)
+            {
+                uint32_t slot = tablePos + fieldOffsets[i];
+                uint32_t child = write(fields[i].mChild, out);
+                patchU32(out, slot, child - slot);
+            }
+        }
+        return tablePos;
+    }
+
+    std::vector< std::unique_ptr< FlatObject > > mObjects;
+};
+
+// Read only, bounds checked view of a flatbuffer table
+class FlatTable
+{
+public:
+    FlatTable(void)
+    {
+    }
+    FlatTable(const uint8_t *buf, uint32_t len, uint32_t pos) : mBuffer(buf), mLength(len)
+    {
+        if (inRange(pos, 4))
+        {
+            int32_t soffset = int32_t(readU32(buf + pos));
+            int64_t vtable = int64_t(pos) - soffset;
+            if (vtable >= 0 && inRange(uint64_t(vtable), 4))
+            {
+                uint16_t vtableSize = readU16(buf + vtable);
+                if (vtableSize >= 4 && (vtableSize & 1) == 0 && inRange(uint64_t(vtable), vtableSize))
+                {
+                    mTable = pos;
+                    mVtable = uint32_t(vtable);
+                    mVtableSize = vtableSize;
+                    mTableSize = readU16(buf + vtable + 2);
+                    mValid = inRange(pos, mTableSize);
+                }
+            }
+        }
+    }
+
+    bool isValid(void) const
+    {
+        return mValid;
+    }
+
+    template< typename T >
+    T scalar(uint16_t id, T defaultValue) const
+    {
+        uint32_t pos = fieldPosition(id, sizeof(T));
+        if (pos == 0)
+        {
+            return defaultValue;
+        }
+        uint64_t v = 0;
+        for (uint32_t i = 0; i < sizeof(T); i++)
+        {
+            v |= uint64_t(mBuffer[pos + i]) << (i * 8);
+        }
+        return T(v);
+    }
+
+    bool has(uint16_t id) const
+    {
+        return fieldPosition(id, 1) != 0;
+    }
+
+    FlatTable table(uint16_t id) const
+    {
+        uint32_t target;
+        if (!offsetTarget(id, target))
+        {
+            return FlatTable();
+        }
+        return FlatTable(mBuffer, mLength, target);
+    }
+
+    // Returns the position of the first element and the element count
+    bool vector(uint16_t id, uint32_t elementSize, uint32_t &pos, uint32_t &count) const
+    {
+        uint32_t target;
+        if (!offsetTarget(id, target) || !inRange(target, 4))
+        {
+            return false;
+        }
+        count = readU32(mBuffer + target);
+        pos = target + 4;
+        return inRange(pos, uint64_t(count) * elementSize);
+    }
+
+    // Table element 'index' of a vector returned by 'vector'
+    FlatTable tableElement(uint32_t pos, uint32_t index) const
+    {
+        uint32_t slot = pos + index * 4;
+        return FlatTable(mBuffer, mLength, uint32_t(uint64_t(slot) + readU32(mBuffer + slot)));
+    }
+
+    bool string(uint16_t id, std::string &str) const
+    {
+        uint32_t pos;
+        uint32_t count;
+        if (!vector(id, 1, pos, count))
+        {
+            return false;
+        }
+        str.assign(reinterpret_cast< const char * >(mBuffer + pos), count);
+        return true;
+    }
+
+    const uint8_t *data(uint32_t pos) const
+    {
+        return mBuffer + pos;
+    }
+
+private:
+    bool inRange(uint64_t pos, uint64_t len) const
+    {
+        return pos <= mLength && len <= mLength - pos;
+    }
+
+    // Returns the absolute position of a field, or zero if it is absent
+    uint32_t fieldPosition(uint16_t id, uint32_t size) const
+    {
+        if (!mValid || uint32_t(4 + id * 2 + 2) > mVtableSize)
+        {
+            return 0;
+        }
+        uint16_t offset = readU16(mBuffer + mVtable + 4 + id * 2);
+        if (offset == 0 || uint32_t(offset) + size > mTableSize)
+        {
+            return 0;
+        }
+        return mTable + offset;
+    }
+
+    bool offsetTarget(uint16_t id, uint32_t &target) const
+    {
+        uint32_t pos = fieldPosition(id, 4);
+        if (pos == 0)
+        {
+            return false;
+        }
+        uint64_t t = uint64_t(pos) + readU32(mBuffer + pos);
+        if (t >= mLength)
+        {
+            return false;
+        }
+        target = uint32_t(t);
+        return true;
+    }
+
+    const uint8_t   *mBuffer{nullptr};
+    uint32_t        mLength{0};
+    uint32_t        mTable{0};
+    uint32_t        mVtable{0};
+    uint16_t        mVtableSize{0};
+    uint16_t        mTableSize{0};
+    bool            mValid{false};
+};
+
+FlatObject *createIntType(FlatBuilder &b, uint32_t bitWidth, bool isSigned)
+{
+    FlatObject *ret = b.createTable();
+    FlatBuilder::addScalar(ret, 0, 4, bitWidth);
+    FlatBuilder::addScalar(ret, 1, 1, isSigned ? 1 : 0);
+    return ret;
+}
+
+// Returns the union id and type table for a column type
+uint8_t createType(FlatBuilder &b, ColumnType type, FlatObject *&table)
+{
+    uint8_t ret = ARROW_TYPE_INT;
+    switch (type)
+    {
+        case ColumnType::boolean:
+            ret = ARROW_TYPE_BOOL;
+            table = b.createTable();
+            break;
+        case ColumnType::int8:
+            table = createIntType(b, 8, true);
+            break;
+        case ColumnType::int16:
+            table = createIntType(b, 16, true);
+            break;
+        case ColumnType::int32:
+            table = createIntType(b, 32, true);
+            break;
+        case ColumnType::int64:
+            table = createIntType(b, 64, true);
+            break;
+        case ColumnType::uint8:
+            table = createIntType(b, 8, false);
+            break;
+        case ColumnType::uint16:
+            table = createIntType(b, 16, false);
+            break;
+        case ColumnType::uint32:
+            table = createIntType(b, 32, false);
+            break;
+        case ColumnType::uint64:
+            table = createIntType(b, 64, false);
+            break;
+        case ColumnType::float32:
+        case ColumnType::float64:
+            ret = ARROW_TYPE_FLOATING_POINT;
+            table = b.createTable();
+            FlatBuilder::addScalar(table, 0, 2, type == ColumnType::float32 ? 1 : 2);
+            break;
+        case ColumnType::utf8:
+        case ColumnType::dictionary:
+        case ColumnType::unsupported:
+            ret = ARROW_TYPE_UTF8;
+            table = b.createTable();
+            break;
+    }
+    return ret;
+}
+
+// Appends a Buffer struct (offset, length) and advances the body
+void addBuffer(FlatObject *buffers, std::string &body, const void *data, size_t len)
+{
+    appendU64(buffers->mBytes, body.size());
+    appendU64(buffers->mBytes, len);
+    buffers->mCount++;
+    body.append(static_cast< const char * >(data), len);
+    padTo(body, 8);
+}
+
+void addFieldNode(FlatObject *nodes, uint64_t length, uint64_t nullCount)
+{
+    appendU64(nodes->mBytes, length);
+    appendU64(nodes->mBytes, nullCount);
+    nodes->mCount++;
+}
+
+FlatObject *createMessage(FlatBuilder &b, uint8_t headerType, FlatObject *header, uint64_t bodyLength)
+{
+    FlatObject *ret = b.createTable();
+    FlatBuilder::addScalar(ret, 0, 2, ARROW_METADATA_VERSION);
+    FlatBuilder::addScalar(ret, 1, 1, headerType);
+    FlatBuilder::addChild(ret, 2, header);
+    FlatBuilder::addScalar(ret, 3, 8, bodyLength);
+    return ret;
+}
+
+// Number of buffers each field type consumes in a record batch
+uint32_t getBufferCount(uint8_t typeId)
+{
+    uint32_t ret = 0;
+    switch (typeId)
+    {
+        case ARROW_TYPE_NULL:
+            ret = 0;
+            break;
+        case ARROW_TYPE_INT:
+        case ARROW_TYPE_FLOATING_POINT:
+        case ARROW_TYPE_BOOL:
+        case ARROW_TYPE_DECIMAL:
+        case ARROW_TYPE_DATE:
+        case ARROW_TYPE_TIME:
+        case ARROW_TYPE_TIMESTAMP:
+        case ARROW_TYPE_INTERVAL:
+        case ARROW_TYPE_FIXED_SIZE_BINARY:
+        case ARROW_TYPE_DURATION:
+            ret = 2;
+            break;
+        case ARROW_TYPE_BINARY:
+        case ARROW_TYPE_UTF8:
+        case ARROW_TYPE_LARGE_BINARY:
+        case ARROW_TYPE_LARGE_UTF8:
+            ret = 3;
+            break;
+        default:
+            ret = 0xFFFFFFFF; // nested or unknown layout
+            break;
+    }
+    return ret;
+}
+
+ColumnType getIntType(uint32_t bitWidth, bool isSigned)
+{
+    ColumnType ret = ColumnType::unsupported;
+    switch (bitWidth)
+    {
+        case 8:
+            ret = isSigned ? ColumnType::int8 : ColumnType::uint8;
+            break;
+        case 16:
+            ret = isSigned ? ColumnType::int16 : ColumnType::uint16;
+            break;
+        case 32:
+            ret = isSigned ? ColumnType::int32 : ColumnType::uint32;
+            break;
+        case 64:
+            ret = isSigned ? ColumnType::int64 : ColumnType::uint64;
+            break;
+    }
+    return ret;
+}
+
+}
+
+uint32_t getColumnWidth(ColumnType type)
+{
+    uint32_t ret = 0;
+    switch (type)
+    {
+        case ColumnType::int8:
+        case ColumnType::uint8:
+            ret = 1;
+            break;
+        case ColumnType::int16:
+        case ColumnType::uint16:
+            ret = 2;
+            break;
+        case ColumnType::int32:
+        case ColumnType::uint32:
+        case ColumnType::float32:
+        case ColumnType::dictionary:
+            ret = 4;
+            break;
+        case ColumnType::int64:
+        case ColumnType::uint64:
+        case ColumnType::float64:
+            ret = 8;
+            break;
+        case ColumnType::boolean:
+        case ColumnType::utf8:
+        case ColumnType::unsupported:
+            ret = 0;
+            break;
+    }
+    return ret;
+}
+
+StreamWriter::StreamWriter(std::string &dest) : mDest(dest)
+{
+}
+
+uint32_t StreamWriter::addField(const char *name, ColumnType type, bool nullable)
+{
+    Field f;
+    f.mName = name;
+    f.mType = type;
+    f.mNullable = nullable;
+    mFields.push_back(f);
+    return uint32_t(mFields.size() - 1);
+}
+
+uint32_t StreamWriter::addDictionaryField(const char *name, const std::vector< std::string > &values, bool nullable)
+{
+    uint32_t ret = addField(name, ColumnType::dictionary, nullable);
+    mFields[ret].mDictionary = values;
+    mFields[ret].mDictionaryId = int64_t(ret);
+    return ret;
+}
+
+void StreamWriter::beginRecordBatch(uint64_t rowCount)
+{
+    if (!mSchemaWritten)
+    {
+        writeSchema();
+    }
+    mRowCount = rowCount;
+    for (auto &f : mFields)
+    {
+        f.mNullCount = 0;
+        f.mValidity.clear();
+        if (f.mNullable)
+        {
+            f.mValidity.resize((rowCount + 63) / 64, ~uint64_t(0));
+        }
+        f.mData.clear();
+        f.mOffsets.clear();
+        f.mStrings.clear();
+        if (f.mType == ColumnType::boolean)
+        {
+            f.mData.resize((rowCount + 63) / 64, 0);
+        }
+        else if (f.mType == ColumnType::utf8)
+        {
+            f.mOffsets.reserve(rowCount + 1);
+            f.mOffsets.push_back(0);
+        }
+        else
+        {
+            f.mData.resize((rowCount * getColumnWidth(f.mType) + 7) / 8, 0);
+        }
+    }
+}
+
+void *StreamWriter::getColumn(uint32_t field)
+{
+    return mFields[field].mData.data();
+}
+
+void StreamWriter::setBool(uint32_t field, uint64_t row, bool value)
+{
+    uint64_t &word = mFields[field].mData[row >> 6];
+    uint64_t mask = uint64_t(1) << (row & 63);
+    word = value ? (word | mask) : (word & ~mask);
+}
+
+void StreamWriter::appendString(uint32_t field, const char *str, size_t len)
+{
+    Field &f = mFields[field];
+    f.mStrings.append(str, len);
+    f.mOffsets.push_back(int32_t(f.mStrings.size()));
+}
+
+void StreamWriter::setNull(uint32_t field, uint64_t row)
+{
+    Field &f = mFields[field];
+    if (f.mNullable)
+    {
+        f.mValidity[row >> 6] &= ~(uint64_t(1) << (row & 63));
+        f.mNullCount++;
+    }
+}
+
+void StreamWriter::endRecordBatch(void)
+{
+    FlatBuilder b;
+    FlatObject *batch = b.createTable();
+    FlatObject *nodes = b.createStructVector();
+    FlatObject *buffers = b.createStructVector();
+    std::string body;
+    // Bitmaps are stored as little-endian words which matches Arrow's LSB bit order
+    size_t bitmapBytes = size_t((mRowCount + 7) / 8);
+    for (auto &f : mFields)
+    {
+        addFieldNode(nodes, mRowCount, f.mNullCount);
+        // A validity buffer may be omitted when there are no nulls
+        addBuffer(buffers, body, f.mValidity.data(), f.mNullCount ? bitmapBytes : 0);
+        if (f.mType == ColumnType::utf8)
+        {
+            // Rows which were never appended are empty strings
+            while (f.mOffsets.size() < mRowCount + 1)
+            {
+                f.mOffsets.push_back(int32_t(f.mStrings.size()));
+            }
+            addBuffer(buffers, body, f.mOffsets.data(), size_t(mRowCount + 1) * 4);
+            addBuffer(buffers, body, f.mStrings.data(), f.mStrings.size());
+        }
+        else if (f.mType == ColumnType::boolean)
+        {
+            addBuffer(buffers, body, f.mData.data(), bitmapBytes);
+        }
+        else
+        {
+            addBuffer(buffers, body, f.mData.data(), size_t(mRowCount * getColumnWidth(f.mType)));
+        }
+    }
+    FlatBuilder::addScalar(batch, 0, 8, mRowCount);
+    FlatBuilder::addChild(batch, 1, nodes);
+    FlatBuilder::addChild(batch, 2, buffers);
+    std::string meta;
+    b.finish(createMessage(b, ARROW_HEADER_RECORD_BATCH, batch, body.size()), meta);
+    writeMessage(ARROW_HEADER_RECORD_BATCH, meta, body);
+}
+
+void StreamWriter::finish(void)
+{
+    if (mFinished)
+    {
+        return;
+    }
+    if (!mSchemaWritten)
+    {
+        writeSchema();
+    }
+    mFinished = true;
+    appendU32(mDest, ARROW_CONTINUATION);
+    appendU32(mDest, 0);
+}
+
+void StreamWriter::writeSchema(void)
+{
+    mSchemaWritten = true;
+    {
+        FlatBuilder b;
+        FlatObject *schema = b.createTable();
+        FlatObject *fields = b.createTableVector();
+        for (auto &f : mFields)
+        {
+            FlatObject *field = b.createTable();
+            FlatObject *type = nullptr;
+            uint8_t typeId = createType(b, f.mType, type);
+            FlatBuilder::addChild(field, 0, b.createString(f.mName));
+            FlatBuilder::addScalar(field, 1, 1, f.mNullable ? 1 : 0);
+            FlatBuilder::addScalar(field, 2, 1, typeId);
+            FlatBuilder::addChild(field, 3, type);
+            if (f.mType == ColumnType::dictionary)
+            {
+                FlatObject *encoding = b.createTable();
+                FlatBuilder::addScalar(encoding, 0, 8, uint64_t(f.mDictionaryId));
+                FlatBuilder::addChild(encoding, 1, createIntType(b, 32, true));
+                FlatBuilder::addChild(field, 4, encoding);
+            }
+            FlatBuilder::addChild(field, 5, b.createTableVector());
+            fields->mChildren.push_back(field);
+        }
+        FlatBuilder::addScalar(schema, 0, 2, 0); // little endian
+        FlatBuilder::addChild(schema, 1, fields);
+        std::string meta;
+        b.finish(createMessage(b, ARROW_HEADER_SCHEMA, schema, 0), meta);
+        writeMessage(ARROW_HEADER_SCHEMA, meta, std::string());
+    }
+    for (auto &f : mFields)
+    {
+        if (f.mType != ColumnType::dictionary)
+        {
+            continue;
+        }
+        FlatBuilder b;
+        FlatObject *dictionary = b.createTable();
+        FlatObject *batch = b.createTable();
+        FlatObject *nodes = b.createStructVector();
+        FlatObject *buffers = b.createStructVector();
+        std::vector< int32_t > offsets;
+        std::string strings;
+        offsets.push_back(0);
+        for (auto &v : f.mDictionary)
+        {
+            strings += v;
+            offsets.push_back(int32_t(strings.size()));
+        }
+        std::string body;
+        addFieldNode(nodes, f.mDictionary.size(), 0);
+        addBuffer(buffers, body, nullptr, 0);
+        addBuffer(buffers, body, offsets.data(), offsets.size() * 4);
+        addBuffer(buffers, body, strings.data(), strings.size());
+        FlatBuilder::addScalar(batch, 0, 8, f.mDictionary.size());
+        FlatBuilder::addChild(batch, 1, nodes);
+        FlatBuilder::addChild(batch, 2, buffers);
+        FlatBuilder::addScalar(dictionary, 0, 8, uint64_t(f.mDictionaryId));
+        FlatBuilder::addChild(dictionary, 1, batch);
+        std::string meta;
+        b.finish(createMessage(b, ARROW_HEADER_DICTIONARY_BATCH, dictionary, body.size()), meta);
+        writeMessage(ARROW_HEADER_DICTIONARY_BATCH, meta, body);
+    }
+}
+
+void StreamWriter::writeMessage(uint8_t /*headerType*/, const std::string &flatBuffer, const std::string &body)
+{
+    // The metadata length includes padding so the body starts 8 byte aligned
+    appendU32(mDest, ARROW_CONTINUATION);
+    appendU32(mDest, uint32_t(flatBuffer.size()));
+    mDest += flatBuffer;
+    mDest += body;
+}
+
+StreamReader::StreamReader(const void *data, size_t len) : mData(static_cast< const uint8_t * >(data)), mLength(len)
+{
+    if (mData == nullptr)
+    {
+        mLength = 0;
+    }
+}
+
+bool StreamReader::nextMessage(uint8_t &headerType, const uint8_t *&meta, uint32_t &metaLen, const uint8_t *&body, uint64_t &bodyLen)
+{
+    if (mLength - mPosition < 4)
+    {
+        // A stream without an end of stream marker simply ends
+        return false;
+    }
+    uint32_t length = readU32(mData + mPosition);
+    mPosition += 4;
+    if (length == ARROW_CONTINUATION)
+    {
+        if (mLength - mPosition < 4)
+        {
+            return fail();
+        }
+        length = readU32(mData + mPosition);
+        mPosition += 4;
+    }
+    if (length == 0)
+    {
+        return false; // end of stream
+    }
+    if (length > mLength - mPosition || length >= 0x80000000)
+    {
+        return fail();
+    }
+    meta = mData + mPosition;
+    metaLen = length;
+    mPosition += length;
+
+    FlatTable message(meta, metaLen, metaLen >= 4 ? readU32(meta) : metaLen);
+    if (!message.isValid())
+    {
+        return fail();
+    }
+    headerType = message.scalar< uint8_t >(1, 0);
+    int64_t bodyLength = message.scalar< int64_t >(3, 0);
+    if (bodyLength < 0 || uint64_t(bodyLength) > mLength - mPosition)
+    {
+        return fail();
+    }
+    body = mData + mPosition;
+    bodyLen = uint64_t(bodyLength);
+    mPosition += size_t(bodyLength);
+    return true;
+}
+
+bool StreamReader::readSchema(void)
+{
+    uint8_t headerType;
+    const uint8_t *meta;
+    uint32_t metaLen;
+    const uint8_t *body;
+    uint64_t bodyLen;
+    if (!nextMessage(headerType, meta, metaLen, body, bodyLen) || headerType != ARROW_HEADER_SCHEMA)
+    {
+        return fail();
+    }
+    FlatTable message(meta, metaLen, readU32(meta));
+    FlatTable schema = message.table(2);
+    uint32_t pos;
+    uint32_t count;
+    if (!schema.isValid() || schema.scalar< int16_t >(0, 0) != 0 || !schema.vector(1, 4, pos, count))
+    {
+        return fail(); // big endian streams are not supported
+    }
+    mFields.clear();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        FlatTable field = schema.tableElement(pos, i);
+        if (!field.isValid())
+        {
+            return fail();
+        }
+        Field f;
+        field.string(0, f.mName);
+        uint8_t typeId = field.scalar< uint8_t >(2, 0);
+        FlatTable type = field.table(3);
+        uint32_t childPos;
+        uint32_t childCount = 0;
+        if (field.vector(5, 4, childPos, childCount) && childCount)
+        {
+            return fail();
+        }
+        f.mBufferCount = getBufferCount(typeId);
+        if (f.mBufferCount == 0xFFFFFFFF)
+        {
+            return fail();
+        }
+        switch (typeId)
+        {
+            case ARROW_TYPE_INT:
+                f.mType = getIntType(type.scalar< uint32_t >(0, 0), type.scalar< uint8_t >(1, 0) != 0);
+                break;
+            case ARROW_TYPE_FLOATING_POINT:
+                {
+                    int16_t precision = type.scalar< int16_t >(0, 0);
+                    f.mType = precision == 1 ? ColumnType::float32 : precision == 2 ? ColumnType::float64 : ColumnType::unsupported;
+                }
+                break;
+            case ARROW_TYPE_BOOL:
+                f.mType = ColumnType::boolean;
+                break;
+            case ARROW_TYPE_UTF8:
+                f.mType = ColumnType::utf8;
+                break;
+        }
+        FlatTable encoding = field.table(4);
+        if (encoding.isValid())
+        {
+            // Dictionary encoded columns store just the validity and index buffers
+            f.mBufferCount = 2;
+            f.mDictionaryId = encoding.scalar< int64_t >(0, 0);
+            FlatTable indexType = encoding.table(1);
+            uint32_t bitWidth = indexType.isValid() ? indexType.scalar< uint32_t >(0, 0) : 32;
+            f.mIndexSigned = indexType.isValid() ? indexType.scalar< uint8_t >(1, 0) != 0 : true;
+            f.mIndexWidth = bitWidth / 8;
+            if (f.mType != ColumnType::utf8 || (bitWidth != 8 && bitWidth != 16 && bitWidth != 32 && bitWidth != 64))
+            {
+                f.mType = ColumnType::unsupported;
+            }
+            else
+            {
+                f.mType = ColumnType::dictionary;
+            }
+            size_t slot = 0;
+            while (slot < mDictionaryIds.size() && mDictionaryIds[slot] != f.mDictionaryId)
+            {
+                slot++;
+            }
+            if (slot == mDictionaryIds.size())
+            {
+                mDictionaryIds.push_back(f.mDictionaryId);
+                mDictionaries.push_back(std::vector< std::string >());
+            }
+            f.mDictionarySlot = uint32_t(slot);
+        }
+        mFields.push_back(f);
+    }
+    mColumns.resize(mFields.size());
+    return true;
+}
+
+int32_t StreamReader::findField(const char *name) const
+{
+    for (size_t i = 0; i < mFields.size(); i++)
+    {
+        if (mFields[i].mName == name)
+        {
+            return int32_t(i);
+        }
+    }
+    return -1;
+}
+
+bool StreamReader::nextRecordBatch(void)
+{
+    mRowCount = 0;
+    for (;;)
+    {
+        uint8_t headerType;
+        const uint8_t *meta;
+        uint32_t metaLen;
+        const uint8_t *body;
+        uint64_t bodyLen;
+        if (!mValid || !nextMessage(headerType, meta, metaLen, body, bodyLen))
+        {
+            return false;
+        }
+        FlatTable message(meta, metaLen, readU32(meta));
+        FlatTable header = message.table(2);
+        if (headerType == ARROW_HEADER_DICTIONARY_BATCH)
+        {
+            if (!header.isValid())
+            {
+                return fail();
+            }
+            int64_t id = header.scalar< int64_t >(0, 0);
+            bool isDelta = header.scalar< uint8_t >(2, 0) != 0;
+            FlatTable batch = header.table(1);
+            uint32_t nodePos;
+            uint32_t nodeCount;
+            uint32_t bufferPos;
+            uint32_t bufferCount;
+            if (!batch.isValid() || batch.has(3) ||
+                !batch.vector(1, 16, nodePos, nodeCount) || nodeCount != 1 ||
+                !batch.vector(2, 16, bufferPos, bufferCount) || bufferCount != 3)
+            {
+                return fail();
+            }
+            uint64_t length = readU64(batch.data(nodePos));
+            uint64_t offsetsPos = readU64(batch.data(bufferPos + 16));
+            uint64_t offsetsLen = readU64(batch.data(bufferPos + 24));
+            uint64_t stringsPos = readU64(batch.data(bufferPos + 32));
+            uint64_t stringsLen = readU64(batch.data(bufferPos + 40));
+            if (offsetsPos > bodyLen || offsetsLen > bodyLen - offsetsPos || stringsPos > bodyLen || stringsLen > bodyLen - stringsPos ||
+                length >= offsetsLen / 4)
+            {
+                return fail();
+            }
+            size_t slot = 0;
+            while (slot < mDictionaryIds.size() && mDictionaryIds[slot] != id)
+            {
+                slot++;
+            }
+            if (slot == mDictionaryIds.size())
+            {
+                continue; // not referenced by any field
+            }
+            std::vector< std::string > &values = mDictionaries[slot];
+            if (!isDelta)
+            {
+                values.clear();
+            }
+            const uint8_t *offsets = body + offsetsPos;
+            const char *strings = reinterpret_cast< const char * >(body + stringsPos);
+            for (uint64_t i = 0; i < length; i++)
+            {
+                uint32_t start = readU32(offsets + i * 4);
+                uint32_t end = readU32(offsets + i * 4 + 4);
+                if (start > end || end > stringsLen)
+                {
+                    return fail();
+                }
+                values.push_back(std::string(strings + start, end - start));
+            }
+        }
+        else if (headerType == ARROW_HEADER_RECORD_BATCH)
+        {
+            uint32_t nodePos;
+            uint32_t nodeCount;
+            uint32_t bufferPos;
+            uint32_t bufferCount;
+            // Compressed bodies are not supported
+            if (!header.isValid() || header.has(3) ||
+                !header.vector(1, 16, nodePos, nodeCount) || nodeCount != mFields.size() ||
+                !header.vector(2, 16, bufferPos, bufferCount))
+            {
+                return fail();
+            }
+            int64_t length = header.scalar< int64_t >(0, 0);
+            if (length < 0)
+            {
+                return fail();
+            }
+            uint64_t rows = uint64_t(length);
+            uint32_t buffer = 0;
+            for (size_t i = 0; i < mFields.size(); i++)
+            {
+                const Field &f = mFields[i];
+                Column &c = mColumns[i];
+                c = Column();
+                if (buffer + f.mBufferCount > bufferCount)
+                {
+                    return fail();
+                }
+                if (readU64(header.data(nodePos + uint32_t(i) * 16)) != rows)
+                {
+                    return fail();
+                }
+                const uint8_t *buffers[3] = { nullptr, nullptr, nullptr };
+                uint64_t lengths[3] = { 0, 0, 0 };
+                for (uint32_t j = 0; j < f.mBufferCount; j++, buffer++)
+                {
+                    uint64_t offset = readU64(header.data(bufferPos + buffer * 16));
+                    uint64_t len = readU64(header.data(bufferPos + buffer * 16 + 8));
+                    if (offset > bodyLen || len > bodyLen - offset)
+                    {
+                        return fail();
+                    }
+                    buffers[j] = body + offset;
+                    lengths[j] = len;
+                }
+                uint64_t bitmapBytes = (rows + 7) / 8;
+                if (lengths[0])
+                {
+                    if (lengths[0] < bitmapBytes)
+                    {
+                        return fail();
+                    }
+                    c.mValidity = buffers[0];
+                }
+                c.mData = buffers[1];
+                c.mDataLength = lengths[1];
+                switch (f.mType)
+                {
+                    case ColumnType::boolean:
+                        if (lengths[1] < bitmapBytes)
+                        {
+                            return fail();
+                        }
+                        break;
+                    case ColumnType::utf8:
+                        if (rows && lengths[1] < (rows + 1) * 4)
+                        {
+                            return fail();
+                        }
+                        c.mOffsets = buffers[1];
+                        c.mData = buffers[2];
+                        c.mDataLength = lengths[2];
+                        break;
+                    case ColumnType::dictionary:
+                        if (lengths[1] < rows * f.mIndexWidth)
+                        {
+                            return fail();
+                        }
+                        break;
+                    case ColumnType::unsupported:
+                        break;
+                    default:
+                        if (lengths[1] < rows * getColumnWidth(f.mType))
+                        {
+                            return fail();
+                        }
+                        break;
+                }
+            }
+            mRowCount = rows;
+            return true;
+        }
+        else
+        {
+            return fail();
+        }
+    }
+}
+
+const char *StreamReader::getString(uint32_t field, uint64_t row, size_t &len) const
+{
+    const Column &c = mColumns[field];
+    uint32_t start = readU32(c.mOffsets + row * 4);
+    uint32_t end = readU32(c.mOffsets + row * 4 + 4);
+    if (start > end || end > c.mDataLength)
+    {
+        len = 0;
+        return nullptr;
+    }
+    len = end - start;
+    return reinterpret_cast< const char * >(c.mData + start);
+}
+
+int64_t StreamReader::getDictionaryIndex(uint32_t field, uint64_t row) const
+{
+    const Field &f = mFields[field];
+    const uint8_t *p = mColumns[field].mData + row * f.mIndexWidth;
+    int64_t ret = 0;
+    switch (f.mIndexWidth)
+    {
+        case 1:
+            ret = f.mIndexSigned ? int64_t(int8_t(p[0])) : int64_t(p[0]);
+            break;
+        case 2:
+            ret = f.mIndexSigned ? int64_t(int16_t(readU16(p))) : int64_t(readU16(p));
+            break;
+        case 4:
+            ret = f.mIndexSigned ? int64_t(int32_t(readU32(p))) : int64_t(readU32(p));
+            break;
+        case 8:
+            ret = int64_t(readU64(p));
+            break;
+    }
+    return ret;
+}
+
+uint32_t StreamReader::getDictionaryCount(uint32_t field) const
+{
+    return uint32_t(mDictionaries[mFields[field].mDictionarySlot].size());
+}
+
+} // end of ARROW_IPC namespace
@@ -0,0 +1,93 @@
+// Implements the sorted runs used by the generated '<Class>Store::ingest'
+#include "BulkIngest.h"
+#include <algorithm>
+#include <utility>
+
+namespace BULK_INGEST
+{
+
+SortedRun::SortedRun(ValueFunction valueFunction)
+    : mValueFunction(std::move(valueFunction))
+{
+}
+
+void SortedRun::reserve(size_t count)
+{
+    mEntries.reserve(count);
+}
+
+void SortedRun::add(std::string key, size_t record)
+{
+    Entry e;
+    e.mKey = std::move(key);
+    e.mRecord = record;
+    mEntries.push_back(std::move(e));
+}
+
+void SortedRun::sort(void)
+{
+    std::stable_sort(mEntries.begin(), mEntries.end(), [](const Entry &a, const Entry &b)
+    {
+        return a.mKey < b.mKey;
+    });
+    // Keep the last of every group of equal keys
+    size_t count = 0;
+    for (size_t i = 0; i < mEntries.size(); i++)
+    {
+        if (i + 1 < mEntries.size() && mEntries[i + 1].mKey == mEntries[i].mKey)
+        {
+            continue;
+        }
+        if (count != i)
+        {
+            mEntries[count] = std::move(mEntries[i]);
+        }
+        count++;
+    }
+    mEntries.resize(count);
+}
+
+size_t SortedRun::size(void) const
+{
+    return mEntries.size();
+}
+
+const std::string &SortedRun::getKey(size_t i) const
+{
+    return mEntries[i].mKey;
+}
+
+size_t SortedRun::getRecord(size_t i) const
+{
+    return mEntries[i].mRecord;
+}
+
+void SortedRun::split(size_t parts, std::vector< std::unique_ptr< RunSlice > > &slices) const
+{
+    size_t count = mEntries.size();
+    parts = std::min(parts, (count + MIN_SLICE_ENTRIES - 1) / MIN_SLICE_ENTRIES);
+    for (size_t i = 0; i < parts; i++)
+    {
+        slices.emplace_back(new RunSlice(*this, count * i / parts, count * (i + 1) / parts));
+    }
+}
+
+RunSlice::RunSlice(const SortedRun &run, size_t begin, size_t end)
+    : mRun(run), mNext(begin), mEnd(end)
+{
+}
+
+bool RunSlice::Next(leveldb::Slice *key, leveldb::Slice *value)
+{
+    if (mNext == mEnd)
+    {
+        return false;
+    }
+    const SortedRun::Entry &e = mRun.mEntries[mNext++];
+    mRun.mValueFunction(e.mRecord, mValue);
+    *key = e.mKey;
+    *value = mValue;
+    return true;
+}
+
+} // end of BULK_INGEST namespace
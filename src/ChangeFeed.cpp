@@ -0,0 +1,150 @@
+// Implements the change feed reader used by the generated '<Class>ChangeFeed'
+#include "ChangeFeed.h"
+#include "leveldb/change_iterator.h"
+#include "leveldb/db.h"
+#include "leveldb/slice.h"
+#include "leveldb/write_batch.h"
+#include <utility>
+
+namespace CHANGE_FEED
+{
+
+// Keeps the writes of a batch which fall under the prefix and come after the
+// last sequence number read
+class ChangeReader::Collector : public leveldb::WriteBatch::Handler
+{
+public:
+    Collector(ChangeReader &reader, uint64_t sequence) : mReader(reader), mSequence(sequence)
+    {
+    }
+
+    void Put(const leveldb::Slice &key, const leveldb::Slice &value) override
+    {
+        Change *change = add(key);
+        if ( change )
+        {
+            change->mValue.assign(value.data(), value.size());
+        }
+    }
+
+    void Delete(const leveldb::Slice &key) override
+    {
+        Change *change = add(key);
+        if ( change )
+        {
+            change->mErased = true;
+        }
+    }
+
+    uint64_t getNextSequence(void) const
+    {
+        return mSequence;
+    }
+
+private:
+    Change *add(const leveldb::Slice &key)
+    {
+        uint64_t sequence = mSequence++;
+        if ( sequence <= mReader.mSequence || !key.starts_with(mReader.mPrefix) )
+        {
+            return nullptr;
+        }
+        mReader.mPending.emplace_back();
+        Change &change = mReader.mPending.back();
+        change.mKey.assign(key.data() + mReader.mPrefix.size(), key.size() - mReader.mPrefix.size());
+        change.mSequence = sequence;
+        return &change;
+    }
+
+    ChangeReader    &mReader;
+    uint64_t        mSequence;
+};
+
+ChangeReader::ChangeReader(leveldb::DB *db, const std::string &prefix, uint64_t sequence)
+    : mPrefix(prefix), mSequence(sequence)
+{
+    leveldb::Status s = db->NewChangeIterator(sequence == 0 ? 0 : sequence + 1, &mIterator);
+    if ( !s.ok() )
+    {
+        mOk = false;
+        mLastError = s.ToString();
+    }
+}
+
+ChangeReader::~ChangeReader(void)
+{
+    delete mIterator;
+}
+
+bool ChangeReader::next(Change &change, uint64_t timeoutMicros)
+{
+    bool waited = false;
+    while ( mPending.empty() )
+    {
+        if ( !mOk )
+        {
+            return false;
+        }
+        if ( !mIterator->Valid() )
+        {
+            // Wait at most once per call, then report that nothing came
+            if ( waited || !mIterator->Wait(timeoutMicros) )
+            {
+                if ( !mIterator->status().ok() )
+                {
+                    mOk = false;
+                    mLastError = mIterator->status().ToString();
+                }
+                return false;
+            }
+            waited = true;
+        }
+        if ( !readBatch() )
+        {
+            return false;
+        }
+    }
+    change = std::move(mPending.front());
+    mPending.pop_front();
+    mSequence = mPending.empty() ? mBatchLast : change.mSequence;
+    return true;
+}
+
+// Reads the batch the iterator is positioned at into mPending and moves on
+bool ChangeReader::readBatch(void)
+{
+    const leveldb::WriteBatch &batch = mIterator->batch();
+    Collector collector(*this, mIterator->sequence());
+    leveldb::Status s = batch.Iterate(&collector);
+    if ( !s.ok() )
+    {
+        mPending.clear();
+        mOk = false;
+        mLastError = s.ToString();
+        return false;
+    }
+    mBatchLast = collector.getNextSequence() - 1;
+    if ( mPending.empty() )
+    {
+        mSequence = mBatchLast;
+    }
+    mIterator->Next();
+    return true;
+}
+
+uint64_t ChangeReader::getSequence(void) const
+{
+    return mSequence;
+}
+
+bool ChangeReader::ok(void) const
+{
+    return mOk;
+}
+
+const std::string &ChangeReader::getLastError(void) const
+{
+    return mLastError;
+}
+
+} // end of CHANGE_FEED namespace
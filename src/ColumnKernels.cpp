@@ -0,0 +1,213 @@
+// Implements the floating point column reductions.  SSE2 is part of the
+// x86-64 baseline so no runtime dispatch is needed; other targets use the
+// generic four accumulator loops.
+#include "ColumnKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define COLUMN_KERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace COLUMN_KERNELS
+{
+
+#ifdef COLUMN_KERNELS_SSE2
+
+static double horizontalSum(__m128d v)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+double sum(const double *values, size_t count)
+{
+    __m128d s0 = _mm_setzero_pd();
+    __m128d s1 = _mm_setzero_pd();
+    __m128d s2 = _mm_setzero_pd();
+    __m128d s3 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        s0 = _mm_add_pd(s0, _mm_loadu_pd(values + i));
+        s1 = _mm_add_pd(s1, _mm_loadu_pd(values + i + 2));
+        s2 = _mm_add_pd(s2, _mm_loadu_pd(values + i + 4));
+        s3 = _mm_add_pd(s3, _mm_loadu_pd(values + i + 6));
+    }
+    double ret = horizontalSum(_mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+    for (; i < count; i++)
+    {
+        ret += values[i];
+    }
+    return ret;
+}
+
+double sum(const float *values, size_t count)
+{
+    __m128d s0 = _mm_setzero_pd();
+    __m128d s1 = _mm_setzero_pd();
+    __m128d s2 = _mm_setzero_pd();
+    __m128d s3 = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128 a = _mm_loadu_ps(values + i);
+        __m128 b = _mm_loadu_ps(values + i + 4);
+        s0 = _mm_add_pd(s0, _mm_cvtps_pd(a));
+        s1 = _mm_add_pd(s1, _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+        s2 = _mm_add_pd(s2, _mm_cvtps_pd(b));
+        s3 = _mm_add_pd(s3, _mm_cvtps_pd(_mm_movehl_ps(b, b)));
+    }
+    double ret = horizontalSum(_mm_add_pd(_mm_add_pd(s0, s1), _mm_add_pd(s2, s3)));
+    for (; i < count; i++)
+    {
+        ret += double(values[i]);
+    }
+    return ret;
+}
+
+double minimum(const double *values, size_t count)
+{
+    if (count < 8)
+    {
+        return minimum< double >(values, count);
+    }
+    __m128d m0 = _mm_loadu_pd(values);
+    __m128d m1 = _mm_loadu_pd(values + 2);
+    __m128d m2 = _mm_loadu_pd(values + 4);
+    __m128d m3 = _mm_loadu_pd(values + 6);
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8)
+    {
+        m0 = _mm_min_pd(m0, _mm_loadu_pd(values + i));
+        m1 = _mm_min_pd(m1, _mm_loadu_pd(values + i + 2));
+        m2 = _mm_min_pd(m2, _mm_loadu_pd(values + i + 4));
+        m3 = _mm_min_pd(m3, _mm_loadu_pd(values + i + 6));
+    }
+    __m128d m = _mm_min_pd(_mm_min_pd(m0, m1), _mm_min_pd(m2, m3));
+    double ret = _mm_cvtsd_f64(_mm_min_sd(m, _mm_unpackhi_pd(m, m)));
+    for (; i < count; i++)
+    {
+        ret = values[i] < ret ? values[i] : ret;
+    }
+    return ret;
+}
+
+double maximum(const double *values, size_t count)
+{
+    if (count < 8)
+    {
+        return maximum< double >(values, count);
+    }
+    __m128d m0 = _mm_loadu_pd(values);
+    __m128d m1 = _mm_loadu_pd(values + 2);
+    __m128d m2 = _mm_loadu_pd(values + 4);
+    __m128d m3 = _mm_loadu_pd(values + 6);
+    size_t i = 8;
+    for (; i + 8 <= count; i += 8)
+    {
+        m0 = _mm_max_pd(m0, _mm_loadu_pd(values + i));
+        m1 = _mm_max_pd(m1, _mm_loadu_pd(values + i + 2));
+        m2 = _mm_max_pd(m2, _mm_loadu_pd(values + i + 4));
+        m3 = _mm_max_pd(m3, _mm_loadu_pd(values + i + 6));
+    }
+    __m128d m = _mm_max_pd(_mm_max_pd(m0, m1), _mm_max_pd(m2, m3));
+    double ret = _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+    for (; i < count; i++)
+    {
+        ret = values[i] > ret ? values[i] : ret;
+    }
+    return ret;
+}
+
+float minimum(const float *values, size_t count)
+{
+    if (count < 16)
+    {
+        return minimum< float >(values, count);
+    }
+    __m128 m0 = _mm_loadu_ps(values);
+    __m128 m1 = _mm_loadu_ps(values + 4);
+    __m128 m2 = _mm_loadu_ps(values + 8);
+    __m128 m3 = _mm_loadu_ps(values + 12);
+    size_t i = 16;
+    for (; i + 16 <= count; i += 16)
+    {
+        m0 = _mm_min_ps(m0, _mm_loadu_ps(values + i));
+        m1 = _mm_min_ps(m1, _mm_loadu_ps(values + i + 4));
+        m2 = _mm_min_ps(m2, _mm_loadu_ps(values + i + 8));
+        m3 = _mm_min_ps(m3, _mm_loadu_ps(values + i + 12));
+    }
+    __m128 m = _mm_min_ps(_mm_min_ps(m0, m1), _mm_min_ps(m2, m3));
+    m = _mm_min_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_min_ss(m, _mm_shuffle_ps(m, m, 1));
+    float ret = _mm_cvtss_f32(m);
+    for (; i < count; i++)
+    {
+        ret = values[i] < ret ? values[i] : ret;
+    }
+    return ret;
+}
+
+float maximum(const float *values, size_t count)
+{
+    if (count < 16)
+    {
+        return maximum< float >(values, count);
+    }
+    __m128 m0 = _mm_loadu_ps(values);
+    __m128 m1 = _mm_loadu_ps(values + 4);
+    __m128 m2 = _mm_loadu_ps(values + 8);
+    __m128 m3 = _mm_loadu_ps(values + 12);
+    size_t i = 16;
+    for (; i + 16 <= count; i += 16)
+    {
+        m0 = _mm_max_ps(m0, _mm_loadu_ps(values + i));
+        m1 = _mm_max_ps(m1, _mm_loadu_ps(values + i + 4));
+        m2 = _mm_max_ps(m2, _mm_loadu_ps(values + i + 8));
+        m3 = _mm_max_ps(m3, _mm_loadu_ps(values + i + 12));
+    }
+    __m128 m = _mm_max_ps(_mm_max_ps(m0, m1), _mm_max_ps(m2, m3));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    float ret = _mm_cvtss_f32(m);
+    for (; i < count; i++)
+    {
+        ret = values[i] > ret ? values[i] : ret;
+    }
+    return ret;
+}
+
+#else
+
+double sum(const double *values, size_t count)
+{
+    return sum< double >(values, count);
+}
+
+double sum(const float *values, size_t count)
+{
+    return sum< float >(values, count);
+}
+
+double minimum(const double *values, size_t count)
+{
+    return minimum< double >(values, count);
+}
+
+float minimum(const float *values, size_t count)
+{
+    return minimum< float >(values, count);
+}
+
+double maximum(const double *values, size_t count)
+{
+    return maximum< double >(values, count);
+}
+
+float maximum(const float *values, size_t count)
+{
+    return maximum< float >(values, count);
+}
+
+#endif
+
+} // end of COLUMN_KERNELS namespace
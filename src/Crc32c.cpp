@@ -0,0 +1,282 @@
+// Implements CRC-32C with a run time choice between the SSE4.2 crc32
+// instruction and a slicing-by-8 fallback
+#include "Crc32c.h"
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CRC32C_SSE42 1
+#include <nmmintrin.h>
+#else
+#define CRC32C_SSE42 0
+#endif
+
+namespace CRC32C
+{
+
+// The reflected Castagnoli polynomial
+#define CRC32C_POLY 0x82f63b78u
+
+// Bytes per stream of the interleaved crc32 loops
+#define CRC32C_LONG_BLOCK 8192
+#define CRC32C_SHORT_BLOCK 256
+
+struct Tables
+{
+    uint32_t    mSlice[8][256];     // slicing-by-8; mSlice[0] advances the register by one byte
+    uint32_t    mLong[4][256];      // advances the register over CRC32C_LONG_BLOCK zero bytes
+    uint32_t    mShort[4][256];     // advances the register over CRC32C_SHORT_BLOCK zero bytes
+    bool        mAccelerated{false};
+};
+
+// Fills 'table' so that shift(table, x) feeds 'len' zero bytes through a
+// register holding 'x'.  Doing so is linear in 'x', so it is enough to run
+// the 32 single bit registers through and combine their results.
+static void buildShiftTable(const uint32_t *byteTable, size_t len, uint32_t table[4][256])
+{
+    uint32_t bits[32];
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        uint32_t v = 1u << i;
+        for (size_t j = 0; j < len; j++)
+        {
+            v = byteTable[v & 0xff] ^ (v >> 8);
+        }
+        bits[i] = v;
+    }
+    for (uint32_t k = 0; k < 4; k++)
+    {
+        for (uint32_t b = 0; b < 256; b++)
+        {
+            uint32_t v = 0;
+            for (uint32_t i = 0; i < 8; i++)
+            {
+                if (b & (1u << i))
+                {
+                    v ^= bits[k * 8 + i];
+                }
+            }
+            table[k][b] = v;
+        }
+    }
+}
+
+static inline uint32_t shift(const uint32_t table[4][256], uint32_t crc)
+{
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^ table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+
+static Tables buildTables(void)
+{
+    Tables t;
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        uint32_t v = i;
+        for (uint32_t j = 0; j < 8; j++)
+        {
+            v = (v >> 1) ^ ((v & 1) ? CRC32C_POLY : 0);
+        }
+        t.mSlice[0][i] = v;
+    }
+    for (uint32_t k = 1; k < 8; k++)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t v = t.mSlice[k - 1][i];
+            t.mSlice[k][i] = (v >> 8) ^ t.mSlice[0][v & 0xff];
+        }
+    }
+    buildShiftTable(t.mSlice[0], CRC32C_LONG_BLOCK, t.mLong);
+    buildShiftTable(t.mSlice[0], CRC32C_SHORT_BLOCK, t.mShort);
+#if CRC32C_SSE42
+    t.mAccelerated = __builtin_cpu_supports("sse4.2") != 0;
+#endif
+    return t;
+}
+
+static const Tables &getTables(void)
+{
+    static const Tables tables = buildTables();
+    return tables;
+}
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+// Slicing-by-8: eight table lookups advance the register by eight bytes
+static uint32_t extendPortable(const Tables &t, uint32_t crc, const uint8_t *p, size_t len)
+{
+    uint32_t l = crc ^ 0xffffffffu;
+    while (len >= 8)
+    {
+        uint32_t lo = read32(p) ^ l;
+        uint32_t hi = read32(p + 4);
+        l = t.mSlice[7][lo & 0xff] ^ t.mSlice[6][(lo >> 8) & 0xff] ^ t.mSlice[5][(lo >> 16) & 0xff] ^ t.mSlice[4][lo >> 24] ^
+            t.mSlice[3][hi & 0xff] ^ t.mSlice[2][(hi >> 8) & 0xff] ^ t.mSlice[1][(hi >> 16) & 0xff] ^ t.mSlice[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len)
+    {
+        l = t.mSlice[0][(l ^ *p++) & 0xff] ^ (l >> 8);
+        len--;
+    }
+    return l ^ 0xffffffffu;
+}
+
+#if CRC32C_SSE42
+
+static inline uint64_t read64(const uint8_t *p)
+{
+    uint64_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+
+// Runs three streams of 'block' bytes through the crc32 instruction at once;
+// the instruction has a latency of three cycles but can start every cycle.
+// The register after the first stream is then advanced over the other two
+// and combined with their results.
+__attribute__((target("sse4.2")))
+static inline uint64_t extendInterleaved(const uint32_t table[4][256], uint64_t l, const uint8_t *&p, size_t &len, size_t block)
+{
+    while (len >= 3 * block)
+    {
+        uint64_t c0 = l;
+        uint64_t c1 = 0;
+        uint64_t c2 = 0;
+        const uint8_t *end = p + block;
+        do
+        {
+            c0 = _mm_crc32_u64(c0, read64(p));
+            c1 = _mm_crc32_u64(c1, read64(p + block));
+            c2 = _mm_crc32_u64(c2, read64(p + 2 * block));
+            p += 8;
+        } while (p < end);
+        l = shift(table, shift(table, uint32_t(c0)) ^ uint32_t(c1)) ^ uint32_t(c2);
+        p += 2 * block;
+        len -= 3 * block;
+    }
+    return l;
+}
+
+__attribute__((target("sse4.2")))
+static uint32_t extendSSE42(const Tables &t, uint32_t crc, const uint8_t *p, size_t len)
+{
+    uint64_t l = crc ^ 0xffffffffu;
+    while (len && (reinterpret_cast< uintptr_t >(p) & 7))
+    {
+        l = _mm_crc32_u8(uint32_t(l), *p++);
+        len--;
+    }
+    l = extendInterleaved(t.mLong, l, p, len, CRC32C_LONG_BLOCK);
+    l = extendInterleaved(t.mShort, l, p, len, CRC32C_SHORT_BLOCK);
+    while (len >= 8)
+    {
+        l = _mm_crc32_u64(l, read64(p));
+        p += 8;
+        len -= 8;
+    }
+    while (len)
+    {
+        l = _mm_crc32_u8(uint32_t(l), *p++);
+        len--;
+    }
+    return uint32_t(l) ^ 0xffffffffu;
+}
+
+#endif
+
+uint32_t extend(uint32_t crc, const void *data, size_t len)
+{
+    const Tables &t = getTables();
+    const uint8_t *p = static_cast< const uint8_t * >(data);
+#if CRC32C_SSE42
+    if (t.mAccelerated)
+    {
+        return extendSSE42(t, crc, p, len);
+    }
+#endif
+    return extendPortable(t, crc, p, len);
+}
+
+uint32_t extendPortable(uint32_t crc, const void *data, size_t len)
+{
+    return extendPortable(getTables(), crc, static_cast< const uint8_t * >(data), len);
+}
+
+bool isAccelerated(void)
+{
+    return getTables().mAccelerated;
+}
+
+uint32_t extendAccelerated(uint32_t crc, const void *data, size_t len)
+{
+#if CRC32C_SSE42
+    const Tables &t = getTables();
+    if (t.mAccelerated)
+    {
+        return extendSSE42(t, crc, static_cast< const uint8_t * >(data), len);
+    }
+#endif
+    (void)crc;
+    (void)data;
+    (void)len;
+    return 0;
+}
+
+#define CRC32C_LINE_SUFFIX 9   // a tab and 8 hex digits
+
+void appendLineChecksum(std::string &line)
+{
+    static const char digits[] = "0123456789abcdef";
+    uint32_t crc = value(line.data(), line.size());
+    char suffix[CRC32C_LINE_SUFFIX];
+    suffix[0] = '\t';
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        suffix[1 + i] = digits[(crc >> (28 - 4 * i)) & 0xf];
+    }
+    line.append(suffix, sizeof(suffix));
+}
+
+bool checkLineChecksum(std::string &line)
+{
+    if (line.size() < CRC32C_LINE_SUFFIX || line[line.size() - CRC32C_LINE_SUFFIX] != '\t')
+    {
+        return true;
+    }
+    uint32_t stored = 0;
+    for (size_t i = line.size() - 8; i < line.size(); i++)
+    {
+        char c = line[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9')
+        {
+            digit = uint32_t(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            digit = uint32_t(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            digit = uint32_t(c - 'A' + 10);
+        }
+        else
+        {
+            return true;
+        }
+        stored = (stored << 4) | digit;
+    }
+    size_t len = line.size() - CRC32C_LINE_SUFFIX;
+    if (value(line.data(), len) != stored)
+    {
+        return false;
+    }
+    line.resize(len);
+    return true;
+}
+
+} // end of CRC32C namespace
@@ -38,6 +38,10 @@ inline int _stricmp(const char *a, const char *b)
 {
 	return strcasecmp(a, b);
 }
+inline int _strnicmp(const char *a, const char *b, size_t n)
+{
+	return strncasecmp(a, b, n);
+}
 char *_strupr(char *s)
 {
 	while (*s)
@@ -103,7 +107,9 @@ std::string fpout(const char *fname,const char *nspace,const char *destDir)
     return fqn;
 }
 
+#ifdef _MSC_VER
 #pragma warning(disable:4100)
+#endif
 
 namespace CREATE_DOM
 {
@@ -274,6 +280,33 @@ namespace CREATE_DOM
         return ret;
     }
 
+    // Returns true if 'flag' appears in a '|' or space separated 'Engine Specific' column
+    bool hasEngineFlag(const std::string &engineSpecific, const char *flag)
+    {
+        bool ret = false;
+
+        size_t flen = strlen(flag);
+        const char *scan = engineSpecific.c_str();
+        while ( *scan && !ret )
+        {
+            while ( *scan == '|' || *scan == ' ' )
+            {
+                scan++;
+            }
+            const char *begin = scan;
+            while ( *scan && *scan != '|' && *scan != ' ' )
+            {
+                scan++;
+            }
+            if ( size_t(scan - begin) == flen && _strnicmp(begin, flag, flen) == 0 )
+            {
+                ret = true;
+            }
+        }
+
+        return ret;
+    }
+
     typedef std::vector< OmniCommandInstance > OmniCommandInstanceVector;
 
 	static std::string getPythonArgDef(const MemberVariable &var, const DOM &dom);
@@ -377,7 +410,7 @@ namespace CREATE_DOM
             char scratch[8192];
             va_list arg;
             va_start(arg, fmt);
-            int32_t r = ::vsnprintf(scratch, sizeof(scratch), fmt, arg);
+            ::vsnprintf(scratch, sizeof(scratch), fmt, arg);
             va_end(arg);
             mOutput+=std::string(scratch);
         }
@@ -499,6 +532,39 @@ public:
 			STRING_HELPER::stringFormat(scratch, 512, "%s::%s", mType.c_str(), mDefaultValue.c_str());
 			mQualifiedDefaultValue = std::string(scratch);
 		}
+		if (hasEngineFlag(mEngineSpecific, "XOR"))
+		{
+			if (mIsArray && !mIsMap && (mType == "double" || mType == "float"))
+			{
+				mXorCompress = true;
+			}
+			else
+			{
+				printf("** WARNING ** XOR compression only applies to double[] and float[] members; ignored for '%s'\n", mMember.c_str());
+			}
+		}
+		if (hasEngineFlag(mEngineSpecific, "KEY"))
+		{
+			if (!mIsArray && !mIsMap && !mIsPointer && mIsOptional == OptionalType::required)
+			{
+				mPrimaryKey = true;
+			}
+			else
+			{
+				printf("** WARNING ** Key members must be required scalars, strings or enums; ignored for '%s'\n", mMember.c_str());
+			}
+		}
+		if (hasEngineFlag(mEngineSpecific, "INDEX"))
+		{
+			if (!mIsArray && !mIsMap && !mIsPointer && mIsOptional == OptionalType::required)
+			{
+				mIndexed = true;
+			}
+			else
+			{
+				printf("** WARNING ** Indexed members must be required scalars, strings or enums; ignored for '%s'\n", mMember.c_str());
+			}
+		}
 	}
 
 	bool			mIsArray{ false }; // true if this data item is an array
@@ -508,6 +574,9 @@ public:
     OptionalType    mIsOptional{OptionalType::required};
     bool            mIsMap{false};
     bool            mSerializeEnumAsInteger{false};
+    bool            mXorCompress{false};    // 'XOR' engine flag; double[]/float[] stored as a XOR compressed blob
+    bool            mPrimaryKey{false};     // 'KEY' engine flag; part of the class's order preserving composite key
+    bool            mIndexed{false};        // 'INDEX' engine flag; record stores keep a secondary index on this member
     std::string     mMapType;
 	std::string		mMember;	// name of this data item
     std::string     mAlias;
@@ -902,6 +971,49 @@ public:
                     cpimpl.printCode(3, "}\n");
                     cpimpl.printCode(2, "}\n");
                 }
+                else if ( i.mXorCompress )
+                {
+                    cpimpl.printCode(2,"auto found = d.FindMember(\"%s\");\n", i.mMember.c_str());
+                    cpimpl.printCode(2,"if ( found != d.MemberEnd() )\n");
+                    cpimpl.printCode(2,"{\n");
+                    cpimpl.printCode(3,"const rapidjson::Value &v = found->value;\n");
+                    cpimpl.printCode(3,"if ( v.IsString() )\n");
+                    cpimpl.printCode(3,"{\n");
+                    cpimpl.printCode(4,"// XOR compressed blob stored as a base64 string\n");
+                    cpimpl.printCode(4,"std::string blob;\n");
+                    cpimpl.printCode(4,"if ( !XOR_COMPRESS::base64Decode(v.GetString(), v.GetStringLength(), blob) ||\n");
+                    cpimpl.printCode(4,"     !XOR_COMPRESS::decode(blob.data(), blob.size(), r.%s) )\n", i.mMember.c_str());
+                    cpimpl.printCode(4,"{\n");
+                    cpimpl.printCode(5,"return false;\n");
+                    cpimpl.printCode(4,"}\n");
+                    cpimpl.printCode(3,"}\n");
+                    cpimpl.printCode(3,"else if ( v.IsArray() )\n");
+                    cpimpl.printCode(3,"{\n");
+                    cpimpl.printCode(4,"// Also accept a plain array of numbers\n");
+                    cpimpl.printCode(4,"r.%s.clear();\n", i.mMember.c_str());
+                    cpimpl.printCode(4,"for (rapidjson::SizeType i = 0; i < v.Size(); i++)\n");
+                    cpimpl.printCode(4,"{\n");
+                    cpimpl.printCode(5,"const rapidjson::Value& entry = v[i];\n");
+                    cpimpl.printCode(5,"if ( !entry.IsNumber() )\n");
+                    cpimpl.printCode(5,"{\n");
+                    cpimpl.printCode(6,"return false;\n");
+                    cpimpl.printCode(5,"}\n");
+                    cpimpl.printCode(5,"r.%s.push_back(entry.%s());\n", i.mMember.c_str(), getType);
+                    cpimpl.printCode(4,"}\n");
+                    cpimpl.printCode(3,"}\n");
+                    cpimpl.printCode(3,"else\n");
+                    cpimpl.printCode(3,"{\n");
+                    cpimpl.printCode(4,"return false;\n");
+                    cpimpl.printCode(3,"}\n");
+                    cpimpl.printCode(2,"}\n");
+                    if ( i.mIsOptional == OptionalType::required)
+                    {
+                        cpimpl.printCode(2,"else\n");
+                        cpimpl.printCode(2,"{\n");
+                        cpimpl.printCode(3,"return false;\n");
+                        cpimpl.printCode(2,"}\n");
+                    }
+                }
                 else if ( getType )
                 {
                     cpimpl.printCode(2,"auto found = d.FindMember(\"%s\");\n", i.mMember.c_str());
@@ -1421,7 +1533,19 @@ public:
             const char *type = i.mType.c_str();
             if ( isStandardType(type) )
             {
-                if ( i.mIsArray )
+                if ( i.mXorCompress )
+                {
+                    cpimpl.printCode(1,"{\n");
+                    cpimpl.printCode(1,"    // Serialize XOR compressed member '%s' as a base64 string\n", i.mMember.c_str());
+                    cpimpl.printCode(1,"    std::string blob;\n");
+                    cpimpl.printCode(1,"    XOR_COMPRESS::encode(type.%s.data(), type.%s.size(), blob);\n", i.mMember.c_str(), i.mMember.c_str());
+                    cpimpl.printCode(1,"    std::string text;\n");
+                    cpimpl.printCode(1,"    XOR_COMPRESS::base64Encode(blob.data(), blob.size(), text);\n");
+                    cpimpl.printCode(1,"    rapidjson::Value v(text.c_str(), rapidjson::SizeType(text.size()), alloc);\n");
+                    cpimpl.printCode(1,"    d.AddMember(\"%s\", v, alloc);\n", i.mMember.c_str());
+                    cpimpl.printCode(1,"}\n");
+                }
+                else if ( i.mIsArray )
                 {
                     if ( i.mIsMap )
                     {
@@ -1836,7 +1960,15 @@ public:
                 {
                     type = "boolean";
                 }
-                if ( i.mIsMap )
+                if ( i.mXorCompress )
+                {
+                    // The JSON holds the XOR compressed blob as a base64 string
+                    cpdom.printCode(1,"%s%s: string // %s\n",
+                        i.mMember.c_str(),
+                        i.mIsOptional != OptionalType::required ? "?" : "",
+                        i.mShortDescription.c_str());
+                }
+                else if ( i.mIsMap )
                 {
                     cpdom.printCode(1, "[%s%s]%s: %s%s // %s\n",
                         i.mMember.c_str(),
@@ -2212,20 +2344,6 @@ public:
                 }
             }
 
-            // see if any items are an array of pointers...
-            bool hasArrayOfPointers = false;
-            bool hasPointers = false;
-            for (auto &i : mItems)
-            {
-                if (i.mIsArray && i.mIsPointer)
-                {
-                    hasArrayOfPointers = true;
-                }
-                else if (i.mIsPointer)
-                {
-                    hasPointers = true;
-                }
-            }
             bool needsDOMVector = false; // True if we need to declare the DOM vector
             for (auto &i : mItems)
             {
@@ -2236,7 +2354,6 @@ public:
                     continue;
                 }
 
-                bool needsNull = false;
                 bool needsArrayOperator = false;
                 // Output the member variable declaration.
                 if (i.mIsArray)
@@ -2290,7 +2407,6 @@ public:
                     assert( !i.mIsMap ); // not yet implemented, todo..
                     if (isDef && i.mIsPointer && !i.mIsArray)
                     {
-                        needsNull = false;
                         cp.printCode(1, "%s%s", getCppTypeString(i.mType.c_str(), isDef),
                             isDef ? "Def" : "");
                     }
@@ -2309,7 +2425,6 @@ public:
 
                 if (i.mIsPointer && !i.mIsArray)
                 {
-                    needsNull = true;
                     cp.printCode(4, "*%s", getMemberName(i.mMember, isDef,i.mIsMap));
                 }
                 else
@@ -3382,13 +3497,13 @@ public:
 		if (initArgs.empty())
 		{
 			cp.printCode(1, "def __init__(self):\n");
-			cp.printCode(2, "pass\n");
+			cp.printCode(2, mInheritsFrom.empty() ? "pass\n" : "super().__init__()\n");
 		}
 		else
 		{
 			cp.printCode(1, "def __init__(self, %s):\n", initArgs.c_str());
 			bool bodyIsEmpty = true;
-			if (!superInitArgs.empty())
+			if (!superInitArgs.empty() || !mInheritsFrom.empty())
 			{
 				cp.printCode(2, "super().__init__(%s)\n", superInitArgs.c_str());
 				bodyIsEmpty = false;
@@ -3430,7 +3545,7 @@ public:
 				else if (isEnumType(dom, m->mType))
 				{
 					// for enums, use lookup table for their string values
-					cp.printCode(2, "data['%s'] = '%s_strings[self.%s]\n", m->mMember.c_str(), m->mType.c_str(), m->mMember.c_str());
+					cp.printCode(2, "data['%s'] = [%s_strings[e] for e in self.%s]\n", m->mMember.c_str(), m->mType.c_str(), m->mMember.c_str());
 				}
 				else if (m->mType == "i8" || m->mType == "i16" || m->mType == "i32" || m->mType == "i64" ||
 					m->mType == "u8" || m->mType == "u16" || m->mType == "u32" || m->mType == "u64" ||
@@ -3583,7 +3698,6 @@ public:
 		cp.printCode(0, "\n");
 		cp.printCode(0, "{\n");
 
-		bool hasInheritedItemsWithDefaultValues = false;
 		uint32_t id = 1;
 
 		for (auto &i : mItems)
@@ -3592,7 +3706,6 @@ public:
 			// Because it was already handled in the initializer
 			if (!i.mInheritsFrom.empty() && !i.mDefaultValue.empty())
 			{
-				hasInheritedItemsWithDefaultValues = true;
 				continue;
 			}
 			const char *repeated = "";
@@ -3600,7 +3713,12 @@ public:
 			{
 				repeated = "repeated ";
 			}
-			if (i.mProtoType.empty())
+			if (i.mXorCompress)
+			{
+				// XOR compressed arrays are stored as a single blob
+				cp.printCode(1, "bytes %s = %d;\n", i.mMember.c_str(), id);
+			}
+			else if (i.mProtoType.empty())
 			{
 				cp.printCode(1, "%s%s %s = %d;\n",
 					repeated,
@@ -3761,6 +3879,23 @@ public:
 		}
 	}
 
+    // Returns true if any member variable uses the 'XOR' engine flag
+    bool hasXorCompression(void) const
+    {
+        bool ret = false;
+        for (auto &i : mObjects)
+        {
+            for (auto &j : i.mItems)
+            {
+                if ( j.mXorCompress )
+                {
+                    ret = true;
+                }
+            }
+        }
+        return ret;
+    }
+
     void saveDeserialize(CodePrinter &cpHeader, CodePrinter &cpImpl)
     {
         cpImpl.linefeed();
@@ -3956,174 +4091,2935 @@ public:
 
     }
 
-    void saveTypeScript(CodePrinter &dom,CodePrinter &cpenum,CodePrinter &cpenumImpl,const char *destDir)
+    // Collects the members of an object, base class members first, in the
+    // order they are serialized.
+    void collectMembers(const Object &obj, std::vector< const MemberVariable * > &members) const
     {
-        cpenum.linefeed();
-        cpenum.printCode(0, "template<typename T>\n");
-        cpenum.printCode(0, "T unstringifyEnum(const std::string& str, bool& ok);\n");
-        cpenum.linefeed();
-
-        cpenumImpl.printCode(0,"// clang-format off\n");
-        cpenumImpl.printCode(0, "// CreateDOM: Schema Generation tool written by John W. Ratcliff, 2019\n");
-        cpenumImpl.printCode(0, "// C++ binding code for enumeration lookups and initialization to default values.\n");
-        cpenumImpl.printCode(0, "// The Google DOCs Schema Spreadsheet for this source came from: %s\n", mURL.c_str());
-        cpenumImpl.printCode(0,"#include \"%s.h\"\n", mFilename.c_str());
-        cpenumImpl.printCode(0, "#include <assert.h>\n");
-        cpenumImpl.printCode(0,"#include <unordered_map>\n");
-        cpenumImpl.printCode(0,"#include <mutex>\n");
-        cpenumImpl.printCode(0,"#include <string>\n");
-        cpenumImpl.printCode(0,"#include <string.h>\n");
-
-        cpenumImpl.printCode(0, "#ifdef _MSC_VER\n");
-        cpenumImpl.printCode(0, "#pragma warning(disable:4996 4100)\n");
-        cpenumImpl.printCode(0, "#endif\n");
-        cpenumImpl.linefeed();
-        cpenumImpl.printCode(0, "#include \"RapidJSONDocument.h\"\n");
-        cpenumImpl.linefeed();
-
-        cpenumImpl.printCode(0,"namespace %s {\n", mNamespace.c_str());
-
-        OmniCommandInstanceVector instances;
-        for (auto &i : mObjects)
+        if (!obj.mInheritsFrom.empty())
         {
-            i.saveTypeScript(dom,cpenum,cpenumImpl,*this,instances,mNamespace.c_str(),destDir);
+            const Object *base = findObject(obj.mInheritsFrom);
+            if (base)
+            {
+                collectMembers(*base, members);
+            }
         }
-        if ( !instances.empty() )
+        for (auto &i : obj.mItems)
         {
-            std::string fpHPP = fpout("OmniApiInstance.h",mNamespace.c_str(),destDir);
-            std::string fpCPP = fpout("OmniApiInstance.cpp",mNamespace.c_str(),destDir);
+            if (i.mInheritsFrom.empty())
             {
-                CodePrinter cpp(fpCPP);
-
-                cpp.printCode(0, "#include \"OmniApiInstance.h\"\n");
-                cpp.printCode(0, "#include \"omniverse_api.h\"\n");
-                cpp.printCode(0, "\n");
-                cpp.printCode(0, "namespace omniapi\n");
-                cpp.printCode(0, "{\n");
-                cpp.printCode(0, "\n");
-                cpp.printCode(0, "// Forward reference functions to create instances for various command types\n");
-                for (auto &i:instances)
-                {
-                    cpp.printCode(0, "OmniApiCommand *create%sInstance(const rapidjson::RapidJSONDocument &d, OmniConnection *oc);\n", i.mCommand.c_str());
-                }
-                cpp.printCode(0, "\n");
-                cpp.printCode(0, "createCommandInstance getCreateCommandInstance(CommandType ctype)\n");
-                cpp.printCode(0, "{\n");
-                cpp.printCode(1, "createCommandInstance ret = nullptr;\n");
-                cpp.printCode(0, "\n");
-                cpp.printCode(1, "switch (ctype)\n");
-                cpp.printCode(1, "{\n");
-                for (auto &i:instances)
-                {
-                    cpp.printCode(2, "case CommandType::%s:\n", i.mCommandType.c_str());
-                    cpp.printCode(3, "ret = create%sInstance;\n", i.mCommand.c_str());
-                    cpp.printCode(3, "break;\n");
-                }
-                cpp.printCode(1, "}\n");
-                cpp.printCode(0,"\n");
-                cpp.printCode(1, "return ret;\n");
-                cpp.printCode(0, "}\n");
-                cpp.printCode(0, "\n");
-                cpp.printCode(0, "}\n");
-                cpp.finalize();
+                members.push_back(&i);
             }
-            {
-                CodePrinter hpp(fpHPP);
-                hpp.printCode(0, "#pragma once\n");
-                hpp.printCode(0, "\n");
-                hpp.printCode(0, "#include <carb/Defines.h>\n");
-                hpp.printCode(0, "\n");
-                hpp.printCode(0, "namespace rapidjson\n");
-                hpp.printCode(0, "{\n");
-                hpp.printCode(1, "class RapidJSONDocument;\n");
-                hpp.printCode(0, "}\n");
-                hpp.printCode(0, "\n");
-                hpp.printCode(0, "namespace omniapi\n");
-                hpp.printCode(0, "{\n");
-                hpp.printCode(0, "class OmniApiCommand;\n");
-                hpp.printCode(0, "class OmniConnection;\n");
-                hpp.printCode(0, "enum class CommandType;\n");
-                hpp.printCode(0, "\n");
-                hpp.printCode(0, "typedef OmniApiCommand *(CARB_ABI* createCommandInstance)(const rapidjson::RapidJSONDocument &d, OmniConnection *oc);\n");
-                hpp.printCode(0, "\n");
-                hpp.printCode(0, "createCommandInstance getCreateCommandInstance(CommandType ctype);\n");
-                hpp.printCode(0, "\n");
-                hpp.printCode(0, "}\n");
+        }
+    }
 
-                hpp.finalize();
+    // Collects the members of a class and returns true if every one of them is
+    // a scalar, string or enum (no arrays, maps, pointers or nested classes).
+    bool getFlatMembers(const Object &obj, std::vector< const MemberVariable * > &members, const ClassEnumMap &classEnum) const
+    {
+        collectMembers(obj, members);
+        bool ret = !members.empty();
+        for (auto &i : members)
+        {
+            if (getArrowColumnType(*i, classEnum) == nullptr)
+            {
+                ret = false;
             }
         }
+        return ret;
     }
 
-    void saveCPP(CodePrinter &cp)
+    // Returns the Arrow column type of a member, or nullptr if the member
+    // cannot be stored as a flat column.
+    const char *getArrowColumnType(const MemberVariable &m, const ClassEnumMap &classEnum) const
     {
-        cp.printCode(0, "#pragma once\n");
-        cp.printCode(0, "\n");
-        cp.printCode(0,"// clang-format off\n");
-        cp.printCode(0, "// CreateDOM: Schema Generation tool written by John W. Ratcliff, 2017\n");
-        cp.printCode(0, "// Warning:This source file was auto-generated by the CreateDOM tool. Do not try to edit this source file manually!\n");
-        cp.printCode(0, "// The Google DOCs Schema Spreadsheet for this source came from: %s\n", mURL.c_str());
-        cp.printCode(0, "\n");
-
-        cp.printCode(0, "#ifdef _MSC_VER\n");
-        cp.printCode(0, "#pragma warning(push)\n");
-        cp.printCode(0, "#pragma warning(disable:4244)\n");
-        cp.printCode(0, "#endif\n");
-
-
-        char temp[512];
-        STRING_HELPER::stringFormat(temp,sizeof(temp), "%s.h", mFilename.c_str());
-        cp.printCode(0, "#include <vector>\n");
-        cp.printCode(0, "#include <unordered_map>\n");
-        cp.printCode(0, "#include <string>\n");
-        cp.printCode(0, "#include <stdint.h>\n");
-        cp.printCode(0,"#include <string.h>\n");
-        cp.printCode(0, "\n");
-        cp.printCode(0, "#define USE_OPTIONAL 1\n");
-        cp.printCode(0, "\n");
-        cp.printCode(0, "#if __has_include(<optional>) && USE_OPTIONAL == 1\n");
-        cp.printCode(0, "#include <optional>\n");
-        cp.printCode(0, "#else\n");
-        cp.printCode(0, "#define NO_OPTIONAL\n");
-        cp.printCode(0, "#endif\n");
-        cp.printCode(0, "\n");
-        cp.printCode(0, "namespace codegen\n");
-        cp.printCode(0, "{\n");
-        cp.printCode(0, "template<typename T>\n");
-        cp.printCode(0, "#ifdef NO_OPTIONAL\n");
-        cp.printCode(0, "using optional = T;\n");
-        cp.printCode(0, "#else\n");
-        cp.printCode(0, "using optional = std::optional<T>;\n");
-        cp.printCode(0, "#endif\n");
-        cp.printCode(0, "}\n");
-
-        cp.printCode(0, "namespace rapidjson\n");
-        cp.printCode(0, "{\n");
-        cp.printCode(0, "    class RapidJSONDocument;\n");
-        cp.printCode(0, "}\n");
-
-        cp.printCode(0, "\n");
-        cp.printCode(0, "namespace %s\n", mNamespace.c_str());
-        cp.printCode(0, "{\n");
-        cp.printCode(0, "\n");
-
-        cp.printCode(0, "\n");
-        cp.printCode(0, "// Forward declare the two types of string vector containers.\n");
-        cp.printCode(0, "\n");
-
-        StringVector arrays;
-        StringVector needsReflection;
-        for (auto &i : mObjects)
+        const char *ret = nullptr;
+        if (m.mIsArray || m.mIsMap || m.mIsPointer)
         {
-            if (i.mNeedsReflection)
+            return ret;
+        }
+        static const char *types[][2] =
+        {
+            { "bool", "boolean" },
+            { "i8", "int8" },
+            { "i16", "int16" },
+            { "i32", "int32" },
+            { "i64", "int64" },
+            { "u8", "uint8" },
+            { "u16", "uint16" },
+            { "u32", "uint32" },
+            { "u64", "uint64" },
+            { "float", "float32" },
+            { "double", "float64" },
+            { "string", "utf8" },
+        };
+        for (auto &i : types)
+        {
+            if (m.mType == i[0])
             {
-                needsReflection.push_back(i.mName);
+                ret = i[1];
             }
         }
-        StringVector cloneObjects;
-        for (auto &i : mObjects)
+        if (ret == nullptr)
         {
-            i.saveCPP(cp, arrays, needsReflection, cloneObjects, *this);
+            ClassEnumMap::const_iterator found = classEnum.find(m.mType);
+            if (found != classEnum.end() && (*found).second)
+            {
+                ret = "dictionary";
+            }
+        }
+        return ret;
+    }
+
+    // Generates 'serializeArrow' and 'deserializeArrow' for every class whose
+    // members (including inherited ones) are scalars, strings or enums.  Each
+    // member becomes a column; optional members are nullable and enums are
+    // dictionary encoded using their string names.
+    void saveArrow(CodePrinter &cpHeader, CodePrinter &cpImpl)
+    {
+        ClassEnumMap classEnumMap;
+        for (auto &i : mObjects)
+        {
+            classEnumMap[i.mName] = i.mIsEnum;
+        }
+
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"/*\n");
+        cpHeader.printCode(0," * Arrow IPC stream export and import of record arrays\n");
+        cpHeader.printCode(0," */\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"/*\n");
+        cpImpl.printCode(0,"* Arrow IPC implementation\n");
+        cpImpl.printCode(0,"*/\n");
+
+        for (auto &obj : mObjects)
+        {
+            if (!obj.mIsClass)
+            {
+                continue;
+            }
+            std::vector< const MemberVariable * > members;
+            if (!getFlatMembers(obj, members, classEnumMap))
+            {
+                printf("** WARNING ** Arrow export skipped for '%s'; only classes made of scalars, strings and enums are supported\n", obj.mName.c_str());
+                continue;
+            }
+            const char *name = obj.mName.c_str();
+
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"// Writes an array of %s records as an Arrow IPC stream; 'out' is replaced.\n", name);
+            cpHeader.printCode(0,"// With 'compress' the stream is wrapped in an LZ frame.\n");
+            cpHeader.printCode(0,"void serializeArrow(const std::vector<%s>& rows, std::string& out, bool compress = false);\n", name);
+            cpHeader.printCode(0,"// Reads an Arrow IPC stream (optionally LZ framed); columns are matched by name\n");
+            cpHeader.printCode(0,"bool deserializeArrow(const void* data, size_t len, std::vector<%s>& rows);\n", name);
+
+            // Each enum type used gets one dictionary and index lookup
+            StringVector enums;
+            for (auto &i : members)
+            {
+                if (strcmp(getArrowColumnType(*i, classEnumMap), "dictionary") == 0 &&
+                    std::find(enums.begin(), enums.end(), i->mType) == enums.end())
+                {
+                    enums.push_back(i->mType);
+                }
+            }
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void serializeArrow(const std::vector<%s>& rows, std::string& out, bool compress)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"out.clear();\n");
+            cpImpl.printCode(1,"std::string stream;\n");
+            cpImpl.printCode(1,"ARROW_IPC::StreamWriter w(compress ? stream : out);\n");
+            for (auto &e : enums)
+            {
+                cpImpl.printCode(1,"std::vector<std::string> names%s;\n", e.c_str());
+                cpImpl.printCode(1,"std::unordered_map<%s, int32_t> index%s;\n", e.c_str(), e.c_str());
+                cpImpl.printCode(1,"for (auto &e : %sList)\n", e.c_str());
+                cpImpl.printCode(1,"{\n");
+                cpImpl.printCode(2,"index%s[e.key] = int32_t(names%s.size());\n", e.c_str(), e.c_str());
+                cpImpl.printCode(2,"names%s.push_back(e.value);\n", e.c_str());
+                cpImpl.printCode(1,"}\n");
+            }
+            for (auto &i : members)
+            {
+                const char *member = i->mMember.c_str();
+                const char *columnType = getArrowColumnType(*i, classEnumMap);
+                const char *nullable = i->mIsOptional == OptionalType::optional ? "true" : "false";
+                if (strcmp(columnType, "dictionary") == 0)
+                {
+                    cpImpl.printCode(1,"uint32_t %sField = w.addDictionaryField(\"%s\", names%s, %s);\n", member, member, i->mType.c_str(), nullable);
+                }
+                else
+                {
+                    cpImpl.printCode(1,"uint32_t %sField = w.addField(\"%s\", ARROW_IPC::ColumnType::%s, %s);\n", member, member, columnType, nullable);
+                }
+            }
+            cpImpl.printCode(1,"w.beginRecordBatch(rows.size());\n");
+            for (auto &i : members)
+            {
+                const char *member = i->mMember.c_str();
+                const char *columnType = getArrowColumnType(*i, classEnumMap);
+                if (strcmp(columnType, "dictionary") == 0)
+                {
+                    cpImpl.printCode(1,"int32_t *%sColumn = static_cast<int32_t *>(w.getColumn(%sField));\n", member, member);
+                }
+                else if (strcmp(columnType, "utf8") != 0 && strcmp(columnType, "boolean") != 0)
+                {
+                    const char *cppType = getCppTypeString(i->mType.c_str(), true);
+                    cpImpl.printCode(1,"%s *%sColumn = static_cast<%s *>(w.getColumn(%sField));\n", cppType, member, cppType, member);
+                }
+            }
+            cpImpl.printCode(1,"for (size_t i = 0; i < rows.size(); i++)\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"const %s &r = rows[i];\n", name);
+            for (auto &i : members)
+            {
+                const char *member = i->mMember.c_str();
+                const char *columnType = getArrowColumnType(*i, classEnumMap);
+                bool isOptional = i->mIsOptional == OptionalType::optional;
+                char value[512];
+                STRING_HELPER::stringFormat(value, sizeof(value), isOptional ? "r.%s.value()" : "r.%s", member);
+                if (isOptional)
+                {
+                    cpImpl.printCode(2,"if ( !r.%s.has_value() )\n", member);
+                    cpImpl.printCode(2,"{\n");
+                    cpImpl.printCode(3,"w.setNull(%sField, i);\n", member);
+                    if (strcmp(columnType, "utf8") == 0)
+                    {
+                        cpImpl.printCode(3,"w.appendString(%sField, \"\", 0);\n", member);
+                    }
+                    cpImpl.printCode(2,"}\n");
+                    cpImpl.printCode(2,"else\n");
+                }
+                cpImpl.printCode(2,"{\n");
+                if (strcmp(columnType, "utf8") == 0)
+                {
+                    cpImpl.printCode(3,"w.appendString(%sField, %s.c_str(), %s.size());\n", member, value, value);
+                }
+                else if (strcmp(columnType, "boolean") == 0)
+                {
+                    cpImpl.printCode(3,"w.setBool(%sField, i, %s);\n", member, value);
+                }
+                else if (strcmp(columnType, "dictionary") == 0)
+                {
+                    cpImpl.printCode(3,"%sColumn[i] = index%s[%s];\n", member, i->mType.c_str(), value);
+                }
+                else
+                {
+                    cpImpl.printCode(3,"%sColumn[i] = %s;\n", member, value);
+                }
+                cpImpl.printCode(2,"}\n");
+            }
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"w.endRecordBatch();\n");
+            cpImpl.printCode(1,"w.finish();\n");
+            cpImpl.printCode(1,"if ( compress )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"LZ_COMPRESS::compressFrame(stream.data(), stream.size(), out);\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool deserializeArrow(const void* data, size_t len, std::vector<%s>& rows)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"rows.clear();\n");
+            cpImpl.printCode(1,"std::string stream;\n");
+            cpImpl.printCode(1,"if ( LZ_COMPRESS::isFrame(data, len) )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"if ( !LZ_COMPRESS::decompressFrame(data, len, stream) )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"return false;\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(2,"data = stream.data();\n");
+            cpImpl.printCode(2,"len = stream.size();\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"ARROW_IPC::StreamReader r(data, len);\n");
+            cpImpl.printCode(1,"if ( !r.readSchema() )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"return false;\n");
+            cpImpl.printCode(1,"}\n");
+            for (auto &i : members)
+            {
+                const char *member = i->mMember.c_str();
+                cpImpl.printCode(1,"int32_t %sField = r.findField(\"%s\");\n", member, member);
+                if (i->mIsOptional == OptionalType::required)
+                {
+                    cpImpl.printCode(1,"if ( %sField < 0 || r.getFieldType(uint32_t(%sField)) != ARROW_IPC::ColumnType::%s )\n", member, member, getArrowColumnType(*i, classEnumMap));
+                }
+                else
+                {
+                    cpImpl.printCode(1,"if ( %sField >= 0 && r.getFieldType(uint32_t(%sField)) != ARROW_IPC::ColumnType::%s )\n", member, member, getArrowColumnType(*i, classEnumMap));
+                }
+                cpImpl.printCode(1,"{\n");
+                cpImpl.printCode(2,"return false;\n");
+                cpImpl.printCode(1,"}\n");
+                if (strcmp(getArrowColumnType(*i, classEnumMap), "dictionary") == 0)
+                {
+                    cpImpl.printCode(1,"std::vector<%s> %sValues;\n", i->mType.c_str(), member);
+                }
+            }
+            cpImpl.printCode(1,"while ( r.nextRecordBatch() )\n");
+            cpImpl.printCode(1,"{\n");
+            for (auto &i : members)
+            {
+                if (strcmp(getArrowColumnType(*i, classEnumMap), "dictionary") != 0)
+                {
+                    continue;
+                }
+                const char *member = i->mMember.c_str();
+                cpImpl.printCode(2,"// Map each dictionary entry to its enum value once per batch\n");
+                cpImpl.printCode(2,"%sValues.clear();\n", member);
+                cpImpl.printCode(2,"for (uint32_t j = 0; %sField >= 0 && j < r.getDictionaryCount(uint32_t(%sField)); j++)\n", member, member);
+                cpImpl.printCode(2,"{\n");
+                cpImpl.printCode(3,"bool isOk;\n");
+                cpImpl.printCode(3,"%sValues.push_back(unstringifyEnum<%s>(r.getDictionaryValue(uint32_t(%sField), j), isOk));\n", member, i->mType.c_str(), member);
+                cpImpl.printCode(3,"if ( !isOk )\n");
+                cpImpl.printCode(3,"{\n");
+                cpImpl.printCode(4,"return false;\n");
+                cpImpl.printCode(3,"}\n");
+                cpImpl.printCode(2,"}\n");
+            }
+            cpImpl.printCode(2,"size_t base = rows.size();\n");
+            cpImpl.printCode(2,"rows.resize(base + size_t(r.getRowCount()));\n");
+            cpImpl.printCode(2,"for (uint64_t i = 0; i < r.getRowCount(); i++)\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"%s &t = rows[base + size_t(i)];\n", name);
+            for (auto &i : members)
+            {
+                const char *member = i->mMember.c_str();
+                const char *columnType = getArrowColumnType(*i, classEnumMap);
+                cpImpl.printCode(3,"if ( %sField >= 0 && !r.isNull(uint32_t(%sField), i) )\n", member, member);
+                cpImpl.printCode(3,"{\n");
+                if (strcmp(columnType, "utf8") == 0)
+                {
+                    cpImpl.printCode(4,"size_t slen;\n");
+                    cpImpl.printCode(4,"const char *s = r.getString(uint32_t(%sField), i, slen);\n", member);
+                    cpImpl.printCode(4,"if ( s == nullptr )\n");
+                    cpImpl.printCode(4,"{\n");
+                    cpImpl.printCode(5,"return false;\n");
+                    cpImpl.printCode(4,"}\n");
+                    cpImpl.printCode(4,"t.%s = std::string(s, slen);\n", member);
+                }
+                else if (strcmp(columnType, "boolean") == 0)
+                {
+                    cpImpl.printCode(4,"t.%s = r.getBool(uint32_t(%sField), i);\n", member, member);
+                }
+                else if (strcmp(columnType, "dictionary") == 0)
+                {
+                    cpImpl.printCode(4,"int64_t index = r.getDictionaryIndex(uint32_t(%sField), i);\n", member);
+                    cpImpl.printCode(4,"if ( index < 0 || uint64_t(index) >= %sValues.size() )\n", member);
+                    cpImpl.printCode(4,"{\n");
+                    cpImpl.printCode(5,"return false;\n");
+                    cpImpl.printCode(4,"}\n");
+                    cpImpl.printCode(4,"t.%s = %sValues[size_t(index)];\n", member, member);
+                }
+                else
+                {
+                    cpImpl.printCode(4,"t.%s = r.getValue<%s>(uint32_t(%sField), i);\n", member, getCppTypeString(i->mType.c_str(), true), member);
+                }
+                cpImpl.printCode(3,"}\n");
+            }
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"return r.isValid();\n");
+            cpImpl.printCode(0,"}\n");
+        }
+    }
+
+    // Generates 'serializeNDJSON' and 'deserializeNDJSON' for every class; one
+    // JSON document per line, optionally followed by a tab and its CRC-32C and
+    // optionally wrapped in an LZ compressed frame.
+    void saveNDJSON(CodePrinter &cpHeader, CodePrinter &cpImpl)
+    {
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"/*\n");
+        cpHeader.printCode(0," * Newline delimited JSON\n");
+        cpHeader.printCode(0," */\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"/*\n");
+        cpImpl.printCode(0,"* Newline delimited JSON implementation\n");
+        cpImpl.printCode(0,"*/\n");
+
+        for (auto &obj : mObjects)
+        {
+            if (obj.mIsEnum)
+            {
+                continue;
+            }
+            const char *name = obj.mName.c_str();
+
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"// Writes one %s document per line; with 'compress' the output is an LZ frame and\n", name);
+            cpHeader.printCode(0,"// with 'checksum' every line ends with a tab and the CRC-32C of the document in hex\n");
+            cpHeader.printCode(0,"void serializeNDJSON(const std::vector<%s>& rows, std::string& out, bool compress = false, bool checksum = false);\n", name);
+            cpHeader.printCode(0,"// Reads newline delimited JSON; LZ frames are detected and decompressed and line\n");
+            cpHeader.printCode(0,"// checksums are verified where present\n");
+            cpHeader.printCode(0,"bool deserializeNDJSON(const void* data, size_t len, std::vector<%s>& rows);\n", name);
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void serializeNDJSON(const std::vector<%s>& rows, std::string& out, bool compress, bool checksum)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"out.clear();\n");
+            cpImpl.printCode(1,"std::string line;\n");
+            cpImpl.printCode(1,"if ( compress )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"LZ_COMPRESS::FrameWriter w(out);\n");
+            cpImpl.printCode(2,"for (auto &i : rows)\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"line = serialize(i);\n");
+            cpImpl.printCode(3,"if ( checksum )\n");
+            cpImpl.printCode(3,"{\n");
+            cpImpl.printCode(4,"CRC32C::appendLineChecksum(line);\n");
+            cpImpl.printCode(3,"}\n");
+            cpImpl.printCode(3,"line.push_back('\\n');\n");
+            cpImpl.printCode(3,"w.write(line);\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(2,"w.finish();\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"else\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"for (auto &i : rows)\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"line = serialize(i);\n");
+            cpImpl.printCode(3,"if ( checksum )\n");
+            cpImpl.printCode(3,"{\n");
+            cpImpl.printCode(4,"CRC32C::appendLineChecksum(line);\n");
+            cpImpl.printCode(3,"}\n");
+            cpImpl.printCode(3,"out += line;\n");
+            cpImpl.printCode(3,"out.push_back('\\n');\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool deserializeNDJSON(const void* data, size_t len, std::vector<%s>& rows)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"rows.clear();\n");
+            cpImpl.printCode(1,"std::string text;\n");
+            cpImpl.printCode(1,"const char *scan = static_cast<const char *>(data);\n");
+            cpImpl.printCode(1,"if ( LZ_COMPRESS::isFrame(data, len) )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"if ( !LZ_COMPRESS::decompressFrame(data, len, text) )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"return false;\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(2,"scan = text.data();\n");
+            cpImpl.printCode(2,"len = text.size();\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"const char *end = scan + len;\n");
+            cpImpl.printCode(1,"std::string line;\n");
+            cpImpl.printCode(1,"while ( scan < end )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"const char *eol = static_cast<const char *>(memchr(scan, '\\n', size_t(end - scan)));\n");
+            cpImpl.printCode(2,"if ( eol == nullptr )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"eol = end;\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(2,"line.assign(scan, size_t(eol - scan));\n");
+            cpImpl.printCode(2,"scan = eol == end ? end : eol + 1;\n");
+            cpImpl.printCode(2,"if ( line.find_first_not_of(\" \\t\\r\") == std::string::npos )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"continue; // skip blank lines\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(2,"if ( !CRC32C::checkLineChecksum(line) )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"return false;\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(2,"bool isOk = false;\n");
+            cpImpl.printCode(2,"rows.push_back(deserialize<%s>(line, isOk));\n", name);
+            cpImpl.printCode(2,"if ( !isOk )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"return false;\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"return true;\n");
+            cpImpl.printCode(0,"}\n");
+        }
+    }
+
+    // How a member (or an array element) is stored in the packed binary layout
+    enum class PackedKind
+    {
+        unsupported,
+        scalar,
+        boolean,
+        enumeration,
+        string,
+        object
+    };
+
+    struct PackedType
+    {
+        PackedKind  mKind{PackedKind::unsupported};
+        const char  *mFormat{nullptr};      // Python struct format character
+        const char  *mArrayCode{nullptr};   // Python array typecode for bulk loaded arrays
+        const char  *mCppType{nullptr};     // C++ type the value is written as
+        uint32_t    mSize{0};               // fixed size, or the minimum size of a variable length value
+    };
+
+    // Classifies the element type of a member for the packed binary layout
+    PackedType getPackedType(const MemberVariable &m) const
+    {
+        PackedType ret;
+        if (m.mIsMap || m.mIsPointer)
+        {
+            return ret;
+        }
+        static const struct
+        {
+            const char  *mType;
+            const char  *mFormat;
+            const char  *mCppType;
+            uint32_t    mSize;
+        } scalars[] =
+        {
+            { "i8", "b", "int8_t", 1 },
+            { "i16", "h", "int16_t", 2 },
+            { "i32", "i", "int32_t", 4 },
+            { "i64", "q", "int64_t", 8 },
+            { "u8", "B", "uint8_t", 1 },
+            { "u16", "H", "uint16_t", 2 },
+            { "u32", "I", "uint32_t", 4 },
+            { "u64", "Q", "uint64_t", 8 },
+            { "float", "f", "float", 4 },
+            { "double", "d", "double", 8 },
+        };
+        for (auto &i : scalars)
+        {
+            if (m.mType == i.mType)
+            {
+                ret.mKind = PackedKind::scalar;
+                ret.mFormat = i.mFormat;
+                ret.mArrayCode = i.mFormat;
+                ret.mCppType = i.mCppType;
+                ret.mSize = i.mSize;
+                return ret;
+            }
+        }
+        if (m.mType == "bool")
+        {
+            ret.mKind = PackedKind::boolean;
+            ret.mFormat = "?";
+            ret.mArrayCode = "B";
+            ret.mCppType = "bool";
+            ret.mSize = 1;
+        }
+        else if (m.mType == "string")
+        {
+            ret.mKind = PackedKind::string;
+            ret.mSize = 4;
+        }
+        else
+        {
+            const Object *obj = findObject(m.mType);
+            if (obj && obj->mIsEnum)
+            {
+                ret.mKind = PackedKind::enumeration;
+                ret.mFormat = "I";
+                ret.mArrayCode = "I";
+                ret.mCppType = "uint32_t";
+                ret.mSize = 4;
+            }
+            else if (obj && obj->mIsClass)
+            {
+                ret.mKind = PackedKind::object;
+                ret.mSize = getPackedMinSize(*obj);
+            }
+        }
+        return ret;
+    }
+
+    // True if a member is written as a run of fixed width bytes with no
+    // presence flag or count; consecutive members like this share one struct.
+    bool isPackedFixed(const MemberVariable &m) const
+    {
+        if (m.mIsArray || m.mIsOptional == OptionalType::optional)
+        {
+            return false;
+        }
+        PackedKind kind = getPackedType(m).mKind;
+        return kind == PackedKind::scalar || kind == PackedKind::boolean || kind == PackedKind::enumeration;
+    }
+
+    // The smallest number of bytes an object can be packed into
+    uint32_t getPackedMinSize(const Object &obj) const
+    {
+        std::vector< const MemberVariable * > members;
+        collectMembers(obj, members);
+        uint32_t ret = 0;
+        for (auto &i : members)
+        {
+            if (i->mIsArray)
+            {
+                ret += 4;
+            }
+            else if (i->mIsOptional == OptionalType::optional)
+            {
+                ret += 1;
+            }
+            else
+            {
+                ret += getPackedType(*i).mSize;
+            }
+        }
+        return ret;
+    }
+
+    // Returns true if every member of a class, and of the classes it contains,
+    // can be stored in the packed binary layout.
+    bool isPackable(const Object &obj, StringVector &visiting) const
+    {
+        if (std::find(visiting.begin(), visiting.end(), obj.mName) != visiting.end())
+        {
+            return true;
+        }
+        visiting.push_back(obj.mName);
+        std::vector< const MemberVariable * > members;
+        collectMembers(obj, members);
+        for (auto &i : members)
+        {
+            PackedType type = getPackedType(*i);
+            if (type.mKind == PackedKind::unsupported)
+            {
+                return false;
+            }
+            if (type.mKind == PackedKind::object && !isPackable(*findObject(i->mType), visiting))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool isPackable(const Object &obj) const
+    {
+        StringVector visiting;
+        return obj.mIsClass && isPackable(obj, visiting);
+    }
+
+    // Writes the C++ statement which appends one packed value
+    void savePackedWrite(CodePrinter &cp, uint32_t indent, const PackedType &type, const char *value) const
+    {
+        switch (type.mKind)
+        {
+            case PackedKind::scalar:
+                cp.printCode(indent,"PACKED_BYTES::put<%s>(out, %s);\n", type.mCppType, value);
+                break;
+            case PackedKind::boolean:
+                cp.printCode(indent,"PACKED_BYTES::putBool(out, %s);\n", value);
+                break;
+            case PackedKind::enumeration:
+                cp.printCode(indent,"PACKED_BYTES::put<uint32_t>(out, uint32_t(%s));\n", value);
+                break;
+            case PackedKind::string:
+                cp.printCode(indent,"PACKED_BYTES::putString(out, %s);\n", value);
+                break;
+            case PackedKind::object:
+                cp.printCode(indent,"toPackedBytes(%s, out);\n", value);
+                break;
+            case PackedKind::unsupported:
+                break;
+        }
+    }
+
+    // Writes the C++ statement which reads one packed value, returning false on failure
+    void savePackedRead(CodePrinter &cp, uint32_t indent, const MemberVariable &m, const PackedType &type, const char *value) const
+    {
+        switch (type.mKind)
+        {
+            case PackedKind::scalar:
+                cp.printCode(indent,"if ( !r.get<%s>(%s) )\n", type.mCppType, value);
+                break;
+            case PackedKind::boolean:
+                cp.printCode(indent,"if ( !r.getBool(%s) )\n", value);
+                break;
+            case PackedKind::enumeration:
+                cp.printCode(indent,"uint32_t e;\n");
+                cp.printCode(indent,"if ( !r.get<uint32_t>(e) || e >= uint32_t(sizeof(%sList) / sizeof(%sList[0])) )\n", m.mType.c_str(), m.mType.c_str());
+                cp.printCode(indent,"{\n");
+                cp.printCode(indent+1,"return false;\n");
+                cp.printCode(indent,"}\n");
+                cp.printCode(indent,"%s = %s(e);\n", value, m.mType.c_str());
+                return;
+            case PackedKind::string:
+                cp.printCode(indent,"if ( !r.getString(%s) )\n", value);
+                break;
+            case PackedKind::object:
+                cp.printCode(indent,"if ( !fromPackedBytes(r, %s) )\n", value);
+                break;
+            case PackedKind::unsupported:
+                return;
+        }
+        cp.printCode(indent,"{\n");
+        cp.printCode(indent+1,"return false;\n");
+        cp.printCode(indent,"}\n");
+    }
+
+    // Generates 'toPackedBytes' and 'fromPackedBytes' for every class whose
+    // members can be stored in the fixed little-endian packed layout described
+    // in PackedBytes.h.  The generated Python module reads and writes the same
+    // layout with 'from_bytes' and 'to_bytes'.
+    void savePackedBytes(CodePrinter &cpHeader, CodePrinter &cpImpl)
+    {
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"/*\n");
+        cpHeader.printCode(0," * Packed little-endian binary layout\n");
+        cpHeader.printCode(0," */\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"/*\n");
+        cpImpl.printCode(0,"* Packed binary layout implementation\n");
+        cpImpl.printCode(0,"*/\n");
+
+        for (auto &obj : mObjects)
+        {
+            if (!obj.mIsClass)
+            {
+                continue;
+            }
+            if (!isPackable(obj))
+            {
+                printf("** WARNING ** Packed bytes skipped for '%s'; maps and pointers are not supported\n", obj.mName.c_str());
+                continue;
+            }
+            const char *name = obj.mName.c_str();
+            std::vector< const MemberVariable * > members;
+            collectMembers(obj, members);
+
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"// Appends the packed binary form of a %s to 'out'; with 'checksum' its CRC-32C follows\n", name);
+            cpHeader.printCode(0,"void toPackedBytes(const %s& v, std::string& out, bool checksum = false);\n", name);
+            cpHeader.printCode(0,"// Reads a packed %s; returns false if the data is truncated or invalid\n", name);
+            cpHeader.printCode(0,"bool fromPackedBytes(PACKED_BYTES::Reader& r, %s& v);\n", name);
+            cpHeader.printCode(0,"// Reads a packed %s which must fill the whole buffer; with 'checksum' the\n", name);
+            cpHeader.printCode(0,"// trailing CRC-32C is verified first\n");
+            cpHeader.printCode(0,"bool fromPackedBytes(const void* data, size_t len, %s& v, bool checksum = false);\n", name);
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void toPackedBytes(const %s& v, std::string& out, bool checksum)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"size_t start = out.size();\n");
+            for (auto &i : members)
+            {
+                PackedType type = getPackedType(*i);
+                std::string value = "v." + i->mMember;
+                if (i->mIsArray)
+                {
+                    if (type.mKind == PackedKind::scalar)
+                    {
+                        cpImpl.printCode(1,"PACKED_BYTES::putArray(out, %s);\n", value.c_str());
+                        continue;
+                    }
+                    cpImpl.printCode(1,"PACKED_BYTES::putCount(out, %s.size());\n", value.c_str());
+                    cpImpl.printCode(1,"for (const auto &e : %s)\n", value.c_str());
+                    cpImpl.printCode(1,"{\n");
+                    savePackedWrite(cpImpl, 2, type, "e");
+                    cpImpl.printCode(1,"}\n");
+                }
+                else if (i->mIsOptional == OptionalType::optional)
+                {
+                    cpImpl.printCode(1,"PACKED_BYTES::putBool(out, %s.has_value());\n", value.c_str());
+                    cpImpl.printCode(1,"if ( %s.has_value() )\n", value.c_str());
+                    cpImpl.printCode(1,"{\n");
+                    savePackedWrite(cpImpl, 2, type, ("*" + value).c_str());
+                    cpImpl.printCode(1,"}\n");
+                }
+                else
+                {
+                    savePackedWrite(cpImpl, 1, type, value.c_str());
+                }
+            }
+            cpImpl.printCode(1,"if ( checksum )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"PACKED_BYTES::putChecksum(out, start);\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool fromPackedBytes(PACKED_BYTES::Reader& r, %s& v)\n", name);
+            cpImpl.printCode(0,"{\n");
+            for (auto &i : members)
+            {
+                PackedType type = getPackedType(*i);
+                std::string value = "v." + i->mMember;
+                if (i->mIsArray)
+                {
+                    if (type.mKind == PackedKind::scalar)
+                    {
+                        cpImpl.printCode(1,"if ( !r.getArray(%s) )\n", value.c_str());
+                        cpImpl.printCode(1,"{\n");
+                        cpImpl.printCode(2,"return false;\n");
+                        cpImpl.printCode(1,"}\n");
+                        continue;
+                    }
+                    cpImpl.printCode(1,"{\n");
+                    cpImpl.printCode(2,"uint32_t count;\n");
+                    cpImpl.printCode(2,"if ( !r.getCount(count, %u) )\n", type.mSize);
+                    cpImpl.printCode(2,"{\n");
+                    cpImpl.printCode(3,"return false;\n");
+                    cpImpl.printCode(2,"}\n");
+                    cpImpl.printCode(2,"%s.resize(count);\n", value.c_str());
+                    cpImpl.printCode(2,"for (uint32_t i = 0; i < count; i++)\n");
+                    cpImpl.printCode(2,"{\n");
+                    if (type.mKind == PackedKind::boolean)
+                    {
+                        // std::vector<bool> elements can't be bound to a reference
+                        cpImpl.printCode(3,"bool b;\n");
+                        savePackedRead(cpImpl, 3, *i, type, "b");
+                        cpImpl.printCode(3,"%s[i] = b;\n", value.c_str());
+                    }
+                    else
+                    {
+                        savePackedRead(cpImpl, 3, *i, type, (value + "[i]").c_str());
+                    }
+                    cpImpl.printCode(2,"}\n");
+                    cpImpl.printCode(1,"}\n");
+                }
+                else if (i->mIsOptional == OptionalType::optional)
+                {
+                    cpImpl.printCode(1,"{\n");
+                    cpImpl.printCode(2,"bool present;\n");
+                    cpImpl.printCode(2,"if ( !r.getBool(present) )\n");
+                    cpImpl.printCode(2,"{\n");
+                    cpImpl.printCode(3,"return false;\n");
+                    cpImpl.printCode(2,"}\n");
+                    cpImpl.printCode(2,"%s.reset();\n", value.c_str());
+                    cpImpl.printCode(2,"if ( present )\n");
+                    cpImpl.printCode(2,"{\n");
+                    if (type.mKind == PackedKind::object || type.mKind == PackedKind::string)
+                    {
+                        cpImpl.printCode(3,"%s.emplace();\n", value.c_str());
+                        savePackedRead(cpImpl, 3, *i, type, ("*" + value).c_str());
+                    }
+                    else
+                    {
+                        cpImpl.printCode(3,"%s value{};\n", getCppTypeString(i->mType.c_str(), true));
+                        savePackedRead(cpImpl, 3, *i, type, "value");
+                        cpImpl.printCode(3,"%s = value;\n", value.c_str());
+                    }
+                    cpImpl.printCode(2,"}\n");
+                    cpImpl.printCode(1,"}\n");
+                }
+                else if (type.mKind == PackedKind::enumeration)
+                {
+                    cpImpl.printCode(1,"{\n");
+                    savePackedRead(cpImpl, 2, *i, type, value.c_str());
+                    cpImpl.printCode(1,"}\n");
+                }
+                else
+                {
+                    savePackedRead(cpImpl, 1, *i, type, value.c_str());
+                }
+            }
+            cpImpl.printCode(1,"return true;\n");
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool fromPackedBytes(const void* data, size_t len, %s& v, bool checksum)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"if ( checksum && !PACKED_BYTES::stripChecksum(data, len) )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"return false;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"PACKED_BYTES::Reader r(data, len, 0);\n");
+            cpImpl.printCode(1,"return fromPackedBytes(r, v) && r.getOffset() == len;\n");
+            cpImpl.printCode(0,"}\n");
+        }
+    }
+
+    // Writes the Python statements which append one packed value to 'out'
+    void savePythonPackedWrite(CodePrinter &cp, uint32_t indent, const MemberVariable &m, const PackedType &type, const char *value) const
+    {
+        switch (type.mKind)
+        {
+            case PackedKind::scalar:
+            case PackedKind::enumeration:
+                cp.printCode(indent,"out += _packed_%s.pack(%s)\n", type.mFormat, value);
+                break;
+            case PackedKind::boolean:
+                cp.printCode(indent,"out += _packed_bool.pack(%s)\n", value);
+                break;
+            case PackedKind::string:
+                cp.printCode(indent,"_packed_put_str(out, %s)\n", value);
+                break;
+            case PackedKind::object:
+                cp.printCode(indent,"%s._pack_into(out)\n", value);
+                break;
+            case PackedKind::unsupported:
+                break;
+        }
+        (void)m;
+    }
+
+    // Writes the Python statements which read one packed value at 'offset' into 'target'
+    void savePythonPackedRead(CodePrinter &cp, uint32_t indent, const MemberVariable &m, const PackedType &type, const char *target) const
+    {
+        switch (type.mKind)
+        {
+            case PackedKind::scalar:
+            case PackedKind::enumeration:
+                cp.printCode(indent,"(%s,) = _packed_%s.unpack_from(view, offset)\n", target, type.mFormat);
+                cp.printCode(indent,"offset += %u\n", type.mSize);
+                break;
+            case PackedKind::boolean:
+                cp.printCode(indent,"(%s,) = _packed_bool.unpack_from(view, offset)\n", target);
+                cp.printCode(indent,"offset += 1\n");
+                break;
+            case PackedKind::string:
+                cp.printCode(indent,"%s, offset = _packed_get_str(view, offset)\n", target);
+                break;
+            case PackedKind::object:
+                cp.printCode(indent,"%s, offset = %s._unpack_from(view, offset)\n", target, m.mType.c_str());
+                break;
+            case PackedKind::unsupported:
+                break;
+        }
+    }
+
+    // Adds 'to_bytes' and 'from_bytes' to a generated Python class.  Runs of
+    // required fixed width members are read and written with one precompiled
+    // struct each and arrays of numbers are bulk converted through 'array'.
+    void savePythonPacked(CodePrinter &cp, const Object &obj) const
+    {
+        if (!isPackable(obj))
+        {
+            return;
+        }
+        const char *name = obj.mName.c_str();
+        std::vector< const MemberVariable * > members;
+        collectMembers(obj, members);
+
+        // Split the members into runs of fixed width members and single members
+        std::vector< std::vector< const MemberVariable * > > groups;
+        for (auto &i : members)
+        {
+            bool fixed = isPackedFixed(*i);
+            if (!fixed || groups.empty() || !isPackedFixed(*groups.back().front()))
+            {
+                groups.push_back(std::vector< const MemberVariable * >());
+            }
+            groups.back().push_back(i);
+        }
+
+        uint32_t structIndex = 0;
+        for (auto &g : groups)
+        {
+            if (isPackedFixed(*g.front()))
+            {
+                if (structIndex == 0)
+                {
+                    cp.printCode(0, "\n");
+                    cp.printCode(1, "# Fixed width runs of the packed binary layout (see PackedBytes.h)\n");
+                }
+                std::string format = "<";
+                for (auto &i : g)
+                {
+                    format += getPackedType(*i).mFormat;
+                }
+                cp.printCode(1, "_packed%u = struct.Struct('%s')\n", structIndex++, format.c_str());
+            }
+        }
+
+        cp.printCode(0, "\n");
+        cp.printCode(1, "def to_bytes(self):\n");
+        cp.printCode(2, "\"\"\"Returns the packed little-endian binary form of this object\"\"\"\n");
+        cp.printCode(2, "out = bytearray()\n");
+        cp.printCode(2, "self._pack_into(out)\n");
+        cp.printCode(2, "return bytes(out)\n");
+
+        cp.printCode(0, "\n");
+        cp.printCode(1, "@classmethod\n");
+        cp.printCode(1, "def from_bytes(cls, data):\n");
+        cp.printCode(2, "\"\"\"Creates an object from its packed binary form (see to_bytes)\"\"\"\n");
+        cp.printCode(2, "obj, offset = cls._unpack_from(memoryview(data), 0)\n");
+        cp.printCode(2, "if offset != len(data):\n");
+        cp.printCode(3, "raise ValueError('trailing bytes after packed %s')\n", name);
+        cp.printCode(2, "return obj\n");
+
+        cp.printCode(0, "\n");
+        cp.printCode(1, "def _pack_into(self, out):\n");
+        structIndex = 0;
+        for (auto &g : groups)
+        {
+            const MemberVariable &m = *g.front();
+            std::string value = "self." + m.mMember;
+            if (isPackedFixed(m))
+            {
+                std::string args;
+                for (auto &i : g)
+                {
+                    args += args.empty() ? "" : ", ";
+                    args += "self." + i->mMember;
+                }
+                cp.printCode(2, "out += %s._packed%u.pack(%s)\n", name, structIndex++, args.c_str());
+                continue;
+            }
+            PackedType type = getPackedType(m);
+            if (m.mIsArray)
+            {
+                if (type.mArrayCode)
+                {
+                    cp.printCode(2, "_packed_put_array(out, '%s', %s)\n", type.mArrayCode, value.c_str());
+                }
+                else
+                {
+                    cp.printCode(2, "out += _packed_I.pack(len(%s))\n", value.c_str());
+                    cp.printCode(2, "for e in %s:\n", value.c_str());
+                    savePythonPackedWrite(cp, 3, m, type, "e");
+                }
+            }
+            else if (m.mIsOptional == OptionalType::optional)
+            {
+                cp.printCode(2, "if %s is None:\n", value.c_str());
+                cp.printCode(3, "out.append(0)\n");
+                cp.printCode(2, "else:\n");
+                cp.printCode(3, "out.append(1)\n");
+                savePythonPackedWrite(cp, 3, m, type, value.c_str());
+            }
+            else
+            {
+                savePythonPackedWrite(cp, 2, m, type, value.c_str());
+            }
+        }
+        if (groups.empty())
+        {
+            cp.printCode(2, "pass\n");
+        }
+
+        cp.printCode(0, "\n");
+        cp.printCode(1, "@classmethod\n");
+        cp.printCode(1, "def _unpack_from(cls, view, offset):\n");
+        cp.printCode(2, "obj = cls.__new__(cls)\n");
+        structIndex = 0;
+        for (auto &g : groups)
+        {
+            const MemberVariable &m = *g.front();
+            std::string target = "obj." + m.mMember;
+            if (isPackedFixed(m))
+            {
+                std::string targets;
+                uint32_t size = 0;
+                for (auto &i : g)
+                {
+                    targets += targets.empty() ? "" : ", ";
+                    targets += "obj." + i->mMember;
+                    size += getPackedType(*i).mSize;
+                }
+                if (g.size() == 1)
+                {
+                    targets += ",";
+                }
+                cp.printCode(2, "(%s) = %s._packed%u.unpack_from(view, offset)\n", targets.c_str(), name, structIndex++);
+                cp.printCode(2, "offset += %u\n", size);
+                continue;
+            }
+            PackedType type = getPackedType(m);
+            if (m.mIsArray)
+            {
+                if (type.mKind == PackedKind::boolean)
+                {
+                    cp.printCode(2, "values, offset = _packed_get_array('B', 1, view, offset)\n");
+                    cp.printCode(2, "%s = [v != 0 for v in values]\n", target.c_str());
+                }
+                else if (type.mArrayCode)
+                {
+                    cp.printCode(2, "%s, offset = _packed_get_array('%s', %u, view, offset)\n", target.c_str(), type.mArrayCode, type.mSize);
+                }
+                else
+                {
+                    cp.printCode(2, "(count,) = _packed_I.unpack_from(view, offset)\n");
+                    cp.printCode(2, "offset += 4\n");
+                    cp.printCode(2, "%s = []\n", target.c_str());
+                    cp.printCode(2, "for _ in range(count):\n");
+                    savePythonPackedRead(cp, 3, m, type, "e");
+                    cp.printCode(3, "%s.append(e)\n", target.c_str());
+                }
+            }
+            else if (m.mIsOptional == OptionalType::optional)
+            {
+                cp.printCode(2, "offset += 1\n");
+                cp.printCode(2, "if view[offset - 1]:\n");
+                savePythonPackedRead(cp, 3, m, type, target.c_str());
+                cp.printCode(2, "else:\n");
+                cp.printCode(3, "%s = None\n", target.c_str());
+            }
+            else
+            {
+                savePythonPackedRead(cp, 2, m, type, target.c_str());
+            }
+        }
+        cp.printCode(2, "return obj, offset\n");
+    }
+
+    // Module level helpers used by the generated 'to_bytes'/'from_bytes' methods
+    void savePythonPackedHelpers(CodePrinter &cp) const
+    {
+        cp.printCode(0, "import array\n");
+        cp.printCode(0, "import struct\n");
+        cp.printCode(0, "import sys\n");
+        cp.printCode(0, "\n");
+        static const char *formats[] = { "b", "h", "i", "q", "B", "H", "I", "Q", "f", "d" };
+        for (auto &i : formats)
+        {
+            cp.printCode(0, "_packed_%s = struct.Struct('<%s')\n", i, i);
+        }
+        cp.printCode(0, "_packed_bool = struct.Struct('<?')\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "def _packed_put_str(out, s):\n");
+        cp.printCode(1, "b = s.encode('utf-8')\n");
+        cp.printCode(1, "out += _packed_I.pack(len(b))\n");
+        cp.printCode(1, "out += b\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "def _packed_get_str(view, offset):\n");
+        cp.printCode(1, "(n,) = _packed_I.unpack_from(view, offset)\n");
+        cp.printCode(1, "offset += 4\n");
+        cp.printCode(1, "if offset + n > len(view):\n");
+        cp.printCode(2, "raise ValueError('truncated packed string')\n");
+        cp.printCode(1, "return str(view[offset:offset + n], 'utf-8'), offset + n\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "def _packed_put_array(out, typecode, values):\n");
+        cp.printCode(1, "a = array.array(typecode, values)\n");
+        cp.printCode(1, "if sys.byteorder != 'little':\n");
+        cp.printCode(2, "a.byteswap()\n");
+        cp.printCode(1, "out += _packed_I.pack(len(a))\n");
+        cp.printCode(1, "out += a.tobytes()\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "def _packed_get_array(typecode, size, view, offset):\n");
+        cp.printCode(1, "(n,) = _packed_I.unpack_from(view, offset)\n");
+        cp.printCode(1, "offset += 4\n");
+        cp.printCode(1, "end = offset + n * size\n");
+        cp.printCode(1, "if end > len(view):\n");
+        cp.printCode(2, "raise ValueError('truncated packed array')\n");
+        cp.printCode(1, "a = array.array(typecode)\n");
+        cp.printCode(1, "a.frombytes(view[offset:end])\n");
+        cp.printCode(1, "if sys.byteorder != 'little':\n");
+        cp.printCode(2, "a.byteswap()\n");
+        cp.printCode(1, "return a.tolist(), end\n");
+    }
+
+    // Returns the C++ type a flat member is declared with in the generated class
+    std::string getFlatMemberType(const MemberVariable &m) const
+    {
+        std::string ret = getCppTypeString(m.mType.c_str(), true);
+        if (m.mIsOptional == OptionalType::optional)
+        {
+            ret = "codegen::optional<" + ret + ">";
+        }
+        return ret;
+    }
+
+    // Returns true if any member variable uses the 'KEY' engine flag
+    bool hasPrimaryKeys(void) const
+    {
+        bool ret = false;
+        for (auto &i : mObjects)
+        {
+            for (auto &j : i.mItems)
+            {
+                if ( j.mPrimaryKey )
+                {
+                    ret = true;
+                }
+            }
+        }
+        return ret;
+    }
+
+    // Collects the 'KEY' members of a class, base class members first; these
+    // make up its order preserving composite key.  Returns true if the class
+    // has a key and every key member is a number, bool, string or enum.
+    bool getKeyMembers(const Object &obj, std::vector< const MemberVariable * > &keys) const
+    {
+        std::vector< const MemberVariable * > members;
+        collectMembers(obj, members);
+        bool ret = true;
+        for (auto &i : members)
+        {
+            if (i->mPrimaryKey)
+            {
+                keys.push_back(i);
+                PackedKind kind = getPackedType(*i).mKind;
+                if (kind == PackedKind::unsupported || kind == PackedKind::object)
+                {
+                    ret = false;
+                }
+            }
+        }
+        return ret && !keys.empty();
+    }
+
+    // Collects the 'INDEX' members of a class, base class members first, which
+    // are numbers, bools, strings or enums.
+    void getIndexMembers(const Object &obj, std::vector< const MemberVariable * > &indexes) const
+    {
+        std::vector< const MemberVariable * > members;
+        collectMembers(obj, members);
+        for (auto &i : members)
+        {
+            if (i->mIndexed)
+            {
+                PackedKind kind = getPackedType(*i).mKind;
+                if (kind == PackedKind::unsupported || kind == PackedKind::object)
+                {
+                    printf("** WARNING ** Index skipped for '%s' of '%s'; indexed members must be numbers, bools, strings or enums\n", i->mMember.c_str(), obj.mName.c_str());
+                    continue;
+                }
+                indexes.push_back(i);
+            }
+        }
+    }
+
+    // The parameter type used to pass a key or index member by value
+    std::string getKeyParamType(const MemberVariable &m) const
+    {
+        if (getPackedType(m).mKind == PackedKind::string)
+        {
+            return "const std::string&";
+        }
+        return getCppTypeString(m.mType.c_str(), true);
+    }
+
+    // Writes the statement which appends the order preserving encoding of 'value'
+    void saveKeyWrite(CodePrinter &cp, uint32_t indent, const MemberVariable &m, const char *out, const char *value) const
+    {
+        if (getPackedType(m).mKind == PackedKind::enumeration)
+        {
+            cp.printCode(indent,"KEY_ENCODING::putKey(%s, uint32_t(%s));\n", out, value);
+        }
+        else
+        {
+            cp.printCode(indent,"KEY_ENCODING::putKey(%s, %s);\n", out, value);
+        }
+    }
+
+    // Generates 'toKeyBytes', 'to<Class>Key' and 'fromKeyBytes' for every class
+    // with 'KEY' members, using the memcmp ordered encoding in KeyEncoding.h.
+    void saveKeys(CodePrinter &cpHeader, CodePrinter &cpImpl)
+    {
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"/*\n");
+        cpHeader.printCode(0," * Order preserving keys\n");
+        cpHeader.printCode(0," */\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"/*\n");
+        cpImpl.printCode(0,"* Order preserving key implementation\n");
+        cpImpl.printCode(0,"*/\n");
+
+        for (auto &obj : mObjects)
+        {
+            if (!obj.mIsClass)
+            {
+                continue;
+            }
+            std::vector< const MemberVariable * > keys;
+            if (!getKeyMembers(obj, keys))
+            {
+                if (!keys.empty())
+                {
+                    printf("** WARNING ** Key skipped for '%s'; key members must be numbers, bools, strings or enums\n", obj.mName.c_str());
+                }
+                continue;
+            }
+            const char *name = obj.mName.c_str();
+            std::string memberList;
+            std::string params;
+            for (auto &i : keys)
+            {
+                memberList += (memberList.empty() ? "" : ", ") + i->mMember;
+                params += ", " + getKeyParamType(*i) + " " + i->mMember;
+            }
+
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"// Appends the order preserving key of a %s (%s) to 'out'\n", name, memberList.c_str());
+            cpHeader.printCode(0,"void toKeyBytes(const %s& v, std::string& out);\n", name);
+            cpHeader.printCode(0,"// Appends the same key built from the member values\n");
+            cpHeader.printCode(0,"void to%sKey(std::string& out%s);\n", name, params.c_str());
+            cpHeader.printCode(0,"// Sets the key members of a %s from a key which must fill the whole buffer\n", name);
+            cpHeader.printCode(0,"bool fromKeyBytes(const void* data, size_t len, %s& v);\n", name);
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void toKeyBytes(const %s& v, std::string& out)\n", name);
+            cpImpl.printCode(0,"{\n");
+            std::string args;
+            for (auto &i : keys)
+            {
+                args += ", v." + i->mMember;
+            }
+            cpImpl.printCode(1,"to%sKey(out%s);\n", name, args.c_str());
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void to%sKey(std::string& out%s)\n", name, params.c_str());
+            cpImpl.printCode(0,"{\n");
+            for (auto &i : keys)
+            {
+                saveKeyWrite(cpImpl, 1, *i, "out", i->mMember.c_str());
+            }
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool fromKeyBytes(const void* data, size_t len, %s& v)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"KEY_ENCODING::Reader r(data, len);\n");
+            for (auto &i : keys)
+            {
+                if (getPackedType(*i).mKind == PackedKind::enumeration)
+                {
+                    cpImpl.printCode(1,"{\n");
+                    cpImpl.printCode(2,"uint32_t e;\n");
+                    cpImpl.printCode(2,"if ( !r.getKey(e) || e >= uint32_t(sizeof(%sList) / sizeof(%sList[0])) )\n", i->mType.c_str(), i->mType.c_str());
+                    cpImpl.printCode(2,"{\n");
+                    cpImpl.printCode(3,"return false;\n");
+                    cpImpl.printCode(2,"}\n");
+                    cpImpl.printCode(2,"v.%s = %s(e);\n", i->mMember.c_str(), i->mType.c_str());
+                    cpImpl.printCode(1,"}\n");
+                }
+                else
+                {
+                    cpImpl.printCode(1,"if ( !r.getKey(v.%s) )\n", i->mMember.c_str());
+                    cpImpl.printCode(1,"{\n");
+                    cpImpl.printCode(2,"return false;\n");
+                    cpImpl.printCode(1,"}\n");
+                }
+            }
+            cpImpl.printCode(1,"return r.atEnd();\n");
+            cpImpl.printCode(0,"}\n");
+        }
+    }
+
+    // Generates the parts of a '<Class>Store' which keep its secondary indexes.
+    // Index entries are keyed by '<Class>.<member>', a zero byte, the order
+    // preserving encoding of the member value and the record key; the value of
+    // an entry is the record key.  They are written in the same WriteBatch as
+    // the record, so the index never disagrees with the records it points at.
+    void saveStoreIndexes(CodePrinter &cpImpl, const Object &obj, const std::vector< const MemberVariable * > &indexes)
+    {
+        const char *name = obj.mName.c_str();
+
+        for (auto &i : indexes)
+        {
+            std::string upper = i->mMember;
+            upper[0] = upcase(upper[0]);
+            std::string prefix = obj.mName + "." + i->mMember;
+            std::string param = getKeyParamType(*i);
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::findBy%s(%s value, std::vector<%s> &results)\n", name, upper.c_str(), param.c_str(), name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"make%sIndexKey(value);\n", upper.c_str());
+            cpImpl.printCode(1,"std::string end = mIndexKey;\n");
+            cpImpl.printCode(1,"KEY_ENCODING::prefixSuccessor(end);\n");
+            cpImpl.printCode(1,"return findByIndex(mIndexKey, end, results);\n");
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::findBy%sRange(%s low, %s high, std::vector<%s> &results)\n", name, upper.c_str(), param.c_str(), param.c_str(), name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"make%sIndexKey(high);\n", upper.c_str());
+            cpImpl.printCode(1,"std::string end = mIndexKey;\n");
+            cpImpl.printCode(1,"KEY_ENCODING::prefixSuccessor(end);\n");
+            cpImpl.printCode(1,"make%sIndexKey(low);\n", upper.c_str());
+            cpImpl.printCode(1,"return findByIndex(mIndexKey, end, results);\n");
+            cpImpl.printCode(0,"}\n");
+
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"// Sets 'mIndexKey' to the start of the '%s' index entries for a value\n", prefix.c_str());
+            cpImpl.printCode(0,"void %sStore::make%sIndexKey(%s value)\n", name, upper.c_str(), param.c_str());
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mIndexKey.assign(\"%s\", %u);\n", prefix.c_str(), uint32_t(prefix.size() + 1));
+            saveKeyWrite(cpImpl, 1, *i, "mIndexKey", "value");
+            cpImpl.printCode(0,"}\n");
+        }
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"// Writes a record under the key in 'mKey' together with its index updates; the\n");
+        cpImpl.printCode(0,"// key stays locked from the read of the record it replaces until the write\n");
+        cpImpl.printCode(0,"bool %sStore::putRecord(const %s &v)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"KEY_LOCKS::LockSet lock(mKey.substr(mPrefix.size()));\n");
+        cpImpl.printCode(1,"leveldb::WriteBatch batch;\n");
+        cpImpl.printCode(1,"if ( !batchRecord(v, batch) || !writeBatch(batch) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"invalidate();\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"// Adds a record under the key in 'mKey' to 'batch' and moves the index\n");
+        cpImpl.printCode(0,"// entries of the record it replaces; the old record is read from the database,\n");
+        cpImpl.printCode(0,"// so the caller holds the lock of the key until 'batch' is written\n");
+        cpImpl.printCode(0,"bool %sStore::batchRecord(const %s &v, leveldb::WriteBatch &batch)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"%s old;\n", name);
+        cpImpl.printCode(1,"bool hasOld;\n");
+        cpImpl.printCode(1,"if ( !readRecord(old, hasOld) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"mRecord.clear();\n");
+        cpImpl.printCode(1,"toPackedBytes(v, mRecord);\n");
+        cpImpl.printCode(1,"leveldb::Slice recordKey(mKey.data() + mPrefix.size(), mKey.size() - mPrefix.size());\n");
+        for (auto &i : indexes)
+        {
+            const char *member = i->mMember.c_str();
+            std::string upper = i->mMember;
+            upper[0] = upcase(upper[0]);
+            cpImpl.printCode(1,"if ( !hasOld || !(old.%s == v.%s) )\n", member, member);
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"if ( hasOld )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"make%sIndexKey(old.%s);\n", upper.c_str(), member);
+            cpImpl.printCode(3,"mIndexKey.append(recordKey.data(), recordKey.size());\n");
+            cpImpl.printCode(3,"batch.Delete(mIndexKey);\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(2,"make%sIndexKey(v.%s);\n", upper.c_str(), member);
+            cpImpl.printCode(2,"mIndexKey.append(recordKey.data(), recordKey.size());\n");
+            cpImpl.printCode(2,"batch.Put(mIndexKey, recordKey);\n");
+            cpImpl.printCode(1,"}\n");
+        }
+        cpImpl.printCode(1,"batch.Put(mKey, mRecord);\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"bool %sStore::erase(const std::string &key)\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"KEY_LOCKS::LockSet lock(key);\n");
+        cpImpl.printCode(1,"makeKey(key);\n");
+        cpImpl.printCode(1,"%s old;\n", name);
+        cpImpl.printCode(1,"bool hasOld;\n");
+        cpImpl.printCode(1,"if ( !readRecord(old, hasOld) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"leveldb::WriteBatch batch;\n");
+        cpImpl.printCode(1,"if ( hasOld )\n");
+        cpImpl.printCode(1,"{\n");
+        for (auto &i : indexes)
+        {
+            std::string upper = i->mMember;
+            upper[0] = upcase(upper[0]);
+            cpImpl.printCode(2,"make%sIndexKey(old.%s);\n", upper.c_str(), i->mMember.c_str());
+            cpImpl.printCode(2,"mIndexKey.append(key);\n");
+            cpImpl.printCode(2,"batch.Delete(mIndexKey);\n");
+        }
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"batch.Delete(mKey);\n");
+        cpImpl.printCode(1,"if ( !writeBatch(batch) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"invalidate();\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"// Reads the record stored under 'mKey', if any, so its index entries can be\n");
+        cpImpl.printCode(0,"// replaced.  A record which cannot be decoded is an error: its index entries\n");
+        cpImpl.printCode(0,"// are unknown, and overwriting or erasing it would leave them behind.\n");
+        cpImpl.printCode(0,"bool %sStore::readRecord(%s &v, bool &found)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"found = false;\n");
+        cpImpl.printCode(1,"leveldb::Status s = mDB->Get(leveldb::ReadOptions(), mKey, &mRecord);\n");
+        cpImpl.printCode(1,"if ( s.IsNotFound() )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return true;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"if ( !s.ok() )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"mLastError = s.ToString();\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"if ( !fromPackedBytes(mRecord.data(), mRecord.size(), v) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"mLastError = \"Corruption: invalid %s record for key '\" + mKey.substr(mPrefix.size()) + \"'; its index entries cannot be updated\";\n", name);
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"found = true;\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"bool %sStore::writeBatch(leveldb::WriteBatch &batch)\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"leveldb::WriteOptions options;\n");
+        cpImpl.printCode(1,"options.sync = mSync;\n");
+        cpImpl.printCode(1,"leveldb::Status s = mDB->Write(options, &batch);\n");
+        cpImpl.printCode(1,"if ( !s.ok() )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"mLastError = s.ToString();\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"// Collects the records referenced by the index entries in [begin, end); the\n");
+        cpImpl.printCode(0,"// entries and the records are read from one snapshot\n");
+        cpImpl.printCode(0,"bool %sStore::findByIndex(const std::string &begin, const std::string &end, std::vector<%s> &results)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"results.clear();\n");
+        cpImpl.printCode(1,"leveldb::ReadOptions options;\n");
+        cpImpl.printCode(1,"options.snapshot = mDB->GetSnapshot();\n");
+        cpImpl.printCode(1,"leveldb::Slice endSlice(end);\n");
+        cpImpl.printCode(1,"options.iterate_upper_bound = &endSlice;\n");
+        cpImpl.printCode(1,"leveldb::Iterator *iterator = mDB->NewIterator(options);\n");
+        cpImpl.printCode(1,"bool ret = true;\n");
+        cpImpl.printCode(1,"for (iterator->Seek(begin); iterator->Valid(); iterator->Next())\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"leveldb::Slice recordKey = iterator->value();\n");
+        cpImpl.printCode(2,"mKey = mPrefix;\n");
+        cpImpl.printCode(2,"mKey.append(recordKey.data(), recordKey.size());\n");
+        cpImpl.printCode(2,"leveldb::Status s = mDB->Get(options, mKey, &mRecord);\n");
+        cpImpl.printCode(2,"if ( !s.ok() )\n");
+        cpImpl.printCode(2,"{\n");
+        cpImpl.printCode(3,"mLastError = s.ToString();\n");
+        cpImpl.printCode(3,"ret = false;\n");
+        cpImpl.printCode(3,"break;\n");
+        cpImpl.printCode(2,"}\n");
+        cpImpl.printCode(2,"results.emplace_back();\n");
+        cpImpl.printCode(2,"if ( !fromPackedBytes(mRecord.data(), mRecord.size(), results.back()) )\n");
+        cpImpl.printCode(2,"{\n");
+        cpImpl.printCode(3,"mLastError = \"Corruption: invalid %s record for key '\" + recordKey.ToString() + \"'\";\n", name);
+        cpImpl.printCode(3,"results.pop_back();\n");
+        cpImpl.printCode(3,"ret = false;\n");
+        cpImpl.printCode(3,"break;\n");
+        cpImpl.printCode(2,"}\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"if ( ret && !iterator->status().ok() )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"mLastError = iterator->status().ToString();\n");
+        cpImpl.printCode(2,"ret = false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"delete iterator;\n");
+        cpImpl.printCode(1,"mDB->ReleaseSnapshot(options.snapshot);\n");
+        cpImpl.printCode(1,"return ret;\n");
+        cpImpl.printCode(0,"}\n");
+    }
+
+    // Generates '<Class>Store::ingest', which bulk loads records with leveldb's
+    // DB::Ingest: one sorted run holds the records and one more each index, and
+    // slices of the runs are written into table files in parallel.  Ingest
+    // cannot delete the index entries of a record it replaces, so an indexed
+    // class refuses to load into a key range which already holds records.
+    void saveStoreIngest(CodePrinter &cpImpl, const Object &obj, const std::vector< const MemberVariable * > &indexes)
+    {
+        const char *name = obj.mName.c_str();
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"bool %sStore::ingest(const std::vector<%s> &records)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"BULK_INGEST::SortedRun run([&records](size_t i, std::string &value)\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"value.clear();\n");
+        cpImpl.printCode(2,"toPackedBytes(records[i], value);\n");
+        cpImpl.printCode(1,"});\n");
+        cpImpl.printCode(1,"run.reserve(records.size());\n");
+        cpImpl.printCode(1,"for (size_t i = 0; i < records.size(); i++)\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"mKey = mPrefix;\n");
+        cpImpl.printCode(2,"toKeyBytes(records[i], mKey);\n");
+        cpImpl.printCode(2,"run.add(mKey, i);\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"run.sort();\n");
+        cpImpl.printCode(1,"if ( run.size() == 0 )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return true;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"size_t prefixSize = mPrefix.size();\n");
+        if (!indexes.empty())
+        {
+            cpImpl.printCode(1,"// The index entries of records already stored in the range would be left behind\n");
+            cpImpl.printCode(1,"leveldb::Iterator *iterator = mDB->NewIterator(leveldb::ReadOptions());\n");
+            cpImpl.printCode(1,"iterator->Seek(run.getKey(0));\n");
+            cpImpl.printCode(1,"bool stored = iterator->Valid() && iterator->key().compare(run.getKey(run.size() - 1)) <= 0;\n");
+            cpImpl.printCode(1,"delete iterator;\n");
+            cpImpl.printCode(1,"if ( stored )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mLastError = \"Invalid argument: %s records are already stored within the key range being ingested\";\n", name);
+            cpImpl.printCode(2,"return false;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"auto recordKey = [&run, prefixSize](size_t i, std::string &value)\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"value.assign(run.getKey(i), prefixSize, std::string::npos);\n");
+            cpImpl.printCode(1,"};\n");
+            for (auto &i : indexes)
+            {
+                const char *member = i->mMember.c_str();
+                std::string upper = i->mMember;
+                upper[0] = upcase(upper[0]);
+                cpImpl.printCode(1,"BULK_INGEST::SortedRun %sIndex(recordKey);\n", member);
+                cpImpl.printCode(1,"%sIndex.reserve(run.size());\n", member);
+                cpImpl.printCode(1,"for (size_t i = 0; i < run.size(); i++)\n");
+                cpImpl.printCode(1,"{\n");
+                cpImpl.printCode(2,"make%sIndexKey(records[run.getRecord(i)].%s);\n", upper.c_str(), member);
+                cpImpl.printCode(2,"mIndexKey.append(run.getKey(i), prefixSize, std::string::npos);\n");
+                cpImpl.printCode(2,"%sIndex.add(mIndexKey, i);\n", member);
+                cpImpl.printCode(1,"}\n");
+                cpImpl.printCode(1,"%sIndex.sort();\n", member);
+            }
+        }
+        cpImpl.printCode(1,"// Each run is split into slices which are written in parallel\n");
+        cpImpl.printCode(1,"leveldb::IngestOptions options;\n");
+        cpImpl.printCode(1,"std::vector< std::unique_ptr< BULK_INGEST::RunSlice > > slices;\n");
+        cpImpl.printCode(1,"run.split(size_t(options.max_threads), slices);\n");
+        for (auto &i : indexes)
+        {
+            cpImpl.printCode(1,"%sIndex.split(size_t(options.max_threads), slices);\n", i->mMember.c_str());
+        }
+        cpImpl.printCode(1,"std::vector< leveldb::IngestSource * > sources;\n");
+        cpImpl.printCode(1,"for (auto &slice : slices)\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"sources.push_back(slice.get());\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"leveldb::Status s = mDB->Ingest(options, int(sources.size()), sources.data());\n");
+        cpImpl.printCode(1,"if ( !s.ok() )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"mLastError = s.ToString();\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"if ( mCache )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"for (size_t i = 0; i < run.size(); i++)\n");
+        cpImpl.printCode(2,"{\n");
+        cpImpl.printCode(3,"const std::string &key = run.getKey(i);\n");
+        cpImpl.printCode(3,"mCache->invalidate(leveldb::Slice(key.data() + prefixSize, key.size() - prefixSize));\n");
+        cpImpl.printCode(2,"}\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+    }
+
+    // Generates 'heapBytes' for every packable class: the heap memory held by a
+    // record beyond its own size, used to charge '<Class>Cache' entries.
+    // Strings are counted when they outgrow the inline buffer.
+    void saveHeapBytes(CodePrinter &cpImpl)
+    {
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"static size_t heapBytes(const std::string &s)\n");
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return s.capacity() >= sizeof(std::string) ? s.capacity() + 1 : 0;\n");
+        cpImpl.printCode(0,"}\n");
+        std::vector< const Object * > classes;
+        for (auto &obj : mObjects)
+        {
+            if (isPackable(obj))
+            {
+                classes.push_back(&obj);
+            }
+        }
+        if (!classes.empty())
+        {
+            cpImpl.linefeed();
+        }
+        for (auto &obj : classes)
+        {
+            cpImpl.printCode(0,"static size_t heapBytes(const %s &v);\n", obj->mName.c_str());
+        }
+        for (auto &obj : classes)
+        {
+            std::vector< const MemberVariable * > members;
+            collectMembers(*obj, members);
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"static size_t heapBytes(const %s &v)\n", obj->mName.c_str());
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"size_t ret = 0;\n");
+            bool usesValue = false;
+            for (auto &i : members)
+            {
+                PackedKind kind = getPackedType(*i).mKind;
+                const char *member = i->mMember.c_str();
+                bool nested = kind == PackedKind::string || kind == PackedKind::object;
+                usesValue = usesValue || i->mIsArray || nested;
+                if (i->mIsArray)
+                {
+                    if (kind == PackedKind::boolean)
+                    {
+                        cpImpl.printCode(1,"ret += v.%s.capacity() / 8;\n", member);
+                        continue;
+                    }
+                    cpImpl.printCode(1,"ret += v.%s.capacity() * sizeof(v.%s[0]);\n", member, member);
+                    if (nested)
+                    {
+                        cpImpl.printCode(1,"for (const auto &e : v.%s)\n", member);
+                        cpImpl.printCode(1,"{\n");
+                        cpImpl.printCode(2,"ret += heapBytes(e);\n");
+                        cpImpl.printCode(1,"}\n");
+                    }
+                }
+                else if (nested && i->mIsOptional == OptionalType::optional)
+                {
+                    cpImpl.printCode(1,"if ( v.%s.has_value() )\n", member);
+                    cpImpl.printCode(1,"{\n");
+                    cpImpl.printCode(2,"ret += heapBytes(*v.%s);\n", member);
+                    cpImpl.printCode(1,"}\n");
+                }
+                else if (nested)
+                {
+                    cpImpl.printCode(1,"ret += heapBytes(v.%s);\n", member);
+                }
+            }
+            if (!usesValue)
+            {
+                cpImpl.printCode(1,"(void)v;\n");
+            }
+            cpImpl.printCode(1,"return ret;\n");
+            cpImpl.printCode(0,"}\n");
+        }
+    }
+
+    // Generates a '<Class>Cache' of decoded records on top of the leveldb
+    // sharded LRU cache (see OBJECT_CACHE::ObjectCache).  Misses are read
+    // straight from the database so the cache can be shared between threads.
+    void saveCache(CodePrinter &cpHeader, CodePrinter &cpImpl, const Object &obj)
+    {
+        const char *name = obj.mName.c_str();
+
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"// Keeps decoded %s records in a sharded LRU cache, shared and immutable, so\n", name);
+        cpHeader.printCode(0,"// a repeat read is a hash lookup rather than a block read and a decode.  Entries\n");
+        cpHeader.printCode(0,"// are charged by the memory they hold.  Thread safe; pass it to the stores and\n");
+        cpHeader.printCode(0,"// flushers which write the class so their writes invalidate it.\n");
+        cpHeader.printCode(0,"class %sCache\n", name);
+        cpHeader.printCode(0,"{\n");
+        cpHeader.printCode(0,"public:\n");
+        cpHeader.printCode(1,"// 'capacity' is the memory budget in bytes\n");
+        cpHeader.printCode(1,"%sCache(leveldb::DB *db, size_t capacity);\n", name);
+        cpHeader.linefeed();
+        cpHeader.printCode(1,"// The record stored under 'key'; nullptr if it is not found or invalid\n");
+        cpHeader.printCode(1,"std::shared_ptr< const %s > get(const std::string &key);\n", name);
+        cpHeader.printCode(1,"// Drops the cached record; needed only for writes made around the stores and flushers\n");
+        cpHeader.printCode(1,"void invalidate(const leveldb::Slice &key);\n");
+        cpHeader.printCode(1,"// Drops every entry which is not in use\n");
+        cpHeader.printCode(1,"void prune(void);\n");
+        cpHeader.printCode(1,"OBJECT_CACHE::Stats getStats(void) const;\n");
+        cpHeader.printCode(1,"// The memory a decoded record holds, which is what its entry is charged\n");
+        cpHeader.printCode(1,"static size_t getCharge(const %s &v);\n", name);
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"private:\n");
+        cpHeader.printCode(1,"leveldb::DB                 *mDB;\n");
+        cpHeader.printCode(1,"std::string                 mPrefix;\n");
+        cpHeader.printCode(1,"OBJECT_CACHE::ObjectCache   mCache;\n");
+        cpHeader.printCode(0,"};\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"%sCache::%sCache(leveldb::DB *db, size_t capacity)\n", name, name);
+        cpImpl.printCode(1,": mDB(db), mPrefix(\"%s\", %u), mCache(capacity)\n", name, uint32_t(obj.mName.size() + 1));
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"std::shared_ptr< const %s > %sCache::get(const std::string &key)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"std::shared_ptr< const void > cached = mCache.lookup(key);\n");
+        cpImpl.printCode(1,"if ( cached )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return std::static_pointer_cast< const %s >(cached);\n", name);
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"uint64_t version = mCache.getVersion();\n");
+        cpImpl.printCode(1,"std::string dbKey = mPrefix;\n");
+        cpImpl.printCode(1,"dbKey += key;\n");
+        cpImpl.printCode(1,"std::string record;\n");
+        cpImpl.printCode(1,"if ( !mDB->Get(leveldb::ReadOptions(), dbKey, &record).ok() )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return nullptr;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"std::shared_ptr< %s > v = std::make_shared< %s >();\n", name, name);
+        cpImpl.printCode(1,"if ( !fromPackedBytes(record.data(), record.size(), *v) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return nullptr;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"mCache.insert(key, v, getCharge(*v) + key.size(), version);\n");
+        cpImpl.printCode(1,"return v;\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"void %sCache::invalidate(const leveldb::Slice &key)\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"mCache.invalidate(key);\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"void %sCache::prune(void)\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"mCache.prune();\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"OBJECT_CACHE::Stats %sCache::getStats(void) const\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return mCache.getStats();\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"size_t %sCache::getCharge(const %s &v)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return sizeof(%s) + heapBytes(v);\n", name);
+        cpImpl.printCode(0,"}\n");
+    }
+
+    // Generates a '<Class>Flusher' which writes queued record snapshots through
+    // a private store on the GROUP_COMMIT flusher thread.  A required bool
+    // 'isDirty' member is cleared in the records written.
+    void saveFlusher(CodePrinter &cpHeader, CodePrinter &cpImpl, const Object &obj, bool hasKey)
+    {
+        const char *name = obj.mName.c_str();
+        std::vector< const MemberVariable * > members;
+        collectMembers(obj, members);
+        bool hasDirtyFlag = false;
+        for (auto &i : members)
+        {
+            if (i->mMember == "isDirty" && i->mType == "bool" && !i->mIsArray && i->mIsOptional == OptionalType::required)
+            {
+                hasDirtyFlag = true;
+            }
+        }
+
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"// Writes dirty %s records in large batches on a background thread (see\n", name);
+        cpHeader.printCode(0,"// GROUP_COMMIT::GroupCommitter); only the newest update of a key is written.\n");
+        cpHeader.printCode(0,"// Queued records must not change, so update a copy and queue that instead.\n");
+        if (hasDirtyFlag)
+        {
+            cpHeader.printCode(0,"// The 'isDirty' flag is cleared in the records written.\n");
+        }
+        cpHeader.printCode(0,"class %sFlusher\n", name);
+        cpHeader.printCode(0,"{\n");
+        cpHeader.printCode(0,"public:\n");
+        cpHeader.printCode(1,"// Records written are invalidated in 'cache', if given\n");
+        cpHeader.printCode(1,"explicit %sFlusher(leveldb::DB *db, const GROUP_COMMIT::Options &options = GROUP_COMMIT::Options(), %sCache *cache = nullptr);\n", name, name);
+        cpHeader.linefeed();
+        if (hasKey)
+        {
+            cpHeader.printCode(1,"// Queues the record to be written under its own key (see toKeyBytes)\n");
+            cpHeader.printCode(1,"void markDirty(std::shared_ptr< const %s > v);\n", name);
+        }
+        cpHeader.printCode(1,"// Queues the record to be written under 'key'\n");
+        cpHeader.printCode(1,"void markDirty(const std::string &key, std::shared_ptr< const %s > v);\n", name);
+        cpHeader.printCode(1,"// Blocks until everything queued so far is written; false if a write failed\n");
+        cpHeader.printCode(1,"bool flush(void);\n");
+        cpHeader.printCode(1,"GROUP_COMMIT::Metrics getMetrics(void) const;\n");
+        cpHeader.printCode(1,"std::string getLastError(void) const;\n");
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"private:\n");
+        if (hasKey)
+        {
+            cpHeader.printCode(1,"static void recordKey(const void *record, std::string &key);\n");
+        }
+        cpHeader.printCode(1,"bool writeRecord(const std::string &key, const void *record, leveldb::WriteBatch &batch, std::string &error);\n");
+        cpHeader.linefeed();
+        cpHeader.printCode(1,"%sStore mStore;   // only used on the flusher thread\n", name);
+        cpHeader.printCode(1,"GROUP_COMMIT::GroupCommitter mCommitter;   // declared last so it stops before the store goes away\n");
+        cpHeader.printCode(0,"};\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"%sFlusher::%sFlusher(leveldb::DB *db, const GROUP_COMMIT::Options &options, %sCache *cache)\n", name, name, name);
+        cpImpl.printCode(1,": mStore(db),\n");
+        cpImpl.printCode(1,"  mCommitter(db, options, %s,\n", hasKey ? (obj.mName + "Flusher::recordKey").c_str() : "nullptr");
+        cpImpl.printCode(1,"      [this](const std::string &key, const void *record, leveldb::WriteBatch &batch, std::string &error)\n");
+        cpImpl.printCode(1,"      {\n");
+        cpImpl.printCode(1,"          return writeRecord(key, record, batch, error);\n");
+        cpImpl.printCode(1,"      },\n");
+        cpImpl.printCode(1,"      [cache](const std::string &key)\n");
+        cpImpl.printCode(1,"      {\n");
+        cpImpl.printCode(1,"          if ( cache )\n");
+        cpImpl.printCode(1,"          {\n");
+        cpImpl.printCode(1,"              cache->invalidate(key);\n");
+        cpImpl.printCode(1,"          }\n");
+        cpImpl.printCode(1,"      })\n");
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(0,"}\n");
+        if (hasKey)
+        {
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sFlusher::markDirty(std::shared_ptr< const %s > v)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mCommitter.markDirty(std::move(v));\n");
+            cpImpl.printCode(0,"}\n");
+        }
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"void %sFlusher::markDirty(const std::string &key, std::shared_ptr< const %s > v)\n", name, name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"mCommitter.markDirty(key, std::move(v));\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"bool %sFlusher::flush(void)\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return mCommitter.flush();\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"GROUP_COMMIT::Metrics %sFlusher::getMetrics(void) const\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return mCommitter.getMetrics();\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"std::string %sFlusher::getLastError(void) const\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return mCommitter.getLastError();\n");
+        cpImpl.printCode(0,"}\n");
+        if (hasKey)
+        {
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sFlusher::recordKey(const void *record, std::string &key)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"toKeyBytes(*static_cast< const %s * >(record), key);\n", name);
+            cpImpl.printCode(0,"}\n");
+        }
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"bool %sFlusher::writeRecord(const std::string &key, const void *record, leveldb::WriteBatch &batch, std::string &error)\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"const %s &v = *static_cast< const %s * >(record);\n", name, name);
+        if (hasDirtyFlag)
+        {
+            cpImpl.printCode(1,"bool ok;\n");
+            cpImpl.printCode(1,"if ( v.isDirty )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"%s clean(v);\n", name);
+            cpImpl.printCode(2,"clean.isDirty = false;\n");
+            cpImpl.printCode(2,"ok = mStore.put(key, clean, batch);\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"else\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"ok = mStore.put(key, v, batch);\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"if ( !ok )\n");
+        }
+        else
+        {
+            cpImpl.printCode(1,"if ( !mStore.put(key, v, batch) )\n");
+        }
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"error = mStore.getLastError();\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+    }
+
+    // Generates a '<Class>ChangeFeed' which reads the puts and erases of the
+    // class's records in commit order through a CHANGE_FEED::ChangeReader and
+    // decodes the records.
+    void saveChangeFeed(CodePrinter &cpHeader, CodePrinter &cpImpl, const Object &obj)
+    {
+        const char *name = obj.mName.c_str();
+
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"// Reads the puts and erases of %s records in commit order from the database's\n", name);
+        cpHeader.printCode(0,"// change feed (see %sStore::open), waiting for new ones, so caches and replicas\n", name);
+        cpHeader.printCode(0,"// can follow the store without scanning it.  Resume a reader by passing the\n");
+        cpHeader.printCode(0,"// sequence number of the last event handled to the constructor.  The feed only\n");
+        cpHeader.printCode(0,"// holds the newest writes; once ok() is false read the store to catch up and\n");
+        cpHeader.printCode(0,"// start a new reader.  Use one reader per thread.\n");
+        cpHeader.printCode(0,"class %sChangeFeed\n", name);
+        cpHeader.printCode(0,"{\n");
+        cpHeader.printCode(0,"public:\n");
+        cpHeader.printCode(1,"struct Event\n");
+        cpHeader.printCode(1,"{\n");
+        cpHeader.printCode(2,"std::string     key;\n");
+        cpHeader.printCode(2,"%s value;       // left unchanged for an erase\n", name);
+        cpHeader.printCode(2,"uint64_t        sequence{0};\n");
+        cpHeader.printCode(2,"bool            erased{false};\n");
+        cpHeader.printCode(1,"};\n");
+        cpHeader.linefeed();
+        cpHeader.printCode(1,"// Starts with the first write after 'sequence'; 0 starts with the oldest write\n");
+        cpHeader.printCode(1,"// the feed holds\n");
+        cpHeader.printCode(1,"explicit %sChangeFeed(leveldb::DB *db, uint64_t sequence = 0);\n", name);
+        cpHeader.linefeed();
+        cpHeader.printCode(1,"// Stores the next put or erase in 'event', waiting up to 'timeoutMicros' for one\n");
+        cpHeader.printCode(1,"// to be committed.  False if none came or the reader failed (see ok)\n");
+        cpHeader.printCode(1,"bool next(Event &event, uint64_t timeoutMicros = 0);\n");
+        cpHeader.printCode(1,"// The sequence number to resume from once the events read so far are handled\n");
+        cpHeader.printCode(1,"uint64_t getSequence(void) const;\n");
+        cpHeader.printCode(1,"// False if the feed is off, lost writes this reader had not read, or a record\n");
+        cpHeader.printCode(1,"// could not be decoded\n");
+        cpHeader.printCode(1,"bool ok(void) const;\n");
+        cpHeader.printCode(1,"const std::string &getLastError(void) const;\n");
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"private:\n");
+        cpHeader.printCode(1,"CHANGE_FEED::ChangeReader   mReader;\n");
+        cpHeader.printCode(1,"CHANGE_FEED::Change         mChange;    // reused between events\n");
+        cpHeader.printCode(1,"bool                        mOk{true};\n");
+        cpHeader.printCode(1,"std::string                 mLastError;\n");
+        cpHeader.printCode(0,"};\n");
+
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"%sChangeFeed::%sChangeFeed(leveldb::DB *db, uint64_t sequence)\n", name, name);
+        cpImpl.printCode(1,": mReader(db, std::string(\"%s\", %u), sequence)\n", name, uint32_t(obj.mName.size() + 1));
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"bool %sChangeFeed::next(Event &event, uint64_t timeoutMicros)\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"if ( !mOk || !mReader.next(mChange, timeoutMicros) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"event.key.swap(mChange.mKey);\n");
+        cpImpl.printCode(1,"event.sequence = mChange.mSequence;\n");
+        cpImpl.printCode(1,"event.erased = mChange.mErased;\n");
+        cpImpl.printCode(1,"if ( !event.erased && !fromPackedBytes(mChange.mValue.data(), mChange.mValue.size(), event.value) )\n");
+        cpImpl.printCode(1,"{\n");
+        cpImpl.printCode(2,"mOk = false;\n");
+        cpImpl.printCode(2,"mLastError = \"Corruption: invalid %s record for key '\" + event.key + \"'\";\n", name);
+        cpImpl.printCode(2,"return false;\n");
+        cpImpl.printCode(1,"}\n");
+        cpImpl.printCode(1,"return true;\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"uint64_t %sChangeFeed::getSequence(void) const\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return mReader.getSequence();\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"bool %sChangeFeed::ok(void) const\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return mOk && mReader.ok();\n");
+        cpImpl.printCode(0,"}\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"const std::string &%sChangeFeed::getLastError(void) const\n", name);
+        cpImpl.printCode(0,"{\n");
+        cpImpl.printCode(1,"return mLastError.empty() ? mReader.getLastError() : mLastError;\n");
+        cpImpl.printCode(0,"}\n");
+    }
+
+    // Generates a '<Class>Store' for every class which can be stored in the
+    // packed binary layout.  The stores wrap a leveldb database and keep each
+    // record under its class name, a zero byte and the record key, so several
+    // stores can share one database.  They are written to their own files so
+    // schemas which don't use them need not link leveldb.
+    void saveStore(CodePrinter &cpHeader, CodePrinter &cpImpl)
+    {
+        cpHeader.printCode(0, "#pragma once\n");
+        cpHeader.printCode(0, "\n");
+        cpHeader.printCode(0,"// clang-format off\n");
+        cpHeader.printCode(0, "// CreateDOM: Schema Generation tool written by John W. Ratcliff, 2017\n");
+        cpHeader.printCode(0, "// Warning:This source file was auto-generated by the CreateDOM tool. Do not try to edit this source file manually!\n");
+        cpHeader.printCode(0, "// The Google DOCs Schema Spreadsheet for this source came from: %s\n", mURL.c_str());
+        cpHeader.printCode(0, "\n");
+        cpHeader.printCode(0, "#include \"%s.h\"\n", mFilename.c_str());
+        cpHeader.printCode(0, "#include \"ChangeFeed.h\"\n");
+        cpHeader.printCode(0, "#include \"GroupCommit.h\"\n");
+        cpHeader.printCode(0, "#include \"KeyLocks.h\"\n");
+        cpHeader.printCode(0, "#include \"ObjectCache.h\"\n");
+        cpHeader.printCode(0, "#include <functional>\n");
+        cpHeader.printCode(0, "#include <memory>\n");
+        cpHeader.printCode(0, "#include <string>\n");
+        cpHeader.printCode(0, "\n");
+        cpHeader.printCode(0, "namespace leveldb\n");
+        cpHeader.printCode(0, "{\n");
+        cpHeader.printCode(0, "    class DB;\n");
+        cpHeader.printCode(0, "    class Iterator;\n");
+        cpHeader.printCode(0, "    class WriteBatch;\n");
+        cpHeader.printCode(0, "}\n");
+        cpHeader.printCode(0, "\n");
+        cpHeader.printCode(0, "namespace %s\n", mNamespace.c_str());
+        cpHeader.printCode(0, "{\n");
+
+        cpImpl.printCode(0,"// clang-format off\n");
+        cpImpl.printCode(0, "// CreateDOM: Schema Generation tool written by John W. Ratcliff, 2019\n");
+        cpImpl.printCode(0, "// Typed record stores on top of leveldb; records are kept in the packed binary layout.\n");
+        cpImpl.printCode(0, "// The Google DOCs Schema Spreadsheet for this source came from: %s\n", mURL.c_str());
+        cpImpl.printCode(0,"#include \"%sStore.h\"\n", mFilename.c_str());
+        cpImpl.printCode(0,"#include \"leveldb/db.h\"\n");
+        cpImpl.printCode(0,"#include \"leveldb/iterator.h\"\n");
+        cpImpl.printCode(0,"#include \"leveldb/options.h\"\n");
+        cpImpl.printCode(0,"#include \"leveldb/write_batch.h\"\n");
+        cpImpl.printCode(0,"#include \"KeyEncoding.h\"\n");
+        cpImpl.printCode(0,"#include \"BulkIngest.h\"\n");
+        cpImpl.printCode(0,"#include <utility>\n");
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"namespace %s\n", mNamespace.c_str());
+        cpImpl.printCode(0,"{\n");
+        saveHeapBytes(cpImpl);
+
+        for (auto &obj : mObjects)
+        {
+            if (!obj.mIsClass)
+            {
+                continue;
+            }
+            if (!isPackable(obj))
+            {
+                printf("** WARNING ** Store skipped for '%s'; maps and pointers are not supported\n", obj.mName.c_str());
+                continue;
+            }
+            const char *name = obj.mName.c_str();
+            std::vector< const MemberVariable * > keys;
+            bool hasKey = getKeyMembers(obj, keys);
+            std::vector< const MemberVariable * > indexes;
+            getIndexMembers(obj, indexes);
+
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"class %sCache;\n", name);
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"// Stores %s records in a leveldb database keyed by string.  The store reuses\n", name);
+            cpHeader.printCode(0,"// its key and record buffers, so it must only be used by one thread at a time.\n");
+            if (!indexes.empty())
+            {
+                cpHeader.printCode(0,"// A put or erase locks its key (see KEY_LOCKS) while it reads the record it\n");
+                cpHeader.printCode(0,"// replaces and writes the index updates, so other stores on the same database\n");
+                cpHeader.printCode(0,"// and the %sFlusher may write the same keys from other threads.  A put into\n", name);
+                cpHeader.printCode(0,"// a caller's WriteBatch does not lock; see put(key, v, batch).\n");
+            }
+            cpHeader.printCode(0,"class %sStore\n", name);
+            cpHeader.printCode(0,"{\n");
+            cpHeader.printCode(0,"public:\n");
+            cpHeader.printCode(1,"// Visits the records of the store, or of a key range of it, in key order\n");
+            cpHeader.printCode(1,"class Iterator\n");
+            cpHeader.printCode(1,"{\n");
+            cpHeader.printCode(1,"public:\n");
+            cpHeader.printCode(2,"Iterator(Iterator &&other);\n");
+            cpHeader.printCode(2,"~Iterator(void);\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(2,"bool valid(void) const;\n");
+            cpHeader.printCode(2,"void next(void);\n");
+            cpHeader.printCode(2,"// Positions at the first record of the range\n");
+            cpHeader.printCode(2,"void seekToFirst(void);\n");
+            cpHeader.printCode(2,"// Positions at the first record whose key is at or after 'key'\n");
+            cpHeader.printCode(2,"void seek(const std::string &key);\n");
+            cpHeader.printCode(2,"// The key of the current record\n");
+            cpHeader.printCode(2,"std::string key(void) const;\n");
+            cpHeader.printCode(2,"// The current record; it is decoded into the same object at every position\n");
+            cpHeader.printCode(2,"const %s &value(void) const;\n", name);
+            cpHeader.printCode(2,"// False if a record could not be decoded or leveldb reported an error\n");
+            cpHeader.printCode(2,"bool ok(void) const;\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"private:\n");
+            cpHeader.printCode(2,"friend class %sStore;\n", name);
+            cpHeader.printCode(2,"Iterator(leveldb::Iterator *iterator, const std::string &prefix, const std::string &start);\n");
+            cpHeader.printCode(2,"Iterator(const Iterator &) = delete;\n");
+            cpHeader.printCode(2,"Iterator &operator=(const Iterator &) = delete;\n");
+            cpHeader.printCode(2,"void decode(void);\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(2,"leveldb::Iterator   *mIterator{nullptr};\n");
+            cpHeader.printCode(2,"std::string         mPrefix;\n");
+            cpHeader.printCode(2,"std::string         mStart;         // the first key of the range\n");
+            cpHeader.printCode(2,"std::string         mSeekKey;\n");
+            cpHeader.printCode(2,"%s mValue;\n", name);
+            cpHeader.printCode(2,"bool                mValid{false};\n");
+            cpHeader.printCode(2,"bool                mOk{true};\n");
+            cpHeader.printCode(1,"};\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"%sStore(void);\n", name);
+            cpHeader.printCode(1,"// Uses a database opened elsewhere, e.g. by another store; it is not closed by this store\n");
+            cpHeader.printCode(1,"explicit %sStore(leveldb::DB *db);\n", name);
+            cpHeader.printCode(1,"~%sStore(void);\n", name);
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"// Opens the database at 'path', creating it if needed; blocks are LZ compressed.  A\n");
+            cpHeader.printCode(1,"// non-zero 'changeFeedSize' keeps that many bytes of the newest writes in memory\n");
+            cpHeader.printCode(1,"// for change feed readers (see %sChangeFeed)\n", name);
+            cpHeader.printCode(1,"bool open(const char *path, size_t changeFeedSize = 0);\n");
+            cpHeader.printCode(1,"void close(void);\n");
+            cpHeader.printCode(1,"// When set every put and erase waits until the write is on disk\n");
+            cpHeader.printCode(1,"void setSync(bool sync);\n");
+            cpHeader.printCode(1,"// Every record the store writes or erases is then invalidated in 'cache'\n");
+            cpHeader.printCode(1,"void setCache(%sCache *cache);\n", name);
+            cpHeader.printCode(1,"// Scans read table files that are not memory mapped this many bytes at a\n");
+            cpHeader.printCode(1,"// time (256KB by default); 0 reads them one block at a time\n");
+            cpHeader.printCode(1,"void setReadahead(size_t bytes);\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"bool put(const std::string &key, const %s &v);\n", name);
+            if (hasKey)
+            {
+                cpHeader.printCode(1,"// Stores the record under its own key (see toKeyBytes)\n");
+                cpHeader.printCode(1,"bool put(const %s &v);\n", name);
+            }
+            cpHeader.printCode(1,"// Adds the record%s to 'batch' instead of writing it; a batch\n", indexes.empty() ? "" : " and its index updates");
+            cpHeader.printCode(1,"// must hold at most one put of a key%s\n", indexes.empty() ? "" : ".  The record it replaces is read now, so while");
+            if (!indexes.empty())
+            {
+                cpHeader.printCode(1,"// other threads write the key hold a KEY_LOCKS::LockSet on it (the key passed\n");
+                cpHeader.printCode(1,"// to put%s) until the batch is written\n", hasKey ? ", or the toKeyBytes of the record" : "");
+            }
+            cpHeader.printCode(1,"bool put(const std::string &key, const %s &v, leveldb::WriteBatch &batch);\n", name);
+            if (hasKey)
+            {
+                cpHeader.printCode(1,"bool put(const %s &v, leveldb::WriteBatch &batch);\n", name);
+                cpHeader.printCode(1,"// Bulk loads records under their own keys, written straight into table files\n");
+                cpHeader.printCode(1,"// through leveldb's DB::Ingest; other writers wait while it runs.%s\n", indexes.empty() ? "" : " Fails if");
+                if (!indexes.empty())
+                {
+                    cpHeader.printCode(1,"// records are already stored between the smallest and the largest key loaded.\n");
+                }
+                cpHeader.printCode(1,"bool ingest(const std::vector<%s> &records);\n", name);
+            }
+            cpHeader.printCode(1,"// Returns false if the key is not found or the record is invalid\n");
+            cpHeader.printCode(1,"bool get(const std::string &key, %s &v);\n", name);
+            cpHeader.printCode(1,"bool erase(const std::string &key);\n");
+            cpHeader.printCode(1,"// Returns an iterator positioned at the first record\n");
+            cpHeader.printCode(1,"Iterator newIterator(void) const;\n");
+            cpHeader.printCode(1,"// Returns an iterator over the records whose keys start with 'prefix'\n");
+            cpHeader.printCode(1,"Iterator scanPrefix(const std::string &prefix) const;\n");
+            cpHeader.printCode(1,"// Returns an iterator over the records whose keys are within [low, high)\n");
+            cpHeader.printCode(1,"Iterator scanRange(const std::string &low, const std::string &high) const;\n");
+            cpHeader.printCode(1,"// Calls 'fn' with the key and record of every record within [low, high), in\n");
+            cpHeader.printCode(1,"// key order, until it returns false.  The key and the record are reused for\n");
+            cpHeader.printCode(1,"// every call.  Returns false if a record could not be read\n");
+            cpHeader.printCode(1,"bool forEachInRange(const std::string &low, const std::string &high, const std::function<bool(const std::string &, const %s &)> &fn);\n", name);
+            cpHeader.printCode(1,"// Like forEachInRange for the records whose keys start with 'prefix'\n");
+            cpHeader.printCode(1,"bool forEachWithPrefix(const std::string &prefix, const std::function<bool(const std::string &, const %s &)> &fn);\n", name);
+            for (auto &i : indexes)
+            {
+                std::string upper = i->mMember;
+                upper[0] = upcase(upper[0]);
+                std::string param = getKeyParamType(*i);
+                cpHeader.linefeed();
+                cpHeader.printCode(1,"// The records whose '%s' equals 'value', found through its index\n", i->mMember.c_str());
+                cpHeader.printCode(1,"bool findBy%s(%s value, std::vector<%s> &results);\n", upper.c_str(), param.c_str(), name);
+                cpHeader.printCode(1,"// The records whose '%s' is within [low, high], ordered by value\n", i->mMember.c_str());
+                cpHeader.printCode(1,"bool findBy%sRange(%s low, %s high, std::vector<%s> &results);\n", upper.c_str(), param.c_str(), param.c_str(), name);
+            }
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"leveldb::DB *getDB(void) const;\n");
+            cpHeader.printCode(1,"const std::string &getLastError(void) const;\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"private:\n");
+            cpHeader.printCode(1,"%sStore(const %sStore &) = delete;\n", name, name);
+            cpHeader.printCode(1,"%sStore &operator=(const %sStore &) = delete;\n", name, name);
+            cpHeader.printCode(1,"const std::string &makeKey(const std::string &key);\n");
+            cpHeader.printCode(1,"Iterator makeIterator(const std::string &start, const std::string &end) const;\n");
+            cpHeader.printCode(1,"bool forEach(Iterator &it, const std::function<bool(const std::string &, const %s &)> &fn);\n", name);
+            cpHeader.printCode(1,"bool putRecord(const %s &v);\n", name);
+            cpHeader.printCode(1,"bool batchRecord(const %s &v, leveldb::WriteBatch &batch);\n", name);
+            cpHeader.printCode(1,"void invalidate(void);\n");
+            if (!indexes.empty())
+            {
+                cpHeader.printCode(1,"bool readRecord(%s &v, bool &found);\n", name);
+                cpHeader.printCode(1,"bool writeBatch(leveldb::WriteBatch &batch);\n");
+                cpHeader.printCode(1,"bool findByIndex(const std::string &begin, const std::string &end, std::vector<%s> &results);\n", name);
+                for (auto &i : indexes)
+                {
+                    std::string upper = i->mMember;
+                    upper[0] = upcase(upper[0]);
+                    cpHeader.printCode(1,"void make%sIndexKey(%s value);\n", upper.c_str(), getKeyParamType(*i).c_str());
+                }
+            }
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"leveldb::DB     *mDB{nullptr};\n");
+            cpHeader.printCode(1,"bool            mOwnsDB{false};\n");
+            cpHeader.printCode(1,"bool            mSync{false};\n");
+            cpHeader.printCode(1,"size_t          mReadahead{256 * 1024};\n");
+            cpHeader.printCode(1,"%sCache *mCache{nullptr};\n", name);
+            cpHeader.printCode(1,"std::string     mPrefix;        // the class name followed by a zero byte\n");
+            cpHeader.printCode(1,"std::string     mKey;           // reused database key\n");
+            cpHeader.printCode(1,"std::string     mRecord;        // reused encode and decode buffer\n");
+            cpHeader.printCode(1,"std::string     mScanKey;       // reused key passed to forEach callbacks\n");
+            if (!indexes.empty())
+            {
+                cpHeader.printCode(1,"std::string     mIndexKey;      // reused index entry key\n");
+            }
+            cpHeader.printCode(1,"std::string     mLastError;\n");
+            cpHeader.printCode(0,"};\n");
+
+            // The iterator
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::Iterator::Iterator(leveldb::Iterator *iterator, const std::string &prefix, const std::string &start)\n", name);
+            cpImpl.printCode(1,": mIterator(iterator), mPrefix(prefix), mStart(start)\n");
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::Iterator::Iterator(Iterator &&other)\n", name);
+            cpImpl.printCode(1,": mIterator(other.mIterator), mPrefix(std::move(other.mPrefix)), mStart(std::move(other.mStart)), mValue(std::move(other.mValue)), mValid(other.mValid), mOk(other.mOk)\n");
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"other.mIterator = nullptr;\n");
+            cpImpl.printCode(1,"other.mValid = false;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::Iterator::~Iterator(void)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"delete mIterator;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::Iterator::valid(void) const\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"return mValid;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sStore::Iterator::next(void)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"if ( mValid )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mIterator->Next();\n");
+            cpImpl.printCode(2,"decode();\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sStore::Iterator::seekToFirst(void)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mOk = true;\n");
+            cpImpl.printCode(1,"mSeekKey = mPrefix;\n");
+            cpImpl.printCode(1,"mSeekKey += mStart;\n");
+            cpImpl.printCode(1,"mIterator->Seek(mSeekKey);\n");
+            cpImpl.printCode(1,"decode();\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sStore::Iterator::seek(const std::string &key)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mOk = true;\n");
+            cpImpl.printCode(1,"mSeekKey = mPrefix;\n");
+            cpImpl.printCode(1,"mSeekKey += key;\n");
+            cpImpl.printCode(1,"mIterator->Seek(mSeekKey);\n");
+            cpImpl.printCode(1,"decode();\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"std::string %sStore::Iterator::key(void) const\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"leveldb::Slice k = mIterator->key();\n");
+            cpImpl.printCode(1,"return std::string(k.data() + mPrefix.size(), k.size() - mPrefix.size());\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"const %s &%sStore::Iterator::value(void) const\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"return mValue;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::Iterator::ok(void) const\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"return mOk;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"// Decodes the record at the current position; the leveldb iterator itself\n");
+            cpImpl.printCode(0,"// stops at the end of the range, which is never past the store's keys\n");
+            cpImpl.printCode(0,"void %sStore::Iterator::decode(void)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mValid = false;\n");
+            cpImpl.printCode(1,"if ( !mIterator->Valid() )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mOk = mOk && mIterator->status().ok();\n");
+            cpImpl.printCode(2,"return;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"leveldb::Slice v = mIterator->value();\n");
+            cpImpl.printCode(1,"if ( !fromPackedBytes(v.data(), v.size(), mValue) )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mOk = false;\n");
+            cpImpl.printCode(2,"return;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"mValid = true;\n");
+            cpImpl.printCode(0,"}\n");
+
+            // The store
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::%sStore(void)\n", name, name);
+            cpImpl.printCode(1,": mPrefix(\"%s\", %u)\n", name, uint32_t(obj.mName.size() + 1));
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::%sStore(leveldb::DB *db)\n", name, name);
+            cpImpl.printCode(1,": mDB(db), mPrefix(\"%s\", %u)\n", name, uint32_t(obj.mName.size() + 1));
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::~%sStore(void)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"close();\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::open(const char *path, size_t changeFeedSize)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"close();\n");
+            cpImpl.printCode(1,"leveldb::Options options;\n");
+            cpImpl.printCode(1,"options.create_if_missing = true;\n");
+            cpImpl.printCode(1,"options.compression = leveldb::kLzCompression;\n");
+            cpImpl.printCode(1,"options.change_feed_size = changeFeedSize;\n");
+            cpImpl.printCode(1,"leveldb::Status s = leveldb::DB::Open(options, path, &mDB);\n");
+            cpImpl.printCode(1,"if ( !s.ok() )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mLastError = s.ToString();\n");
+            cpImpl.printCode(2,"mDB = nullptr;\n");
+            cpImpl.printCode(2,"return false;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"mOwnsDB = true;\n");
+            cpImpl.printCode(1,"return true;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sStore::close(void)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"if ( mOwnsDB )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"delete mDB;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"mDB = nullptr;\n");
+            cpImpl.printCode(1,"mOwnsDB = false;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sStore::setSync(bool sync)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mSync = sync;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sStore::setReadahead(size_t bytes)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mReadahead = bytes;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"void %sStore::setCache(%sCache *cache)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mCache = cache;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::put(const std::string &key, const %s &v)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"makeKey(key);\n");
+            cpImpl.printCode(1,"return putRecord(v);\n");
+            cpImpl.printCode(0,"}\n");
+            if (hasKey)
+            {
+                cpImpl.linefeed();
+                cpImpl.printCode(0,"bool %sStore::put(const %s &v)\n", name, name);
+                cpImpl.printCode(0,"{\n");
+                cpImpl.printCode(1,"mKey = mPrefix;\n");
+                cpImpl.printCode(1,"toKeyBytes(v, mKey);\n");
+                cpImpl.printCode(1,"return putRecord(v);\n");
+                cpImpl.printCode(0,"}\n");
+            }
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::put(const std::string &key, const %s &v, leveldb::WriteBatch &batch)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"makeKey(key);\n");
+            cpImpl.printCode(1,"return batchRecord(v, batch);\n");
+            cpImpl.printCode(0,"}\n");
+            if (hasKey)
+            {
+                cpImpl.linefeed();
+                cpImpl.printCode(0,"bool %sStore::put(const %s &v, leveldb::WriteBatch &batch)\n", name, name);
+                cpImpl.printCode(0,"{\n");
+                cpImpl.printCode(1,"mKey = mPrefix;\n");
+                cpImpl.printCode(1,"toKeyBytes(v, mKey);\n");
+                cpImpl.printCode(1,"return batchRecord(v, batch);\n");
+                cpImpl.printCode(0,"}\n");
+                saveStoreIngest(cpImpl, obj, indexes);
+            }
+            if (indexes.empty())
+            {
+                cpImpl.linefeed();
+                cpImpl.printCode(0,"// Writes a record under the key in 'mKey'\n");
+                cpImpl.printCode(0,"bool %sStore::putRecord(const %s &v)\n", name, name);
+                cpImpl.printCode(0,"{\n");
+                cpImpl.printCode(1,"mRecord.clear();\n");
+                cpImpl.printCode(1,"toPackedBytes(v, mRecord);\n");
+                cpImpl.printCode(1,"leveldb::WriteOptions options;\n");
+                cpImpl.printCode(1,"options.sync = mSync;\n");
+                cpImpl.printCode(1,"leveldb::Status s = mDB->Put(options, mKey, mRecord);\n");
+                cpImpl.printCode(1,"if ( !s.ok() )\n");
+                cpImpl.printCode(1,"{\n");
+                cpImpl.printCode(2,"mLastError = s.ToString();\n");
+                cpImpl.printCode(2,"return false;\n");
+                cpImpl.printCode(1,"}\n");
+                cpImpl.printCode(1,"invalidate();\n");
+                cpImpl.printCode(1,"return true;\n");
+                cpImpl.printCode(0,"}\n");
+                cpImpl.linefeed();
+                cpImpl.printCode(0,"// Adds a record under the key in 'mKey' to 'batch'\n");
+                cpImpl.printCode(0,"bool %sStore::batchRecord(const %s &v, leveldb::WriteBatch &batch)\n", name, name);
+                cpImpl.printCode(0,"{\n");
+                cpImpl.printCode(1,"mRecord.clear();\n");
+                cpImpl.printCode(1,"toPackedBytes(v, mRecord);\n");
+                cpImpl.printCode(1,"batch.Put(mKey, mRecord);\n");
+                cpImpl.printCode(1,"return true;\n");
+                cpImpl.printCode(0,"}\n");
+            }
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::get(const std::string &key, %s &v)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"leveldb::Status s = mDB->Get(leveldb::ReadOptions(), makeKey(key), &mRecord);\n");
+            cpImpl.printCode(1,"if ( !s.ok() )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mLastError = s.ToString();\n");
+            cpImpl.printCode(2,"return false;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"if ( !fromPackedBytes(mRecord.data(), mRecord.size(), v) )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mLastError = \"Corruption: invalid %s record for key '\" + key + \"'\";\n", name);
+            cpImpl.printCode(2,"return false;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"return true;\n");
+            cpImpl.printCode(0,"}\n");
+            if (indexes.empty())
+            {
+                cpImpl.linefeed();
+                cpImpl.printCode(0,"bool %sStore::erase(const std::string &key)\n", name);
+                cpImpl.printCode(0,"{\n");
+                cpImpl.printCode(1,"leveldb::WriteOptions options;\n");
+                cpImpl.printCode(1,"options.sync = mSync;\n");
+                cpImpl.printCode(1,"leveldb::Status s = mDB->Delete(options, makeKey(key));\n");
+                cpImpl.printCode(1,"if ( !s.ok() )\n");
+                cpImpl.printCode(1,"{\n");
+                cpImpl.printCode(2,"mLastError = s.ToString();\n");
+                cpImpl.printCode(2,"return false;\n");
+                cpImpl.printCode(1,"}\n");
+                cpImpl.printCode(1,"invalidate();\n");
+                cpImpl.printCode(1,"return true;\n");
+                cpImpl.printCode(0,"}\n");
+            }
+            else
+            {
+                saveStoreIndexes(cpImpl, obj, indexes);
+            }
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::Iterator %sStore::newIterator(void) const\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"return makeIterator(std::string(), std::string());\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::Iterator %sStore::scanPrefix(const std::string &prefix) const\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"std::string end = prefix;\n");
+            cpImpl.printCode(1,"if ( !KEY_ENCODING::prefixSuccessor(end) )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"return makeIterator(prefix, std::string());\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"return makeIterator(prefix, mPrefix + end);\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"%sStore::Iterator %sStore::scanRange(const std::string &low, const std::string &high) const\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"return makeIterator(low, mPrefix + high);\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::forEachInRange(const std::string &low, const std::string &high, const std::function<bool(const std::string &, const %s &)> &fn)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"Iterator it = scanRange(low, high);\n");
+            cpImpl.printCode(1,"return forEach(it, fn);\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::forEachWithPrefix(const std::string &prefix, const std::function<bool(const std::string &, const %s &)> &fn)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"Iterator it = scanPrefix(prefix);\n");
+            cpImpl.printCode(1,"return forEach(it, fn);\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"// Returns an iterator over the records from the key 'start' up to the database\n");
+            cpImpl.printCode(0,"// key 'end' (excluded), positioned at the first; an empty 'end' is the end of\n");
+            cpImpl.printCode(0,"// the store.  leveldb stops at the bound without reading the blocks after it\n");
+            cpImpl.printCode(0,"%sStore::Iterator %sStore::makeIterator(const std::string &start, const std::string &end) const\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"std::string bound = end;\n");
+            cpImpl.printCode(1,"if ( bound.empty() )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"bound = mPrefix;\n");
+            cpImpl.printCode(2,"KEY_ENCODING::prefixSuccessor(bound);\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"leveldb::Slice boundSlice(bound);\n");
+            cpImpl.printCode(1,"leveldb::ReadOptions options;\n");
+            cpImpl.printCode(1,"options.iterate_upper_bound = &boundSlice;\n");
+            cpImpl.printCode(1,"options.readahead_size = mReadahead;\n");
+            cpImpl.printCode(1,"Iterator ret(mDB->NewIterator(options), mPrefix, start);\n");
+            cpImpl.printCode(1,"ret.seekToFirst();\n");
+            cpImpl.printCode(1,"return ret;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"bool %sStore::forEach(Iterator &it, const std::function<bool(const std::string &, const %s &)> &fn)\n", name, name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"for (; it.valid(); it.next())\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"leveldb::Slice k = it.mIterator->key();\n");
+            cpImpl.printCode(2,"mScanKey.assign(k.data() + mPrefix.size(), k.size() - mPrefix.size());\n");
+            cpImpl.printCode(2,"if ( !fn(mScanKey, it.value()) )\n");
+            cpImpl.printCode(2,"{\n");
+            cpImpl.printCode(3,"break;\n");
+            cpImpl.printCode(2,"}\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"if ( !it.ok() )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mLastError = it.mIterator->status().ok() ? \"Corruption: invalid %s record\" : it.mIterator->status().ToString();\n", name);
+            cpImpl.printCode(2,"return false;\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(1,"return true;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"leveldb::DB *%sStore::getDB(void) const\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"return mDB;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"const std::string &%sStore::getLastError(void) const\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"return mLastError;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"const std::string &%sStore::makeKey(const std::string &key)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"mKey = mPrefix;\n");
+            cpImpl.printCode(1,"mKey += key;\n");
+            cpImpl.printCode(1,"return mKey;\n");
+            cpImpl.printCode(0,"}\n");
+            cpImpl.linefeed();
+            cpImpl.printCode(0,"// Drops the record under 'mKey' from the cache once it has been written\n");
+            cpImpl.printCode(0,"void %sStore::invalidate(void)\n", name);
+            cpImpl.printCode(0,"{\n");
+            cpImpl.printCode(1,"if ( mCache )\n");
+            cpImpl.printCode(1,"{\n");
+            cpImpl.printCode(2,"mCache->invalidate(leveldb::Slice(mKey.data() + mPrefix.size(), mKey.size() - mPrefix.size()));\n");
+            cpImpl.printCode(1,"}\n");
+            cpImpl.printCode(0,"}\n");
+
+            saveCache(cpHeader, cpImpl, obj);
+            saveFlusher(cpHeader, cpImpl, obj, hasKey);
+            saveChangeFeed(cpHeader, cpImpl, obj);
+        }
+
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"} // End of namespace:%s\n", mNamespace.c_str());
+        cpImpl.linefeed();
+        cpImpl.printCode(0,"} // End of namespace:%s\n", mNamespace.c_str());
+    }
+
+    // Generates a '<Class>Columns' struct of arrays container for every class
+    // whose members are scalars, strings or enums.  Required numeric members
+    // get sum/min/max/countIf methods which run over the contiguous column.
+    // The columns are named after the members, so the parameters and locals
+    // of the generated methods take '_' prefixed names no member can hide.
+    void saveColumns(CodePrinter &cpHeader)
+    {
+        ClassEnumMap classEnumMap;
+        for (auto &i : mObjects)
+        {
+            classEnumMap[i.mName] = i.mIsEnum;
+        }
+
+        cpHeader.linefeed();
+        cpHeader.printCode(0,"/*\n");
+        cpHeader.printCode(0," * Struct of arrays containers\n");
+        cpHeader.printCode(0," */\n");
+
+        for (auto &obj : mObjects)
+        {
+            if (!obj.mIsClass)
+            {
+                continue;
+            }
+            std::vector< const MemberVariable * > members;
+            if (!getFlatMembers(obj, members, classEnumMap))
+            {
+                printf("** WARNING ** Columns container skipped for '%s'; only classes made of scalars, strings and enums are supported\n", obj.mName.c_str());
+                continue;
+            }
+            const MemberVariable *clash = nullptr;
+            for (auto &i : members)
+            {
+                static const char *methods[] = { "push_back", "get", "size", "empty", "clear", "reserve" };
+                for (const char *m : methods)
+                {
+                    if (i->mMember == m)
+                    {
+                        clash = i;
+                    }
+                }
+            }
+            if (clash)
+            {
+                printf("** WARNING ** Columns container skipped for '%s'; its member '%s' has the name of a container method\n", obj.mName.c_str(), clash->mMember.c_str());
+                continue;
+            }
+            const char *name = obj.mName.c_str();
+            const char *first = members[0]->mMember.c_str();
+
+            cpHeader.linefeed();
+            cpHeader.printCode(0,"// Stores %s records with each member in its own contiguous column\n", name);
+            cpHeader.printCode(0,"class %sColumns\n", name);
+            cpHeader.printCode(0,"{\n");
+            cpHeader.printCode(0,"public:\n");
+            cpHeader.printCode(1,"void push_back(const %s &_record)\n", name);
+            cpHeader.printCode(1,"{\n");
+            for (auto &i : members)
+            {
+                cpHeader.printCode(2,"%s.push_back(_record.%s);\n", i->mMember.c_str(), i->mMember.c_str());
+            }
+            cpHeader.printCode(1,"}\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"%s get(size_t _index) const\n", name);
+            cpHeader.printCode(1,"{\n");
+            cpHeader.printCode(2,"%s _record;\n", name);
+            for (auto &i : members)
+            {
+                if (i->mType == "bool" && i->mIsOptional != OptionalType::optional)
+                {
+                    cpHeader.printCode(2,"_record.%s = %s[_index] != 0;\n", i->mMember.c_str(), i->mMember.c_str());
+                }
+                else
+                {
+                    cpHeader.printCode(2,"_record.%s = %s[_index];\n", i->mMember.c_str(), i->mMember.c_str());
+                }
+            }
+            cpHeader.printCode(2,"return _record;\n");
+            cpHeader.printCode(1,"}\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"size_t size(void) const\n");
+            cpHeader.printCode(1,"{\n");
+            cpHeader.printCode(2,"return %s.size();\n", first);
+            cpHeader.printCode(1,"}\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"bool empty(void) const\n");
+            cpHeader.printCode(1,"{\n");
+            cpHeader.printCode(2,"return %s.empty();\n", first);
+            cpHeader.printCode(1,"}\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"void clear(void)\n");
+            cpHeader.printCode(1,"{\n");
+            for (auto &i : members)
+            {
+                cpHeader.printCode(2,"%s.clear();\n", i->mMember.c_str());
+            }
+            cpHeader.printCode(1,"}\n");
+            cpHeader.linefeed();
+            cpHeader.printCode(1,"void reserve(size_t _count)\n");
+            cpHeader.printCode(1,"{\n");
+            for (auto &i : members)
+            {
+                cpHeader.printCode(2,"%s.reserve(_count);\n", i->mMember.c_str());
+            }
+            cpHeader.printCode(1,"}\n");
+
+            for (auto &i : members)
+            {
+                const char *columnType = getArrowColumnType(*i, classEnumMap);
+                if (i->mIsOptional == OptionalType::optional ||
+                    strcmp(columnType, "boolean") == 0 ||
+                    strcmp(columnType, "utf8") == 0 ||
+                    strcmp(columnType, "dictionary") == 0)
+                {
+                    continue; // only required numeric members have aggregates
+                }
+                const char *member = i->mMember.c_str();
+                const char *cppType = getCppTypeString(i->mType.c_str(), true);
+                char upper[512];
+                strncpy(upper, member, sizeof(upper) - 1);
+                upper[sizeof(upper) - 1] = 0;
+                upper[0] = upcase(upper[0]);
+                cpHeader.linefeed();
+                cpHeader.printCode(1,"// Aggregates over the '%s' column; min and max require a non-empty container\n", member);
+                cpHeader.printCode(1,"COLUMN_KERNELS::SumOf<%s>::Type sum%s(void) const\n", cppType, upper);
+                cpHeader.printCode(1,"{\n");
+                cpHeader.printCode(2,"return COLUMN_KERNELS::sum(%s.data(), %s.size());\n", member, member);
+                cpHeader.printCode(1,"}\n");
+                cpHeader.printCode(1,"%s min%s(void) const\n", cppType, upper);
+                cpHeader.printCode(1,"{\n");
+                cpHeader.printCode(2,"return COLUMN_KERNELS::minimum(%s.data(), %s.size());\n", member, member);
+                cpHeader.printCode(1,"}\n");
+                cpHeader.printCode(1,"%s max%s(void) const\n", cppType, upper);
+                cpHeader.printCode(1,"{\n");
+                cpHeader.printCode(2,"return COLUMN_KERNELS::maximum(%s.data(), %s.size());\n", member, member);
+                cpHeader.printCode(1,"}\n");
+                cpHeader.printCode(1,"template<typename Predicate>\n");
+                cpHeader.printCode(1,"size_t countIf%s(Predicate _predicate) const\n", upper);
+                cpHeader.printCode(1,"{\n");
+                cpHeader.printCode(2,"return COLUMN_KERNELS::countIf(%s.data(), %s.size(), _predicate);\n", member, member);
+                cpHeader.printCode(1,"}\n");
+            }
+
+            cpHeader.linefeed();
+            for (auto &i : members)
+            {
+                std::string type = getFlatMemberType(*i);
+                if (i->mType == "bool" && i->mIsOptional != OptionalType::optional)
+                {
+                    type = "uint8_t"; // std::vector<bool> is not contiguous
+                }
+                cpHeader.printCode(1,"std::vector< %s > %s;\n", type.c_str(), i->mMember.c_str());
+            }
+            cpHeader.printCode(0,"};\n");
+        }
+    }
+
+    void saveTypeScript(CodePrinter &dom,CodePrinter &cpenum,CodePrinter &cpenumImpl,const char *destDir)
+    {
+        cpenum.linefeed();
+        cpenum.printCode(0, "template<typename T>\n");
+        cpenum.printCode(0, "T unstringifyEnum(const std::string& str, bool& ok);\n");
+        cpenum.linefeed();
+
+        cpenumImpl.printCode(0,"// clang-format off\n");
+        cpenumImpl.printCode(0, "// CreateDOM: Schema Generation tool written by John W. Ratcliff, 2019\n");
+        cpenumImpl.printCode(0, "// C++ binding code for enumeration lookups and initialization to default values.\n");
+        cpenumImpl.printCode(0, "// The Google DOCs Schema Spreadsheet for this source came from: %s\n", mURL.c_str());
+        cpenumImpl.printCode(0,"#include \"%s.h\"\n", mFilename.c_str());
+        cpenumImpl.printCode(0, "#include <assert.h>\n");
+        cpenumImpl.printCode(0,"#include <unordered_map>\n");
+        cpenumImpl.printCode(0,"#include <mutex>\n");
+        cpenumImpl.printCode(0,"#include <string>\n");
+        cpenumImpl.printCode(0,"#include <string.h>\n");
+
+        cpenumImpl.printCode(0, "#ifdef _MSC_VER\n");
+        cpenumImpl.printCode(0, "#pragma warning(disable:4996 4100)\n");
+        cpenumImpl.printCode(0, "#endif\n");
+        cpenumImpl.linefeed();
+        cpenumImpl.printCode(0, "#include \"RapidJSONDocument.h\"\n");
+        if ( hasXorCompression() )
+        {
+            cpenumImpl.printCode(0, "#include \"XorCompress.h\"\n");
+        }
+        if ( mArrow )
+        {
+            cpenumImpl.printCode(0, "#include \"ArrowIPC.h\"\n");
+        }
+        if ( mArrow || mNDJSON )
+        {
+            cpenumImpl.printCode(0, "#include \"LzCompress.h\"\n");
+        }
+        if ( mNDJSON )
+        {
+            cpenumImpl.printCode(0, "#include \"Crc32c.h\"\n");
+        }
+        cpenumImpl.linefeed();
+
+        cpenumImpl.printCode(0,"namespace %s {\n", mNamespace.c_str());
+
+        OmniCommandInstanceVector instances;
+        for (auto &i : mObjects)
+        {
+            i.saveTypeScript(dom,cpenum,cpenumImpl,*this,instances,mNamespace.c_str(),destDir);
+        }
+        if ( !instances.empty() )
+        {
+            std::string fpHPP = fpout("OmniApiInstance.h",mNamespace.c_str(),destDir);
+            std::string fpCPP = fpout("OmniApiInstance.cpp",mNamespace.c_str(),destDir);
+            {
+                CodePrinter cpp(fpCPP);
+
+                cpp.printCode(0, "#include \"OmniApiInstance.h\"\n");
+                cpp.printCode(0, "#include \"omniverse_api.h\"\n");
+                cpp.printCode(0, "\n");
+                cpp.printCode(0, "namespace omniapi\n");
+                cpp.printCode(0, "{\n");
+                cpp.printCode(0, "\n");
+                cpp.printCode(0, "// Forward reference functions to create instances for various command types\n");
+                for (auto &i:instances)
+                {
+                    cpp.printCode(0, "OmniApiCommand *create%sInstance(const rapidjson::RapidJSONDocument &d, OmniConnection *oc);\n", i.mCommand.c_str());
+                }
+                cpp.printCode(0, "\n");
+                cpp.printCode(0, "createCommandInstance getCreateCommandInstance(CommandType ctype)\n");
+                cpp.printCode(0, "{\n");
+                cpp.printCode(1, "createCommandInstance ret = nullptr;\n");
+                cpp.printCode(0, "\n");
+                cpp.printCode(1, "switch (ctype)\n");
+                cpp.printCode(1, "{\n");
+                for (auto &i:instances)
+                {
+                    cpp.printCode(2, "case CommandType::%s:\n", i.mCommandType.c_str());
+                    cpp.printCode(3, "ret = create%sInstance;\n", i.mCommand.c_str());
+                    cpp.printCode(3, "break;\n");
+                }
+                cpp.printCode(1, "}\n");
+                cpp.printCode(0,"\n");
+                cpp.printCode(1, "return ret;\n");
+                cpp.printCode(0, "}\n");
+                cpp.printCode(0, "\n");
+                cpp.printCode(0, "}\n");
+                cpp.finalize();
+            }
+            {
+                CodePrinter hpp(fpHPP);
+                hpp.printCode(0, "#pragma once\n");
+                hpp.printCode(0, "\n");
+                hpp.printCode(0, "#include <carb/Defines.h>\n");
+                hpp.printCode(0, "\n");
+                hpp.printCode(0, "namespace rapidjson\n");
+                hpp.printCode(0, "{\n");
+                hpp.printCode(1, "class RapidJSONDocument;\n");
+                hpp.printCode(0, "}\n");
+                hpp.printCode(0, "\n");
+                hpp.printCode(0, "namespace omniapi\n");
+                hpp.printCode(0, "{\n");
+                hpp.printCode(0, "class OmniApiCommand;\n");
+                hpp.printCode(0, "class OmniConnection;\n");
+                hpp.printCode(0, "enum class CommandType;\n");
+                hpp.printCode(0, "\n");
+                hpp.printCode(0, "typedef OmniApiCommand *(CARB_ABI* createCommandInstance)(const rapidjson::RapidJSONDocument &d, OmniConnection *oc);\n");
+                hpp.printCode(0, "\n");
+                hpp.printCode(0, "createCommandInstance getCreateCommandInstance(CommandType ctype);\n");
+                hpp.printCode(0, "\n");
+                hpp.printCode(0, "}\n");
+
+                hpp.finalize();
+            }
+        }
+    }
+
+    void saveCPP(CodePrinter &cp)
+    {
+        cp.printCode(0, "#pragma once\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0,"// clang-format off\n");
+        cp.printCode(0, "// CreateDOM: Schema Generation tool written by John W. Ratcliff, 2017\n");
+        cp.printCode(0, "// Warning:This source file was auto-generated by the CreateDOM tool. Do not try to edit this source file manually!\n");
+        cp.printCode(0, "// The Google DOCs Schema Spreadsheet for this source came from: %s\n", mURL.c_str());
+        cp.printCode(0, "\n");
+
+        cp.printCode(0, "#ifdef _MSC_VER\n");
+        cp.printCode(0, "#pragma warning(push)\n");
+        cp.printCode(0, "#pragma warning(disable:4244)\n");
+        cp.printCode(0, "#endif\n");
+
+
+        char temp[512];
+        STRING_HELPER::stringFormat(temp,sizeof(temp), "%s.h", mFilename.c_str());
+        cp.printCode(0, "#include <vector>\n");
+        cp.printCode(0, "#include <unordered_map>\n");
+        cp.printCode(0, "#include <string>\n");
+        cp.printCode(0, "#include <stdint.h>\n");
+        cp.printCode(0,"#include <string.h>\n");
+        if ( mColumns )
+        {
+            cp.printCode(0, "#include \"ColumnKernels.h\"\n");
+        }
+        if ( mPacked || mStore )
+        {
+            cp.printCode(0, "#include \"PackedBytes.h\"\n");
+        }
+        if ( hasPrimaryKeys() )
+        {
+            cp.printCode(0, "#include \"KeyEncoding.h\"\n");
+        }
+        cp.printCode(0, "\n");
+        cp.printCode(0, "#define USE_OPTIONAL 1\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "#if __has_include(<optional>) && USE_OPTIONAL == 1\n");
+        cp.printCode(0, "#include <optional>\n");
+        cp.printCode(0, "#else\n");
+        cp.printCode(0, "#define NO_OPTIONAL\n");
+        cp.printCode(0, "#endif\n");
+        cp.printCode(0, "\n");
+        cp.printCode(0, "namespace codegen\n");
+        cp.printCode(0, "{\n");
+        cp.printCode(0, "template<typename T>\n");
+        cp.printCode(0, "#ifdef NO_OPTIONAL\n");
+        cp.printCode(0, "using optional = T;\n");
+        cp.printCode(0, "#else\n");
+        cp.printCode(0, "using optional = std::optional<T>;\n");
+        cp.printCode(0, "#endif\n");
+        cp.printCode(0, "}\n");
+
+        cp.printCode(0, "namespace rapidjson\n");
+        cp.printCode(0, "{\n");
+        cp.printCode(0, "    class RapidJSONDocument;\n");
+        cp.printCode(0, "}\n");
+
+        cp.printCode(0, "\n");
+        cp.printCode(0, "namespace %s\n", mNamespace.c_str());
+        cp.printCode(0, "{\n");
+        cp.printCode(0, "\n");
+
+        cp.printCode(0, "\n");
+        cp.printCode(0, "// Forward declare the two types of string vector containers.\n");
+        cp.printCode(0, "\n");
+
+        StringVector arrays;
+        StringVector needsReflection;
+        for (auto &i : mObjects)
+        {
+            if (i.mNeedsReflection)
+            {
+                needsReflection.push_back(i.mName);
+            }
+        }
+        StringVector cloneObjects;
+        for (auto &i : mObjects)
+        {
+            i.saveCPP(cp, arrays, needsReflection, cloneObjects, *this);
         }
 
 
@@ -4231,20 +7127,33 @@ public:
 				printf("  inheritsFrom: %s\n", type->mInheritsFrom.c_str());
 			}
 		}
-        cp.printCode(0,"// clang-format off\n");
+        cp.printCode(0,"# clang-format off\n");
 		cp.printCode(0, "# CreateDOM: Schema Generation tool written by John W. Ratcliff, 2017\n");
 		cp.printCode(0, "# Warning:This source file was auto-generated by the CreateDOM tool. Do not try to edit this source file manually!\n");
 		cp.printCode(0, "# The Google DOCs Schema Spreadsheet for this source came from: %s\n", mURL.c_str());
 		cp.printCode(0, "\n");
+        if ( mPacked )
+        {
+            savePythonPackedHelpers(cp);
+        }
 
 		StringVector cloneObjects;
 		for (auto &i : mObjects)
 		{
 			i.savePython(cp, *this);
+            if ( mPacked && i.mIsClass )
+            {
+                savePythonPacked(cp, i);
+            }
 		}
 	}
 
     bool            mPlainOldData{false};
+    bool            mArrow{false};          // generate Arrow IPC stream export/import for flat classes
+    bool            mColumns{false};        // generate '<Class>Columns' struct of arrays containers
+    bool            mNDJSON{false};         // generate newline delimited JSON output with optional LZ framing
+    bool            mPacked{false};         // generate the packed binary codec in C++ and Python
+    bool            mStore{false};          // generate '<Class>Store' leveldb record stores (uses the packed codec)
 	std::string		mNamespace;
     std::string     mDestDir;
 	std::string		mFilename;
@@ -4297,7 +7206,7 @@ public:
 				{
 					// Skip any linefeeds
 					argc = 0;
-					while (*scan == 10 || *scan == 13 && *scan )
+					while (*scan == 10 || (*scan == 13 && *scan) )
 					{
 						scan++;
 					}
@@ -4415,9 +7324,37 @@ public:
             cpp.printCode(0,"} // End of namespace:%s\n", mDOM.mNamespace.c_str());
             dom.finalize();
             cpp.finalize();
+            // The Python module carries the matching packed binary codec
+            if ( mDOM.mPacked )
+            {
+                savePython();
+            }
+            if ( mDOM.mStore )
+            {
+                saveStore();
+            }
         }
     }
 
+    // Save the '<Class>Store' leveldb record stores
+    void saveStore(void)
+    {
+        char scratch[512];
+        STRING_HELPER::stringFormat(scratch, 512, "%sStore.h", mDOM.mFilename.c_str());
+        std::string fpHeader = fpout(scratch, mDOM.mNamespace.c_str(), mDestDir.c_str());
+        printf("Saving C++ record stores to: %s\n", scratch);
+
+        STRING_HELPER::stringFormat(scratch, 512, "%sStore.cpp", mDOM.mFilename.c_str());
+        std::string fpImpl = fpout(scratch, mDOM.mNamespace.c_str(), mDestDir.c_str());
+        printf("Saving C++ record store implementation to: %s\n", scratch);
+
+        CodePrinter header(fpHeader);
+        CodePrinter impl(fpImpl);
+        mDOM.saveStore(header, impl);
+        header.finalize();
+        impl.finalize();
+    }
+
 	// Save the DOM as C++ code
 	void saveTypeScript(CodePrinter &hpp,CodePrinter &cpp,const char *destDir,bool saveTypeScriptFlag) 
 	{
@@ -4446,6 +7383,26 @@ public:
 		mDOM.saveTypeScript(typeScript,hpp,cpp,mDestDir.c_str());
         mDOM.saveSerialize(hpp,cpp);
         mDOM.saveDeserialize(hpp,cpp);
+        if ( mDOM.mArrow )
+        {
+            mDOM.saveArrow(hpp,cpp);
+        }
+        if ( mDOM.mColumns )
+        {
+            mDOM.saveColumns(hpp);
+        }
+        if ( mDOM.mNDJSON )
+        {
+            mDOM.saveNDJSON(hpp,cpp);
+        }
+        if ( mDOM.mPacked || mDOM.mStore )
+        {
+            mDOM.savePackedBytes(hpp,cpp);
+        }
+        if ( mDOM.hasPrimaryKeys() )
+        {
+            mDOM.saveKeys(hpp,cpp);
+        }
 
         typeScript.finalize();
 	}
@@ -4517,6 +7474,41 @@ public:
             {
                 mDOM.mPlainOldData = getBool(argv[1]);
             }
+        }
+        else if (_stricmp(argv[0], "Store") == 0)
+        {
+            if (argc >= 2)
+            {
+                mDOM.mStore = getBool(argv[1]);
+            }
+        }
+        else if (_stricmp(argv[0], "Packed") == 0)
+        {
+            if (argc >= 2)
+            {
+                mDOM.mPacked = getBool(argv[1]);
+            }
+        }
+        else if (_stricmp(argv[0], "NDJSON") == 0)
+        {
+            if (argc >= 2)
+            {
+                mDOM.mNDJSON = getBool(argv[1]);
+            }
+        }
+        else if (_stricmp(argv[0], "Columns") == 0)
+        {
+            if (argc >= 2)
+            {
+                mDOM.mColumns = getBool(argv[1]);
+            }
+        }
+        else if (_stricmp(argv[0], "Arrow") == 0)
+        {
+            if (argc >= 2)
+            {
+                mDOM.mArrow = getBool(argv[1]);
+            }
         }
 		else if (_stricmp(argv[0], "ExportXML") == 0)
 		{
@@ -0,0 +1,268 @@
+// Implements the group commit flusher used by the generated '<Class>Flusher'
+#include "GroupCommit.h"
+#include "KeyLocks.h"
+#include "leveldb/db.h"
+#include "leveldb/options.h"
+#include "leveldb/write_batch.h"
+#include <chrono>
+#include <unordered_set>
+#include <utility>
+
+namespace GROUP_COMMIT
+{
+
+GroupCommitter::GroupCommitter(leveldb::DB *db, const Options &options, KeyFunction keyFunction, WriteFunction writeFunction, CommittedFunction committedFunction)
+    : mDB(db), mOptions(options), mKeyFunction(std::move(keyFunction)), mWriteFunction(std::move(writeFunction)), mCommittedFunction(std::move(committedFunction))
+{
+    if (mOptions.mMaxBatchRecords == 0)
+    {
+        mOptions.mMaxBatchRecords = 1;
+    }
+    mRunning = true;
+    mThread = std::thread(&GroupCommitter::run, this);
+}
+
+GroupCommitter::~GroupCommitter(void)
+{
+    stop();
+    // Records marked dirty after 'stop' get one last synchronous attempt
+    std::vector< Entry > work;
+    work.swap(mPending);
+    if (!work.empty())
+    {
+        std::vector< Entry > failed;
+        write(work, failed);
+    }
+}
+
+void GroupCommitter::markDirty(std::shared_ptr< const void > record)
+{
+    Entry e;
+    e.mRecord = std::move(record);
+    enqueue(std::move(e));
+}
+
+void GroupCommitter::markDirty(std::string key, std::shared_ptr< const void > record)
+{
+    Entry e;
+    e.mKey = std::move(key);
+    e.mRecord = std::move(record);
+    enqueue(std::move(e));
+}
+
+void GroupCommitter::enqueue(Entry &&entry)
+{
+    std::lock_guard< std::mutex > lock(mMutex);
+    mPending.push_back(std::move(entry));
+    mMetrics.mEnqueued++;
+    // Only the update which fills a batch wakes the flusher early
+    if (mPending.size() == mOptions.mMaxBatchRecords)
+    {
+        mWake.notify_one();
+    }
+}
+
+bool GroupCommitter::flush(void)
+{
+    std::unique_lock< std::mutex > lock(mMutex);
+    if (!mRunning)
+    {
+        return mPending.empty() && mFlushOk;
+    }
+    uint64_t request = ++mFlushRequest;
+    mWake.notify_one();
+    mDone.wait(lock, [this, request] { return mFlushDone >= request || !mRunning; });
+    return mFlushOk;
+}
+
+void GroupCommitter::stop(void)
+{
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        mStop = true;
+        mWake.notify_one();
+    }
+    if (mThread.joinable())
+    {
+        mThread.join();
+    }
+}
+
+Metrics GroupCommitter::getMetrics(void) const
+{
+    std::lock_guard< std::mutex > lock(mMutex);
+    Metrics ret = mMetrics;
+    ret.mPending = mPending.size();
+    return ret;
+}
+
+std::string GroupCommitter::getLastError(void) const
+{
+    std::lock_guard< std::mutex > lock(mMutex);
+    return mLastError;
+}
+
+// The flusher thread; each cycle takes everything pending and writes it
+void GroupCommitter::run(void)
+{
+    std::vector< Entry > work;
+    std::vector< Entry > failed;
+    std::unique_lock< std::mutex > lock(mMutex);
+    for (;;)
+    {
+        mWake.wait_for(lock, std::chrono::milliseconds(mOptions.mFlushIntervalMs), [this]
+        {
+            return mStop || mFlushRequest != mFlushDone || mPending.size() >= mOptions.mMaxBatchRecords;
+        });
+        uint64_t request = mFlushRequest;
+        bool ok = true;
+        if (!mPending.empty())
+        {
+            work.swap(mPending);
+            lock.unlock();
+            auto start = std::chrono::steady_clock::now();
+            ok = write(work, failed);
+            uint64_t micros = uint64_t(std::chrono::duration_cast< std::chrono::microseconds >(std::chrono::steady_clock::now() - start).count());
+            work.clear();
+            lock.lock();
+            mMetrics.mFlushes++;
+            mMetrics.mFlushMicros += micros;
+            if (micros > mMetrics.mMaxFlushMicros)
+            {
+                mMetrics.mMaxFlushMicros = micros;
+            }
+            if (!failed.empty())
+            {
+                // Failed records are older than anything queued since, so they go first
+                failed.insert(failed.end(), std::make_move_iterator(mPending.begin()), std::make_move_iterator(mPending.end()));
+                mPending.swap(failed);
+                failed.clear();
+            }
+        }
+        mFlushDone = request;
+        mFlushOk = ok;
+        mDone.notify_all();
+        // When stopping, give up after a failed attempt rather than retry forever
+        if (mStop && (mPending.empty() || !ok))
+        {
+            break;
+        }
+    }
+    mRunning = false;
+    mDone.notify_all();
+}
+
+// Coalesces the updates by key and writes the newest of each; records whose
+// commit failed are moved to 'failed'
+bool GroupCommitter::write(std::vector< Entry > &work, std::vector< Entry > &failed)
+{
+    size_t coalesced = 0;
+    std::unordered_set< std::string > keys;
+    keys.reserve(work.size());
+    for (size_t i = work.size(); i-- > 0; )
+    {
+        Entry &e = work[i];
+        if (e.mKey.empty() && mKeyFunction)
+        {
+            mKeyFunction(e.mRecord.get(), e.mKey);
+        }
+        if (!keys.insert(e.mKey).second)
+        {
+            e.mRecord.reset();
+            coalesced++;
+        }
+    }
+    if (coalesced)
+    {
+        std::lock_guard< std::mutex > lock(mMutex);
+        mMetrics.mCoalesced += coalesced;
+    }
+
+    // The write function of an indexed store reads the record a key replaces,
+    // so the keys stay locked until their records are committed
+    KEY_LOCKS::LockSet locks;
+    for (auto &e : work)
+    {
+        if (e.mRecord)
+        {
+            locks.add(e.mKey);
+        }
+    }
+    locks.lock();
+
+    bool ret = true;
+    std::string error;
+    leveldb::WriteBatch batch;
+    size_t begin = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < work.size(); i++)
+    {
+        Entry &e = work[i];
+        if (e.mRecord && mWriteFunction(e.mKey, e.mRecord.get(), batch, error))
+        {
+            count++;
+        }
+        else if (e.mRecord)
+        {
+            // The batch holds the records before this one; retry this one later
+            std::lock_guard< std::mutex > lock(mMutex);
+            mLastError = error;
+            mMetrics.mErrors++;
+            failed.push_back(std::move(e));
+            ret = false;
+        }
+        bool last = i + 1 == work.size();
+        if (count && (last || count >= mOptions.mMaxBatchRecords || batch.ApproximateSize() >= mOptions.mMaxBatchBytes))
+        {
+            if (!commit(batch, count))
+            {
+                for (size_t j = begin; j <= i; j++)
+                {
+                    if (work[j].mRecord)
+                    {
+                        failed.push_back(std::move(work[j]));
+                    }
+                }
+                ret = false;
+            }
+            else if (mCommittedFunction)
+            {
+                for (size_t j = begin; j <= i; j++)
+                {
+                    if (work[j].mRecord)
+                    {
+                        mCommittedFunction(work[j].mKey);
+                    }
+                }
+            }
+            batch.Clear();
+            begin = i + 1;
+            count = 0;
+        }
+    }
+    return ret;
+}
+
+bool GroupCommitter::commit(leveldb::WriteBatch &batch, size_t count)
+{
+    leveldb::WriteOptions options;
+    options.sync = mOptions.mSync;
+    leveldb::Status s = mDB->Write(options, &batch);
+    std::lock_guard< std::mutex > lock(mMutex);
+    if (!s.ok())
+    {
+        mLastError = s.ToString();
+        mMetrics.mErrors++;
+        return false;
+    }
+    mMetrics.mWritten += count;
+    mMetrics.mBatches++;
+    mMetrics.mBytes += batch.ApproximateSize();
+    if (count > mMetrics.mLargestBatch)
+    {
+        mMetrics.mLargestBatch = count;
+    }
+    return true;
+}
+
+} // end of GROUP_COMMIT namespace
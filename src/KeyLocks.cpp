@@ -0,0 +1,86 @@
+// Implements the striped record key locks
+#include "KeyLocks.h"
+#include <algorithm>
+#include <mutex>
+
+namespace KEY_LOCKS
+{
+
+namespace
+{
+
+const uint32_t STRIPES = 256;
+
+std::mutex *getStripes(void)
+{
+    static std::mutex stripes[STRIPES];
+    return stripes;
+}
+
+// FNV-1a
+uint32_t hashKey(const void *key, size_t len)
+{
+    const uint8_t *p = static_cast< const uint8_t * >(key);
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++)
+    {
+        h = (h ^ p[i]) * 16777619u;
+    }
+    return h;
+}
+
+} // end of anonymous namespace
+
+LockSet::LockSet(const std::string &key)
+{
+    add(key);
+    lock();
+}
+
+LockSet::~LockSet(void)
+{
+    unlock();
+}
+
+void LockSet::add(const void *key, size_t len)
+{
+    mStripes.push_back(hashKey(key, len) % STRIPES);
+}
+
+void LockSet::lock(void)
+{
+    if (mLocked)
+    {
+        return;
+    }
+    std::sort(mStripes.begin(), mStripes.end());
+    mStripes.erase(std::unique(mStripes.begin(), mStripes.end()), mStripes.end());
+    std::mutex *stripes = getStripes();
+    for (uint32_t stripe : mStripes)
+    {
+        stripes[stripe].lock();
+    }
+    mLocked = true;
+}
+
+void LockSet::unlock(void)
+{
+    if (!mLocked)
+    {
+        return;
+    }
+    std::mutex *stripes = getStripes();
+    for (size_t i = mStripes.size(); i-- > 0; )
+    {
+        stripes[mStripes[i]].unlock();
+    }
+    mLocked = false;
+}
+
+void LockSet::clear(void)
+{
+    unlock();
+    mStripes.clear();
+}
+
+} // end of KEY_LOCKS namespace
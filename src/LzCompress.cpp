@@ -0,0 +1,511 @@
+// Implements the LZ block compressor and the frame format
+#include "LzCompress.h"
+#include <string.h>
+#include <vector>
+
+namespace LZ_COMPRESS
+{
+
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_BITS 14
+// The last bytes of a block are always literals so the match search can read
+// ahead without bounds checks.
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_LIMIT 12
+// After this many misses in a row the search starts skipping ahead faster
+#define LZ_SKIP_TRIGGER 6
+// Slack the decoder needs past a copy to use whole chunk copies
+#define LZ_WILD_COPY 16
+
+#define LZ_FRAME_STORED 0x80000000u
+
+static const char gFrameMagic[4] = { 'L', 'Z', 'F', '1' };
+
+static inline uint32_t read32(const uint8_t *p)
+{
+    uint32_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+
+static inline uint64_t read64(const uint8_t *p)
+{
+    uint64_t ret;
+    memcpy(&ret, p, sizeof(ret));
+    return ret;
+}
+
+static inline uint32_t hash32(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline uint32_t countTrailingZeros(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return uint32_t(__builtin_ctzll(v));
+#else
+    uint32_t ret = 0;
+    while (!(v & 1))
+    {
+        v >>= 1;
+        ret++;
+    }
+    return ret;
+#endif
+}
+
+// Number of matching bytes starting at 'a' and 'b', not reading past 'limit'
+static inline size_t matchLength(const uint8_t *a, const uint8_t *b, const uint8_t *limit)
+{
+    const uint8_t *start = a;
+    while (a + 8 <= limit)
+    {
+        uint64_t x = read64(a) ^ read64(b);
+        if (x)
+        {
+            // Little-endian: the lowest set bit is the first differing byte
+            return size_t(a - start) + (countTrailingZeros(x) >> 3);
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return size_t(a - start);
+}
+
+static inline uint8_t *writeLength(uint8_t *op, size_t len)
+{
+    while (len >= 255)
+    {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = uint8_t(len);
+    return op;
+}
+
+static inline uint8_t *writeLiterals(uint8_t *op, const uint8_t *literals, size_t literalCount, size_t matchCode)
+{
+    uint8_t *token = op++;
+    if (literalCount >= 15)
+    {
+        *token = uint8_t(0xF0 | (matchCode >= 15 ? 15 : matchCode));
+        op = writeLength(op, literalCount - 15);
+    }
+    else
+    {
+        *token = uint8_t((literalCount << 4) | (matchCode >= 15 ? 15 : matchCode));
+    }
+    if (literalCount)
+    {
+        memcpy(op, literals, literalCount);
+    }
+    return op + literalCount;
+}
+
+size_t compressBound(size_t len)
+{
+    // varint header, one extension byte per 255 literals and a token
+    return 10 + len + len / 255 + 16;
+}
+
+size_t compress(const void *src, size_t len, std::string &dest)
+{
+    const uint8_t *input = static_cast< const uint8_t * >(src);
+    size_t base = dest.size();
+    dest.resize(base + compressBound(len));
+    uint8_t *out = reinterpret_cast< uint8_t * >(&dest[base]);
+    uint8_t *op = out;
+
+    size_t v = len;
+    while (v >= 0x80)
+    {
+        *op++ = uint8_t(v | 0x80);
+        v >>= 7;
+    }
+    *op++ = uint8_t(v);
+
+    const uint8_t *anchor = input;
+    if (len > LZ_MATCH_LIMIT)
+    {
+        std::vector< uint32_t > table(size_t(1) << LZ_HASH_BITS, 0);
+        const uint8_t *ip = input + 1;
+        const uint8_t *matchLimit = input + len - LZ_MATCH_LIMIT;
+        const uint8_t *copyLimit = input + len - LZ_LAST_LITERALS;
+        table[hash32(read32(input))] = 0;
+        while (ip < matchLimit)
+        {
+            // Find a match, skipping ahead faster the longer nothing is found
+            const uint8_t *match = nullptr;
+            uint32_t misses = 1 << LZ_SKIP_TRIGGER;
+            while (ip < matchLimit)
+            {
+                uint32_t h = hash32(read32(ip));
+                const uint8_t *candidate = input + table[h];
+                table[h] = uint32_t(ip - input);
+                if (candidate < ip && size_t(ip - candidate) <= LZ_MAX_OFFSET && read32(candidate) == read32(ip))
+                {
+                    match = candidate;
+                    break;
+                }
+                ip += misses++ >> LZ_SKIP_TRIGGER;
+            }
+            if (match == nullptr)
+            {
+                break;
+            }
+            // Extend the match backwards over pending literals
+            while (ip > anchor && match > input && ip[-1] == match[-1])
+            {
+                ip--;
+                match--;
+            }
+            size_t length = LZ_MIN_MATCH + matchLength(ip + LZ_MIN_MATCH, match + LZ_MIN_MATCH, copyLimit);
+            size_t matchCode = length - LZ_MIN_MATCH;
+            op = writeLiterals(op, anchor, size_t(ip - anchor), matchCode);
+            uint16_t offset = uint16_t(ip - match);
+            *op++ = uint8_t(offset & 0xFF);
+            *op++ = uint8_t(offset >> 8);
+            if (matchCode >= 15)
+            {
+                op = writeLength(op, matchCode - 15);
+            }
+            ip += length;
+            anchor = ip;
+            // Index a position inside the match to help the next search
+            if (ip - 2 > input && ip < matchLimit)
+            {
+                table[hash32(read32(ip - 2))] = uint32_t(ip - 2 - input);
+            }
+        }
+    }
+    // The remaining bytes are literals
+    op = writeLiterals(op, anchor, size_t(input + len - anchor), 0);
+    size_t ret = size_t(op - out);
+    dest.resize(base + ret);
+    return ret;
+}
+
+bool getUncompressedLength(const void *src, size_t len, size_t &result)
+{
+    const uint8_t *ip = static_cast< const uint8_t * >(src);
+    uint64_t v = 0;
+    for (uint32_t shift = 0; shift < 64 && len; shift += 7, len--)
+    {
+        uint8_t b = *ip++;
+        v |= uint64_t(b & 0x7F) << shift;
+        if (!(b & 0x80))
+        {
+            result = size_t(v);
+            return uint64_t(result) == v;
+        }
+    }
+    return false;
+}
+
+// Copies 'len' bytes in 16 byte chunks; may read and write up to
+// LZ_WILD_COPY bytes past the end, which the caller has checked is in bounds.
+static inline void wildCopy(uint8_t *dest, const uint8_t *src, size_t len)
+{
+    for (size_t i = 0; i < len; i += 16)
+    {
+        memcpy(dest + i, src + i, 16);
+    }
+}
+
+static inline size_t headerLength(const uint8_t *ip)
+{
+    size_t ret = 1;
+    while (*ip++ & 0x80)
+    {
+        ret++;
+    }
+    return ret;
+}
+
+// Reads an extended length; returns false if the input runs out
+static inline bool readLength(const uint8_t *&ip, const uint8_t *end, size_t &len)
+{
+    uint8_t b;
+    do
+    {
+        if (ip == end)
+        {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+bool decompress(const void *src, size_t len, char *dest, size_t destLen)
+{
+    size_t expected;
+    if (!getUncompressedLength(src, len, expected) || expected != destLen)
+    {
+        return false;
+    }
+    const uint8_t *ip = static_cast< const uint8_t * >(src);
+    const uint8_t *end = ip + len;
+    ip += headerLength(ip);
+    uint8_t *op = reinterpret_cast< uint8_t * >(dest);
+    uint8_t *opEnd = op + destLen;
+    uint8_t *opStart = op;
+    while (ip < end)
+    {
+        uint8_t token = *ip++;
+        size_t literalCount = token >> 4;
+        // Short command fast path: at most 14 literals and an 18 byte match
+        // far enough back to copy in 8 byte chunks.  Record data is mostly
+        // made of these.
+        if (literalCount < 15 && (token & 15) < 15 && end - ip >= 18 && opEnd - op >= 40)
+        {
+            size_t offset = size_t(ip[literalCount]) | (size_t(ip[literalCount + 1]) << 8);
+            if (offset >= 8 && offset <= size_t(op - opStart) + literalCount)
+            {
+                memcpy(op, ip, 16);
+                op += literalCount;
+                ip += literalCount + 2;
+                const uint8_t *match = op - offset;
+                memcpy(op, match, 8);
+                memcpy(op + 8, match + 8, 8);
+                memcpy(op + 16, match + 16, 8);
+                op += (token & 15) + LZ_MIN_MATCH;
+                continue;
+            }
+        }
+        if (literalCount == 15 && !readLength(ip, end, literalCount))
+        {
+            return false;
+        }
+        if (literalCount > size_t(end - ip) || literalCount > size_t(opEnd - op))
+        {
+            return false;
+        }
+        if (size_t(end - ip) >= literalCount + LZ_WILD_COPY && size_t(opEnd - op) >= literalCount + LZ_WILD_COPY)
+        {
+            // Room to spare on both sides; copy whole chunks past the end
+            wildCopy(op, ip, literalCount);
+        }
+        else if (literalCount)
+        {
+            memcpy(op, ip, literalCount);
+        }
+        op += literalCount;
+        ip += literalCount;
+        if (ip == end)
+        {
+            break; // the final command has no match
+        }
+        if (end - ip < 2)
+        {
+            return false;
+        }
+        size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(ip, end, length))
+        {
+            return false;
+        }
+        length += LZ_MIN_MATCH;
+        if (offset == 0 || offset > size_t(op - opStart) || length > size_t(opEnd - op))
+        {
+            return false;
+        }
+        const uint8_t *match = op - offset;
+        if (offset >= 8 && size_t(opEnd - op) >= length + LZ_WILD_COPY)
+        {
+            // Each 8 byte chunk is read from data which is already written
+            for (size_t i = 0; i < length; i += 8)
+            {
+                memcpy(op + i, match + i, 8);
+            }
+            op += length;
+            continue;
+        }
+        if (offset >= 8)
+        {
+            while (length >= 8)
+            {
+                memcpy(op, match, 8);
+                op += 8;
+                match += 8;
+                length -= 8;
+            }
+        }
+        while (length)
+        {
+            *op++ = *match++;
+            length--;
+        }
+    }
+    return op == opEnd;
+}
+
+bool decompress(const void *src, size_t len, std::string &dest)
+{
+    size_t ulength;
+    dest.clear();
+    if (!getUncompressedLength(src, len, ulength) || ulength > len * 255 + 16)
+    {
+        return false; // a block can't expand more than this
+    }
+    dest.resize(ulength);
+    if (!decompress(src, len, ulength ? &dest[0] : nullptr, ulength))
+    {
+        dest.clear();
+        return false;
+    }
+    return true;
+}
+
+bool isFrame(const void *src, size_t len)
+{
+    return src && len >= sizeof(gFrameMagic) && memcmp(src, gFrameMagic, sizeof(gFrameMagic)) == 0;
+}
+
+static void appendU32(std::string &dest, uint32_t v)
+{
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        dest.push_back(char((v >> (i * 8)) & 0xFF));
+    }
+}
+
+FrameWriter::FrameWriter(std::string &dest) : mDest(dest)
+{
+    mDest.append(gFrameMagic, sizeof(gFrameMagic));
+}
+
+FrameWriter::~FrameWriter(void)
+{
+    finish();
+}
+
+void FrameWriter::write(const void *data, size_t len)
+{
+    const char *scan = static_cast< const char * >(data);
+    while (len)
+    {
+        size_t count = LZ_COMPRESS_FRAME_BLOCK_SIZE - mBuffer.size();
+        if (count > len)
+        {
+            count = len;
+        }
+        mBuffer.append(scan, count);
+        scan += count;
+        len -= count;
+        if (mBuffer.size() == LZ_COMPRESS_FRAME_BLOCK_SIZE)
+        {
+            flushBlock();
+        }
+    }
+}
+
+void FrameWriter::flushBlock(void)
+{
+    if (mBuffer.empty())
+    {
+        return;
+    }
+    size_t header = mDest.size();
+    appendU32(mDest, 0);
+    size_t compressed = compress(mBuffer.data(), mBuffer.size(), mDest);
+    uint32_t blockHeader = uint32_t(compressed);
+    if (compressed >= mBuffer.size())
+    {
+        // Incompressible; store the raw bytes instead
+        mDest.resize(header + 4);
+        mDest += mBuffer;
+        blockHeader = uint32_t(mBuffer.size()) | LZ_FRAME_STORED;
+    }
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        mDest[header + i] = char((blockHeader >> (i * 8)) & 0xFF);
+    }
+    mBuffer.clear();
+}
+
+void FrameWriter::finish(void)
+{
+    if (mFinished)
+    {
+        return;
+    }
+    mFinished = true;
+    flushBlock();
+    appendU32(mDest, 0);
+}
+
+void compressFrame(const void *src, size_t len, std::string &dest)
+{
+    dest.clear();
+    dest.reserve(len / 2 + 64);
+    FrameWriter w(dest);
+    w.write(src, len);
+    w.finish();
+}
+
+bool decompressFrame(const void *src, size_t len, std::string &dest)
+{
+    dest.clear();
+    if (!isFrame(src, len))
+    {
+        return false;
+    }
+    const uint8_t *ip = static_cast< const uint8_t * >(src) + sizeof(gFrameMagic);
+    const uint8_t *end = static_cast< const uint8_t * >(src) + len;
+    for (;;)
+    {
+        if (end - ip < 4)
+        {
+            break; // truncated
+        }
+        uint32_t header = uint32_t(ip[0]) | (uint32_t(ip[1]) << 8) | (uint32_t(ip[2]) << 16) | (uint32_t(ip[3]) << 24);
+        ip += 4;
+        if (header == 0)
+        {
+            return true;
+        }
+        size_t size = header & ~LZ_FRAME_STORED;
+        if (size > size_t(end - ip))
+        {
+            break;
+        }
+        if (header & LZ_FRAME_STORED)
+        {
+            if (size > LZ_COMPRESS_FRAME_BLOCK_SIZE)
+            {
+                break;
+            }
+            dest.append(reinterpret_cast< const char * >(ip), size);
+        }
+        else
+        {
+            size_t ulength;
+            if (!getUncompressedLength(ip, size, ulength) || ulength > LZ_COMPRESS_FRAME_BLOCK_SIZE)
+            {
+                break;
+            }
+            size_t base = dest.size();
+            dest.resize(base + ulength);
+            if (!decompress(ip, size, ulength ? &dest[base] : nullptr, ulength))
+            {
+                break;
+            }
+        }
+        ip += size;
+    }
+    dest.clear();
+    return false;
+}
+
+} // end of LZ_COMPRESS namespace
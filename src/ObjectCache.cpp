@@ -0,0 +1,86 @@
+// Implements the decoded object cache used by the generated '<Class>Cache'
+#include "ObjectCache.h"
+#include "leveldb/cache.h"
+
+namespace OBJECT_CACHE
+{
+
+typedef std::shared_ptr< const void > ObjectPtr;
+
+static void deleteObject(const leveldb::Slice &key, void *value)
+{
+    (void)key;
+    delete static_cast< ObjectPtr * >(value);
+}
+
+ObjectCache::ObjectCache(size_t capacity)
+    : mCache(leveldb::NewLRUCache(capacity)), mCapacity(capacity)
+{
+}
+
+ObjectCache::~ObjectCache(void)
+{
+    delete mCache;
+}
+
+std::shared_ptr< const void > ObjectCache::lookup(const leveldb::Slice &key)
+{
+    leveldb::Cache::Handle *handle = mCache->Lookup(key);
+    if (handle == nullptr)
+    {
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    mHits.fetch_add(1, std::memory_order_relaxed);
+    ObjectPtr ret = *static_cast< ObjectPtr * >(mCache->Value(handle));
+    mCache->Release(handle);
+    return ret;
+}
+
+uint64_t ObjectCache::getVersion(void) const
+{
+    return mVersion.load(std::memory_order_acquire);
+}
+
+void ObjectCache::insert(const leveldb::Slice &key, std::shared_ptr< const void > value, size_t charge, uint64_t version)
+{
+    if (mVersion.load(std::memory_order_acquire) != version)
+    {
+        return;
+    }
+    leveldb::Cache::Handle *handle = mCache->Insert(key, new ObjectPtr(std::move(value)), charge, deleteObject);
+    mCache->Release(handle);
+    mInserts.fetch_add(1, std::memory_order_relaxed);
+    // An invalidation may have erased the key before the insert above; drop
+    // the entry again rather than keep what may be the old record
+    if (mVersion.load(std::memory_order_acquire) != version)
+    {
+        mCache->Erase(key);
+    }
+}
+
+void ObjectCache::invalidate(const leveldb::Slice &key)
+{
+    mVersion.fetch_add(1, std::memory_order_acq_rel);
+    mInvalidations.fetch_add(1, std::memory_order_relaxed);
+    mCache->Erase(key);
+}
+
+void ObjectCache::prune(void)
+{
+    mCache->Prune();
+}
+
+Stats ObjectCache::getStats(void) const
+{
+    Stats ret;
+    ret.mHits = mHits.load(std::memory_order_relaxed);
+    ret.mMisses = mMisses.load(std::memory_order_relaxed);
+    ret.mInserts = mInserts.load(std::memory_order_relaxed);
+    ret.mInvalidations = mInvalidations.load(std::memory_order_relaxed);
+    ret.mCharge = mCache->TotalCharge();
+    ret.mCapacity = mCapacity;
+    return ret;
+}
+
+} // end of OBJECT_CACHE namespace
@@ -0,0 +1,433 @@
+// Implements the append-only object log on top of leveldb's log format
+#include "ObjectLog.h"
+#include "db/log_format.h"
+#include "db/log_reader.h"
+#include "db/log_writer.h"
+#include "leveldb/env.h"
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+namespace OBJECT_LOG
+{
+
+namespace
+{
+
+// The offset just past a record of 'length' bytes whose first fragment
+// starts at 'offset', following the fragmentation of log::Writer::AddRecord
+uint64_t recordEnd(uint64_t offset, size_t length)
+{
+    const uint64_t blockSize = leveldb::log::kBlockSize;
+    const uint64_t headerSize = leveldb::log::kHeaderSize;
+    uint64_t pos = offset;
+    size_t left = length;
+    do
+    {
+        uint64_t leftover = blockSize - pos % blockSize;
+        if (leftover < headerSize)
+        {
+            // the writer pads the trailer and starts a new block
+            pos += leftover;
+            leftover = blockSize;
+        }
+        size_t fragment = size_t(std::min< uint64_t >(left, leftover - headerSize));
+        pos += headerSize + fragment;
+        left -= fragment;
+    } while (left > 0);
+    return pos;
+}
+
+} // end of anonymous namespace
+
+struct LogWriter::Waiter
+{
+    const void                  *mData{nullptr};    // nullptr for a sync
+    size_t                      mLen{0};
+    bool                        mSync{false};
+    bool                        mDone{false};
+    bool                        mOk{false};
+    std::condition_variable     mWake;
+};
+
+LogWriter::LogWriter(void)
+{
+}
+
+LogWriter::~LogWriter(void)
+{
+    close();
+}
+
+// Finds the end of the last complete record.  Only the tail of the file is
+// read; the window grows until it holds the start of a complete record.
+bool LogWriter::recover(const std::string &path, uint64_t &end)
+{
+    leveldb::Env *env = leveldb::Env::Default();
+    end = 0;
+    uint64_t size = 0;
+    if (!env->FileExists(path))
+    {
+        return true;
+    }
+    leveldb::Status s = env->GetFileSize(path, &size);
+    uint64_t window = 1 << 20;
+    bool found = false;
+    while (s.ok() && size > 0 && !found)
+    {
+        uint64_t start = size > window ? (size - window) / leveldb::log::kBlockSize * leveldb::log::kBlockSize : 0;
+        leveldb::SequentialFile *file = nullptr;
+        s = env->NewSequentialFile(path, &file);
+        if (!s.ok())
+        {
+            break;
+        }
+        leveldb::log::Reader reader(file, nullptr, true, start);
+        leveldb::Slice record;
+        std::string scratch;
+        while (reader.ReadRecord(&record, &scratch))
+        {
+            end = recordEnd(reader.LastRecordOffset(), record.size());
+            found = true;
+        }
+        delete file;
+        if (start == 0)
+        {
+            break;
+        }
+        window *= 4;
+    }
+    if (!s.ok())
+    {
+        mLastError = s.ToString();
+        return false;
+    }
+    if (end < size)
+    {
+        if (::truncate(path.c_str(), off_t(end)) != 0)
+        {
+            mLastError = "IO error: could not truncate " + path;
+            return false;
+        }
+        mStats.mTruncatedBytes = size - end;
+    }
+    return true;
+}
+
+bool LogWriter::open(const std::string &path, const Options &options)
+{
+    close();
+    std::lock_guard< std::mutex > lock(mMutex);
+    mOptions = options;
+    mStats = Stats();
+    mLastError.clear();
+    mFailed = false;
+    uint64_t end = 0;
+    if (!recover(path, end))
+    {
+        return false;
+    }
+    leveldb::Status s = leveldb::Env::Default()->NewAppendableFile(path, &mFile);
+    if (!s.ok())
+    {
+        mLastError = s.ToString();
+        mFile = nullptr;
+        return false;
+    }
+    mWriter = new leveldb::log::Writer(mFile, end);
+    return true;
+}
+
+void LogWriter::close(void)
+{
+    std::lock_guard< std::mutex > lock(mMutex);
+    delete mWriter;
+    mWriter = nullptr;
+    if (mFile)
+    {
+        mFile->Close();
+        delete mFile;
+        mFile = nullptr;
+    }
+}
+
+bool LogWriter::append(const void *data, size_t len)
+{
+    return commit(data, len, mOptions.mSync);
+}
+
+bool LogWriter::sync(void)
+{
+    return commit(nullptr, 0, true);
+}
+
+bool LogWriter::commit(const void *data, size_t len, bool sync)
+{
+    Waiter w;
+    w.mData = data;
+    w.mLen = len;
+    w.mSync = sync;
+
+    std::unique_lock< std::mutex > lock(mMutex);
+    if (mWriter == nullptr || mFailed)
+    {
+        if (mLastError.empty())
+        {
+            mLastError = "Invalid argument: object log is not open";
+        }
+        return false;
+    }
+    mQueue.push_back(&w);
+    while (!w.mDone && &w != mQueue.front())
+    {
+        w.mWake.wait(lock);
+    }
+    if (w.mDone)
+    {
+        return w.mOk;
+    }
+    if (mFailed)
+    {
+        // A group failed while this one waited and left the end of the file
+        // unknown, so every queued append fails without being written
+        for (Waiter *waiter : mQueue)
+        {
+            waiter->mOk = false;
+            waiter->mDone = true;
+            if (waiter != &w)
+            {
+                waiter->mWake.notify_one();
+            }
+        }
+        mQueue.clear();
+        return false;
+    }
+
+    // This thread writes everything queued so far; appends arriving meanwhile
+    // wait for the next group
+    std::vector< Waiter * > group(mQueue.begin(), mQueue.end());
+    for (Waiter *waiter : group)
+    {
+        sync = sync || waiter->mSync;
+    }
+    lock.unlock();
+
+    leveldb::Status s;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    for (Waiter *waiter : group)
+    {
+        if (waiter->mData && s.ok())
+        {
+            s = mWriter->AddRecord(leveldb::Slice(static_cast< const char * >(waiter->mData), waiter->mLen));
+            records++;
+            bytes += waiter->mLen;
+        }
+    }
+    if (s.ok() && sync)
+    {
+        s = mFile->Sync();
+    }
+
+    lock.lock();
+    mStats.mGroups++;
+    mStats.mRecords += records;
+    mStats.mBytes += bytes;
+    if (sync)
+    {
+        mStats.mSyncs++;
+    }
+    if (!s.ok())
+    {
+        // A partly written group leaves the end of the file unknown, so
+        // every later append fails; reopen the log to recover it
+        mFailed = true;
+        mLastError = s.ToString();
+    }
+    for (Waiter *waiter : group)
+    {
+        mQueue.pop_front();
+        waiter->mOk = s.ok();
+        waiter->mDone = true;
+        if (waiter != &w)
+        {
+            waiter->mWake.notify_one();
+        }
+    }
+    if (!mQueue.empty())
+    {
+        mQueue.front()->mWake.notify_one();
+    }
+    return s.ok();
+}
+
+Stats LogWriter::getStats(void) const
+{
+    std::lock_guard< std::mutex > lock(mMutex);
+    return mStats;
+}
+
+std::string LogWriter::getLastError(void) const
+{
+    std::lock_guard< std::mutex > lock(mMutex);
+    return mLastError;
+}
+
+// Counts the bytes the log reader drops; anything but corruption is a read error
+class LogReader::Reporter : public leveldb::log::Reader::Reporter
+{
+public:
+    explicit Reporter(std::string &lastError) : mLastError(lastError)
+    {
+    }
+
+    void Corruption(size_t bytes, const leveldb::Status &status) override
+    {
+        if (status.IsCorruption())
+        {
+            mDropped += bytes;
+        }
+        else if (mLastError.empty())
+        {
+            mLastError = status.ToString();
+        }
+    }
+
+    uint64_t        mDropped{0};
+
+private:
+    std::string     &mLastError;
+};
+
+// Reads the file a megabyte at a time and hands out the 32KB blocks the log
+// reader asks for without copying them; a block stays valid until the next
+// read, which is all the log reader needs
+class LogReader::BufferedFile : public leveldb::SequentialFile
+{
+public:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    explicit BufferedFile(leveldb::SequentialFile *file) : mFile(file), mBuffer(new char[BUFFER_SIZE])
+    {
+    }
+
+    ~BufferedFile(void) override
+    {
+        delete mFile;
+    }
+
+    leveldb::Status Read(size_t n, leveldb::Slice *result, char *scratch) override
+    {
+        (void)scratch;
+        while (mAvailable.size() < n)
+        {
+            // The log reader takes a short block for the end of the file, so
+            // keep what is left and fill the rest of the buffer
+            size_t kept = mAvailable.size();
+            memmove(mBuffer.get(), mAvailable.data(), kept);
+            leveldb::Slice chunk;
+            leveldb::Status s = mFile->Read(BUFFER_SIZE - kept, &chunk, mBuffer.get() + kept);
+            if (!s.ok())
+            {
+                mAvailable.clear();
+                return s;
+            }
+            if (chunk.data() != mBuffer.get() + kept)
+            {
+                memcpy(mBuffer.get() + kept, chunk.data(), chunk.size());
+            }
+            mAvailable = leveldb::Slice(mBuffer.get(), kept + chunk.size());
+            if (chunk.empty())
+            {
+                break;
+            }
+        }
+        size_t len = std::min(n, mAvailable.size());
+        *result = leveldb::Slice(mAvailable.data(), len);
+        mAvailable.remove_prefix(len);
+        return leveldb::Status::OK();
+    }
+
+    leveldb::Status Skip(uint64_t n) override
+    {
+        if (n <= mAvailable.size())
+        {
+            mAvailable.remove_prefix(size_t(n));
+            return leveldb::Status::OK();
+        }
+        n -= mAvailable.size();
+        mAvailable.clear();
+        return mFile->Skip(n);
+    }
+
+private:
+    leveldb::SequentialFile     *mFile;
+    std::unique_ptr< char[] >   mBuffer;
+    leveldb::Slice              mAvailable;     // read but not yet handed out
+};
+
+LogReader::LogReader(void)
+{
+}
+
+LogReader::~LogReader(void)
+{
+    close();
+}
+
+bool LogReader::open(const std::string &path)
+{
+    close();
+    mLastError.clear();
+    leveldb::SequentialFile *file = nullptr;
+    leveldb::Status s = leveldb::Env::Default()->NewSequentialFile(path, &file);
+    if (!s.ok())
+    {
+        mLastError = s.ToString();
+        return false;
+    }
+    mFile = new BufferedFile(file);
+    mReporter = new Reporter(mLastError);
+    mReader = new leveldb::log::Reader(mFile, mReporter, true, 0);
+    return true;
+}
+
+void LogReader::close(void)
+{
+    delete mReader;
+    mReader = nullptr;
+    delete mReporter;
+    mReporter = nullptr;
+    delete mFile;
+    mFile = nullptr;
+}
+
+bool LogReader::next(const char *&data, size_t &len)
+{
+    leveldb::Slice record;
+    if (mReader == nullptr || !mReader->ReadRecord(&record, &mScratch))
+    {
+        return false;
+    }
+    data = record.data();
+    len = record.size();
+    return true;
+}
+
+uint64_t LogReader::getDroppedBytes(void) const
+{
+    return mReporter ? mReporter->mDropped : 0;
+}
+
+bool LogReader::ok(void) const
+{
+    return mLastError.empty();
+}
+
+const std::string &LogReader::getLastError(void) const
+{
+    return mLastError;
+}
+
+} // end of OBJECT_LOG namespace
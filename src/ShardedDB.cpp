@@ -0,0 +1,519 @@
+// Implements the hash sharded database on top of several leveldb databases
+#include "ShardedDB.h"
+#include "leveldb/comparator.h"
+#include "leveldb/env.h"
+#include "leveldb/iterator.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <utility>
+
+namespace SHARDED_DB
+{
+
+namespace
+{
+
+// Changing the seed moves every key to another shard, so it is part of the
+// format of a database
+const uint32_t SHARD_HASH_SEED = 0x5bd1e995;
+
+// The size of a WriteBatch holding only its header
+const size_t EMPTY_BATCH_SIZE = 12;
+
+// The hash of leveldb's util/hash.cc, which picked the shards of the first
+// sharded databases
+uint32_t hashKey(const char *data, size_t n, uint32_t seed)
+{
+    const uint32_t m = 0xc6a4a793;
+    const uint8_t *p = reinterpret_cast< const uint8_t * >(data);
+    const uint8_t *limit = p + n;
+    uint32_t h = seed ^ uint32_t(n * m);
+    for (; p + 4 <= limit; p += 4)
+    {
+        h += uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+        h *= m;
+        h ^= (h >> 16);
+    }
+    switch (limit - p)
+    {
+        case 3:
+            h += uint32_t(p[2]) << 16;
+            // fall through
+        case 2:
+            h += uint32_t(p[1]) << 8;
+            // fall through
+        case 1:
+            h += p[0];
+            h *= m;
+            h ^= (h >> 24);
+            break;
+    }
+    return h;
+}
+
+// Writes 'data' to a new file and syncs it, removing the file on failure
+leveldb::Status writeFileSync(leveldb::Env *env, const std::string &data, const std::string &fname)
+{
+    leveldb::WritableFile *file = nullptr;
+    leveldb::Status s = env->NewWritableFile(fname, &file);
+    if (!s.ok())
+    {
+        return s;
+    }
+    s = file->Append(data);
+    if (s.ok())
+    {
+        s = file->Sync();
+    }
+    if (s.ok())
+    {
+        s = file->Close();
+    }
+    delete file;
+    if (!s.ok())
+    {
+        env->RemoveFile(fname);
+    }
+    return s;
+}
+
+std::string shardPath(const std::string &path, uint32_t shard)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/shard-%03u", shard);
+    return path + name;
+}
+
+} // end of anonymous namespace
+
+// The part of a batch one write thread commits
+struct ShardedDB::Task
+{
+    uint32_t                mShard;
+    leveldb::WriteBatch     *mBatch;
+    Group                   *mGroup;
+};
+
+// The parts of one batch which are written in parallel
+struct ShardedDB::Group
+{
+    std::mutex              mMutex;
+    std::condition_variable mDone;
+    size_t                  mLeft{0};
+    bool                    mOk{true};
+};
+
+ShardedBatch::ShardedBatch(const ShardedDB &db) : mDB(db), mBatches(db.getShardCount())
+{
+}
+
+leveldb::WriteBatch &ShardedBatch::getBatch(const leveldb::Slice &key)
+{
+    uint32_t shard = mDB.getShard(key);
+    if (mBatches[shard].ApproximateSize() == EMPTY_BATCH_SIZE)
+    {
+        mTouched.push_back(shard);
+    }
+    return mBatches[shard];
+}
+
+void ShardedBatch::put(const leveldb::Slice &key, const leveldb::Slice &value)
+{
+    getBatch(key).Put(key, value);
+}
+
+void ShardedBatch::erase(const leveldb::Slice &key)
+{
+    getBatch(key).Delete(key);
+}
+
+void ShardedBatch::clear(void)
+{
+    for (uint32_t shard : mTouched)
+    {
+        mBatches[shard].Clear();
+    }
+    mTouched.clear();
+}
+
+bool ShardedBatch::empty(void) const
+{
+    return mTouched.empty();
+}
+
+size_t ShardedBatch::getApproximateSize(void) const
+{
+    size_t size = 0;
+    for (uint32_t shard : mTouched)
+    {
+        size += mBatches[shard].ApproximateSize();
+    }
+    return size;
+}
+
+ShardedDB::ShardedDB(void)
+{
+}
+
+ShardedDB::~ShardedDB(void)
+{
+    close();
+}
+
+// Reads the number of shards of the database at 'path', or records it for a
+// new database
+bool ShardedDB::openShardCount(const std::string &path, const Options &options, uint32_t &shards)
+{
+    leveldb::Env *env = leveldb::Env::Default();
+    const std::string fname = path + "/SHARDS";
+    std::string contents;
+    leveldb::Status s = leveldb::ReadFileToString(env, fname, &contents);
+    if (s.ok())
+    {
+        shards = uint32_t(strtoul(contents.c_str(), nullptr, 10));
+        if (shards == 0)
+        {
+            s = leveldb::Status::Corruption(fname, "invalid shard count");
+        }
+        else if (options.mShards != 0 && options.mShards != shards)
+        {
+            s = leveldb::Status::InvalidArgument(path, "was created with another number of shards");
+        }
+    }
+    else if (!env->FileExists(fname))
+    {
+        if (options.mShards == 0)
+        {
+            s = leveldb::Status::InvalidArgument(path, "does not exist (no number of shards given)");
+        }
+        else
+        {
+            env->CreateDir(path);
+            shards = options.mShards;
+            s = writeFileSync(env, std::to_string(shards) + "\n", fname);
+        }
+    }
+    if (!s.ok())
+    {
+        setLastError(s);
+        return false;
+    }
+    return true;
+}
+
+bool ShardedDB::open(const std::string &path, const leveldb::Options &dbOptions, const Options &options)
+{
+    close();
+    {
+        std::lock_guard< std::mutex > lock(mErrorMutex);
+        mLastError.clear();
+    }
+    leveldb::Env *env = leveldb::Env::Default();
+    if (!dbOptions.create_if_missing && !env->FileExists(path + "/SHARDS"))
+    {
+        setLastError(leveldb::Status::InvalidArgument(path, "does not exist (create_if_missing is false)"));
+        return false;
+    }
+    if (dbOptions.error_if_exists && env->FileExists(path + "/SHARDS"))
+    {
+        setLastError(leveldb::Status::InvalidArgument(path, "exists (error_if_exists is true)"));
+        return false;
+    }
+    uint32_t shards = 0;
+    if (!openShardCount(path, options, shards))
+    {
+        return false;
+    }
+
+    mOptions = options;
+    mComparator = dbOptions.comparator;
+    leveldb::Options shardOptions = dbOptions;
+    if (mOptions.mOwnCompactions && shards > 1 && shardOptions.max_background_compactions < 2)
+    {
+        // With 1 every shard queues its flushes and compactions on the Env's
+        // single background thread
+        shardOptions.max_background_compactions = 2;
+    }
+    for (uint32_t shard = 0; shard < shards; shard++)
+    {
+        leveldb::DB *db = nullptr;
+        leveldb::Status s = leveldb::DB::Open(shardOptions, shardPath(path, shard), &db);
+        if (!s.ok())
+        {
+            setLastError(s);
+            close();
+            return false;
+        }
+        mShards.push_back(db);
+    }
+    mSlots.reset(new WriterSlot[shards]);
+
+    uint32_t threads = mOptions.mWriteThreads ? mOptions.mWriteThreads : shards - 1;
+    mStopWriters = false;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        mWriters.emplace_back(&ShardedDB::runWriter, this);
+    }
+    return true;
+}
+
+void ShardedDB::close(void)
+{
+    {
+        std::lock_guard< std::mutex > lock(mPoolMutex);
+        mStopWriters = true;
+    }
+    mPoolWake.notify_all();
+    for (std::thread &writer : mWriters)
+    {
+        writer.join();
+    }
+    mWriters.clear();
+    for (leveldb::DB *db : mShards)
+    {
+        delete db;
+    }
+    mShards.clear();
+    mSlots.reset();
+}
+
+uint32_t ShardedDB::getShardCount(void) const
+{
+    return uint32_t(mShards.size());
+}
+
+uint32_t ShardedDB::getShard(const leveldb::Slice &key) const
+{
+    return hashKey(key.data(), key.size(), SHARD_HASH_SEED) % uint32_t(mShards.size());
+}
+
+leveldb::DB *ShardedDB::getShardDB(uint32_t shard) const
+{
+    return mShards[shard];
+}
+
+// Counts a write in 'slot' unless a snapshot is being taken, in which case it
+// waits for the snapshot first.  Both sides store their flag before they look
+// at the other's, so either the snapshot sees the write or the write sees the
+// snapshot.
+void ShardedDB::beginWrite(WriterSlot &slot)
+{
+    while (true)
+    {
+        slot.mWriters.fetch_add(1);
+        if (!mSnapshotting.load())
+        {
+            return;
+        }
+        slot.mWriters.fetch_sub(1);
+        std::unique_lock< std::mutex > lock(mSnapshotMutex);
+        mSnapshotDone.wait(lock, [this]() { return !mSnapshotting.load(); });
+    }
+}
+
+void ShardedDB::endWrite(WriterSlot &slot)
+{
+    slot.mWriters.fetch_sub(1);
+}
+
+bool ShardedDB::writeShard(uint32_t shard, leveldb::WriteBatch *batch)
+{
+    leveldb::WriteOptions options;
+    options.sync = mOptions.mSync;
+    leveldb::Status s = mShards[shard]->Write(options, batch);
+    if (!s.ok())
+    {
+        setLastError(s);
+        return false;
+    }
+    return true;
+}
+
+bool ShardedDB::put(const leveldb::Slice &key, const leveldb::Slice &value)
+{
+    uint32_t shard = getShard(key);
+    leveldb::WriteBatch batch;
+    batch.Put(key, value);
+    beginWrite(mSlots[shard]);
+    bool ok = writeShard(shard, &batch);
+    endWrite(mSlots[shard]);
+    return ok;
+}
+
+bool ShardedDB::erase(const leveldb::Slice &key)
+{
+    uint32_t shard = getShard(key);
+    leveldb::WriteBatch batch;
+    batch.Delete(key);
+    beginWrite(mSlots[shard]);
+    bool ok = writeShard(shard, &batch);
+    endWrite(mSlots[shard]);
+    return ok;
+}
+
+bool ShardedDB::write(ShardedBatch &batch)
+{
+    if (batch.mTouched.empty())
+    {
+        return true;
+    }
+    WriterSlot &slot = mSlots[batch.mTouched.front()];
+    beginWrite(slot);
+    bool ok = true;
+    if (batch.mTouched.size() > 1 && !mWriters.empty() &&
+        (mOptions.mSync || batch.getApproximateSize() >= mOptions.mParallelBytes))
+    {
+        ok = writeParallel(batch);
+    }
+    else
+    {
+        // Handing small unsynced parts to another thread costs more than
+        // inserting them into the memtables here
+        for (uint32_t shard : batch.mTouched)
+        {
+            ok = ok && writeShard(shard, &batch.mBatches[shard]);
+        }
+    }
+    endWrite(slot);
+    return ok;
+}
+
+// Queues every part but the first for the write threads, writes the first and
+// waits for the others
+bool ShardedDB::writeParallel(ShardedBatch &batch)
+{
+    Group group;
+    group.mLeft = batch.mTouched.size() - 1;
+    {
+        std::lock_guard< std::mutex > lock(mPoolMutex);
+        for (size_t i = 1; i < batch.mTouched.size(); i++)
+        {
+            uint32_t shard = batch.mTouched[i];
+            Task task;
+            task.mShard = shard;
+            task.mBatch = &batch.mBatches[shard];
+            task.mGroup = &group;
+            mTasks.push_back(task);
+        }
+    }
+    mPoolWake.notify_all();
+
+    uint32_t first = batch.mTouched.front();
+    bool ok = writeShard(first, &batch.mBatches[first]);
+
+    std::unique_lock< std::mutex > lock(group.mMutex);
+    group.mDone.wait(lock, [&group]() { return group.mLeft == 0; });
+    return ok && group.mOk;
+}
+
+void ShardedDB::runWriter(void)
+{
+    std::unique_lock< std::mutex > lock(mPoolMutex);
+    while (true)
+    {
+        mPoolWake.wait(lock, [this]() { return mStopWriters || !mTasks.empty(); });
+        if (mTasks.empty())
+        {
+            return;
+        }
+        Task task = mTasks.front();
+        mTasks.pop_front();
+        lock.unlock();
+
+        bool ok = writeShard(task.mShard, task.mBatch);
+        {
+            std::lock_guard< std::mutex > groupLock(task.mGroup->mMutex);
+            task.mGroup->mOk = task.mGroup->mOk && ok;
+            if (--task.mGroup->mLeft == 0)
+            {
+                task.mGroup->mDone.notify_one();
+            }
+        }
+        lock.lock();
+    }
+}
+
+bool ShardedDB::get(const leveldb::Slice &key, std::string &value, const Snapshot *snapshot)
+{
+    uint32_t shard = getShard(key);
+    leveldb::ReadOptions options;
+    if (snapshot)
+    {
+        options.snapshot = snapshot->mShards[shard];
+    }
+    leveldb::Status s = mShards[shard]->Get(options, key, &value);
+    if (!s.ok())
+    {
+        if (!s.IsNotFound())
+        {
+            setLastError(s);
+        }
+        return false;
+    }
+    return true;
+}
+
+leveldb::Iterator *ShardedDB::newIterator(const Snapshot *snapshot, bool fillCache) const
+{
+    std::vector< leveldb::Iterator * > children;
+    for (uint32_t shard = 0; shard < mShards.size(); shard++)
+    {
+        leveldb::ReadOptions options;
+        options.fill_cache = fillCache;
+        if (snapshot)
+        {
+            options.snapshot = snapshot->mShards[shard];
+        }
+        children.push_back(mShards[shard]->NewIterator(options));
+    }
+    // No key is in two shards, so the merge never sees duplicates
+    return leveldb::NewMergingIterator(mComparator, children.data(), int(children.size()));
+}
+
+const Snapshot *ShardedDB::getSnapshot(void)
+{
+    Snapshot *snapshot = new Snapshot();
+    std::lock_guard< std::mutex > lock(mSnapshotMutex);
+    mSnapshotting.store(true);
+    for (uint32_t shard = 0; shard < mShards.size(); shard++)
+    {
+        while (mSlots[shard].mWriters.load() != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (leveldb::DB *db : mShards)
+    {
+        snapshot->mShards.push_back(db->GetSnapshot());
+    }
+    mSnapshotting.store(false);
+    mSnapshotDone.notify_all();
+    return snapshot;
+}
+
+void ShardedDB::releaseSnapshot(const Snapshot *snapshot)
+{
+    if (snapshot == nullptr)
+    {
+        return;
+    }
+    for (uint32_t shard = 0; shard < snapshot->mShards.size(); shard++)
+    {
+        mShards[shard]->ReleaseSnapshot(snapshot->mShards[shard]);
+    }
+    delete snapshot;
+}
+
+void ShardedDB::setLastError(const leveldb::Status &s)
+{
+    std::lock_guard< std::mutex > lock(mErrorMutex);
+    mLastError = s.ToString();
+}
+
+std::string ShardedDB::getLastError(void) const
+{
+    std::lock_guard< std::mutex > lock(mErrorMutex);
+    return mLastError;
+}
+
+} // end of SHARDED_DB namespace
@@ -0,0 +1,162 @@
+// Implements the array and base64 helpers for the XOR time-series codec
+#include "XorCompress.h"
+
+namespace XOR_COMPRESS
+{
+
+void encode(const double *values, size_t count, std::string &blob)
+{
+    blob.clear();
+    // Worst case is slightly more than the raw size; most series are far smaller
+    blob.reserve(4 + count * 2);
+    DoubleEncoder e(blob);
+    for (size_t i = 0; i < count; i++)
+    {
+        e.add(values[i]);
+    }
+    e.finish();
+}
+
+void encode(const float *values, size_t count, std::string &blob)
+{
+    blob.clear();
+    blob.reserve(4 + count);
+    FloatEncoder e(blob);
+    for (size_t i = 0; i < count; i++)
+    {
+        e.add(values[i]);
+    }
+    e.finish();
+}
+
+bool decode(const void *blob, size_t len, std::vector< double > &values)
+{
+    DoubleDecoder d(blob, len);
+    values.clear();
+    if (!d.isValid())
+    {
+        return false;
+    }
+    values.resize(d.getCount());
+    for (auto &v : values)
+    {
+        if (!d.next(v))
+        {
+            values.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool decode(const void *blob, size_t len, std::vector< float > &values)
+{
+    FloatDecoder d(blob, len);
+    values.clear();
+    if (!d.isValid())
+    {
+        return false;
+    }
+    values.resize(d.getCount());
+    for (auto &v : values)
+    {
+        if (!d.next(v))
+        {
+            values.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+static const char gBase64Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+void base64Encode(const void *data, size_t len, std::string &out)
+{
+    const uint8_t *scan = static_cast< const uint8_t * >(data);
+    out.clear();
+    out.reserve(((len + 2) / 3) * 4);
+    size_t i = 0;
+    for (; i + 3 <= len; i += 3)
+    {
+        uint32_t v = (uint32_t(scan[i]) << 16) | (uint32_t(scan[i + 1]) << 8) | scan[i + 2];
+        out.push_back(gBase64Chars[(v >> 18) & 63]);
+        out.push_back(gBase64Chars[(v >> 12) & 63]);
+        out.push_back(gBase64Chars[(v >> 6) & 63]);
+        out.push_back(gBase64Chars[v & 63]);
+    }
+    size_t remaining = len - i;
+    if (remaining)
+    {
+        uint32_t v = uint32_t(scan[i]) << 16;
+        if (remaining == 2)
+        {
+            v |= uint32_t(scan[i + 1]) << 8;
+        }
+        out.push_back(gBase64Chars[(v >> 18) & 63]);
+        out.push_back(gBase64Chars[(v >> 12) & 63]);
+        out.push_back(remaining == 2 ? gBase64Chars[(v >> 6) & 63] : '=');
+        out.push_back('=');
+    }
+}
+
+static int32_t base64Value(char c)
+{
+    int32_t ret = -1;
+    if (c >= 'A' && c <= 'Z')
+    {
+        ret = c - 'A';
+    }
+    else if (c >= 'a' && c <= 'z')
+    {
+        ret = c - 'a' + 26;
+    }
+    else if (c >= '0' && c <= '9')
+    {
+        ret = c - '0' + 52;
+    }
+    else if (c == '+')
+    {
+        ret = 62;
+    }
+    else if (c == '/')
+    {
+        ret = 63;
+    }
+    return ret;
+}
+
+bool base64Decode(const char *str, size_t len, std::string &out)
+{
+    out.clear();
+    while (len && str[len - 1] == '=')
+    {
+        len--;
+    }
+    if ((len % 4) == 1)
+    {
+        return false;
+    }
+    out.reserve((len * 3) / 4);
+    uint32_t accumulator = 0;
+    uint32_t bits = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        int32_t v = base64Value(str[i]);
+        if (v < 0)
+        {
+            out.clear();
+            return false;
+        }
+        accumulator = (accumulator << 6) | uint32_t(v);
+        bits += 6;
+        if (bits >= 8)
+        {
+            bits -= 8;
+            out.push_back(char((accumulator >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+} // end of XOR_COMPRESS namespace
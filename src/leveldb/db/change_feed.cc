@@ -0,0 +1,160 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "db/change_feed.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+
+#include "db/write_batch_internal.h"
+
+namespace leveldb {
+
+ChangeIterator::~ChangeIterator() = default;
+
+class ChangeFeed::Iter : public ChangeIterator {
+ public:
+  Iter(ChangeFeed* feed, SequenceNumber sequence)
+      : feed_(feed), sequence_(sequence) {
+    status_ = feed_->Find(sequence_, 0, &current_);
+  }
+
+  ~Iter() override = default;
+
+  bool Valid() const override { return current_ != nullptr; }
+
+  void Next() override {
+    assert(Valid());
+    sequence_ = current_->limit;
+    current_.reset();
+    status_ = feed_->Find(sequence_, 0, &current_);
+  }
+
+  bool Wait(uint64_t timeout_micros) override {
+    if (current_ == nullptr && status_.ok()) {
+      status_ = feed_->Find(sequence_, timeout_micros, &current_);
+    }
+    return Valid();
+  }
+
+  uint64_t sequence() const override {
+    assert(Valid());
+    return current_->sequence;
+  }
+
+  const WriteBatch& batch() const override {
+    assert(Valid());
+    return current_->batch;
+  }
+
+  Status status() const override { return status_; }
+
+ private:
+  ChangeFeed* const feed_;
+  SequenceNumber sequence_;  // The next sequence number to read
+  std::shared_ptr<const Entry> current_;
+  Status status_;
+};
+
+ChangeFeed::ChangeFeed(size_t max_bytes)
+    : max_bytes_(max_bytes), bytes_(0), first_(0), next_(0) {}
+
+ChangeFeed::~ChangeFeed() = default;
+
+void ChangeFeed::Append(const WriteBatch* batch) {
+  const int count = WriteBatchInternal::Count(batch);
+  if (count == 0) {
+    return;
+  }
+  const SequenceNumber sequence = WriteBatchInternal::Sequence(batch);
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->sequence = sequence;
+  entry->limit = sequence + count;
+  entry->batch = *batch;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence != next_) {
+      // Updates between next_ and sequence never reach the feed, e.g.
+      // those of an ingest replayed at open.
+      entries_.clear();
+      bytes_ = 0;
+      first_ = sequence;
+    }
+    entries_.push_back(entry);
+    bytes_ += sizeof(Entry) + WriteBatchInternal::ByteSize(batch);
+    next_ = entry->limit;
+    while (bytes_ > max_bytes_ && entries_.size() > 1) {
+      bytes_ -= sizeof(Entry) +
+                WriteBatchInternal::ByteSize(&entries_.front()->batch);
+      entries_.pop_front();
+      first_ = entries_.front()->sequence;
+    }
+  }
+  appended_.notify_all();
+}
+
+void ChangeFeed::Start(SequenceNumber next_sequence) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (next_sequence != next_) {
+    entries_.clear();
+    bytes_ = 0;
+    first_ = next_ = next_sequence;
+  }
+}
+
+void ChangeFeed::Truncate(SequenceNumber next_sequence) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    bytes_ = 0;
+    first_ = next_ = next_sequence;
+  }
+  // Waiting iterators are now behind the feed
+  appended_.notify_all();
+}
+
+ChangeIterator* ChangeFeed::NewIterator(SequenceNumber sequence) {
+  if (sequence == 0) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sequence = first_;
+  }
+  return new Iter(this, sequence);
+}
+
+Status ChangeFeed::Find(SequenceNumber sequence, uint64_t timeout_micros,
+                        std::shared_ptr<const Entry>* entry) {
+  const std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::microseconds(timeout_micros);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (sequence < first_) {
+      entry->reset();
+      return Status::NotFound("change feed no longer holds sequence number");
+    }
+    if (sequence < next_) {
+      // The first batch which ends after "sequence"
+      auto it = std::upper_bound(
+          entries_.begin(), entries_.end(), sequence,
+          [](SequenceNumber s, const std::shared_ptr<const Entry>& e) {
+            return s < e->limit;
+          });
+      assert(it != entries_.end());
+      *entry = *it;
+      return Status::OK();
+    }
+    if (timeout_micros == 0 ||
+        appended_.wait_until(lock, deadline) == std::cv_status::timeout) {
+      if (sequence >= next_) {
+        entry->reset();
+        return Status::OK();
+      }
+      timeout_micros = 0;  // Found on this pass
+    }
+  }
+}
+
+}  // namespace leveldb
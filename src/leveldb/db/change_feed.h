@@ -0,0 +1,78 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_DB_CHANGE_FEED_H_
+#define STORAGE_LEVELDB_DB_CHANGE_FEED_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "db/dbformat.h"
+#include "leveldb/change_iterator.h"
+#include "leveldb/status.h"
+#include "leveldb/write_batch.h"
+
+namespace leveldb {
+
+// The write batches most recently committed to a DB, in sequence order,
+// for ChangeIterators.  Once the batches take more than "max_bytes", the
+// oldest are dropped; an iterator keeps the batch it is positioned at
+// alive.  Thread-safe.
+class ChangeFeed {
+ public:
+  explicit ChangeFeed(size_t max_bytes);
+
+  ChangeFeed(const ChangeFeed&) = delete;
+  ChangeFeed& operator=(const ChangeFeed&) = delete;
+
+  ~ChangeFeed();
+
+  // Adds a batch whose sequence number is set; batches must be added in
+  // sequence order, without gaps.  Empty batches are ignored.
+  void Append(const WriteBatch* batch);
+
+  // Called once the DB is open, with the sequence number of the next
+  // write.  The feed starts there unless batches replayed from the log
+  // were already appended.
+  void Start(SequenceNumber next_sequence);
+
+  // Drops every batch.  Sequence numbers below "next_sequence" are no
+  // longer available.
+  void Truncate(SequenceNumber next_sequence);
+
+  // Returns an iterator positioned at the batch holding "sequence", or at
+  // the oldest batch kept if "sequence" is 0.
+  ChangeIterator* NewIterator(SequenceNumber sequence);
+
+ private:
+  class Iter;
+
+  struct Entry {
+    SequenceNumber sequence;  // of the first update
+    SequenceNumber limit;     // sequence + number of updates
+    WriteBatch batch;
+  };
+
+  // Stores in *entry the batch holding "sequence", waiting up to
+  // "timeout_micros" for it to be committed; leaves *entry null if it is
+  // not committed by then.  Fails if "sequence" is no longer kept.
+  Status Find(SequenceNumber sequence, uint64_t timeout_micros,
+              std::shared_ptr<const Entry>* entry);
+
+  const size_t max_bytes_;
+
+  std::mutex mutex_;
+  std::condition_variable appended_;
+  std::deque<std::shared_ptr<const Entry>> entries_;
+  size_t bytes_;
+  SequenceNumber first_;  // Oldest sequence number still available
+  SequenceNumber next_;   // Follows the newest batch; 0 before the start
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_DB_CHANGE_FEED_H_
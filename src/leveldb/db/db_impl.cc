@@ -8,11 +8,15 @@
 #include <atomic>
 #include <cstdint>
 #include <cstdio>
+#include <deque>
 #include <set>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "db/builder.h"
+#include "db/change_feed.h"
 #include "db/db_iter.h"
 #include "db/dbformat.h"
 #include "db/filename.h"
@@ -24,6 +28,8 @@
 #include "db/write_batch_internal.h"
 #include "leveldb/db.h"
 #include "leveldb/env.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/statistics.h"
 #include "leveldb/status.h"
 #include "leveldb/table.h"
 #include "leveldb/table_builder.h"
@@ -34,6 +40,7 @@
 #include "util/coding.h"
 #include "util/logging.h"
 #include "util/mutexlock.h"
+#include "util/rate_limited_file.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable:4100 4267)
@@ -43,15 +50,63 @@ namespace leveldb {
 
 const int kNumNonTableCacheFiles = 10;
 
+static_assert(Statistics::kNumLevels == config::kNumLevels,
+              "Statistics keeps a counter per level");
+
+namespace {
+
+// Adds the time until the end of the scope to a histogram of "stats".  Does
+// not read the clock if "stats" is null.
+class StatisticsTimer {
+ public:
+  StatisticsTimer(Env* env, Statistics* stats, Statistics::Histogram histogram)
+      : env_(env),
+        stats_(stats),
+        histogram_(histogram),
+        start_micros_(stats != nullptr ? env->NowMicros() : 0) {}
+
+  StatisticsTimer(const StatisticsTimer&) = delete;
+  StatisticsTimer& operator=(const StatisticsTimer&) = delete;
+
+  ~StatisticsTimer() {
+    if (stats_ != nullptr) {
+      stats_->Measure(histogram_, env_->NowMicros() - start_micros_);
+    }
+  }
+
+ private:
+  Env* const env_;
+  Statistics* const stats_;
+  const Statistics::Histogram histogram_;
+  const uint64_t start_micros_;
+};
+
+}  // namespace
+
 // Information kept for every waiting writer
 struct DBImpl::Writer {
   explicit Writer(port::Mutex* mu)
-      : batch(nullptr), sync(false), done(false), cv(mu) {}
+      : batch(nullptr),
+        sync(false),
+        done(false),
+        ingest(false),
+        memtable(nullptr),
+        leader(nullptr),
+        pending(0),
+        cv(mu) {}
 
   Status status;
   WriteBatch* batch;
   bool sync;
   bool done;
+  bool ingest;  // An Ingest() call; never grouped with other writers
+
+  // Set by the group's leader when this writer should insert its batch
+  // into "memtable" itself, then decrement leader->pending.
+  MemTable* memtable;
+  Writer* leader;
+  int pending;  // Followers still inserting; only used by a leader
+
   port::CondVar cv;
 };
 
@@ -85,6 +140,7 @@ struct DBImpl::CompactionState {
   // State kept for output being generated
   WritableFile* outfile;
   TableBuilder* builder;
+  Compaction::OutputCursor cursor;
 
   uint64_t total_bytes;
 };
@@ -98,14 +154,19 @@ static void ClipToRange(T* ptr, V minvalue, V maxvalue) {
 Options SanitizeOptions(const std::string& dbname,
                         const InternalKeyComparator* icmp,
                         const InternalFilterPolicy* ipolicy,
+                        const InternalPrefixExtractor* iextractor,
                         const Options& src) {
   Options result = src;
   result.comparator = icmp;
   result.filter_policy = (src.filter_policy != nullptr) ? ipolicy : nullptr;
+  result.prefix_extractor =
+      (src.prefix_extractor != nullptr) ? iextractor : nullptr;
   ClipToRange(&result.max_open_files, 64 + kNumNonTableCacheFiles, 50000);
   ClipToRange(&result.write_buffer_size, 64 << 10, 1 << 30);
   ClipToRange(&result.max_file_size, 1 << 20, 1 << 30);
   ClipToRange(&result.block_size, 1 << 10, 4 << 20);
+  ClipToRange(&result.max_background_compactions, 1, 64);
+  ClipToRange(&result.max_subcompactions, 1, 64);
   if (result.info_log == nullptr) {
     // Open a log file in the same directory as the db
     src.env->CreateDir(dbname);  // In case it does not exist
@@ -127,16 +188,88 @@ static int TableCacheSize(const Options& sanitized_options) {
   return sanitized_options.max_open_files - kNumNonTableCacheFiles;
 }
 
+class DBImpl::CompactionRateLimiter : public RateLimiter {
+ public:
+  CompactionRateLimiter(const Options& options,
+                        const std::atomic<int>* level0_files)
+      : limiter_(options.rate_limiter),
+        env_(options.env),
+        statistics_(options.statistics),
+        level0_files_(level0_files),
+        charged_bytes_(0),
+        throttled_micros_(0) {}
+
+  // Charges "bytes" less one half for every level-0 file past the
+  // compaction trigger, and nothing once writes are being slowed down: a
+  // backlog in level-0 costs writers more than compactions cost readers.
+  void Request(size_t bytes) override {
+    const int level0 = level0_files_->load(std::memory_order_relaxed);
+    if (level0 >= config::kL0_SlowdownWritesTrigger) {
+      return;
+    }
+    if (level0 > config::kL0_CompactionTrigger) {
+      bytes >>= level0 - config::kL0_CompactionTrigger;
+    }
+    if (bytes == 0) {
+      return;
+    }
+    const uint64_t start_micros = env_->NowMicros();
+    limiter_->Request(bytes);
+    const uint64_t micros = env_->NowMicros() - start_micros;
+    charged_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    throttled_micros_.fetch_add(micros, std::memory_order_relaxed);
+    if (statistics_ != nullptr) {
+      statistics_->Record(Statistics::kRateLimitedBytes, bytes);
+      statistics_->Record(Statistics::kRateLimitMicros, micros);
+    }
+  }
+
+  int64_t GetBytesPerSecond() const override {
+    return limiter_->GetBytesPerSecond();
+  }
+
+  void SetBytesPerSecond(int64_t bytes_per_second) override {
+    limiter_->SetBytesPerSecond(bytes_per_second);
+  }
+
+  // The bytes and waits of this database only, which may share the limiter
+  uint64_t GetTotalBytes() const override {
+    return charged_bytes_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t GetThrottledMicros() const override {
+    return throttled_micros_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  RateLimiter* const limiter_;
+  Env* const env_;
+  Statistics* const statistics_;
+  const std::atomic<int>* const level0_files_;
+  std::atomic<uint64_t> charged_bytes_;
+  std::atomic<uint64_t> throttled_micros_;
+};
+
 DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
     : env_(raw_options.env),
       internal_comparator_(raw_options.comparator),
       internal_filter_policy_(raw_options.filter_policy),
+      internal_prefix_extractor_(raw_options.prefix_extractor),
       options_(SanitizeOptions(dbname, &internal_comparator_,
-                               &internal_filter_policy_, raw_options)),
+                               &internal_filter_policy_,
+                               &internal_prefix_extractor_, raw_options)),
       owns_info_log_(options_.info_log != raw_options.info_log),
       owns_cache_(options_.block_cache != raw_options.block_cache),
       dbname_(dbname),
       table_cache_(new TableCache(dbname_, options_, TableCacheSize(options_))),
+      change_feed_(options_.change_feed_size > 0
+                       ? new ChangeFeed(options_.change_feed_size)
+                       : nullptr),
+      level0_files_(0),
+      compaction_limiter_(options_.rate_limiter != nullptr
+                              ? new CompactionRateLimiter(options_,
+                                                          &level0_files_)
+                              : nullptr),
       db_lock_(nullptr),
       shutting_down_(false),
       background_work_finished_signal_(&mutex_),
@@ -148,7 +281,13 @@ DBImpl::DBImpl(const Options& raw_options, const std::string& dbname)
       log_(nullptr),
       seed_(0),
       tmp_batch_(new WriteBatch),
-      background_compaction_scheduled_(false),
+      background_compactions_scheduled_(0),
+      running_compactions_(0),
+      flushing_memtable_(false),
+      manual_running_(false),
+      compaction_blocked_(false),
+      applying_edit_(false),
+      ingest_installing_(false),
       manual_compaction_(nullptr),
       versions_(new VersionSet(dbname_, &options_, table_cache_,
                                &internal_comparator_)) {}
@@ -157,7 +296,7 @@ DBImpl::~DBImpl() {
   // Wait for background work to finish.
   mutex_.Lock();
   shutting_down_.store(true, std::memory_order_release);
-  while (background_compaction_scheduled_) {
+  while (background_compactions_scheduled_ > 0) {
     background_work_finished_signal_.Wait();
   }
   mutex_.Unlock();
@@ -173,6 +312,8 @@ DBImpl::~DBImpl() {
   delete log_;
   delete logfile_;
   delete table_cache_;
+  delete change_feed_;
+  delete compaction_limiter_;
 
   if (owns_info_log_) {
     delete options_.info_log;
@@ -450,6 +591,9 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
     if (!status.ok()) {
       break;
     }
+    if (change_feed_ != nullptr) {
+      change_feed_->Append(&batch);
+    }
     const SequenceNumber last_seq = WriteBatchInternal::Sequence(&batch) +
                                     WriteBatchInternal::Count(&batch) - 1;
     if (last_seq > *max_sequence) {
@@ -459,7 +603,9 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
     if (mem->ApproximateMemoryUsage() > options_.write_buffer_size) {
       compactions++;
       *save_manifest = true;
-      status = WriteLevel0Table(mem, edit, nullptr);
+      uint64_t number;
+      status = WriteLevel0Table(mem, edit, nullptr, &number);
+      pending_outputs_.erase(number);
       mem->Unref();
       mem = nullptr;
       if (!status.ok()) {
@@ -498,7 +644,9 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
     // mem did not get reused; compact it.
     if (status.ok()) {
       *save_manifest = true;
-      status = WriteLevel0Table(mem, edit, nullptr);
+      uint64_t number;
+      status = WriteLevel0Table(mem, edit, nullptr, &number);
+      pending_outputs_.erase(number);
     }
     mem->Unref();
   }
@@ -507,12 +655,13 @@ Status DBImpl::RecoverLogFile(uint64_t log_number, bool last_log,
 }
 
 Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
-                                Version* base) {
+                                Version* base, uint64_t* number) {
   mutex_.AssertHeld();
   const uint64_t start_micros = env_->NowMicros();
   FileMetaData meta;
   meta.number = versions_->NewFileNumber();
   pending_outputs_.insert(meta.number);
+  *number = meta.number;
   Iterator* iter = mem->NewIterator();
   Log(options_.info_log, "Level-0 table #%llu: started",
       (unsigned long long)meta.number);
@@ -528,7 +677,6 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
       (unsigned long long)meta.number, (unsigned long long)meta.file_size,
       s.ToString().c_str());
   delete iter;
-  pending_outputs_.erase(meta.number);
 
   // Note that if file_size is zero, the file has been deleted and
   // should not be added to the manifest.
@@ -536,7 +684,12 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
   if (s.ok() && meta.file_size > 0) {
     const Slice min_user_key = meta.smallest.user_key();
     const Slice max_user_key = meta.largest.user_key();
-    if (base != nullptr) {
+    // While compactions run on other threads the table stays in level-0:
+    // their outputs are not in "base" yet, so a deeper level could turn out
+    // to overlap them.
+    const bool concurrent_compactions =
+        options_.max_background_compactions > 1 && running_compactions_ > 0;
+    if (base != nullptr && !concurrent_compactions) {
       level = base->PickLevelForMemTableOutput(min_user_key, max_user_key);
     }
     edit->AddFile(level, meta.number, meta.file_size, meta.smallest,
@@ -547,18 +700,29 @@ Status DBImpl::WriteLevel0Table(MemTable* mem, VersionEdit* edit,
   stats.micros = env_->NowMicros() - start_micros;
   stats.bytes_written = meta.file_size;
   stats_[level].Add(stats);
+  if (options_.statistics != nullptr) {
+    options_.statistics->RecordCompaction(level, stats.micros, 0,
+                                          stats.bytes_written);
+    options_.statistics->Measure(Statistics::kFlushMicros, stats.micros);
+  }
   return s;
 }
 
 void DBImpl::CompactMemTable() {
   mutex_.AssertHeld();
   assert(imm_ != nullptr);
+  assert(!flushing_memtable_);
+  flushing_memtable_ = true;
+
+  // Compactions may start on other threads meanwhile
+  MaybeScheduleCompaction();
 
   // Save the contents of the memtable as a new Table
   VersionEdit edit;
   Version* base = versions_->current();
   base->Ref();
-  Status s = WriteLevel0Table(imm_, &edit, base);
+  uint64_t number;
+  Status s = WriteLevel0Table(imm_, &edit, base, &number);
   base->Unref();
 
   if (s.ok() && shutting_down_.load(std::memory_order_acquire)) {
@@ -569,8 +733,10 @@ void DBImpl::CompactMemTable() {
   if (s.ok()) {
     edit.SetPrevLogNumber(0);
     edit.SetLogNumber(logfile_number_);  // Earlier logs no longer needed
-    s = versions_->LogAndApply(&edit, &mutex_);
+    s = ApplyVersionEdit(&edit);
   }
+  pending_outputs_.erase(number);
+  flushing_memtable_ = false;
 
   if (s.ok()) {
     // Commit to the new state
@@ -663,21 +829,55 @@ void DBImpl::RecordBackgroundError(const Status& s) {
   }
 }
 
+Status DBImpl::ApplyVersionEdit(VersionEdit* edit) {
+  mutex_.AssertHeld();
+  while (applying_edit_) {
+    background_work_finished_signal_.Wait();
+  }
+  applying_edit_ = true;
+  Status s = versions_->LogAndApply(edit, &mutex_);
+  applying_edit_ = false;
+  level0_files_.store(versions_->NumLevelFiles(0), std::memory_order_relaxed);
+  // The new version may have compactions that were blocked before
+  compaction_blocked_ = false;
+  background_work_finished_signal_.SignalAll();
+  return s;
+}
+
 void DBImpl::MaybeScheduleCompaction() {
   mutex_.AssertHeld();
-  if (background_compaction_scheduled_) {
+  if (background_compactions_scheduled_ >=
+      options_.max_background_compactions) {
     // Already scheduled
   } else if (shutting_down_.load(std::memory_order_acquire)) {
     // DB is being deleted; no more background compactions
+  } else if (ingest_installing_) {
+    // Ingest() reschedules once its version edit is applied
   } else if (!bg_error_.ok()) {
     // Already got an error; no more changes
-  } else if (imm_ == nullptr && manual_compaction_ == nullptr &&
-             !versions_->NeedsCompaction()) {
+  } else if (!HasBackgroundWork()) {
     // No work to be done
   } else {
-    background_compaction_scheduled_ = true;
-    env_->Schedule(&DBImpl::BGWork, this);
+    background_compactions_scheduled_++;
+    if (options_.max_background_compactions == 1) {
+      env_->Schedule(&DBImpl::BGWork, this);
+    } else {
+      // The Env runs scheduled work one item at a time
+      env_->StartThread(&DBImpl::BGWork, this);
+    }
+  }
+}
+
+bool DBImpl::HasBackgroundWork() {
+  mutex_.AssertHeld();
+  if (imm_ != nullptr && !flushing_memtable_) {
+    return true;
+  }
+  if (manual_compaction_ != nullptr) {
+    // A manual compaction runs alone and holds back the others
+    return !manual_running_ && running_compactions_ == 0;
   }
+  return versions_->NeedsCompaction() && !compaction_blocked_;
 }
 
 void DBImpl::BGWork(void* db) {
@@ -686,7 +886,7 @@ void DBImpl::BGWork(void* db) {
 
 void DBImpl::BackgroundCall() {
   MutexLock l(&mutex_);
-  assert(background_compaction_scheduled_);
+  assert(background_compactions_scheduled_ > 0);
   if (shutting_down_.load(std::memory_order_acquire)) {
     // No more background work when shutting down.
   } else if (!bg_error_.ok()) {
@@ -695,7 +895,7 @@ void DBImpl::BackgroundCall() {
     BackgroundCompaction();
   }
 
-  background_compaction_scheduled_ = false;
+  background_compactions_scheduled_--;
 
   // Previous compaction may have produced too many files in a level,
   // so reschedule another compaction if needed.
@@ -706,7 +906,7 @@ void DBImpl::BackgroundCall() {
 void DBImpl::BackgroundCompaction() {
   mutex_.AssertHeld();
 
-  if (imm_ != nullptr) {
+  if (imm_ != nullptr && !flushing_memtable_) {
     CompactMemTable();
     return;
   }
@@ -715,6 +915,12 @@ void DBImpl::BackgroundCompaction() {
   bool is_manual = (manual_compaction_ != nullptr);
   InternalKey manual_end;
   if (is_manual) {
+    if (manual_running_ || running_compactions_ > 0) {
+      // Another job runs it, or it waits until the other compactions are
+      // done and scheduled again by the last of them
+      return;
+    }
+    manual_running_ = true;
     ManualCompaction* m = manual_compaction_;
     c = versions_->CompactRange(m->level, m->begin, m->end);
     m->done = (c == nullptr);
@@ -728,6 +934,14 @@ void DBImpl::BackgroundCompaction() {
         (m->done ? "(end)" : manual_end.DebugString().c_str()));
   } else {
     c = versions_->PickCompaction();
+    if (c == nullptr && versions_->NeedsCompaction()) {
+      // Every compaction needed shares inputs with a running one
+      compaction_blocked_ = true;
+    }
+  }
+
+  if (c != nullptr) {
+    NotifyCompactionInputs(c, true);
   }
 
   Status status;
@@ -740,7 +954,7 @@ void DBImpl::BackgroundCompaction() {
     c->edit()->RemoveFile(c->level(), f->number);
     c->edit()->AddFile(c->level() + 1, f->number, f->file_size, f->smallest,
                        f->largest);
-    status = versions_->LogAndApply(c->edit(), &mutex_);
+    status = ApplyVersionEdit(c->edit());
     if (!status.ok()) {
       RecordBackgroundError(status);
     }
@@ -749,14 +963,21 @@ void DBImpl::BackgroundCompaction() {
         static_cast<unsigned long long>(f->number), c->level() + 1,
         static_cast<unsigned long long>(f->file_size),
         status.ToString().c_str(), versions_->LevelSummary(&tmp));
+    NotifyCompactionInputs(c, false);
   } else {
+    running_compactions_++;
+    // Other jobs may take on the rest of the work meanwhile
+    MaybeScheduleCompaction();
     CompactionState* compact = new CompactionState(c);
     status = DoCompactionWork(compact);
     if (!status.ok()) {
       RecordBackgroundError(status);
     }
     CleanupCompaction(compact);
+    NotifyCompactionInputs(c, false);
     c->ReleaseInputs();
+    running_compactions_--;
+    compaction_blocked_ = false;
     RemoveObsoleteFiles();
   }
   delete c;
@@ -780,10 +1001,25 @@ void DBImpl::BackgroundCompaction() {
       m->tmp_storage = manual_end;
       m->begin = &m->tmp_storage;
     }
+    manual_running_ = false;
     manual_compaction_ = nullptr;
   }
 }
 
+void DBImpl::NotifyCompactionInputs(Compaction* c, bool picked) {
+  mutex_.AssertHeld();
+  if (!compaction_inputs_hook_) {
+    return;
+  }
+  std::vector<uint64_t> files;
+  for (int which = 0; which < 2; which++) {
+    for (int i = 0; i < c->num_input_files(which); i++) {
+      files.push_back(c->input(which, i)->number);
+    }
+  }
+  compaction_inputs_hook_(picked, c->level(), files);
+}
+
 void DBImpl::CleanupCompaction(CompactionState* compact) {
   mutex_.AssertHeld();
   if (compact->builder != nullptr) {
@@ -820,6 +1056,10 @@ Status DBImpl::OpenCompactionOutputFile(CompactionState* compact) {
   // Make the output file
   std::string fname = TableFileName(dbname_, file_number);
   Status s = env_->NewWritableFile(fname, &compact->outfile);
+  if (s.ok() && compaction_limiter_ != nullptr) {
+    compact->outfile =
+        new RateLimitedWritableFile(compact->outfile, compaction_limiter_);
+  }
   if (s.ok()) {
     compact->builder = new TableBuilder(options_, compact->outfile);
   }
@@ -890,19 +1130,19 @@ Status DBImpl::InstallCompactionResults(CompactionState* compact) {
     compact->compaction->edit()->AddFile(level + 1, out.number, out.file_size,
                                          out.smallest, out.largest);
   }
-  return versions_->LogAndApply(compact->compaction->edit(), &mutex_);
+  return ApplyVersionEdit(compact->compaction->edit());
 }
 
 Status DBImpl::DoCompactionWork(CompactionState* compact) {
   const uint64_t start_micros = env_->NowMicros();
   int64_t imm_micros = 0;  // Micros spent doing imm_ compactions
+  Compaction* const c = compact->compaction;
 
   Log(options_.info_log, "Compacting %d@%d + %d@%d files",
-      compact->compaction->num_input_files(0), compact->compaction->level(),
-      compact->compaction->num_input_files(1),
-      compact->compaction->level() + 1);
+      c->num_input_files(0), c->level(), c->num_input_files(1),
+      c->level() + 1);
 
-  assert(versions_->NumLevelFiles(compact->compaction->level()) > 0);
+  assert(versions_->NumLevelFiles(c->level()) > 0);
   assert(compact->builder == nullptr);
   assert(compact->outfile == nullptr);
   if (snapshots_.empty()) {
@@ -911,12 +1151,150 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
     compact->smallest_snapshot = snapshots_.oldest()->sequence_number();
   }
 
-  Iterator* input = versions_->MakeInputIterator(compact->compaction);
+  // A large compaction is split into key ranges that are merged on threads
+  // of their own.  Every range collects its outputs in its own state; they
+  // are appended to *compact in key order afterwards.
+  std::vector<std::string> bounds;
+  SplitCompaction(c, &bounds);
+  std::vector<CompactionState*> ranges(1, compact);
+  std::vector<Iterator*> inputs(
+      1, versions_->MakeInputIterator(c, compaction_limiter_));
+  for (size_t i = 0; i < bounds.size(); i++) {
+    CompactionState* range = new CompactionState(c);
+    range->smallest_snapshot = compact->smallest_snapshot;
+    ranges.push_back(range);
+    inputs.push_back(versions_->MakeInputIterator(c, compaction_limiter_));
+  }
+  if (!bounds.empty()) {
+    Log(options_.info_log, "Compacting in %d subcompactions",
+        static_cast<int>(ranges.size()));
+  }
 
   // Release mutex while we're actually doing the compaction work
   mutex_.Unlock();
 
-  input->SeekToFirst();
+  std::vector<Slice> limits(bounds.begin(), bounds.end());
+  std::vector<Status> statuses(ranges.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < ranges.size(); i++) {
+    threads.emplace_back([this, &ranges, &inputs, &limits, &statuses, i]() {
+      statuses[i] = DoCompactionRange(
+          ranges[i], inputs[i], &limits[i - 1],
+          i < limits.size() ? &limits[i] : nullptr, nullptr);
+    });
+  }
+  // Only this thread flushes the memtable, so the time it takes is known
+  statuses[0] = DoCompactionRange(compact, inputs[0], nullptr,
+                                  limits.empty() ? nullptr : &limits[0],
+                                  &imm_micros);
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  Status status;
+  for (size_t i = 0; i < ranges.size(); i++) {
+    if (status.ok()) {
+      status = statuses[i];
+    }
+    delete inputs[i];
+  }
+
+  mutex_.Lock();
+  for (size_t i = 1; i < ranges.size(); i++) {
+    CompactionState* range = ranges[i];
+    compact->outputs.insert(compact->outputs.end(), range->outputs.begin(),
+                            range->outputs.end());
+    compact->total_bytes += range->total_bytes;
+    // The outputs now belong to *compact, which drops them from
+    // pending_outputs_
+    range->outputs.clear();
+    CleanupCompaction(range);
+  }
+
+  CompactionStats stats;
+  stats.micros = env_->NowMicros() - start_micros - imm_micros;
+  for (int which = 0; which < 2; which++) {
+    for (int i = 0; i < c->num_input_files(which); i++) {
+      stats.bytes_read += c->input(which, i)->file_size;
+    }
+  }
+  for (size_t i = 0; i < compact->outputs.size(); i++) {
+    stats.bytes_written += compact->outputs[i].file_size;
+  }
+  stats_[c->level() + 1].Add(stats);
+  if (options_.statistics != nullptr) {
+    options_.statistics->RecordCompaction(c->level() + 1, stats.micros,
+                                          stats.bytes_read,
+                                          stats.bytes_written);
+    options_.statistics->Measure(Statistics::kCompactionMicros, stats.micros);
+  }
+
+  if (status.ok()) {
+    status = InstallCompactionResults(compact);
+  }
+  if (!status.ok()) {
+    RecordBackgroundError(status);
+  }
+  VersionSet::LevelSummaryStorage tmp;
+  Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
+  return status;
+}
+
+void DBImpl::SplitCompaction(Compaction* c, std::vector<std::string>* bounds) {
+  bounds->clear();
+
+  // Candidate bounds are the largest keys of the input files which are
+  // sorted and disjoint, each weighted by the size of its file.  Level-0
+  // files may span the whole key space, so they only add to the total.
+  std::vector<std::pair<Slice, uint64_t>> ends;
+  uint64_t total = 0;
+  for (int which = 0; which < 2; which++) {
+    if (c->level() + which == 0) {
+      continue;
+    }
+    for (int i = 0; i < c->num_input_files(which); i++) {
+      const FileMetaData* f = c->input(which, i);
+      ends.emplace_back(f->largest.user_key(), f->file_size);
+      total += f->file_size;
+    }
+  }
+
+  // Every range should fill at least one output file
+  const uint64_t ranges =
+      std::min<uint64_t>(options_.max_subcompactions,
+                         c->TotalInputBytes() / c->MaxOutputFileSize());
+  if (ranges < 2 || ends.size() < 2) {
+    return;
+  }
+
+  const Comparator* ucmp = user_comparator();
+  std::sort(ends.begin(), ends.end(),
+            [ucmp](const std::pair<Slice, uint64_t>& a,
+                   const std::pair<Slice, uint64_t>& b) {
+              return ucmp->Compare(a.first, b.first) < 0;
+            });
+  uint64_t sum = 0;
+  for (size_t i = 0; i + 1 < ends.size() && bounds->size() + 1 < ranges;
+       i++) {
+    sum += ends[i].second;
+    if (sum * ranges >= total * (bounds->size() + 1) &&
+        (bounds->empty() || ucmp->Compare(ends[i].first, bounds->back()) > 0)) {
+      // A range ends before its bound, so every version of a user key is
+      // merged by the same subcompaction
+      bounds->push_back(ends[i].first.ToString());
+    }
+  }
+}
+
+Status DBImpl::DoCompactionRange(CompactionState* compact, Iterator* input,
+                                 const Slice* begin, const Slice* end,
+                                 int64_t* imm_micros) {
+  if (begin == nullptr) {
+    input->SeekToFirst();
+  } else {
+    InternalKey start(*begin, kMaxSequenceNumber, kValueTypeForSeek);
+    input->Seek(start.Encode());
+  }
   Status status;
   ParsedInternalKey ikey;
   std::string current_user_key;
@@ -924,20 +1302,25 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   SequenceNumber last_sequence_for_key = kMaxSequenceNumber;
   while (input->Valid() && !shutting_down_.load(std::memory_order_acquire)) {
     // Prioritize immutable compaction work
-    if (has_imm_.load(std::memory_order_relaxed)) {
+    if (imm_micros != nullptr && has_imm_.load(std::memory_order_relaxed)) {
       const uint64_t imm_start = env_->NowMicros();
       mutex_.Lock();
-      if (imm_ != nullptr) {
+      if (imm_ != nullptr && !flushing_memtable_) {
         CompactMemTable();
         // Wake up MakeRoomForWrite() if necessary.
         background_work_finished_signal_.SignalAll();
       }
       mutex_.Unlock();
-      imm_micros += (env_->NowMicros() - imm_start);
+      *imm_micros += (env_->NowMicros() - imm_start);
     }
 
     Slice key = input->key();
-    if (compact->compaction->ShouldStopBefore(key) &&
+    if (end != nullptr && key.size() >= 8 &&
+        user_comparator()->Compare(ExtractUserKey(key), *end) >= 0) {
+      // The rest belongs to the next range
+      break;
+    }
+    if (compact->compaction->ShouldStopBefore(key, &compact->cursor) &&
         compact->builder != nullptr) {
       status = FinishCompactionOutputFile(compact, input);
       if (!status.ok()) {
@@ -967,7 +1350,8 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         drop = true;  // (A)
       } else if (ikey.type == kTypeDeletion &&
                  ikey.sequence <= compact->smallest_snapshot &&
-                 compact->compaction->IsBaseLevelForKey(ikey.user_key)) {
+                 compact->compaction->IsBaseLevelForKey(ikey.user_key,
+                                                      &compact->cursor)) {
         // For this user key:
         // (1) there is no data in higher levels
         // (2) data in lower levels will have larger sequence numbers
@@ -986,7 +1370,8 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
         "%d smallest_snapshot: %d",
         ikey.user_key.ToString().c_str(),
         (int)ikey.sequence, ikey.type, kTypeValue, drop,
-        compact->compaction->IsBaseLevelForKey(ikey.user_key),
+        compact->compaction->IsBaseLevelForKey(ikey.user_key,
+                                               &compact->cursor),
         (int)last_sequence_for_key, (int)compact->smallest_snapshot);
 #endif
 
@@ -1026,31 +1411,6 @@ Status DBImpl::DoCompactionWork(CompactionState* compact) {
   if (status.ok()) {
     status = input->status();
   }
-  delete input;
-  input = nullptr;
-
-  CompactionStats stats;
-  stats.micros = env_->NowMicros() - start_micros - imm_micros;
-  for (int which = 0; which < 2; which++) {
-    for (int i = 0; i < compact->compaction->num_input_files(which); i++) {
-      stats.bytes_read += compact->compaction->input(which, i)->file_size;
-    }
-  }
-  for (size_t i = 0; i < compact->outputs.size(); i++) {
-    stats.bytes_written += compact->outputs[i].file_size;
-  }
-
-  mutex_.Lock();
-  stats_[compact->compaction->level() + 1].Add(stats);
-
-  if (status.ok()) {
-    status = InstallCompactionResults(compact);
-  }
-  if (!status.ok()) {
-    RecordBackgroundError(status);
-  }
-  VersionSet::LevelSummaryStorage tmp;
-  Log(options_.info_log, "compacted to: %s", versions_->LevelSummary(&tmp));
   return status;
 }
 
@@ -1076,6 +1436,41 @@ static void CleanupIteratorState(void* arg1, void* arg2) {
   delete state;
 }
 
+// ReadOptions::iterate_upper_bound or iterate_prefix copied for the lifetime
+// of an iterator, as a user key for the DBIter and as an internal key for
+// the table iterators below it.
+struct IterateBound {
+  explicit IterateBound(const Slice& bound)
+      : user_key(bound.ToString()),
+        internal_key(bound, kMaxSequenceNumber, kValueTypeForSeek),
+        user_slice(user_key),
+        internal_slice(internal_key.Encode()) {}
+
+  const std::string user_key;
+  const InternalKey internal_key;
+  const Slice user_slice;
+  const Slice internal_slice;
+};
+
+static void DeleteIterateBound(void* arg1, void* arg2) {
+  delete reinterpret_cast<IterateBound*>(arg1);
+}
+
+// Sets "*limit" to the smallest key after every key starting with "prefix"
+// in bytewise order.  False if there is none: the prefix is empty or all
+// 0xff bytes.
+static bool PrefixSuccessor(const Slice& prefix, std::string* limit) {
+  limit->assign(prefix.data(), prefix.size());
+  while (!limit->empty() && static_cast<uint8_t>(limit->back()) == 0xff) {
+    limit->pop_back();
+  }
+  if (limit->empty()) {
+    return false;
+  }
+  (*limit)[limit->size() - 1]++;
+  return true;
+}
+
 }  // anonymous namespace
 
 Iterator* DBImpl::NewInternalIterator(const ReadOptions& options,
@@ -1116,8 +1511,14 @@ int64_t DBImpl::TEST_MaxNextLevelOverlappingBytes() {
   return versions_->MaxNextLevelOverlappingBytes();
 }
 
+void DBImpl::TEST_SetCompactionInputsHook(CompactionInputsHook hook) {
+  MutexLock l(&mutex_);
+  compaction_inputs_hook_ = std::move(hook);
+}
+
 Status DBImpl::Get(const ReadOptions& options, const Slice& key,
                    std::string* value) {
+  StatisticsTimer timer(env_, options_.statistics, Statistics::kGetMicros);
   Status s;
   MutexLock l(&mutex_);
   SequenceNumber snapshot;
@@ -1160,19 +1561,374 @@ Status DBImpl::Get(const ReadOptions& options, const Slice& key,
   mem->Unref();
   if (imm != nullptr) imm->Unref();
   current->Unref();
+  if (options_.statistics != nullptr && s.ok()) {
+    options_.statistics->Record(Statistics::kBytesRead, value->size());
+  }
+  return s;
+}
+
+void DBImpl::MultiGet(const ReadOptions& options, size_t num_keys,
+                      const Slice* keys, std::string* values,
+                      Status* statuses) {
+  if (num_keys == 0) {
+    return;
+  }
+  MutexLock l(&mutex_);
+  SequenceNumber snapshot;
+  if (options.snapshot != nullptr) {
+    snapshot =
+        static_cast<const SnapshotImpl*>(options.snapshot)->sequence_number();
+  } else {
+    snapshot = versions_->LastSequence();
+  }
+
+  MemTable* mem = mem_;
+  MemTable* imm = imm_;
+  Version* current = versions_->current();
+  mem->Ref();
+  if (imm != nullptr) imm->Ref();
+  current->Ref();
+
+  bool schedule_compaction = false;
+
+  // Unlock while reading from files and memtables
+  {
+    mutex_.Unlock();
+    // Sort the keys so each table file and block is visited once
+    const Comparator* ucmp = user_comparator();
+    std::vector<size_t> order(num_keys);
+    for (size_t i = 0; i < num_keys; i++) {
+      order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return ucmp->Compare(keys[a], keys[b]) < 0;
+    });
+
+    // First look in the memtable, then in the immutable memtable (if any);
+    // the rest are looked up in the current version together.
+    std::deque<LookupKey> lkeys;
+    std::vector<const LookupKey*> table_keys;
+    std::vector<std::string*> table_values;
+    std::vector<size_t> table_index;
+    for (size_t i : order) {
+      lkeys.emplace_back(keys[i], snapshot);
+      const LookupKey& lkey = lkeys.back();
+      // MemTable::Get() only sets the status of a deleted key, so start from
+      // OK and an empty value rather than whatever the caller passed in
+      statuses[i] = Status::OK();
+      values[i].clear();
+      if (mem->Get(lkey, &values[i], &statuses[i])) {
+        // Done
+      } else if (imm != nullptr && imm->Get(lkey, &values[i], &statuses[i])) {
+        // Done
+      } else {
+        table_keys.push_back(&lkey);
+        table_values.push_back(&values[i]);
+        table_index.push_back(i);
+      }
+    }
+
+    std::vector<Version::GetStats> stats(table_keys.size());
+    std::vector<Status> table_status(table_keys.size());
+    if (!table_keys.empty()) {
+      current->MultiGet(options, static_cast<int>(table_keys.size()),
+                        table_keys.data(), table_values.data(),
+                        table_status.data(), stats.data());
+    }
+    for (size_t j = 0; j < table_index.size(); j++) {
+      statuses[table_index[j]] = table_status[j];
+    }
+    mutex_.Lock();
+
+    for (const Version::GetStats& s : stats) {
+      if (current->UpdateStats(s)) {
+        schedule_compaction = true;
+      }
+    }
+  }
+
+  if (schedule_compaction) {
+    MaybeScheduleCompaction();
+  }
+  mem->Unref();
+  if (imm != nullptr) imm->Unref();
+  current->Unref();
+}
+
+Status DBImpl::BuildIngestTables(IngestSource* source, SequenceNumber sequence,
+                                 std::vector<FileMetaData>* files) {
+  const Comparator* ucmp = user_comparator();
+  WritableFile* file = nullptr;
+  TableBuilder* builder = nullptr;
+  std::string ikey;
+  std::string last_user_key;
+  bool has_last = false;
+
+  // Completes the current file and checks that it can be opened, as
+  // BuildTable() does; abandons it instead if "status" is an error.
+  auto finish_file = [&](Status status) {
+    FileMetaData& meta = files->back();
+    meta.largest.DecodeFrom(ikey);
+    if (status.ok()) {
+      status = builder->Finish();
+      meta.file_size = builder->FileSize();
+    } else {
+      builder->Abandon();
+    }
+    delete builder;
+    builder = nullptr;
+    if (status.ok()) {
+      status = file->Sync();
+    }
+    if (status.ok()) {
+      status = file->Close();
+    }
+    delete file;
+    file = nullptr;
+    if (status.ok()) {
+      Iterator* it = table_cache_->NewIterator(ReadOptions(), meta.number,
+                                               meta.file_size);
+      status = it->status();
+      delete it;
+    }
+    return status;
+  };
+
+  Status s;
+  Slice key, value;
+  while (source->Next(&key, &value)) {
+    if (has_last && ucmp->Compare(key, last_user_key) <= 0) {
+      s = Status::InvalidArgument("ingested keys are not strictly increasing");
+      break;
+    }
+    if (builder == nullptr) {
+      FileMetaData meta;
+      {
+        MutexLock l(&mutex_);
+        meta.number = versions_->NewFileNumber();
+        pending_outputs_.insert(meta.number);
+      }
+      files->push_back(meta);
+      s = env_->NewWritableFile(TableFileName(dbname_, meta.number), &file);
+      if (!s.ok()) {
+        break;
+      }
+      builder = new TableBuilder(options_, file);
+    }
+
+    ikey.clear();
+    AppendInternalKey(&ikey, ParsedInternalKey(key, sequence, kTypeValue));
+    if (builder->NumEntries() == 0) {
+      files->back().smallest.DecodeFrom(ikey);
+    }
+    builder->Add(ikey, value);
+    last_user_key.assign(key.data(), key.size());
+    has_last = true;
+
+    if (builder->FileSize() >= options_.max_file_size) {
+      s = finish_file(s);
+      if (!s.ok()) {
+        break;
+      }
+    }
+  }
+  if (s.ok()) {
+    s = source->status();
+  }
+  if (builder != nullptr) {
+    s = finish_file(s);
+  }
+  return s;
+}
+
+Status DBImpl::Ingest(const IngestOptions& options, int num_sources,
+                      IngestSource* const* sources) {
+  Writer w(&mutex_);
+  w.ingest = true;
+
+  MutexLock l(&mutex_);
+  writers_.push_back(&w);
+  while (&w != writers_.front()) {
+    w.cv.Wait();
+  }
+
+  // Other writers now wait behind us.  Flush the memtable, so that every
+  // entry the ingested files may replace is older than them and lives in a
+  // table file.
+  Status s = MakeRoomForWrite(true /* force */);
+  while (s.ok() && imm_ != nullptr && bg_error_.ok()) {
+    background_work_finished_signal_.Wait();
+  }
+  if (s.ok() && imm_ != nullptr) {
+    s = bg_error_;
+  }
+
+  std::vector<std::vector<FileMetaData>> outputs(num_sources);
+  if (s.ok() && num_sources > 0) {
+    // Every ingested entry gets the same sequence number, newer than all
+    // the entries written so far.
+    const SequenceNumber sequence = versions_->LastSequence() + 1;
+    versions_->SetLastSequence(sequence);
+
+    mutex_.Unlock();
+    std::vector<Status> results(num_sources);
+    std::atomic<int> next_source(0);
+    auto build = [&]() {
+      int i;
+      while ((i = next_source.fetch_add(1)) < num_sources) {
+        results[i] = BuildIngestTables(sources[i], sequence, &outputs[i]);
+      }
+    };
+    const int num_threads =
+        std::max(1, std::min(options.max_threads, num_sources));
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; i++) {
+      threads.emplace_back(build);
+    }
+    build();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    mutex_.Lock();
+
+    for (int i = 0; i < num_sources && s.ok(); i++) {
+      s = results[i];
+    }
+  }
+
+  std::vector<FileMetaData> files;
+  for (const std::vector<FileMetaData>& output : outputs) {
+    files.insert(files.end(), output.begin(), output.end());
+  }
+  if (s.ok()) {
+    std::sort(files.begin(), files.end(),
+              [this](const FileMetaData& a, const FileMetaData& b) {
+                return internal_comparator_.Compare(a.smallest, b.smallest) <
+                       0;
+              });
+    for (size_t i = 1; i < files.size() && s.ok(); i++) {
+      if (user_comparator()->Compare(files[i - 1].largest.user_key(),
+                                     files[i].smallest.user_key()) >= 0) {
+        s = Status::InvalidArgument("ingested key ranges overlap");
+      }
+    }
+  }
+
+  if (s.ok() && !files.empty()) {
+    // Background jobs apply their own version edits, so wait until they
+    // are idle and keep them so until the files are installed.
+    ingest_installing_ = true;
+    while (background_compactions_scheduled_ > 0) {
+      background_work_finished_signal_.Wait();
+    }
+
+    // Each file goes to the deepest level such that no level above it
+    // holds overlapping (and therefore older) entries; a file which
+    // overlaps level 0 stays there, newer than the files it overlaps.
+    VersionEdit edit;
+    Version* current = versions_->current();
+    int levels[config::kNumLevels] = {};
+    for (const FileMetaData& f : files) {
+      const Slice smallest = f.smallest.user_key();
+      const Slice largest = f.largest.user_key();
+      int level = 0;
+      if (!current->OverlapInLevel(0, &smallest, &largest)) {
+        while (level + 1 < config::kNumLevels &&
+               !current->OverlapInLevel(level + 1, &smallest, &largest)) {
+          level++;
+        }
+      }
+      edit.AddFile(level, f.number, f.file_size, f.smallest, f.largest);
+      stats_[level].bytes_written += f.file_size;
+      levels[level]++;
+    }
+    s = ApplyVersionEdit(&edit);
+    ingest_installing_ = false;
+    if (s.ok() && change_feed_ != nullptr) {
+      // Readers of the feed have missed the ingested pairs
+      change_feed_->Truncate(versions_->LastSequence() + 1);
+    }
+    MaybeScheduleCompaction();
+    background_work_finished_signal_.SignalAll();
+
+    std::string placement;
+    for (int level = 0; level < config::kNumLevels; level++) {
+      if (levels[level] > 0) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), " %d@%d", levels[level], level);
+        placement += buf;
+      }
+    }
+    Log(options_.info_log, "Ingested files:%s: %s", placement.c_str(),
+        s.ToString().c_str());
+  }
+
+  for (const FileMetaData& f : files) {
+    pending_outputs_.erase(f.number);
+    if (!s.ok()) {
+      env_->RemoveFile(TableFileName(dbname_, f.number));
+    }
+  }
+
+  writers_.pop_front();
+  if (!writers_.empty()) {
+    writers_.front()->cv.Signal();
+  }
   return s;
 }
 
 Iterator* DBImpl::NewIterator(const ReadOptions& options) {
   SequenceNumber latest_snapshot;
   uint32_t seed;
-  Iterator* iter = NewInternalIterator(options, &latest_snapshot, &seed);
-  return NewDBIterator(this, user_comparator(), iter,
-                       (options.snapshot != nullptr
-                            ? static_cast<const SnapshotImpl*>(options.snapshot)
-                                  ->sequence_number()
-                            : latest_snapshot),
-                       seed);
+  ReadOptions internal_options = options;
+  IterateBound* bound = nullptr;
+  IterateBound* prefix = nullptr;
+  if (options.iterate_prefix != nullptr) {
+    // The scan starts at the prefix and ends at its successor, so that no
+    // key outside the prefix, whose tables may have been skipped, is read.
+    prefix = new IterateBound(*options.iterate_prefix);
+    internal_options.iterate_prefix = &prefix->internal_slice;
+    std::string limit;
+    if (PrefixSuccessor(*options.iterate_prefix, &limit) &&
+        (options.iterate_upper_bound == nullptr ||
+         user_comparator()->Compare(limit, *options.iterate_upper_bound) <
+             0)) {
+      bound = new IterateBound(limit);
+    }
+  }
+  if (bound == nullptr && options.iterate_upper_bound != nullptr) {
+    bound = new IterateBound(*options.iterate_upper_bound);
+  }
+  if (bound != nullptr) {
+    internal_options.iterate_upper_bound = &bound->internal_slice;
+  }
+  Iterator* iter =
+      NewInternalIterator(internal_options, &latest_snapshot, &seed);
+  Iterator* db_iter = NewDBIterator(
+      this, user_comparator(), iter,
+      (options.snapshot != nullptr
+           ? static_cast<const SnapshotImpl*>(options.snapshot)
+                 ->sequence_number()
+           : latest_snapshot),
+      seed, bound != nullptr ? &bound->user_slice : nullptr,
+      prefix != nullptr ? &prefix->user_slice : nullptr);
+  // Runs after the DBIter has deleted the iterators which use the bounds
+  if (bound != nullptr) {
+    db_iter->RegisterCleanup(&DeleteIterateBound, bound, nullptr);
+  }
+  if (prefix != nullptr) {
+    db_iter->RegisterCleanup(&DeleteIterateBound, prefix, nullptr);
+  }
+  return db_iter;
+}
+
+Status DBImpl::NewChangeIterator(uint64_t sequence, ChangeIterator** result) {
+  *result = nullptr;
+  if (change_feed_ == nullptr) {
+    return Status::NotSupported("Options::change_feed_size is not set");
+  }
+  *result = change_feed_->NewIterator(sequence);
+  return Status::OK();
 }
 
 void DBImpl::RecordReadSample(Slice key) {
@@ -1194,14 +1950,25 @@ void DBImpl::ReleaseSnapshot(const Snapshot* snapshot) {
 
 // Convenience methods
 Status DBImpl::Put(const WriteOptions& o, const Slice& key, const Slice& val) {
+  StatisticsTimer timer(env_, options_.statistics, Statistics::kPutMicros);
   return DB::Put(o, key, val);
 }
 
 Status DBImpl::Delete(const WriteOptions& options, const Slice& key) {
+  StatisticsTimer timer(env_, options_.statistics, Statistics::kPutMicros);
   return DB::Delete(options, key);
 }
 
 Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
+  // A null batch only forces a memtable switch; it is not a user write.
+  Statistics* const statistics =
+      updates != nullptr ? options_.statistics : nullptr;
+  StatisticsTimer timer(env_, statistics, Statistics::kWriteMicros);
+  if (statistics != nullptr) {
+    statistics->Record(Statistics::kBytesWritten,
+                       WriteBatchInternal::ByteSize(updates));
+  }
+
   Writer w(&mutex_);
   w.batch = updates;
   w.sync = options.sync;
@@ -1210,6 +1977,19 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
   MutexLock l(&mutex_);
   writers_.push_back(&w);
   while (!w.done && &w != writers_.front()) {
+    if (w.memtable != nullptr) {
+      // The leader has logged our batch and asks us to insert it
+      MemTable* mem = w.memtable;
+      w.memtable = nullptr;
+      mutex_.Unlock();
+      Status s = WriteBatchInternal::InsertIntoConcurrently(w.batch, mem);
+      mutex_.Lock();
+      w.status = s;
+      if (--w.leader->pending == 0) {
+        w.leader->cv.Signal();
+      }
+      continue;
+    }
     w.cv.Wait();
   }
   if (w.done) {
@@ -1223,7 +2003,22 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
   if (status.ok() && updates != nullptr) {  // nullptr batch is for compactions
     WriteBatch* write_batch = BuildBatchGroup(&last_writer);
     WriteBatchInternal::SetSequence(write_batch, last_sequence + 1);
-    last_sequence += WriteBatchInternal::Count(write_batch);
+
+    // Give each batch of the group its own sequence numbers if the
+    // writers are to insert their batches themselves.
+    bool parallel = false;
+    if (options_.allow_concurrent_memtable_write && write_batch == tmp_batch_) {
+      for (Writer* writer : writers_) {
+        if (writer->batch != nullptr) {
+          WriteBatchInternal::SetSequence(writer->batch, last_sequence + 1);
+          last_sequence += WriteBatchInternal::Count(writer->batch);
+        }
+        if (writer == last_writer) break;
+      }
+      parallel = true;
+    } else {
+      last_sequence += WriteBatchInternal::Count(write_batch);
+    }
 
     // Add to log and apply to memtable.  We can release the lock
     // during this phase since &w is currently responsible for logging
@@ -1239,7 +2034,7 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
           sync_error = true;
         }
       }
-      if (status.ok()) {
+      if (status.ok() && !parallel) {
         status = WriteBatchInternal::InsertInto(write_batch, mem_);
       }
       mutex_.Lock();
@@ -1250,6 +2045,12 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
         RecordBackgroundError(status);
       }
     }
+    if (status.ok() && parallel) {
+      status = InsertBatchGroup(&w, last_writer);
+    }
+    if (status.ok() && change_feed_ != nullptr) {
+      change_feed_->Append(write_batch);
+    }
     if (write_batch == tmp_batch_) tmp_batch_->Clear();
 
     versions_->SetLastSequence(last_sequence);
@@ -1274,6 +2075,44 @@ Status DBImpl::Write(const WriteOptions& options, WriteBatch* updates) {
   return status;
 }
 
+// REQUIRES: leader is at the front of the writer queue
+// REQUIRES: every batch of the group has its sequence number set
+Status DBImpl::InsertBatchGroup(Writer* leader, Writer* last_writer) {
+  mutex_.AssertHeld();
+  assert(writers_.front() == leader);
+  MemTable* mem = mem_;
+
+  // Hand every other batch to its writer's thread
+  std::deque<Writer*>::iterator iter = writers_.begin();
+  if (leader != last_writer) {
+    do {
+      ++iter;
+      Writer* w = *iter;
+      if (w->batch != nullptr) {
+        w->memtable = mem;
+        w->leader = leader;
+        leader->pending++;
+        w->cv.Signal();
+      }
+    } while (*iter != last_writer);
+  }
+
+  mutex_.Unlock();
+  Status status = WriteBatchInternal::InsertIntoConcurrently(leader->batch, mem);
+  mutex_.Lock();
+  while (leader->pending > 0) {
+    leader->cv.Wait();
+  }
+
+  for (Writer* w : writers_) {
+    if (status.ok() && w != leader && w->batch != nullptr) {
+      status = w->status;
+    }
+    if (w == last_writer) break;
+  }
+  return status;
+}
+
 // REQUIRES: Writer list must be non-empty
 // REQUIRES: First writer must have a non-null batch
 WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
@@ -1298,6 +2137,11 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
   ++iter;  // Advance past "first"
   for (; iter != writers_.end(); ++iter) {
     Writer* w = *iter;
+    if (w->ingest) {
+      // An ingest has to run on its own
+      break;
+    }
+
     if (w->sync && !first->sync) {
       // Do not include a sync write into a batch handled by a non-sync write.
       break;
@@ -1324,6 +2168,16 @@ WriteBatch* DBImpl::BuildBatchGroup(Writer** last_writer) {
   return result;
 }
 
+void DBImpl::RecordWriteStall(uint64_t start_micros) {
+  mutex_.AssertHeld();
+  const uint64_t micros = env_->NowMicros() - start_micros;
+  stall_stats_.micros += micros;
+  if (options_.statistics != nullptr) {
+    options_.statistics->Record(Statistics::kWriteStalls);
+    options_.statistics->Record(Statistics::kWriteStallMicros, micros);
+  }
+}
+
 // REQUIRES: mutex_ is held
 // REQUIRES: this thread is currently at the front of the writer queue
 Status DBImpl::MakeRoomForWrite(bool force) {
@@ -1344,10 +2198,13 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // individual write by 1ms to reduce latency variance.  Also,
       // this delay hands over some CPU to the compaction thread in
       // case it is sharing the same core as the writer.
+      const uint64_t start_micros = env_->NowMicros();
       mutex_.Unlock();
       env_->SleepForMicroseconds(1000);
       allow_delay = false;  // Do not delay a single write more than once
       mutex_.Lock();
+      stall_stats_.delayed_writes++;
+      RecordWriteStall(start_micros);
     } else if (!force &&
                (mem_->ApproximateMemoryUsage() <= options_.write_buffer_size)) {
       // There is room in current memtable
@@ -1356,11 +2213,17 @@ Status DBImpl::MakeRoomForWrite(bool force) {
       // We have filled up the current memtable, but the previous
       // one is still being compacted, so we wait.
       Log(options_.info_log, "Current memtable full; waiting...\n");
+      const uint64_t start_micros = env_->NowMicros();
       background_work_finished_signal_.Wait();
+      stall_stats_.memtable_waits++;
+      RecordWriteStall(start_micros);
     } else if (versions_->NumLevelFiles(0) >= config::kL0_StopWritesTrigger) {
       // There are too many level-0 files.
       Log(options_.info_log, "Too many L0 files; waiting...\n");
+      const uint64_t start_micros = env_->NowMicros();
       background_work_finished_signal_.Wait();
+      stall_stats_.level0_waits++;
+      RecordWriteStall(start_micros);
     } else {
       // Attempt to switch to a new memtable and trigger compaction of old
       assert(versions_->PrevLogNumber() == 0);
@@ -1443,6 +2306,34 @@ bool DBImpl::GetProperty(const Slice& property, std::string* value) {
       }
     }
     return true;
+  } else if (in == "write-stalls") {
+    char buf[200];
+    std::snprintf(buf, sizeof(buf),
+                  "Delayed writes: %lld\n"
+                  "Memtable waits: %lld\n"
+                  "Level-0 waits: %lld\n"
+                  "Stall time(sec): %.3f\n",
+                  static_cast<long long>(stall_stats_.delayed_writes),
+                  static_cast<long long>(stall_stats_.memtable_waits),
+                  static_cast<long long>(stall_stats_.level0_waits),
+                  stall_stats_.micros / 1e6);
+    value->append(buf);
+    return true;
+  } else if (in == "rate-limiter") {
+    if (compaction_limiter_ == nullptr) {
+      return false;
+    }
+    char buf[200];
+    std::snprintf(
+        buf, sizeof(buf),
+        "Rate(MB/s): %.1f\n"
+        "Charged(MB): %.1f\n"
+        "Throttled time(sec): %.3f\n",
+        compaction_limiter_->GetBytesPerSecond() / 1048576.0,
+        compaction_limiter_->GetTotalBytes() / 1048576.0,
+        compaction_limiter_->GetThrottledMicros() / 1e6);
+    value->append(buf);
+    return true;
   } else if (in == "sstables") {
     *value = versions_->current()->DebugString();
     return true;
@@ -1496,6 +2387,54 @@ Status DB::Delete(const WriteOptions& opt, const Slice& key) {
   return Write(opt, &batch);
 }
 
+void DB::MultiGet(const ReadOptions& options, size_t num_keys,
+                  const Slice* keys, std::string* values, Status* statuses) {
+  // Read every key from the same snapshot
+  ReadOptions read_options = options;
+  const Snapshot* snapshot = nullptr;
+  if (read_options.snapshot == nullptr) {
+    snapshot = GetSnapshot();
+    read_options.snapshot = snapshot;
+  }
+  for (size_t i = 0; i < num_keys; i++) {
+    statuses[i] = Get(read_options, keys[i], &values[i]);
+  }
+  if (snapshot != nullptr) {
+    ReleaseSnapshot(snapshot);
+  }
+}
+
+Status DB::Ingest(const IngestOptions& options, int num_sources,
+                  IngestSource* const* sources) {
+  // Apply the pairs in batches of about 1MB
+  WriteBatch batch;
+  Slice key, value;
+  Status s;
+  for (int i = 0; i < num_sources && s.ok(); i++) {
+    while (s.ok() && sources[i]->Next(&key, &value)) {
+      batch.Put(key, value);
+      if (batch.ApproximateSize() >= (1 << 20)) {
+        s = Write(WriteOptions(), &batch);
+        batch.Clear();
+      }
+    }
+    if (s.ok()) {
+      s = sources[i]->status();
+    }
+  }
+  if (s.ok()) {
+    s = Write(WriteOptions(), &batch);
+  }
+  (void)options;
+  return s;
+}
+
+Status DB::NewChangeIterator(uint64_t sequence, ChangeIterator** result) {
+  (void)sequence;
+  *result = nullptr;
+  return Status::NotSupported("change feed");
+}
+
 DB::~DB() = default;
 
 Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
@@ -1528,8 +2467,13 @@ Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
     s = impl->versions_->LogAndApply(&edit, &impl->mutex_);
   }
   if (s.ok()) {
+    impl->level0_files_.store(impl->versions_->NumLevelFiles(0),
+                              std::memory_order_relaxed);
     impl->RemoveObsoleteFiles();
     impl->MaybeScheduleCompaction();
+    if (impl->change_feed_ != nullptr) {
+      impl->change_feed_->Start(impl->versions_->LastSequence() + 1);
+    }
   }
   impl->mutex_.Unlock();
   if (s.ok()) {
@@ -1543,6 +2487,8 @@ Status DB::Open(const Options& options, const std::string& dbname, DB** dbptr) {
 
 Snapshot::~Snapshot() = default;
 
+IngestSource::~IngestSource() = default;
+
 Status DestroyDB(const std::string& dbname, const Options& options) {
   Env* env = options.env;
   std::vector<std::string> filenames;
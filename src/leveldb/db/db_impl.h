@@ -7,8 +7,10 @@
 
 #include <atomic>
 #include <deque>
+#include <functional>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "db/dbformat.h"
 #include "db/log_writer.h"
@@ -20,6 +22,9 @@
 
 namespace leveldb {
 
+struct FileMetaData;
+class ChangeFeed;
+class Compaction;
 class MemTable;
 class TableCache;
 class Version;
@@ -42,6 +47,12 @@ class DBImpl : public DB {
   Status Write(const WriteOptions& options, WriteBatch* updates) override;
   Status Get(const ReadOptions& options, const Slice& key,
              std::string* value) override;
+  void MultiGet(const ReadOptions& options, size_t num_keys, const Slice* keys,
+                std::string* values, Status* statuses) override;
+  Status Ingest(const IngestOptions& options, int num_sources,
+                IngestSource* const* sources) override;
+  Status NewChangeIterator(uint64_t sequence,
+                           ChangeIterator** result) override;
   Iterator* NewIterator(const ReadOptions&) override;
   const Snapshot* GetSnapshot() override;
   void ReleaseSnapshot(const Snapshot* snapshot) override;
@@ -66,6 +77,15 @@ class DBImpl : public DB {
   // file at a level >= 1.
   int64_t TEST_MaxNextLevelOverlappingBytes();
 
+  // Called with mutex_ held when a background job picks the input files of a
+  // compaction ("picked" is true) and when it lets go of them, with the level
+  // of the compaction and the numbers of its input files.
+  using CompactionInputsHook = std::function<void(
+      bool picked, int level, const std::vector<uint64_t>& files)>;
+
+  // Install "hook", or remove it if empty.
+  void TEST_SetCompactionInputsHook(CompactionInputsHook hook);
+
   // Record a sample of bytes read at the specified internal key.
   // Samples are taken approximately once every config::kReadBytesPeriod
   // bytes.
@@ -101,6 +121,22 @@ class DBImpl : public DB {
     int64_t bytes_written;
   };
 
+  // Requests the I/O of compactions from options_.rate_limiter; see
+  // Options::rate_limiter.
+  class CompactionRateLimiter;
+
+  // Writes held back by MakeRoomForWrite() because background work fell
+  // behind.
+  struct WriteStallStats {
+    WriteStallStats()
+        : delayed_writes(0), memtable_waits(0), level0_waits(0), micros(0) {}
+
+    int64_t delayed_writes;  // Writes slowed down by 1ms for level-0 files
+    int64_t memtable_waits;  // Waits for the immutable memtable's flush
+    int64_t level0_waits;    // Waits for level-0 files to be compacted
+    int64_t micros;          // Time spent in all of the above
+  };
+
   Iterator* NewInternalIterator(const ReadOptions&,
                                 SequenceNumber* latest_snapshot,
                                 uint32_t* seed);
@@ -127,25 +163,63 @@ class DBImpl : public DB {
                         VersionEdit* edit, SequenceNumber* max_sequence)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
-  Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, Version* base)
-      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Writes "mem" into a new table file and adds it to *edit.  The file's
+  // number is stored in *number and stays in pending_outputs_, so that
+  // the caller can remove it once *edit is applied.
+  Status WriteLevel0Table(MemTable* mem, VersionEdit* edit, Version* base,
+                          uint64_t* number) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
   Status MakeRoomForWrite(bool force /* compact even if there is room? */)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Adds the time since "start_micros" to stall_stats_ and counts the stall
+  // in options_.statistics.  The caller counts the kind of stall.
+  void RecordWriteStall(uint64_t start_micros) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   WriteBatch* BuildBatchGroup(Writer** last_writer)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Inserts the batches of the writers from "leader" to "last_writer" into
+  // mem_, each in its own writer's thread.  Returns the first error.
+  Status InsertBatchGroup(Writer* leader, Writer* last_writer)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   void RecordBackgroundError(const Status& s);
 
+  // Writes the pairs of "source" into table files of at most
+  // options_.max_file_size bytes, all at sequence number "sequence".  Every
+  // file number taken is appended to *files, even if the build fails.
+  Status BuildIngestTables(IngestSource* source, SequenceNumber sequence,
+                           std::vector<FileMetaData>* files);
+
+  // Applies *edit to the current version.  VersionSet::LogAndApply()
+  // releases the mutex while it writes the manifest, so concurrent
+  // background jobs take turns here.
+  Status ApplyVersionEdit(VersionEdit* edit) EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
   void MaybeScheduleCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  bool HasBackgroundWork() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   static void BGWork(void* db);
   void BackgroundCall();
   void BackgroundCompaction() EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+  // Reports the inputs of "c" to compaction_inputs_hook_, if set.
+  void NotifyCompactionInputs(Compaction* c, bool picked)
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   void CleanupCompaction(CompactionState* compact)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
   Status DoCompactionWork(CompactionState* compact)
       EXCLUSIVE_LOCKS_REQUIRED(mutex_);
 
+  // Stores in *bounds the user keys at which "c" is split into
+  // subcompactions, in increasing order; leaves it empty if "c" runs whole.
+  void SplitCompaction(Compaction* c, std::vector<std::string>* bounds);
+
+  // Merges the entries of "input" with user keys in [*begin,*end) into the
+  // outputs of *compact; a null bound is open.  Flushes the immutable
+  // memtable on the way if imm_micros is non-null, adding the time taken.
+  Status DoCompactionRange(CompactionState* compact, Iterator* input,
+                           const Slice* begin, const Slice* end,
+                           int64_t* imm_micros);
+
   Status OpenCompactionOutputFile(CompactionState* compact);
   Status FinishCompactionOutputFile(CompactionState* compact, Iterator* input);
   Status InstallCompactionResults(CompactionState* compact)
@@ -159,6 +233,7 @@ class DBImpl : public DB {
   Env* const env_;
   const InternalKeyComparator internal_comparator_;
   const InternalFilterPolicy internal_filter_policy_;
+  const InternalPrefixExtractor internal_prefix_extractor_;
   const Options options_;  // options_.comparator == &internal_comparator_
   const bool owns_info_log_;
   const bool owns_cache_;
@@ -167,6 +242,18 @@ class DBImpl : public DB {
   // table_cache_ provides its own synchronization
   TableCache* const table_cache_;
 
+  // Null unless options_.change_feed_size is set; provides its own
+  // synchronization
+  ChangeFeed* const change_feed_;
+
+  // Files in level-0 as of the last version edit, read by
+  // compaction_limiter_ without holding mutex_
+  std::atomic<int> level0_files_;
+
+  // Null unless options_.rate_limiter is set; provides its own
+  // synchronization
+  CompactionRateLimiter* const compaction_limiter_;
+
   // Lock over the persistent DB state.  Non-null iff successfully acquired.
   FileLock* db_lock_;
 
@@ -192,8 +279,30 @@ class DBImpl : public DB {
   // part of ongoing compactions.
   std::set<uint64_t> pending_outputs_ GUARDED_BY(mutex_);
 
-  // Has a background compaction been scheduled or is running?
-  bool background_compaction_scheduled_ GUARDED_BY(mutex_);
+  // Number of background jobs scheduled or running, at most
+  // options_.max_background_compactions.
+  int background_compactions_scheduled_ GUARDED_BY(mutex_);
+
+  // Number of compactions between picking their inputs and cleaning up.
+  int running_compactions_ GUARDED_BY(mutex_);
+
+  CompactionInputsHook compaction_inputs_hook_ GUARDED_BY(mutex_);
+
+  // Is a job writing imm_ to a table file?
+  bool flushing_memtable_ GUARDED_BY(mutex_);
+
+  // Is a job running manual_compaction_?
+  bool manual_running_ GUARDED_BY(mutex_);
+
+  // Did the last attempt to pick a compaction find every candidate held by
+  // running compactions?  Cleared when a version edit is applied.
+  bool compaction_blocked_ GUARDED_BY(mutex_);
+
+  // Is a job inside VersionSet::LogAndApply()?
+  bool applying_edit_ GUARDED_BY(mutex_);
+
+  // Is Ingest() installing its files?  No compaction is scheduled meanwhile.
+  bool ingest_installing_ GUARDED_BY(mutex_);
 
   ManualCompaction* manual_compaction_ GUARDED_BY(mutex_);
 
@@ -203,6 +312,8 @@ class DBImpl : public DB {
   Status bg_error_ GUARDED_BY(mutex_);
 
   CompactionStats stats_[config::kNumLevels] GUARDED_BY(mutex_);
+
+  WriteStallStats stall_stats_ GUARDED_BY(mutex_);
 };
 
 // Sanitize db options.  The caller should delete result.info_log if
@@ -210,6 +321,7 @@ class DBImpl : public DB {
 Options SanitizeOptions(const std::string& db,
                         const InternalKeyComparator* icmp,
                         const InternalFilterPolicy* ipolicy,
+                        const InternalPrefixExtractor* iextractor,
                         const Options& src);
 
 }  // namespace leveldb
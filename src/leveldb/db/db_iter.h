@@ -16,10 +16,14 @@ class DBImpl;
 
 // Return a new iterator that converts internal keys (yielded by
 // "*internal_iter") that were live at the specified "sequence" number
-// into appropriate user keys.
+// into appropriate user keys.  If "upper_bound" is non-null the iterator
+// ends before the first user key at or after *upper_bound, and if
+// "lower_bound" is non-null it starts at the first user key at or after
+// *lower_bound.  Both must outlive the iterator.
 Iterator* NewDBIterator(DBImpl* db, const Comparator* user_key_comparator,
                         Iterator* internal_iter, SequenceNumber sequence,
-                        uint32_t seed);
+                        uint32_t seed, const Slice* upper_bound,
+                        const Slice* lower_bound);
 
 }  // namespace leveldb
 
@@ -118,6 +118,18 @@ bool InternalFilterPolicy::KeyMayMatch(const Slice& key, const Slice& f) const {
   return user_policy_->KeyMayMatch(ExtractUserKey(key), f);
 }
 
+const char* InternalPrefixExtractor::Name() const {
+  return user_extractor_->Name();
+}
+
+Slice InternalPrefixExtractor::Transform(const Slice& key) const {
+  return user_extractor_->Transform(ExtractUserKey(key));
+}
+
+bool InternalPrefixExtractor::InDomain(const Slice& key) const {
+  return user_extractor_->InDomain(ExtractUserKey(key));
+}
+
 LookupKey::LookupKey(const Slice& user_key, SequenceNumber s) {
   size_t usize = user_key.size();
   size_t needed = usize + 13;  // A conservative estimate
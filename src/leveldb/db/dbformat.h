@@ -12,6 +12,7 @@
 #include "leveldb/comparator.h"
 #include "leveldb/db.h"
 #include "leveldb/filter_policy.h"
+#include "leveldb/slice_transform.h"
 #include "leveldb/slice.h"
 #include "leveldb/table_builder.h"
 #include "util/coding.h"
@@ -128,6 +129,19 @@ class InternalFilterPolicy : public FilterPolicy {
   bool KeyMayMatch(const Slice& key, const Slice& filter) const override;
 };
 
+// A prefix extractor wrapper that converts from internal keys to user keys
+class InternalPrefixExtractor : public SliceTransform {
+ private:
+  const SliceTransform* const user_extractor_;
+
+ public:
+  explicit InternalPrefixExtractor(const SliceTransform* e)
+      : user_extractor_(e) {}
+  const char* Name() const override;
+  Slice Transform(const Slice& key) const override;
+  bool InDomain(const Slice& key) const override;
+};
+
 // Modules in this directory should keep internal keys wrapped inside
 // the following class instead of plain strings so that we do not
 // incorrectly use string comparisons instead of an InternalKeyComparator.
@@ -56,6 +56,11 @@ class MemTable {
   void Add(SequenceNumber seq, ValueType type, const Slice& key,
            const Slice& value);
 
+  // Like Add(), but several threads may call it at once, provided that
+  // none calls Add() meanwhile.
+  void AddConcurrently(SequenceNumber seq, ValueType type, const Slice& key,
+                       const Slice& value);
+
   // If memtable contains a value for key, store it in *value and return true.
   // If memtable contains a deletion for key, store a NotFound() error
   // in *status and return true.
@@ -76,6 +81,12 @@ class MemTable {
 
   ~MemTable();  // Private since only Unref() should be used to delete it
 
+  // Encodes an entry into memory taken from arena_, with
+  // Arena::AllocateConcurrently() if "concurrent".
+  const char* EncodeEntry(SequenceNumber seq, ValueType type,
+                          const Slice& key, const Slice& value,
+                          bool concurrent);
+
   KeyComparator comparator_;
   int refs_;
   Arena arena_;
@@ -6,6 +6,7 @@
 
 #include "db/filename.h"
 #include "leveldb/env.h"
+#include "leveldb/statistics.h"
 #include "leveldb/table.h"
 #include "util/coding.h"
 
@@ -49,6 +50,11 @@ Status TableCache::FindTable(uint64_t file_number, uint64_t file_size,
   EncodeFixed64(buf, file_number);
   Slice key(buf, sizeof(buf));
   *handle = cache_->Lookup(key);
+  if (options_.statistics != nullptr) {
+    options_.statistics->Record(*handle != nullptr
+                                    ? Statistics::kTableCacheHits
+                                    : Statistics::kTableCacheMisses);
+  }
   if (*handle == nullptr) {
     std::string fname = TableFileName(dbname_, file_number);
     RandomAccessFile* file = nullptr;
@@ -115,6 +121,24 @@ Status TableCache::Get(const ReadOptions& options, uint64_t file_number,
   return s;
 }
 
+void TableCache::MultiGet(const ReadOptions& options, uint64_t file_number,
+                          uint64_t file_size, int n, const Slice* keys,
+                          void* const* args, Status* statuses,
+                          void (*handle_result)(void*, const Slice&,
+                                                const Slice&)) {
+  Cache::Handle* handle = nullptr;
+  Status s = FindTable(file_number, file_size, &handle);
+  if (!s.ok()) {
+    for (int i = 0; i < n; i++) {
+      statuses[i] = s;
+    }
+    return;
+  }
+  Table* t = reinterpret_cast<TableAndFile*>(cache_->Value(handle))->table;
+  t->InternalMultiGet(options, n, keys, args, statuses, handle_result);
+  cache_->Release(handle);
+}
+
 void TableCache::Evict(uint64_t file_number) {
   char buf[sizeof(file_number)];
   EncodeFixed64(buf, file_number);
@@ -164,11 +164,19 @@ bool SomeFileOverlapsRange(const InternalKeyComparator& icmp,
 // is the largest key that occurs in the file, and value() is an
 // 16-byte value containing the file number and file size, both
 // encoded using EncodeFixed64.
+//
+// If "upper_bound" is non-null, Next() ends the iteration at the first file
+// whose smallest key is at or after *upper_bound, so a bounded scan does not
+// open it.
 class Version::LevelFileNumIterator : public Iterator {
  public:
   LevelFileNumIterator(const InternalKeyComparator& icmp,
-                       const std::vector<FileMetaData*>* flist)
-      : icmp_(icmp), flist_(flist), index_(flist->size()) {  // Marks as invalid
+                       const std::vector<FileMetaData*>* flist,
+                       const Slice* upper_bound)
+      : icmp_(icmp),
+        flist_(flist),
+        upper_bound_(upper_bound),
+        index_(flist->size()) {  // Marks as invalid
   }
   bool Valid() const override { return index_ < flist_->size(); }
   void Seek(const Slice& target) override {
@@ -181,6 +189,11 @@ class Version::LevelFileNumIterator : public Iterator {
   void Next() override {
     assert(Valid());
     index_++;
+    if (upper_bound_ != nullptr && index_ < flist_->size() &&
+        icmp_.Compare((*flist_)[index_]->smallest.Encode(), *upper_bound_) >=
+            0) {
+      index_ = flist_->size();  // Marks as invalid
+    }
   }
   void Prev() override {
     assert(Valid());
@@ -205,6 +218,7 @@ class Version::LevelFileNumIterator : public Iterator {
  private:
   const InternalKeyComparator icmp_;
   const std::vector<FileMetaData*>* const flist_;
+  const Slice* const upper_bound_;
   uint32_t index_;
 
   // Backing store for value().  Holds the file number and size.
@@ -226,8 +240,9 @@ static Iterator* GetFileIterator(void* arg, const ReadOptions& options,
 Iterator* Version::NewConcatenatingIterator(const ReadOptions& options,
                                             int level) const {
   return NewTwoLevelIterator(
-      new LevelFileNumIterator(vset_->icmp_, &files_[level]), &GetFileIterator,
-      vset_->table_cache_, options);
+      new LevelFileNumIterator(vset_->icmp_, &files_[level],
+                               options.iterate_upper_bound),
+      &GetFileIterator, vset_->table_cache_, options, nullptr);
 }
 
 void Version::AddIterators(const ReadOptions& options,
@@ -403,6 +418,156 @@ Status Version::Get(const ReadOptions& options, const LookupKey& k,
   return state.found ? state.s : Status::NotFound(Slice());
 }
 
+void Version::MultiGet(const ReadOptions& options, int n,
+                       const LookupKey* const* keys, std::string* const* vals,
+                       Status* statuses, GetStats* stats) {
+  const Comparator* ucmp = vset_->icmp_.user_comparator();
+
+  // The per key state of Get()
+  struct KeyState {
+    Saver saver;
+    FileMetaData* last_file_read;
+    int last_file_read_level;
+    bool done;
+  };
+  std::vector<KeyState> state(n);
+  std::vector<int> pending;  // Keys still being searched, in key order
+  pending.reserve(n);
+  for (int i = 0; i < n; i++) {
+    KeyState& ks = state[i];
+    ks.saver.state = kNotFound;
+    ks.saver.ucmp = ucmp;
+    ks.saver.user_key = keys[i]->user_key();
+    ks.saver.value = vals[i];
+    ks.last_file_read = nullptr;
+    ks.last_file_read_level = -1;
+    ks.done = false;
+    stats[i].seek_file = nullptr;
+    stats[i].seek_file_level = -1;
+    statuses[i] = Status::NotFound(Slice());
+    pending.push_back(i);
+  }
+
+  // Searches "f" for the keys in "group"
+  std::vector<int> group;
+  std::vector<Slice> group_keys;
+  std::vector<void*> group_args;
+  std::vector<Status> group_status;
+  auto search = [&](int level, FileMetaData* f) {
+    group_keys.clear();
+    group_args.clear();
+    group_status.resize(group.size());
+    for (int i : group) {
+      KeyState& ks = state[i];
+      if (stats[i].seek_file == nullptr && ks.last_file_read != nullptr) {
+        // We have had more than one seek for this read.  Charge the 1st file.
+        stats[i].seek_file = ks.last_file_read;
+        stats[i].seek_file_level = ks.last_file_read_level;
+      }
+      ks.last_file_read = f;
+      ks.last_file_read_level = level;
+      group_keys.push_back(keys[i]->internal_key());
+      group_args.push_back(&ks.saver);
+    }
+    vset_->table_cache_->MultiGet(options, f->number, f->file_size,
+                                  static_cast<int>(group.size()),
+                                  group_keys.data(), group_args.data(),
+                                  group_status.data(), SaveValue);
+    for (size_t j = 0; j < group.size(); j++) {
+      int i = group[j];
+      KeyState& ks = state[i];
+      if (!group_status[j].ok()) {
+        statuses[i] = group_status[j];
+        ks.done = true;
+        continue;
+      }
+      switch (ks.saver.state) {
+        case kNotFound:
+          break;  // Keep searching in other files
+        case kFound:
+          statuses[i] = Status::OK();
+          ks.done = true;
+          break;
+        case kDeleted:
+          ks.done = true;
+          break;
+        case kCorrupt:
+          statuses[i] = Status::Corruption("corrupted key for ",
+                                           ks.saver.user_key);
+          ks.done = true;
+          break;
+      }
+    }
+  };
+  auto remove_done = [&]() {
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [&](int i) { return state[i].done; }),
+                  pending.end());
+  };
+
+  // Search level-0 in order from newest to oldest; each file gets the keys
+  // within its range.
+  std::vector<FileMetaData*> tmp(files_[0]);
+  std::sort(tmp.begin(), tmp.end(), NewestFirst);
+  for (FileMetaData* f : tmp) {
+    if (pending.empty()) {
+      return;
+    }
+    Slice smallest = f->smallest.user_key();
+    Slice largest = f->largest.user_key();
+    auto first = std::lower_bound(pending.begin(), pending.end(), smallest,
+                                  [&](int i, const Slice& k) {
+                                    return ucmp->Compare(
+                                               state[i].saver.user_key, k) < 0;
+                                  });
+    group.clear();
+    for (auto p = first; p != pending.end() &&
+                         ucmp->Compare(state[*p].saver.user_key, largest) <= 0;
+         ++p) {
+      group.push_back(*p);
+    }
+    if (!group.empty()) {
+      search(0, f);
+      remove_done();
+    }
+  }
+
+  // Search other levels.  Files do not overlap, so consecutive keys are
+  // grouped until one is past the largest key of their file.
+  for (int level = 1; level < config::kNumLevels; level++) {
+    const std::vector<FileMetaData*>& files = files_[level];
+    if (files.empty()) continue;
+    if (pending.empty()) {
+      return;
+    }
+    size_t p = 0;
+    while (p < pending.size()) {
+      uint32_t index =
+          FindFile(vset_->icmp_, files, keys[pending[p]]->internal_key());
+      if (index >= files.size()) {
+        break;  // The remaining keys are past the last file
+      }
+      FileMetaData* f = files[index];
+      Slice largest = f->largest.Encode();
+      group.clear();
+      for (; p < pending.size() &&
+             vset_->icmp_.Compare(keys[pending[p]]->internal_key(),
+                                  largest) <= 0;
+           p++) {
+        // Keys before the file's smallest key fall between files
+        if (ucmp->Compare(state[pending[p]].saver.user_key,
+                          f->smallest.user_key()) >= 0) {
+          group.push_back(pending[p]);
+        }
+      }
+      if (!group.empty()) {
+        search(level, f);
+      }
+    }
+    remove_done();
+  }
+}
+
 bool Version::UpdateStats(const GetStats& stats) {
   FileMetaData* f = stats.seek_file;
   if (f != nullptr) {
@@ -1060,6 +1225,7 @@ void VersionSet::Finalize(Version* v) {
           static_cast<double>(level_bytes) / MaxBytesForLevel(options_, level);
     }
 
+    v->level_scores_[level] = score;
     if (score > best_score) {
       best_level = level;
       best_score = score;
@@ -1220,10 +1386,12 @@ void VersionSet::GetRange2(const std::vector<FileMetaData*>& inputs1,
   GetRange(all, smallest, largest);
 }
 
-Iterator* VersionSet::MakeInputIterator(Compaction* c) {
+Iterator* VersionSet::MakeInputIterator(Compaction* c,
+                                        RateLimiter* rate_limiter) {
   ReadOptions options;
   options.verify_checksums = options_->paranoid_checks;
   options.fill_cache = false;
+  options.rate_limiter = rate_limiter;
 
   // Level-0 files have to be merged together.  For other levels,
   // we will make a concatenating iterator per level.
@@ -1242,8 +1410,9 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
       } else {
         // Create concatenating iterator for the files from this level
         list[num++] = NewTwoLevelIterator(
-            new Version::LevelFileNumIterator(icmp_, &c->inputs_[which]),
-            &GetFileIterator, table_cache_, options);
+            new Version::LevelFileNumIterator(icmp_, &c->inputs_[which],
+                                              nullptr),
+            &GetFileIterator, table_cache_, options, nullptr);
       }
     }
   }
@@ -1254,40 +1423,67 @@ Iterator* VersionSet::MakeInputIterator(Compaction* c) {
 }
 
 Compaction* VersionSet::PickCompaction() {
-  Compaction* c;
-  int level;
-
   // We prefer compactions triggered by too much data in a level over
-  // the compactions triggered by seeks.
-  const bool size_compaction = (current_->compaction_score_ >= 1);
-  const bool seek_compaction = (current_->file_to_compact_ != nullptr);
-  if (size_compaction) {
-    level = current_->compaction_level_;
-    assert(level >= 0);
-    assert(level + 1 < config::kNumLevels);
-    c = new Compaction(options_, level);
-
-    // Pick the first file that comes after compact_pointer_[level]
-    for (size_t i = 0; i < current_->files_[level].size(); i++) {
-      FileMetaData* f = current_->files_[level][i];
-      if (compact_pointer_[level].empty() ||
-          icmp_.Compare(f->largest.Encode(), compact_pointer_[level]) > 0) {
-        c->inputs_[0].push_back(f);
-        break;
+  // the compactions triggered by seeks.  The levels are tried from the
+  // highest score down, so a level whose files are all held by running
+  // compactions hands over to the next one.
+  int levels[config::kNumLevels - 1];
+  int num_levels = 0;
+  for (int level = 0; level < config::kNumLevels - 1; level++) {
+    if (current_->level_scores_[level] >= 1) {
+      levels[num_levels++] = level;
+    }
+  }
+  std::stable_sort(levels, levels + num_levels, [this](int a, int b) {
+    return current_->level_scores_[a] > current_->level_scores_[b];
+  });
+
+  for (int i = 0; i < num_levels; i++) {
+    const int level = levels[i];
+    const std::vector<FileMetaData*>& files = current_->files_[level];
+    if (level == 0 && std::any_of(files.begin(), files.end(),
+                                  [](const FileMetaData* f) {
+                                    return f->being_compacted;
+                                  })) {
+      // Level-0 files may overlap each other, so only one compaction at a
+      // time reads them
+      continue;
+    }
+
+    // Pick the first file that comes after compact_pointer_[level],
+    // wrapping around to the beginning of the key space
+    size_t first = 0;
+    if (!compact_pointer_[level].empty()) {
+      while (first < files.size() &&
+             icmp_.Compare(files[first]->largest.Encode(),
+                           compact_pointer_[level]) <= 0) {
+        first++;
+      }
+      if (first == files.size()) {
+        first = 0;
       }
     }
-    if (c->inputs_[0].empty()) {
-      // Wrap-around to the beginning of the key space
-      c->inputs_[0].push_back(current_->files_[level][0]);
+    for (size_t j = 0; j < files.size(); j++) {
+      FileMetaData* f = files[(first + j) % files.size()];
+      if (!f->being_compacted) {
+        Compaction* c = SetupCompaction(level, f);
+        if (c != nullptr) {
+          return c;
+        }
+      }
     }
-  } else if (seek_compaction) {
-    level = current_->file_to_compact_level_;
-    c = new Compaction(options_, level);
-    c->inputs_[0].push_back(current_->file_to_compact_);
-  } else {
-    return nullptr;
   }
 
+  FileMetaData* f = current_->file_to_compact_;
+  if (f != nullptr && !f->being_compacted) {
+    return SetupCompaction(current_->file_to_compact_level_, f);
+  }
+  return nullptr;
+}
+
+Compaction* VersionSet::SetupCompaction(int level, FileMetaData* f) {
+  Compaction* c = new Compaction(options_, level);
+  c->inputs_[0].push_back(f);
   c->input_version_ = current_;
   c->input_version_->Ref();
 
@@ -1303,7 +1499,12 @@ Compaction* VersionSet::PickCompaction() {
   }
 
   SetupOtherInputs(c);
-
+  if (c->InputsBeingCompacted()) {
+    delete c;
+    return nullptr;
+  }
+  c->MarkInputs(true);
+  AdvanceCompactPointer(c);
   return c;
 }
 
@@ -1410,7 +1611,10 @@ void VersionSet::SetupOtherInputs(Compaction* c) {
     const int64_t inputs0_size = TotalFileSize(c->inputs_[0]);
     const int64_t inputs1_size = TotalFileSize(c->inputs_[1]);
     const int64_t expanded0_size = TotalFileSize(expanded0);
-    if (expanded0.size() > c->inputs_[0].size() &&
+    const bool expanded0_free =
+        std::none_of(expanded0.begin(), expanded0.end(),
+                     [](const FileMetaData* f) { return f->being_compacted; });
+    if (expanded0.size() > c->inputs_[0].size() && expanded0_free &&
         inputs1_size + expanded0_size <
             ExpandedCompactionByteSizeLimit(options_)) {
       InternalKey new_start, new_limit;
@@ -1425,8 +1629,6 @@ void VersionSet::SetupOtherInputs(Compaction* c) {
             level, int(c->inputs_[0].size()), int(c->inputs_[1].size()),
             long(inputs0_size), long(inputs1_size), int(expanded0.size()),
             int(expanded1.size()), long(expanded0_size), long(inputs1_size));
-        smallest = new_start;
-        largest = new_limit;
         c->inputs_[0] = expanded0;
         c->inputs_[1] = expanded1;
         GetRange2(c->inputs_[0], c->inputs_[1], &all_start, &all_limit);
@@ -1440,13 +1642,18 @@ void VersionSet::SetupOtherInputs(Compaction* c) {
     current_->GetOverlappingInputs(level + 2, &all_start, &all_limit,
                                    &c->grandparents_);
   }
+}
+
+void VersionSet::AdvanceCompactPointer(Compaction* c) {
+  InternalKey smallest, largest;
+  GetRange(c->inputs_[0], &smallest, &largest);
 
   // Update the place where we will do the next compaction for this level.
   // We update this immediately instead of waiting for the VersionEdit
   // to be applied so that if the compaction fails, we will try a different
   // key range next time.
-  compact_pointer_[level] = largest.Encode().ToString();
-  c->edit_.SetCompactPointer(level, largest);
+  compact_pointer_[c->level()] = largest.Encode().ToString();
+  c->edit_.SetCompactPointer(c->level(), largest);
 }
 
 Compaction* VersionSet::CompactRange(int level, const InternalKey* begin,
@@ -1479,6 +1686,9 @@ Compaction* VersionSet::CompactRange(int level, const InternalKey* begin,
   c->input_version_->Ref();
   c->inputs_[0] = inputs;
   SetupOtherInputs(c);
+  assert(!c->InputsBeingCompacted());
+  c->MarkInputs(true);
+  AdvanceCompactPointer(c);
   return c;
 }
 
@@ -1486,17 +1696,14 @@ Compaction::Compaction(const Options* options, int level)
     : level_(level),
       max_output_file_size_(MaxFileSizeForLevel(options, level)),
       input_version_(nullptr),
-      grandparent_index_(0),
-      seen_key_(false),
-      overlapped_bytes_(0) {
-  for (int i = 0; i < config::kNumLevels; i++) {
-    level_ptrs_[i] = 0;
-  }
-}
+      inputs_marked_(false) {}
 
-Compaction::~Compaction() {
-  if (input_version_ != nullptr) {
-    input_version_->Unref();
+Compaction::~Compaction() { ReleaseInputs(); }
+
+Compaction::OutputCursor::OutputCursor()
+    : grandparent_index(0), seen_key(false), overlapped_bytes(0) {
+  for (int i = 0; i < config::kNumLevels; i++) {
+    level_ptrs[i] = 0;
   }
 }
 
@@ -1518,13 +1725,14 @@ void Compaction::AddInputDeletions(VersionEdit* edit) {
   }
 }
 
-bool Compaction::IsBaseLevelForKey(const Slice& user_key) {
+bool Compaction::IsBaseLevelForKey(const Slice& user_key,
+                                   OutputCursor* cursor) const {
   // Maybe use binary search to find right entry instead of linear search?
   const Comparator* user_cmp = input_version_->vset_->icmp_.user_comparator();
   for (int lvl = level_ + 2; lvl < config::kNumLevels; lvl++) {
     const std::vector<FileMetaData*>& files = input_version_->files_[lvl];
-    while (level_ptrs_[lvl] < files.size()) {
-      FileMetaData* f = files[level_ptrs_[lvl]];
+    while (cursor->level_ptrs[lvl] < files.size()) {
+      FileMetaData* f = files[cursor->level_ptrs[lvl]];
       if (user_cmp->Compare(user_key, f->largest.user_key()) <= 0) {
         // We've advanced far enough
         if (user_cmp->Compare(user_key, f->smallest.user_key()) >= 0) {
@@ -1533,37 +1741,68 @@ bool Compaction::IsBaseLevelForKey(const Slice& user_key) {
         }
         break;
       }
-      level_ptrs_[lvl]++;
+      cursor->level_ptrs[lvl]++;
     }
   }
   return true;
 }
 
-bool Compaction::ShouldStopBefore(const Slice& internal_key) {
+bool Compaction::ShouldStopBefore(const Slice& internal_key,
+                                  OutputCursor* cursor) const {
   const VersionSet* vset = input_version_->vset_;
   // Scan to find earliest grandparent file that contains key.
   const InternalKeyComparator* icmp = &vset->icmp_;
-  while (grandparent_index_ < grandparents_.size() &&
-         icmp->Compare(internal_key,
-                       grandparents_[grandparent_index_]->largest.Encode()) >
-             0) {
-    if (seen_key_) {
-      overlapped_bytes_ += grandparents_[grandparent_index_]->file_size;
+  while (cursor->grandparent_index < grandparents_.size() &&
+         icmp->Compare(
+             internal_key,
+             grandparents_[cursor->grandparent_index]->largest.Encode()) > 0) {
+    if (cursor->seen_key) {
+      cursor->overlapped_bytes +=
+          grandparents_[cursor->grandparent_index]->file_size;
     }
-    grandparent_index_++;
+    cursor->grandparent_index++;
   }
-  seen_key_ = true;
+  cursor->seen_key = true;
 
-  if (overlapped_bytes_ > MaxGrandParentOverlapBytes(vset->options_)) {
+  if (cursor->overlapped_bytes > MaxGrandParentOverlapBytes(vset->options_)) {
     // Too much overlap for current output; start new output
-    overlapped_bytes_ = 0;
+    cursor->overlapped_bytes = 0;
     return true;
   } else {
     return false;
   }
 }
 
+uint64_t Compaction::TotalInputBytes() const {
+  return TotalFileSize(inputs_[0]) + TotalFileSize(inputs_[1]);
+}
+
+bool Compaction::InputsBeingCompacted() const {
+  for (int which = 0; which < 2; which++) {
+    for (const FileMetaData* f : inputs_[which]) {
+      if (f->being_compacted) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void Compaction::MarkInputs(bool being_compacted) {
+  for (int which = 0; which < 2; which++) {
+    for (FileMetaData* f : inputs_[which]) {
+      assert(f->being_compacted != being_compacted);
+      f->being_compacted = being_compacted;
+    }
+  }
+  inputs_marked_ = being_compacted;
+}
+
 void Compaction::ReleaseInputs() {
+  // The input files may be freed along with the input version
+  if (inputs_marked_) {
+    MarkInputs(false);
+  }
   if (input_version_ != nullptr) {
     input_version_->Unref();
     input_version_ = nullptr;
@@ -38,6 +38,7 @@ class Writer;
 class Compaction;
 class Iterator;
 class MemTable;
+class RateLimiter;
 class TableBuilder;
 class TableCache;
 class Version;
@@ -80,6 +81,13 @@ class Version {
   Status Get(const ReadOptions&, const LookupKey& key, std::string* val,
              GetStats* stats);
 
+  // Looks up "n" keys sorted by user key as Get() does for each of them,
+  // searching every file once for all the keys which may be in it.
+  // vals[i], statuses[i] and stats[i] receive the results for keys[i].
+  // REQUIRES: lock is not held
+  void MultiGet(const ReadOptions&, int n, const LookupKey* const* keys,
+                std::string* const* vals, Status* statuses, GetStats* stats);
+
   // Adds "stats" into the current state.  Returns true if a new
   // compaction may need to be triggered, false otherwise.
   // REQUIRES: lock is held
@@ -133,7 +141,11 @@ class Version {
         file_to_compact_(nullptr),
         file_to_compact_level_(-1),
         compaction_score_(-1),
-        compaction_level_(-1) {}
+        compaction_level_(-1) {
+    for (int level = 0; level < config::kNumLevels - 1; level++) {
+      level_scores_[level] = -1;
+    }
+  }
 
   Version(const Version&) = delete;
   Version& operator=(const Version&) = delete;
@@ -167,6 +179,9 @@ class Version {
   // are initialized by Finalize().
   double compaction_score_;
   int compaction_level_;
+
+  // Compaction score of every level but the last, also set by Finalize().
+  double level_scores_[config::kNumLevels - 1];
 };
 
 class VersionSet {
@@ -233,15 +248,18 @@ class VersionSet {
   uint64_t PrevLogNumber() const { return prev_log_number_; }
 
   // Pick level and inputs for a new compaction.
-  // Returns nullptr if there is no compaction to be done.
-  // Otherwise returns a pointer to a heap-allocated object that
-  // describes the compaction.  Caller should delete the result.
+  // Returns nullptr if there is no compaction to be done, or if every
+  // compaction that is needed would share an input file with a running
+  // one.  Otherwise returns a pointer to a heap-allocated object that
+  // describes the compaction and whose inputs are marked as being
+  // compacted.  Caller should delete the result.
   Compaction* PickCompaction();
 
   // Return a compaction object for compacting the range [begin,end] in
   // the specified level.  Returns nullptr if there is nothing in that
   // level that overlaps the specified range.  Caller should delete
   // the result.
+  // REQUIRES: no other compaction is running
   Compaction* CompactRange(int level, const InternalKey* begin,
                            const InternalKey* end);
 
@@ -250,8 +268,10 @@ class VersionSet {
   int64_t MaxNextLevelOverlappingBytes();
 
   // Create an iterator that reads over the compaction inputs for "*c".
+  // Its reads of table files are requested from "rate_limiter" first
+  // unless it is null.
   // The caller should delete the iterator when no longer needed.
-  Iterator* MakeInputIterator(Compaction* c);
+  Iterator* MakeInputIterator(Compaction* c, RateLimiter* rate_limiter);
 
   // Returns true iff some level needs a compaction.
   bool NeedsCompaction() const {
@@ -293,6 +313,13 @@ class VersionSet {
 
   void SetupOtherInputs(Compaction* c);
 
+  // Returns a compaction of "level" that starts from file "f" and marks
+  // its inputs, or nullptr if one of them is being compacted already.
+  Compaction* SetupCompaction(int level, FileMetaData* f);
+
+  // Update the place where the next compaction of c->level() starts.
+  void AdvanceCompactPointer(Compaction* c);
+
   // Save current contents to *log
   Status WriteSnapshot(log::Writer* log);
 
@@ -349,17 +376,42 @@ class Compaction {
   // Add all inputs to this compaction as delete operations to *edit.
   void AddInputDeletions(VersionEdit* edit);
 
+  // Position of the output of a compaction among the files of the levels
+  // below it.  Output keys are produced in order, so the position only
+  // moves forward; every subcompaction keeps its own.
+  struct OutputCursor {
+    OutputCursor();
+
+    // State used to check for number of overlapping grandparent files
+    // (parent == level_ + 1, grandparent == level_ + 2)
+    size_t grandparent_index;  // Index in grandparents_
+    bool seen_key;             // Some output key has been seen
+    int64_t overlapped_bytes;  // Bytes of overlap between current output
+                               // and grandparent files
+
+    // State for implementing IsBaseLevelForKey
+
+    // level_ptrs holds indices into input_version_->levels_: our state
+    // is that we are positioned at one of the file ranges for each
+    // higher level than the ones involved in this compaction (i.e. for
+    // all L >= level_ + 2).
+    size_t level_ptrs[config::kNumLevels];
+  };
+
   // Returns true if the information we have available guarantees that
   // the compaction is producing data in "level+1" for which no data exists
   // in levels greater than "level+1".
-  bool IsBaseLevelForKey(const Slice& user_key);
+  bool IsBaseLevelForKey(const Slice& user_key, OutputCursor* cursor) const;
 
   // Returns true iff we should stop building the current output
   // before processing "internal_key".
-  bool ShouldStopBefore(const Slice& internal_key);
+  bool ShouldStopBefore(const Slice& internal_key, OutputCursor* cursor) const;
+
+  // Returns the total size of the input files.
+  uint64_t TotalInputBytes() const;
 
   // Release the input version for the compaction, once the compaction
-  // is successful.
+  // is successful.  Also clears the marks on its input files.
   void ReleaseInputs();
 
  private:
@@ -368,29 +420,23 @@ class Compaction {
 
   Compaction(const Options* options, int level);
 
+  // Returns true if an input file is an input of a running compaction.
+  bool InputsBeingCompacted() const;
+
+  // Sets or clears the being_compacted flag of every input file.
+  void MarkInputs(bool being_compacted);
+
   int level_;
   uint64_t max_output_file_size_;
   Version* input_version_;
   VersionEdit edit_;
+  bool inputs_marked_;
 
   // Each compaction reads inputs from "level_" and "level_+1"
   std::vector<FileMetaData*> inputs_[2];  // The two sets of inputs
 
-  // State used to check for number of overlapping grandparent files
-  // (parent == level_ + 1, grandparent == level_ + 2)
+  // Files of level_ + 2 that overlap the compaction
   std::vector<FileMetaData*> grandparents_;
-  size_t grandparent_index_;  // Index in grandparent_starts_
-  bool seen_key_;             // Some output key has been seen
-  int64_t overlapped_bytes_;  // Bytes of overlap between current output
-                              // and grandparent files
-
-  // State for implementing IsBaseLevelForKey
-
-  // level_ptrs_ holds indices into input_version_->levels_: our state
-  // is that we are positioned at one of the file ranges for each
-  // higher level than the ones involved in this compaction (i.e. for
-  // all L >= level_ + 2).
-  size_t level_ptrs_[config::kNumLevels];
 };
 
 }  // namespace leveldb
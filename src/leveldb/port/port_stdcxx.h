@@ -47,6 +47,12 @@
 
 #include "port/thread_annotations.h"
 
+// The in-tree LZ block compressor; always available
+#include "LzCompress.h"
+// The in-tree CRC-32C, which uses the SSE4.2 crc32 instruction when the CPU
+// has it
+#include "Crc32c.h"
+
 namespace leveldb {
 namespace port {
 
@@ -135,6 +141,28 @@ inline bool Snappy_Uncompress(const char* input, size_t length, char* output) {
 #endif  // HAVE_SNAPPY
 }
 
+inline bool Lz_Compress(const char* input, size_t length,
+                        std::string* output) {
+  output->clear();
+  LZ_COMPRESS::compress(input, length, *output);
+  return true;
+}
+
+inline bool Lz_GetUncompressedLength(const char* input, size_t length,
+                                     size_t* result) {
+  // Reject lengths no valid block can expand to before anything is allocated.
+  return LZ_COMPRESS::getUncompressedLength(input, length, *result) &&
+         *result <= length * 255 + 16;
+}
+
+inline bool Lz_Uncompress(const char* input, size_t length, char* output) {
+  size_t outlen;
+  if (!Lz_GetUncompressedLength(input, length, &outlen)) {
+    return false;
+  }
+  return LZ_COMPRESS::decompress(input, length, output, outlen);
+}
+
 inline bool Zstd_Compress(int level, const char* input, size_t length,
                           std::string* output) {
 #if HAVE_ZSTD
@@ -214,11 +242,8 @@ inline uint32_t AcceleratedCRC32C(uint32_t crc, const char* buf, size_t size) {
 #if HAVE_CRC32C
   return ::crc32c::Extend(crc, reinterpret_cast<const uint8_t*>(buf), size);
 #else
-  // Silence compiler warnings about unused arguments.
-  (void)crc;
-  (void)buf;
-  (void)size;
-  return 0;
+  // Zero when the CPU has no crc32 instruction
+  return ::CRC32C::extendAccelerated(crc, buf, size);
 #endif  // HAVE_CRC32C
 }
 
@@ -7,12 +7,14 @@
 #include "table/block.h"
 
 #include <algorithm>
+#include <cstring>
 #include <cstdint>
 #include <vector>
 
 #include "leveldb/comparator.h"
 #include "table/format.h"
 #include "util/coding.h"
+#include "util/hash.h"
 #include "util/logging.h"
 
 #ifdef _MSC_VER
@@ -21,25 +23,43 @@
 
 namespace leveldb {
 
-inline uint32_t Block::NumRestarts() const {
-  assert(size_ >= sizeof(uint32_t));
-  return DecodeFixed32(data_ + size_ - sizeof(uint32_t));
-}
-
 Block::Block(const BlockContents& contents)
     : data_(contents.data.data()),
       size_(contents.data.size()),
+      restart_offset_(0),
+      num_restarts_(0),
+      hash_buckets_(nullptr),
+      num_hash_buckets_(0),
       owned_(contents.heap_allocated) {
   if (size_ < sizeof(uint32_t)) {
     size_ = 0;  // Error marker
-  } else {
-    size_t max_restarts_allowed = (size_ - sizeof(uint32_t)) / sizeof(uint32_t);
-    if (NumRestarts() > max_restarts_allowed) {
-      // The size is too small for NumRestarts()
+    return;
+  }
+  size_t restarts_end = size_ - sizeof(uint32_t);
+  num_restarts_ = DecodeFixed32(data_ + restarts_end);
+  if ((num_restarts_ & kBlockHashIndexFlag) != 0) {
+    // The hash index sits between the restart array and its length
+    num_restarts_ &= ~kBlockHashIndexFlag;
+    if (restarts_end < sizeof(uint16_t)) {
       size_ = 0;
-    } else {
-      restart_offset_ = size_ - (1 + NumRestarts()) * sizeof(uint32_t);
+      return;
+    }
+    restarts_end -= sizeof(uint16_t);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data_ + restarts_end);
+    num_hash_buckets_ = p[0] | (static_cast<uint32_t>(p[1]) << 8);
+    if (num_hash_buckets_ == 0 || restarts_end < num_hash_buckets_) {
+      size_ = 0;
+      return;
     }
+    restarts_end -= num_hash_buckets_;
+    hash_buckets_ = reinterpret_cast<const uint8_t*>(data_ + restarts_end);
+  }
+  size_t max_restarts_allowed = restarts_end / sizeof(uint32_t);
+  if (num_restarts_ > max_restarts_allowed) {
+    // The size is too small for num_restarts_
+    size_ = 0;
+  } else {
+    restart_offset_ = restarts_end - num_restarts_ * sizeof(uint32_t);
   }
 }
 
@@ -84,6 +104,8 @@ class Block::Iter : public Iterator {
   const char* const data_;       // underlying block contents
   uint32_t const restarts_;      // Offset of restart array (list of fixed32)
   uint32_t const num_restarts_;  // Number of uint32_t entries in restart array
+  const uint8_t* const hash_buckets_;  // Hash index, or nullptr if none
+  uint32_t const num_hash_buckets_;
 
   // current_ is offset in data_ of current entry.  >= restarts_ if !Valid
   uint32_t current_;
@@ -118,11 +140,14 @@ class Block::Iter : public Iterator {
 
  public:
   Iter(const Comparator* comparator, const char* data, uint32_t restarts,
-       uint32_t num_restarts)
+       uint32_t num_restarts, const uint8_t* hash_buckets,
+       uint32_t num_hash_buckets)
       : comparator_(comparator),
         data_(data),
         restarts_(restarts),
         num_restarts_(num_restarts),
+        hash_buckets_(hash_buckets),
+        num_hash_buckets_(num_hash_buckets),
         current_(restarts_),
         restart_index_(num_restarts_) {
     assert(num_restarts_ > 0);
@@ -166,6 +191,10 @@ class Block::Iter : public Iterator {
   }
 
   void Seek(const Slice& target) override {
+    if (hash_buckets_ != nullptr && SeekWithHashIndex(target)) {
+      return;
+    }
+
     // Binary search in restart array to find the last restart point
     // with a key < target
     uint32_t left = 0;
@@ -243,6 +272,88 @@ class Block::Iter : public Iterator {
   }
 
  private:
+  // Seeks to the first entry at or after "target" among the entries of its
+  // user key, starting at the restart interval the hash index gives for it.
+  // The skipped entries are matched against the user key as they are
+  // decoded, without building their keys.  Returns false, leaving the
+  // caller to binary search, if the block may not hold the user key or
+  // holds no version of it at or after "target".
+  bool SeekWithHashIndex(const Slice& target) {
+    if (target.size() < 8) {
+      return false;
+    }
+    const char* user_key = target.data();
+    const size_t user_key_size = target.size() - 8;
+    const uint32_t bucket =
+        hash_buckets_[Hash(user_key, user_key_size, kBlockHashSeed) %
+                      num_hash_buckets_];
+    if (bucket >= kBlockHashCollision || bucket >= num_restarts_) {
+      return false;
+    }
+
+    // key_ is reused below, so the current entry is given up
+    current_ = restarts_;
+    restart_index_ = num_restarts_;
+
+    const char* const limit = data_ + restarts_;
+    const uint32_t interval_end =
+        bucket + 1 < num_restarts_ ? GetRestartPoint(bucket + 1) : restarts_;
+    uint32_t offset = GetRestartPoint(bucket);
+    size_t match = 0;  // Leading bytes of the last key equal to the user key
+    bool last_matched = false;  // The last key has the user key
+    char trailer[8];            // Trailer of the last key, if it matched
+    while (offset < interval_end || last_matched) {
+      const char* p = data_ + offset;
+      uint32_t shared, non_shared, value_length;
+      const char* delta = p < limit ? DecodeEntry(p, limit, &shared,
+                                                  &non_shared, &value_length)
+                                    : nullptr;
+      if (delta == nullptr) {
+        return false;
+      }
+      // A key shares "shared" bytes with the last key and differs from it
+      // in the next one
+      if (shared < match) {
+        match = shared;
+      } else if (shared == match) {
+        while (match < user_key_size && match - shared < non_shared &&
+               delta[match - shared] == user_key[match]) {
+          match++;
+        }
+      }
+      const bool matched =
+          match == user_key_size && shared + non_shared == user_key_size + 8;
+      if (matched) {
+        if (shared <= user_key_size) {
+          memcpy(trailer, delta + (user_key_size - shared), 8);
+        } else if (last_matched) {
+          memcpy(trailer + (shared - user_key_size), delta, non_shared);
+        } else {
+          return false;
+        }
+        key_.assign(user_key, user_key_size);
+        key_.append(trailer, 8);
+        if (Compare(key_, target) >= 0) {
+          current_ = offset;
+          value_ = Slice(delta + non_shared, value_length);
+          restart_index_ = bucket;
+          while (restart_index_ + 1 < num_restarts_ &&
+                 GetRestartPoint(restart_index_ + 1) < current_) {
+            ++restart_index_;
+          }
+          return true;
+        }
+      } else if (last_matched) {
+        // Every version of the user key is before the target
+        return false;
+      }
+      last_matched = matched;
+      offset = static_cast<uint32_t>((delta + non_shared + value_length) -
+                                     data_);
+    }
+    return false;
+  }
+
   void CorruptionError() {
     current_ = restarts_;
     restart_index_ = num_restarts_;
@@ -285,11 +396,11 @@ Iterator* Block::NewIterator(const Comparator* comparator) {
   if (size_ < sizeof(uint32_t)) {
     return NewErrorIterator(Status::Corruption("bad block contents"));
   }
-  const uint32_t num_restarts = NumRestarts();
-  if (num_restarts == 0) {
+  if (num_restarts_ == 0) {
     return NewEmptyIterator();
   } else {
-    return new Iter(comparator, data_, restart_offset_, num_restarts);
+    return new Iter(comparator, data_, restart_offset_, num_restarts_,
+                    hash_buckets_, num_hash_buckets_);
   }
 }
 
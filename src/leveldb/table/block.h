@@ -31,12 +31,13 @@ class Block {
  private:
   class Iter;
 
-  uint32_t NumRestarts() const;
-
   const char* data_;
   size_t size_;
   uint32_t restart_offset_;  // Offset in data_ of restart array
-  bool owned_;               // Block owns data_[]
+  uint32_t num_restarts_;
+  const uint8_t* hash_buckets_;  // Hash index, or nullptr if none
+  uint32_t num_hash_buckets_;
+  bool owned_;                   // Block owns data_[]
 };
 
 }  // namespace leveldb
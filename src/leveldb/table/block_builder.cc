@@ -25,6 +25,16 @@
 //     restarts: uint32[num_restarts]
 //     num_restarts: uint32
 // restarts[i] contains the offset within the block of the ith restart point.
+//
+// A block with a hash index has the trailer:
+//     restarts: uint32[num_restarts]
+//     buckets: uint8[num_buckets]
+//     num_buckets: uint16
+//     num_restarts | kBlockHashIndexFlag: uint32
+// The user key of each internal key is hashed to a bucket which holds the
+// first restart interval holding that user key, kBlockHashNoEntry if no
+// user key hashes to it, or kBlockHashCollision if user keys of different
+// restart intervals, or of an interval past the 254th, do.
 
 #include "table/block_builder.h"
 
@@ -33,7 +43,9 @@
 
 #include "leveldb/comparator.h"
 #include "leveldb/options.h"
+#include "table/format.h"
 #include "util/coding.h"
+#include "util/hash.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable:4100 4996 4267)
@@ -41,8 +53,17 @@
 
 namespace leveldb {
 
-BlockBuilder::BlockBuilder(const Options* options)
-    : options_(options), restarts_(), counter_(0), finished_(false) {
+// Buckets per distinct user key
+static const double kHashBucketsPerKey = 2.0;
+static const size_t kMaxHashBuckets = 65535;
+
+BlockBuilder::BlockBuilder(const Options* options, bool hash_index)
+    : options_(options),
+      restarts_(),
+      counter_(0),
+      finished_(false),
+      hash_index_(hash_index),
+      hashable_(true) {
   assert(options->block_restart_interval >= 1);
   restarts_.push_back(0);  // First restart point is at offset 0
 }
@@ -54,12 +75,24 @@ void BlockBuilder::Reset() {
   counter_ = 0;
   finished_ = false;
   last_key_.clear();
+  hashable_ = true;
+  hashes_.clear();
+  hash_restarts_.clear();
+}
+
+static size_t NumHashBuckets(size_t num_keys) {
+  return std::min(kMaxHashBuckets,
+                  static_cast<size_t>(num_keys * kHashBucketsPerKey) + 1);
 }
 
 size_t BlockBuilder::CurrentSizeEstimate() const {
-  return (buffer_.size() +                       // Raw data buffer
-          restarts_.size() * sizeof(uint32_t) +  // Restart array
-          sizeof(uint32_t));                     // Restart array length
+  size_t estimate = (buffer_.size() +                       // Raw data buffer
+                     restarts_.size() * sizeof(uint32_t) +  // Restart array
+                     sizeof(uint32_t));  // Restart array length
+  if (hash_index_ && !hashes_.empty()) {
+    estimate += NumHashBuckets(hashes_.size()) + sizeof(uint16_t);
+  }
+  return estimate;
 }
 
 Slice BlockBuilder::Finish() {
@@ -67,7 +100,29 @@ Slice BlockBuilder::Finish() {
   for (size_t i = 0; i < restarts_.size(); i++) {
     PutFixed32(&buffer_, restarts_[i]);
   }
-  PutFixed32(&buffer_, restarts_.size());
+  if (hash_index_ && hashable_ && !hashes_.empty()) {
+    // Append the hash index
+    const size_t num_buckets = NumHashBuckets(hashes_.size());
+    const size_t buckets_offset = buffer_.size();
+    buffer_.append(num_buckets, static_cast<char>(kBlockHashNoEntry));
+    uint8_t* buckets = reinterpret_cast<uint8_t*>(&buffer_[buckets_offset]);
+    for (size_t i = 0; i < hashes_.size(); i++) {
+      uint8_t* bucket = &buckets[hashes_[i] % num_buckets];
+      const uint32_t restart = hash_restarts_[i];
+      if (restart >= kBlockHashCollision) {
+        *bucket = kBlockHashCollision;
+      } else if (*bucket == kBlockHashNoEntry) {
+        *bucket = static_cast<uint8_t>(restart);
+      } else if (*bucket != restart) {
+        *bucket = kBlockHashCollision;
+      }
+    }
+    buffer_.push_back(static_cast<char>(num_buckets & 0xff));
+    buffer_.push_back(static_cast<char>(num_buckets >> 8));
+    PutFixed32(&buffer_, restarts_.size() | kBlockHashIndexFlag);
+  } else {
+    PutFixed32(&buffer_, restarts_.size());
+  }
   finished_ = true;
   return Slice(buffer_);
 }
@@ -92,6 +147,23 @@ void BlockBuilder::Add(const Slice& key, const Slice& value) {
   }
   const size_t non_shared = key.size() - shared;
 
+  if (hash_index_ && hashable_) {
+    if (key.size() < 8) {
+      hashable_ = false;
+    } else {
+      // Only the newest version of each user key is indexed; the older
+      // versions follow it
+      const Slice user_key(key.data(), key.size() - 8);
+      if (hashes_.empty() || last_key_piece.size() < 8 ||
+          Slice(last_key_piece.data(), last_key_piece.size() - 8) !=
+              user_key) {
+        hashes_.push_back(
+            Hash(user_key.data(), user_key.size(), kBlockHashSeed));
+        hash_restarts_.push_back(restarts_.size() - 1);
+      }
+    }
+  }
+
   // Add "<shared><non_shared><value_size>" to buffer_
   PutVarint32(&buffer_, shared);
   PutVarint32(&buffer_, non_shared);
@@ -16,7 +16,9 @@ struct Options;
 
 class BlockBuilder {
  public:
-  explicit BlockBuilder(const Options* options);
+  // With "hash_index" the block ends with a hash index from the user keys
+  // of its internal keys to their restart intervals.
+  explicit BlockBuilder(const Options* options, bool hash_index = false);
 
   BlockBuilder(const BlockBuilder&) = delete;
   BlockBuilder& operator=(const BlockBuilder&) = delete;
@@ -47,6 +49,11 @@ class BlockBuilder {
   int counter_;                     // Number of entries emitted since restart
   bool finished_;                   // Has Finish() been called?
   std::string last_key_;
+
+  const bool hash_index_;
+  bool hashable_;                   // All keys have an internal key trailer
+  std::vector<uint32_t> hashes_;    // Hash of each distinct user key
+  std::vector<uint32_t> hash_restarts_;  // Restart interval of hashes_[i]
 };
 
 }  // namespace leveldb
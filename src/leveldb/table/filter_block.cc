@@ -4,6 +4,8 @@
 
 #include "table/filter_block.h"
 
+#include <cstring>
+
 #include "leveldb/filter_policy.h"
 #include "util/coding.h"
 
@@ -19,8 +21,16 @@ namespace leveldb {
 static const size_t kFilterBaseLg = 11;
 static const size_t kFilterBase = 1 << kFilterBaseLg;
 
+// Prefixes are hashed as keys with an empty internal key trailer
+static const size_t kPrefixPadding = 8;
+
+static void PadPrefix(const Slice& prefix, std::string* dst) {
+  dst->assign(prefix.data(), prefix.size());
+  dst->append(kPrefixPadding, '\0');
+}
+
 FilterBlockBuilder::FilterBlockBuilder(const FilterPolicy* policy)
-    : policy_(policy) {}
+    : policy_(policy), prefix_in_filter_(false) {}
 
 void FilterBlockBuilder::StartBlock(uint64_t block_offset) {
   uint64_t filter_index = (block_offset / kFilterBase);
@@ -36,6 +46,23 @@ void FilterBlockBuilder::AddKey(const Slice& key) {
   keys_.append(k.data(), k.size());
 }
 
+void FilterBlockBuilder::AddPrefix(const Slice& prefix) {
+  const bool is_new = prefix_start_.empty() ||
+                      last_prefix_.size() != prefix.size() + kPrefixPadding ||
+                      memcmp(last_prefix_.data(), prefix.data(),
+                             prefix.size()) != 0;
+  if (is_new) {
+    PadPrefix(prefix, &last_prefix_);
+    prefix_start_.push_back(prefixes_.size());
+    prefixes_.append(last_prefix_);
+    prefix_in_filter_ = false;
+  }
+  if (!prefix_in_filter_) {
+    AddKey(last_prefix_);
+    prefix_in_filter_ = true;
+  }
+}
+
 Slice FilterBlockBuilder::Finish() {
   if (!start_.empty()) {
     GenerateFilter();
@@ -52,6 +79,20 @@ Slice FilterBlockBuilder::Finish() {
   return Slice(result_);
 }
 
+Slice FilterBlockBuilder::FinishPrefixes() {
+  const size_t num_prefixes = prefix_start_.size();
+  prefix_start_.push_back(prefixes_.size());  // Simplify length computation
+  tmp_keys_.resize(num_prefixes);
+  for (size_t i = 0; i < num_prefixes; i++) {
+    tmp_keys_[i] = Slice(prefixes_.data() + prefix_start_[i],
+                         prefix_start_[i + 1] - prefix_start_[i]);
+  }
+  policy_->CreateFilter(tmp_keys_.data(), static_cast<int>(num_prefixes),
+                        &prefix_result_);
+  tmp_keys_.clear();
+  return Slice(prefix_result_);
+}
+
 void FilterBlockBuilder::GenerateFilter() {
   const size_t num_keys = start_.size();
   if (num_keys == 0) {
@@ -76,6 +117,7 @@ void FilterBlockBuilder::GenerateFilter() {
   tmp_keys_.clear();
   keys_.clear();
   start_.clear();
+  prefix_in_filter_ = false;
 }
 
 FilterBlockReader::FilterBlockReader(const FilterPolicy* policy,
@@ -107,4 +149,18 @@ bool FilterBlockReader::KeyMayMatch(uint64_t block_offset, const Slice& key) {
   return true;  // Errors are treated as potential matches
 }
 
+bool FilterBlockReader::PrefixMayMatch(uint64_t block_offset,
+                                       const Slice& prefix) {
+  std::string key;
+  PadPrefix(prefix, &key);
+  return KeyMayMatch(block_offset, key);
+}
+
+bool PrefixFilterMayMatch(const FilterPolicy* policy, const Slice& prefix,
+                          const Slice& filter) {
+  std::string key;
+  PadPrefix(prefix, &key);
+  return policy->KeyMayMatch(key, filter);
+}
+
 }  // namespace leveldb
@@ -26,7 +26,12 @@ class FilterPolicy;
 // a special block in the Table.
 //
 // The sequence of calls to FilterBlockBuilder must match the regexp:
-//      (StartBlock AddKey*)* Finish
+//      (StartBlock (AddKey AddPrefix?)*)* Finish FinishPrefixes?
+//
+// A prefix is added to the filter of the block holding its key, and to a
+// table-wide prefix filter returned by FinishPrefixes.  Prefixes are hashed
+// with an 8-byte zero trailer, the size of an internal key's trailer, so
+// that InternalFilterPolicy hashes the bare prefix.
 class FilterBlockBuilder {
  public:
   explicit FilterBlockBuilder(const FilterPolicy*);
@@ -36,7 +41,12 @@ class FilterBlockBuilder {
 
   void StartBlock(uint64_t block_offset);
   void AddKey(const Slice& key);
+  // REQUIRES: keys with equal prefixes are added one after another
+  void AddPrefix(const Slice& prefix);
   Slice Finish();
+  // Returns the filter over every prefix added.
+  // REQUIRES: Finish() has been called
+  Slice FinishPrefixes();
 
  private:
   void GenerateFilter();
@@ -47,6 +57,12 @@ class FilterBlockBuilder {
   std::string result_;           // Filter data computed so far
   std::vector<Slice> tmp_keys_;  // policy_->CreateFilter() argument
   std::vector<uint32_t> filter_offsets_;
+
+  std::string prefixes_;              // Flattened padded prefixes
+  std::vector<size_t> prefix_start_;  // Starting index in prefixes_
+  std::string last_prefix_;           // Padded prefix added last
+  bool prefix_in_filter_;   // last_prefix_ is in the pending block filter
+  std::string prefix_result_;
 };
 
 class FilterBlockReader {
@@ -54,6 +70,9 @@ class FilterBlockReader {
   // REQUIRES: "contents" and *policy must stay live while *this is live.
   FilterBlockReader(const FilterPolicy* policy, const Slice& contents);
   bool KeyMayMatch(uint64_t block_offset, const Slice& key);
+  // False if no key of the block starts with "prefix", which must have been
+  // added with FilterBlockBuilder::AddPrefix.
+  bool PrefixMayMatch(uint64_t block_offset, const Slice& prefix);
 
  private:
   const FilterPolicy* policy_;
@@ -63,6 +82,11 @@ class FilterBlockReader {
   size_t base_lg_;      // Encoding parameter (see kFilterBaseLg in .cc file)
 };
 
+// False if no key of the table starts with "prefix", given the table-wide
+// filter returned by FilterBlockBuilder::FinishPrefixes().
+bool PrefixFilterMayMatch(const FilterPolicy* policy, const Slice& prefix,
+                          const Slice& filter);
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_TABLE_FILTER_BLOCK_H_
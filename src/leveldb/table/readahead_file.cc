@@ -0,0 +1,72 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "table/readahead_file.h"
+
+#include <cstring>
+
+namespace leveldb {
+
+ReadaheadFile::ReadaheadFile(RandomAccessFile* file, uint64_t file_size,
+                             size_t readahead_size)
+    : file_(file),
+      file_size_(file_size),
+      readahead_size_(readahead_size),
+      buffer_(nullptr),
+      buffer_size_(0),
+      buffer_offset_(0),
+      pass_through_(false) {}
+
+ReadaheadFile::~ReadaheadFile() { delete[] buffer_; }
+
+Status ReadaheadFile::Read(uint64_t offset, size_t n, Slice* result,
+                           char* scratch) const {
+  if (pass_through_) {
+    return file_->Read(offset, n, result, scratch);
+  }
+
+  if (offset < buffer_offset_ ||
+      offset + n > buffer_offset_ + buffered_.size()) {
+    if (offset >= file_size_) {
+      return file_->Read(offset, n, result, scratch);
+    }
+    // Refill the buffer; a read larger than the readahead is read whole,
+    // and none reaches past the end of the file.
+    size_t size = (n > readahead_size_) ? n : readahead_size_;
+    if (size > file_size_ - offset) {
+      size = static_cast<size_t>(file_size_ - offset);
+    }
+    if (size > buffer_size_) {
+      delete[] buffer_;
+      buffer_ = new char[size];
+      buffer_size_ = size;
+    }
+    buffered_ = Slice();
+    Status s = file_->Read(offset, size, &buffered_, buffer_);
+    if (!s.ok()) {
+      buffered_ = Slice();
+      return s;
+    }
+    buffer_offset_ = offset;
+    if (buffered_.data() != buffer_) {
+      // The file hands out its own memory, e.g. a memory mapping
+      pass_through_ = true;
+      buffered_ = Slice();
+      return file_->Read(offset, n, result, scratch);
+    }
+  }
+
+  // Copy into scratch, since callers may keep the result after the next
+  // read refills the buffer.
+  const size_t start = static_cast<size_t>(offset - buffer_offset_);
+  size_t available = buffered_.size() - start;
+  if (available > n) {
+    available = n;
+  }
+  std::memcpy(scratch, buffered_.data() + start, available);
+  *result = Slice(scratch, available);
+  return Status::OK();
+}
+
+}  // namespace leveldb
@@ -0,0 +1,54 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_TABLE_READAHEAD_FILE_H_
+#define STORAGE_LEVELDB_TABLE_READAHEAD_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "leveldb/env.h"
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+// Wraps a RandomAccessFile for a sequential scan: a read that misses the
+// buffer fetches "readahead_size" bytes from its offset onwards, and the
+// following reads are served from memory.  Files that are memory mapped
+// already return data without a copy, so once the wrapped file is seen to
+// return memory other than the caller's buffer, reads are passed through.
+//
+// Unlike other RandomAccessFiles it is not safe for concurrent use; each
+// iterator owns its own.
+class ReadaheadFile : public RandomAccessFile {
+ public:
+  // Does not take ownership of "file", which must outlive this object and
+  // holds "file_size" bytes.
+  ReadaheadFile(RandomAccessFile* file, uint64_t file_size,
+                size_t readahead_size);
+
+  ReadaheadFile(const ReadaheadFile&) = delete;
+  ReadaheadFile& operator=(const ReadaheadFile&) = delete;
+
+  ~ReadaheadFile() override;
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override;
+
+ private:
+  RandomAccessFile* const file_;
+  const uint64_t file_size_;
+  const size_t readahead_size_;
+
+  // The bytes of the file at [buffer_offset_, buffer_offset_+buffered_.size())
+  mutable char* buffer_;
+  mutable size_t buffer_size_;
+  mutable uint64_t buffer_offset_;
+  mutable Slice buffered_;
+  mutable bool pass_through_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_TABLE_READAHEAD_FILE_H_
@@ -9,11 +9,15 @@
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
 #include "leveldb/options.h"
+#include "leveldb/slice_transform.h"
+#include "leveldb/statistics.h"
 #include "table/block.h"
 #include "table/filter_block.h"
 #include "table/format.h"
+#include "table/readahead_file.h"
 #include "table/two_level_iterator.h"
 #include "util/coding.h"
+#include "util/rate_limited_file.h"
 
 #ifdef _MSC_VER
 #pragma warning(disable:4100 4996 4267)
@@ -25,15 +29,21 @@ struct Table::Rep {
   ~Rep() {
     delete filter;
     delete[] filter_data;
+    delete[] prefix_filter_data;
     delete index_block;
   }
 
   Options options;
   Status status;
   RandomAccessFile* file;
+  uint64_t file_size;
   uint64_t cache_id;
   FilterBlockReader* filter;
   const char* filter_data;
+  // Set if the filters hold the prefixes of options.prefix_extractor
+  bool has_prefix_filter;
+  Slice prefix_filter;  // Table-wide filter of the prefixes
+  const char* prefix_filter_data;
 
   BlockHandle metaindex_handle;  // Handle to metaindex_block: saved from footer
   Block* index_block;
@@ -71,11 +81,14 @@ Status Table::Open(const Options& options, RandomAccessFile* file,
     Rep* rep = new Table::Rep;
     rep->options = options;
     rep->file = file;
+    rep->file_size = size;
     rep->metaindex_handle = footer.metaindex_handle();
     rep->index_block = index_block;
     rep->cache_id = (options.block_cache ? options.block_cache->NewId() : 0);
     rep->filter_data = nullptr;
     rep->filter = nullptr;
+    rep->has_prefix_filter = false;
+    rep->prefix_filter_data = nullptr;
     *table = new Table(rep);
     (*table)->ReadMeta(footer);
   }
@@ -108,6 +121,14 @@ void Table::ReadMeta(const Footer& footer) {
   if (iter->Valid() && iter->key() == Slice(key)) {
     ReadFilter(iter->value());
   }
+  if (rep_->filter != nullptr && rep_->options.prefix_extractor != nullptr) {
+    key = "prefixfilter.";
+    key.append(rep_->options.prefix_extractor->Name());
+    iter->Seek(key);
+    if (iter->Valid() && iter->key() == Slice(key)) {
+      ReadPrefixFilter(iter->value());
+    }
+  }
   delete iter;
   delete meta;
 }
@@ -135,6 +156,40 @@ void Table::ReadFilter(const Slice& filter_handle_value) {
   rep_->filter = new FilterBlockReader(rep_->options.filter_policy, block.data);
 }
 
+void Table::ReadPrefixFilter(const Slice& filter_handle_value) {
+  Slice v = filter_handle_value;
+  BlockHandle filter_handle;
+  if (!filter_handle.DecodeFrom(&v).ok()) {
+    return;
+  }
+  ReadOptions opt;
+  if (rep_->options.paranoid_checks) {
+    opt.verify_checksums = true;
+  }
+  BlockContents block;
+  if (!ReadBlock(rep_->file, opt, filter_handle, &block).ok()) {
+    return;
+  }
+  if (block.heap_allocated) {
+    rep_->prefix_filter_data = block.data.data();  // Will need to delete later
+  }
+  rep_->prefix_filter = block.data;
+  rep_->has_prefix_filter = true;
+}
+
+bool Table::ScanPrefix(const ReadOptions& options, Slice* prefix) const {
+  if (options.iterate_prefix == nullptr || !rep_->has_prefix_filter) {
+    return false;
+  }
+  const SliceTransform* extractor = rep_->options.prefix_extractor;
+  if (!extractor->InDomain(*options.iterate_prefix)) {
+    return false;
+  }
+  // Every key starting with the scan prefix shares its extractor prefix
+  *prefix = extractor->Transform(*options.iterate_prefix);
+  return true;
+}
+
 Table::~Table() { delete rep_; }
 
 static void DeleteBlock(void* arg, void* ignored) {
@@ -152,12 +207,52 @@ static void ReleaseBlock(void* arg, void* h) {
   cache->Release(handle);
 }
 
+namespace {
+
+// The state of a table iterator which reads ahead or is rate limited
+struct IteratorFileState {
+  IteratorFileState(Table* t, RandomAccessFile* file, uint64_t file_size,
+                    const ReadOptions& options)
+      : table(t),
+        limited(file, options.rate_limiter),
+        readahead(&limited, file_size, options.readahead_size),
+        file(options.readahead_size != 0
+                 ? static_cast<RandomAccessFile*>(&readahead)
+                 : &limited) {}
+
+  Table* const table;
+  RateLimitedFile limited;
+  ReadaheadFile readahead;  // Only used with a readahead_size
+  RandomAccessFile* const file;
+};
+
+void DeleteIteratorFileState(void* arg, void* ignored) {
+  delete reinterpret_cast<IteratorFileState*>(arg);
+}
+
+}  // namespace
+
 // Convert an index iterator value (i.e., an encoded BlockHandle)
 // into an iterator over the contents of the corresponding block.
 Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
                              const Slice& index_value) {
   Table* table = reinterpret_cast<Table*>(arg);
+  return ReadBlockFrom(table, table->rep_->file, options, index_value);
+}
+
+// Like BlockReader(), reading through the iterator's own file
+Iterator* Table::IteratorFileBlockReader(void* arg,
+                                         const ReadOptions& options,
+                                         const Slice& index_value) {
+  IteratorFileState* state = reinterpret_cast<IteratorFileState*>(arg);
+  return ReadBlockFrom(state->table, state->file, options, index_value);
+}
+
+Iterator* Table::ReadBlockFrom(Table* table, RandomAccessFile* file,
+                               const ReadOptions& options,
+                               const Slice& index_value) {
   Cache* block_cache = table->rep_->options.block_cache;
+  Statistics* stats = table->rep_->options.statistics;
   Block* block = nullptr;
   Cache::Handle* cache_handle = nullptr;
 
@@ -167,6 +262,13 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
   // We intentionally allow extra stuff in index_value so that we
   // can add more features in the future.
 
+  Slice prefix;
+  if (s.ok() && table->ScanPrefix(options, &prefix) &&
+      !table->rep_->filter->PrefixMayMatch(handle.offset(), prefix)) {
+    // No key of the block is part of the scan
+    return NewEmptyIterator();
+  }
+
   if (s.ok()) {
     BlockContents contents;
     if (block_cache != nullptr) {
@@ -177,8 +279,15 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
       cache_handle = block_cache->Lookup(key);
       if (cache_handle != nullptr) {
         block = reinterpret_cast<Block*>(block_cache->Value(cache_handle));
+        if (stats != nullptr) {
+          stats->Record(Statistics::kBlockCacheHits);
+        }
       } else {
-        s = ReadBlock(table->rep_->file, options, handle, &contents);
+        s = ReadBlock(file, options, handle, &contents);
+        if (stats != nullptr) {
+          stats->Record(Statistics::kBlockCacheMisses);
+          stats->Record(Statistics::kBlockBytesRead, handle.size());
+        }
         if (s.ok()) {
           block = new Block(contents);
           if (contents.cachable && options.fill_cache) {
@@ -188,7 +297,10 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
         }
       }
     } else {
-      s = ReadBlock(table->rep_->file, options, handle, &contents);
+      s = ReadBlock(file, options, handle, &contents);
+      if (stats != nullptr) {
+        stats->Record(Statistics::kBlockBytesRead, handle.size());
+      }
       if (s.ok()) {
         block = new Block(contents);
       }
@@ -210,14 +322,87 @@ Iterator* Table::BlockReader(void* arg, const ReadOptions& options,
 }
 
 Iterator* Table::NewIterator(const ReadOptions& options) const {
-  return NewTwoLevelIterator(
-      rep_->index_block->NewIterator(rep_->options.comparator),
-      &Table::BlockReader, const_cast<Table*>(this), options);
+  const Comparator* cmp = rep_->options.comparator;
+  Slice prefix;
+  if (ScanPrefix(options, &prefix) &&
+      !PrefixFilterMayMatch(rep_->options.filter_policy, prefix,
+                            rep_->prefix_filter)) {
+    return NewEmptyIterator();
+  }
+  if (options.readahead_size == 0 && options.rate_limiter == nullptr) {
+    return NewTwoLevelIterator(rep_->index_block->NewIterator(cmp),
+                               &Table::BlockReader, const_cast<Table*>(this),
+                               options, cmp);
+  }
+  IteratorFileState* state = new IteratorFileState(
+      const_cast<Table*>(this), rep_->file, rep_->file_size, options);
+  Iterator* iter =
+      NewTwoLevelIterator(rep_->index_block->NewIterator(cmp),
+                          &Table::IteratorFileBlockReader, state, options, cmp);
+  iter->RegisterCleanup(&DeleteIteratorFileState, state, nullptr);
+  return iter;
+}
+
+void Table::InternalMultiGet(const ReadOptions& read_options, int n,
+                             const Slice* keys, void* const* args,
+                             Status* statuses,
+                             void (*handle_result)(void*, const Slice&,
+                                                   const Slice&)) {
+  // Blocks are found by key, not pruned by a scan prefix
+  ReadOptions options = read_options;
+  options.iterate_prefix = nullptr;
+  const Comparator* cmp = rep_->options.comparator;
+  Iterator* iiter = rep_->index_block->NewIterator(cmp);
+  Iterator* block_iter = nullptr;
+  uint64_t block_offset = 0;
+  bool positioned = false;
+  for (int i = 0; i < n; i++) {
+    const Slice& k = keys[i];
+    // The keys are sorted, so the index entry found for an earlier key
+    // still covers this one unless the key is past the entry's separator.
+    if (!positioned || cmp->Compare(k, iiter->key()) > 0) {
+      iiter->Seek(k);
+      positioned = true;
+      if (!iiter->Valid()) {
+        // Every remaining key is past the last block
+        for (; i < n; i++) {
+          statuses[i] = iiter->status();
+        }
+        break;
+      }
+    }
+    Slice handle_value = iiter->value();
+    BlockHandle handle;
+    if (!handle.DecodeFrom(&handle_value).ok()) {
+      statuses[i] = Status::Corruption("bad block handle");
+      continue;
+    }
+    FilterBlockReader* filter = rep_->filter;
+    if (filter != nullptr && !filter->KeyMayMatch(handle.offset(), k)) {
+      statuses[i] = Status::OK();
+      continue;
+    }
+    if (block_iter == nullptr || handle.offset() != block_offset) {
+      delete block_iter;
+      block_iter = BlockReader(this, options, iiter->value());
+      block_offset = handle.offset();
+    }
+    block_iter->Seek(k);
+    if (block_iter->Valid()) {
+      (*handle_result)(args[i], block_iter->key(), block_iter->value());
+    }
+    statuses[i] = block_iter->status();
+  }
+  delete block_iter;
+  delete iiter;
 }
 
-Status Table::InternalGet(const ReadOptions& options, const Slice& k, void* arg,
+Status Table::InternalGet(const ReadOptions& read_options, const Slice& k,
+                          void* arg,
                           void (*handle_result)(void*, const Slice&,
                                                 const Slice&)) {
+  ReadOptions options = read_options;
+  options.iterate_prefix = nullptr;
   Status s;
   Iterator* iiter = rep_->index_block->NewIterator(rep_->options.comparator);
   iiter->Seek(k);
@@ -10,6 +10,7 @@
 #include "leveldb/env.h"
 #include "leveldb/filter_policy.h"
 #include "leveldb/options.h"
+#include "leveldb/slice_transform.h"
 #include "table/block_builder.h"
 #include "table/filter_block.h"
 #include "table/format.h"
@@ -28,13 +29,15 @@ struct TableBuilder::Rep {
         index_block_options(opt),
         file(f),
         offset(0),
-        data_block(&options),
+        data_block(&options, opt.data_block_hash_index),
         index_block(&index_block_options),
         num_entries(0),
         closed(false),
         filter_block(opt.filter_policy == nullptr
                          ? nullptr
                          : new FilterBlockBuilder(opt.filter_policy)),
+        prefix_extractor(filter_block == nullptr ? nullptr
+                                                 : opt.prefix_extractor),
         pending_index_entry(false) {
     index_block_options.block_restart_interval = 1;
   }
@@ -50,6 +53,8 @@ struct TableBuilder::Rep {
   int64_t num_entries;
   bool closed;  // Either Finish() or Abandon() has been called.
   FilterBlockBuilder* filter_block;
+  // Non-null if prefixes are added to the filters; fixed for the whole table
+  const SliceTransform* prefix_extractor;
 
   // We do not emit the index entry for a block until we have seen the
   // first key for the next data block.  This allows us to use shorter
@@ -114,6 +119,9 @@ void TableBuilder::Add(const Slice& key, const Slice& value) {
 
   if (r->filter_block != nullptr) {
     r->filter_block->AddKey(key);
+    if (r->prefix_extractor != nullptr && r->prefix_extractor->InDomain(key)) {
+      r->filter_block->AddPrefix(r->prefix_extractor->Transform(key));
+    }
   }
 
   r->last_key.assign(key.data(), key.size());
@@ -187,6 +195,19 @@ void TableBuilder::WriteBlock(BlockBuilder* block, BlockHandle* handle) {
       }
       break;
     }
+
+    case kLzCompression: {
+      std::string* compressed = &r->compressed_output;
+      if (port::Lz_Compress(raw.data(), raw.size(), compressed) &&
+          compressed->size() < raw.size() - (raw.size() / 8u)) {
+        block_contents = *compressed;
+      } else {
+        // Compressed less than 12.5%, so just store uncompressed form
+        block_contents = raw;
+        type = kNoCompression;
+      }
+      break;
+    }
   }
   WriteRawBlock(block_contents, type, handle);
   r->compressed_output.clear();
@@ -221,6 +242,7 @@ Status TableBuilder::Finish() {
   r->closed = true;
 
   BlockHandle filter_block_handle, metaindex_block_handle, index_block_handle;
+  BlockHandle prefix_filter_handle;
 
   // Write filter block
   if (ok() && r->filter_block != nullptr) {
@@ -228,6 +250,12 @@ Status TableBuilder::Finish() {
                   &filter_block_handle);
   }
 
+  // Write the table-wide prefix filter block
+  if (ok() && r->prefix_extractor != nullptr) {
+    WriteRawBlock(r->filter_block->FinishPrefixes(), kNoCompression,
+                  &prefix_filter_handle);
+  }
+
   // Write metaindex block
   if (ok()) {
     BlockBuilder meta_index_block(&r->options);
@@ -239,6 +267,15 @@ Status TableBuilder::Finish() {
       filter_block_handle.EncodeTo(&handle_encoding);
       meta_index_block.Add(key, handle_encoding);
     }
+    if (r->prefix_extractor != nullptr) {
+      // Add mapping from "prefixfilter.Name" to the prefix filter, sorting
+      // after "filter."
+      std::string key = "prefixfilter.";
+      key.append(r->prefix_extractor->Name());
+      std::string handle_encoding;
+      prefix_filter_handle.EncodeTo(&handle_encoding);
+      meta_index_block.Add(key, handle_encoding);
+    }
 
     // TODO(postrelease): Add stats and other meta blocks
     WriteBlock(&meta_index_block, &metaindex_block_handle);
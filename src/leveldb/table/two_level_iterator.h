@@ -9,6 +9,7 @@
 
 namespace leveldb {
 
+class Comparator;
 struct ReadOptions;
 
 // Return a new two level iterator.  A two-level iterator contains an
@@ -20,11 +21,16 @@ struct ReadOptions;
 //
 // Uses a supplied function to convert an index_iter value into
 // an iterator over the contents of the corresponding block.
+//
+// The key of each index entry must be at or after the keys of its block
+// and before those of the next one.  If options.iterate_upper_bound is set
+// and "comparator" is non-null, moving forward stops instead of opening a
+// block that follows an index key at or after the bound.
 Iterator* NewTwoLevelIterator(
     Iterator* index_iter,
     Iterator* (*block_function)(void* arg, const ReadOptions& options,
                                 const Slice& index_value),
-    void* arg, const ReadOptions& options);
+    void* arg, const ReadOptions& options, const Comparator* comparator);
 
 }  // namespace leveldb
 
@@ -4,17 +4,27 @@
 
 #include "util/arena.h"
 
+#include <new>
+#include <thread>
+
+#include "util/mutexlock.h"
+
 namespace leveldb {
 
 static const int kBlockSize = 4096;
 
 Arena::Arena()
-    : alloc_ptr_(nullptr), alloc_bytes_remaining_(0), memory_usage_(0) {}
+    : alloc_ptr_(nullptr),
+      alloc_bytes_remaining_(0),
+      memory_usage_(0),
+      shards_(nullptr),
+      num_shards_(0) {}
 
 Arena::~Arena() {
   for (size_t i = 0; i < blocks_.size(); i++) {
     delete[] blocks_[i];
   }
+  delete[] shards_.load(std::memory_order_relaxed);
 }
 
 char* Arena::AllocateFallback(size_t bytes) {
@@ -63,4 +73,53 @@ char* Arena::AllocateNewBlock(size_t block_bytes) {
   return result;
 }
 
+Arena::Shard* Arena::CurrentShard() {
+  Shard* shards = shards_.load(std::memory_order_acquire);
+  if (shards == nullptr) {
+    MutexLock l(&mutex_);
+    shards = shards_.load(std::memory_order_relaxed);
+    if (shards == nullptr) {
+      // One shard per hardware thread, rounded up to a power of two
+      const size_t threads = std::thread::hardware_concurrency();
+      num_shards_ = 1;
+      while (num_shards_ < threads && num_shards_ < 64) {
+        num_shards_ *= 2;
+      }
+      shards = new Shard[num_shards_];
+      shards_.store(shards, std::memory_order_release);
+    }
+  }
+
+  // Threads take shards in turn as they first allocate from any arena
+  static std::atomic<size_t> next_thread(0);
+  static thread_local size_t thread_index =
+      next_thread.fetch_add(1, std::memory_order_relaxed);
+  return &shards[thread_index & (num_shards_ - 1)];
+}
+
+char* Arena::AllocateConcurrentlyFallback(Shard* shard, size_t bytes) {
+  MutexLock l(&mutex_);
+  if (bytes > kBlockSize / 4) {
+    // See AllocateFallback()
+    return AllocateNewBlock(bytes);
+  }
+
+  // Another thread of the shard may have replaced the block while we
+  // waited for the lock
+  Block* block = shard->current.load(std::memory_order_acquire);
+  if (block != nullptr) {
+    const size_t offset =
+        block->used.fetch_add(bytes, std::memory_order_relaxed);
+    if (offset + bytes <= block->size) {
+      return block->data() + offset;
+    }
+  }
+
+  // We waste the remaining space in the current block.
+  block = new (AllocateNewBlock(sizeof(Block) + kBlockSize)) Block(kBlockSize);
+  block->used.store(bytes, std::memory_order_relaxed);
+  shard->current.store(block, std::memory_order_release);
+  return block->data();
+}
+
 }  // namespace leveldb
@@ -11,6 +11,8 @@
 #include <cstdint>
 #include <vector>
 
+#include "port/port.h"
+
 namespace leveldb {
 
 class Arena {
@@ -28,6 +30,12 @@ class Arena {
   // Allocate memory with the normal alignment guarantees provided by malloc.
   char* AllocateAligned(size_t bytes);
 
+  // Like AllocateAligned(), but any number of threads may call it at once,
+  // as long as no thread calls Allocate() or AllocateAligned() meanwhile.
+  // Each thread bumps a pointer in the block of one of several shards, so
+  // threads rarely touch the same cache line; only a new block takes a lock.
+  char* AllocateConcurrently(size_t bytes);
+
   // Returns an estimate of the total memory usage of data allocated
   // by the arena.
   size_t MemoryUsage() const {
@@ -35,14 +43,37 @@ class Arena {
   }
 
  private:
+  static const size_t kAlign = (sizeof(void*) > 8) ? sizeof(void*) : 8;
+
+  // A block shared by the threads of a shard; its data follows the header
+  struct Block {
+    explicit Block(size_t n) : used(0), size(n) {}
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+
+    std::atomic<size_t> used;
+    const size_t size;
+  };
+
+  // Padded so that threads of different shards do not share a cache line
+  struct Shard {
+    Shard() : current(nullptr) {}
+
+    std::atomic<Block*> current;
+    char padding[64 - sizeof(std::atomic<Block*>)];
+  };
+
   char* AllocateFallback(size_t bytes);
   char* AllocateNewBlock(size_t block_bytes);
 
+  Shard* CurrentShard();
+  char* AllocateConcurrentlyFallback(Shard* shard, size_t bytes);
+
   // Allocation state
   char* alloc_ptr_;
   size_t alloc_bytes_remaining_;
 
-  // Array of new[] allocated memory blocks
+  // Array of new[] allocated memory blocks.  AllocateConcurrently() changes
+  // it only while holding mutex_.
   std::vector<char*> blocks_;
 
   // Total memory usage of the arena.
@@ -50,6 +81,11 @@ class Arena {
   // TODO(costan): This member is accessed via atomics, but the others are
   //               accessed without any locking. Is this OK?
   std::atomic<size_t> memory_usage_;
+
+  // The shards of AllocateConcurrently(), made by its first call
+  std::atomic<Shard*> shards_;
+  size_t num_shards_;
+  port::Mutex mutex_;
 };
 
 inline char* Arena::Allocate(size_t bytes) {
@@ -66,6 +102,24 @@ inline char* Arena::Allocate(size_t bytes) {
   return AllocateFallback(bytes);
 }
 
+inline char* Arena::AllocateConcurrently(size_t bytes) {
+  assert(bytes > 0);
+  static_assert((kAlign & (kAlign - 1)) == 0,
+                "Pointer size should be a power of 2");
+  // Rounding every size up keeps every offset in a block aligned
+  bytes = (bytes + kAlign - 1) & ~(kAlign - 1);
+  Shard* shard = CurrentShard();
+  Block* block = shard->current.load(std::memory_order_acquire);
+  if (block != nullptr) {
+    const size_t offset =
+        block->used.fetch_add(bytes, std::memory_order_relaxed);
+    if (offset + bytes <= block->size) {
+      return block->data() + offset;
+    }
+  }
+  return AllocateConcurrentlyFallback(shard, bytes);
+}
+
 }  // namespace leveldb
 
 #endif  // STORAGE_LEVELDB_UTIL_ARENA_H_
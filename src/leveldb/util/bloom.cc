@@ -4,6 +4,8 @@
 
 #include "leveldb/filter_policy.h"
 
+#include <algorithm>
+
 #include "leveldb/slice.h"
 #include "util/hash.h"
 
@@ -14,6 +16,43 @@ static uint32_t BloomHash(const Slice& key) {
   return Hash(key.data(), key.size(), 0xbc9f1d34);
 }
 
+// A blocked filter is a whole number of 64-byte blocks followed by the number
+// of probes and kBlockedMarker.  The marker sits where the standard filter
+// keeps its probe count and is above the largest count it allows, so readers
+// which predate the blocked format treat such a filter as a match.
+static const size_t kBlockedBytes = 64;
+static const size_t kBlockedBits = kBlockedBytes * 8;
+static const char kBlockedMarker = static_cast<char>(0xff);
+
+static bool IsBlockedFilter(const Slice& filter) {
+  return filter.size() >= kBlockedBytes + 2 &&
+         filter[filter.size() - 1] == kBlockedMarker;
+}
+
+// Every probe for a key falls in the block picked by the high bits of its
+// hash, so a lookup reads one block instead of up to k cache lines.  The
+// probe positions are the top 9 bits of successive products of the hash with
+// an odd constant.
+static bool BlockedKeyMayMatch(const Slice& key, const Slice& filter) {
+  const size_t len = filter.size();
+  const size_t blocks = (len - 2) / kBlockedBytes;
+  const size_t k = static_cast<unsigned char>(filter[len - 2]);
+  const uint32_t h = BloomHash(key);
+  const char* block =
+      filter.data() + ((static_cast<uint64_t>(h) * blocks) >> 32) *
+                          kBlockedBytes;
+  // The block is in cache after the first probe, so testing every bit costs
+  // less than the mispredicted branch of stopping at the first clear one
+  uint32_t probe = (h >> 15 | h << 17) * 0x9e3779b9u;
+  int match = 1;
+  for (size_t j = 0; j < k; j++) {
+    const uint32_t bitpos = probe >> 23;
+    match &= static_cast<unsigned char>(block[bitpos / 8]) >> (bitpos % 8);
+    probe *= 0x9e3779b9u;
+  }
+  return match != 0;
+}
+
 class BloomFilterPolicy : public FilterPolicy {
  public:
   explicit BloomFilterPolicy(int bits_per_key) : bits_per_key_(bits_per_key) {
@@ -54,6 +93,9 @@ class BloomFilterPolicy : public FilterPolicy {
   }
 
   bool KeyMayMatch(const Slice& key, const Slice& bloom_filter) const override {
+    if (IsBlockedFilter(bloom_filter)) {
+      return BlockedKeyMayMatch(key, bloom_filter);
+    }
     const size_t len = bloom_filter.size();
     if (len < 2) return false;
 
@@ -79,14 +121,56 @@ class BloomFilterPolicy : public FilterPolicy {
     return true;
   }
 
- private:
+ protected:
   size_t bits_per_key_;
   size_t k_;
 };
+
+// Writes blocked filters under the name of the standard filter, so that both
+// policies read the filters of either kind and a database can switch between
+// them without rewriting its tables.
+class BlockedBloomFilterPolicy : public BloomFilterPolicy {
+ public:
+  explicit BlockedBloomFilterPolicy(int bits_per_key)
+      : BloomFilterPolicy(bits_per_key) {
+    // Keys crowd into some blocks more than others, which costs a little
+    // accuracy; one more probe than the standard filter wins most of it back.
+    k_ = static_cast<size_t>(bits_per_key * 0.69) + 1;
+    if (k_ < 1) k_ = 1;
+    if (k_ > 30) k_ = 30;
+  }
+
+  void CreateFilter(const Slice* keys, int n, std::string* dst) const override {
+    const size_t bits = n * bits_per_key_;
+    const size_t blocks = std::max<size_t>(1, (bits + kBlockedBits - 1) /
+                                                  kBlockedBits);
+
+    const size_t init_size = dst->size();
+    dst->resize(init_size + blocks * kBlockedBytes, 0);
+    dst->push_back(static_cast<char>(k_));
+    dst->push_back(kBlockedMarker);
+    char* array = &(*dst)[init_size];
+    for (int i = 0; i < n; i++) {
+      const uint32_t h = BloomHash(keys[i]);
+      char* block =
+          array + ((static_cast<uint64_t>(h) * blocks) >> 32) * kBlockedBytes;
+      uint32_t probe = (h >> 15 | h << 17) * 0x9e3779b9u;
+      for (size_t j = 0; j < k_; j++) {
+        const uint32_t bitpos = probe >> 23;
+        block[bitpos / 8] |= (1 << (bitpos % 8));
+        probe *= 0x9e3779b9u;
+      }
+    }
+  }
+};
 }  // namespace
 
 const FilterPolicy* NewBloomFilterPolicy(int bits_per_key) {
   return new BloomFilterPolicy(bits_per_key);
 }
 
+const FilterPolicy* NewBlockedBloomFilterPolicy(int bits_per_key) {
+  return new BlockedBloomFilterPolicy(bits_per_key);
+}
+
 }  // namespace leveldb
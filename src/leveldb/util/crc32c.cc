@@ -2,7 +2,9 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file. See the AUTHORS file for names of contributors.
 //
-// A portable implementation of crc32c.
+// A portable implementation of crc32c.  Extend() prefers the accelerated
+// implementation from port::AcceleratedCRC32C(): the crc32c library when it
+// is linked, else the SSE4.2 path of the in-tree CRC32C.
 
 #include "util/crc32c.h"
 
@@ -0,0 +1,39 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "util/rate_limited_file.h"
+
+namespace leveldb {
+
+RateLimitedFile::RateLimitedFile(RandomAccessFile* file, RateLimiter* limiter)
+    : file_(file), limiter_(limiter) {}
+
+RateLimitedFile::~RateLimitedFile() = default;
+
+Status RateLimitedFile::Read(uint64_t offset, size_t n, Slice* result,
+                             char* scratch) const {
+  if (limiter_ != nullptr) {
+    limiter_->Request(n);
+  }
+  return file_->Read(offset, n, result, scratch);
+}
+
+RateLimitedWritableFile::RateLimitedWritableFile(WritableFile* file,
+                                                 RateLimiter* limiter)
+    : file_(file), limiter_(limiter) {}
+
+RateLimitedWritableFile::~RateLimitedWritableFile() { delete file_; }
+
+Status RateLimitedWritableFile::Append(const Slice& data) {
+  limiter_->Request(data.size());
+  return file_->Append(data);
+}
+
+Status RateLimitedWritableFile::Close() { return file_->Close(); }
+
+Status RateLimitedWritableFile::Flush() { return file_->Flush(); }
+
+Status RateLimitedWritableFile::Sync() { return file_->Sync(); }
+
+}  // namespace leveldb
@@ -0,0 +1,60 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#ifndef STORAGE_LEVELDB_UTIL_RATE_LIMITED_FILE_H_
+#define STORAGE_LEVELDB_UTIL_RATE_LIMITED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "leveldb/env.h"
+#include "leveldb/rate_limiter.h"
+#include "leveldb/slice.h"
+
+namespace leveldb {
+
+// Requests the bytes of every read from "limiter" before passing it on to
+// "file"; a null limiter passes reads straight through.  Does not take
+// ownership of "file", which must outlive this object.
+class RateLimitedFile : public RandomAccessFile {
+ public:
+  RateLimitedFile(RandomAccessFile* file, RateLimiter* limiter);
+
+  RateLimitedFile(const RateLimitedFile&) = delete;
+  RateLimitedFile& operator=(const RateLimitedFile&) = delete;
+
+  ~RateLimitedFile() override;
+
+  Status Read(uint64_t offset, size_t n, Slice* result,
+              char* scratch) const override;
+
+ private:
+  RandomAccessFile* const file_;
+  RateLimiter* const limiter_;
+};
+
+// Requests the bytes of every append from "limiter" before passing it on to
+// "file".  Takes ownership of "file".
+class RateLimitedWritableFile : public WritableFile {
+ public:
+  RateLimitedWritableFile(WritableFile* file, RateLimiter* limiter);
+
+  RateLimitedWritableFile(const RateLimitedWritableFile&) = delete;
+  RateLimitedWritableFile& operator=(const RateLimitedWritableFile&) = delete;
+
+  ~RateLimitedWritableFile() override;
+
+  Status Append(const Slice& data) override;
+  Status Close() override;
+  Status Flush() override;
+  Status Sync() override;
+
+ private:
+  WritableFile* const file_;
+  RateLimiter* const limiter_;
+};
+
+}  // namespace leveldb
+
+#endif  // STORAGE_LEVELDB_UTIL_RATE_LIMITED_FILE_H_
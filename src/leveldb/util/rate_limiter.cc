@@ -0,0 +1,109 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/rate_limiter.h"
+
+#include <atomic>
+#include <cassert>
+
+#include "leveldb/env.h"
+#include "port/port.h"
+#include "port/thread_annotations.h"
+#include "util/mutexlock.h"
+
+namespace leveldb {
+
+RateLimiter::~RateLimiter() = default;
+
+namespace {
+
+// Refills its bucket from the clock whenever a request comes.  A request
+// always takes its bytes, leaving the bucket in debt if it held too few, and
+// waits until the debt would have been paid off; later requests queue behind
+// that debt, so the waits follow the order of the requests.
+class TokenBucketRateLimiter : public RateLimiter {
+ public:
+  // Seconds' worth of bytes the bucket holds after an idle spell.
+  static constexpr double kBurstSeconds = 0.1;
+
+  // Shortest wait.  The bytes that come in meanwhile let the requests after
+  // it through, so a throttled thread wakes up about a hundred times a second
+  // instead of once per block, and preempts the foreground threads as often.
+  static const uint64_t kMinWaitMicros = 10000;
+
+  TokenBucketRateLimiter(int64_t bytes_per_second, Env* env)
+      : env_(env),
+        bytes_per_second_(bytes_per_second),
+        tokens_(bytes_per_second * kBurstSeconds),
+        last_refill_micros_(env->NowMicros()),
+        total_bytes_(0),
+        throttled_micros_(0) {
+    assert(bytes_per_second > 0);
+  }
+
+  void Request(size_t bytes) override {
+    total_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+    uint64_t wait_micros = 0;
+    {
+      MutexLock l(&mutex_);
+      const double rate = static_cast<double>(bytes_per_second_);
+      const uint64_t now = env_->NowMicros();
+      if (now > last_refill_micros_) {
+        tokens_ += (now - last_refill_micros_) * rate / 1e6;
+        if (tokens_ > rate * kBurstSeconds) {
+          tokens_ = rate * kBurstSeconds;
+        }
+        last_refill_micros_ = now;
+      }
+      tokens_ -= static_cast<double>(bytes);
+      if (tokens_ < 0) {
+        wait_micros = static_cast<uint64_t>(-tokens_ * 1e6 / rate);
+        if (wait_micros < kMinWaitMicros) {
+          wait_micros = kMinWaitMicros;
+        }
+      }
+    }
+    if (wait_micros > 0) {
+      env_->SleepForMicroseconds(static_cast<int>(wait_micros));
+      throttled_micros_.fetch_add(wait_micros, std::memory_order_relaxed);
+    }
+  }
+
+  int64_t GetBytesPerSecond() const override {
+    MutexLock l(&mutex_);
+    return bytes_per_second_;
+  }
+
+  void SetBytesPerSecond(int64_t bytes_per_second) override {
+    assert(bytes_per_second > 0);
+    MutexLock l(&mutex_);
+    bytes_per_second_ = bytes_per_second;
+  }
+
+  uint64_t GetTotalBytes() const override {
+    return total_bytes_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t GetThrottledMicros() const override {
+    return throttled_micros_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  Env* const env_;
+  mutable port::Mutex mutex_;
+  int64_t bytes_per_second_ GUARDED_BY(mutex_);
+  double tokens_ GUARDED_BY(mutex_);  // Negative while requests owe bytes
+  uint64_t last_refill_micros_ GUARDED_BY(mutex_);
+  std::atomic<uint64_t> total_bytes_;
+  std::atomic<uint64_t> throttled_micros_;
+};
+
+}  // namespace
+
+RateLimiter* NewTokenBucketRateLimiter(int64_t bytes_per_second, Env* env) {
+  return new TokenBucketRateLimiter(bytes_per_second,
+                                    env != nullptr ? env : Env::Default());
+}
+
+}  // namespace leveldb
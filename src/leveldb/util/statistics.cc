@@ -0,0 +1,216 @@
+// Copyright (c) 2011 The LevelDB Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file. See the AUTHORS file for names of contributors.
+
+#include "leveldb/statistics.h"
+
+#include <cassert>
+#include <limits>
+
+namespace leveldb {
+
+namespace {
+
+const uint64_t kNoMin = std::numeric_limits<uint64_t>::max();
+
+int HighestBit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63 - __builtin_clzll(value);
+#else
+  int bit = 0;
+  while (value >>= 1) {
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+// Start of "bucket"; the inverse of Statistics::BucketFor().
+uint64_t BucketStart(int bucket) {
+  if (bucket < 4) {
+    return bucket;
+  }
+  const int shift = (bucket - 4) / 4;
+  const uint64_t sub = (bucket - 4) % 4;
+  return (4 + sub) << shift;
+}
+
+}  // namespace
+
+Statistics::Statistics() { Reset(); }
+
+Statistics::~Statistics() = default;
+
+int Statistics::BucketFor(uint64_t value) {
+  if (value < 4) {
+    return static_cast<int>(value);
+  }
+  const int shift = HighestBit(value) - 2;
+  return 4 + shift * 4 + static_cast<int>((value >> shift) & 3);
+}
+
+uint64_t Statistics::BucketLimit(int bucket) {
+  return bucket + 1 < kNumBuckets ? BucketStart(bucket + 1) : kNoMin;
+}
+
+void Statistics::Measure(Histogram histogram, uint64_t value) {
+  HistogramImpl& h = histograms_[histogram];
+  h.sum.fetch_add(value, std::memory_order_relaxed);
+  h.buckets[BucketFor(value)].fetch_add(1, std::memory_order_relaxed);
+
+  uint64_t current = h.min.load(std::memory_order_relaxed);
+  while (value < current &&
+         !h.min.compare_exchange_weak(current, value,
+                                      std::memory_order_relaxed)) {
+  }
+  current = h.max.load(std::memory_order_relaxed);
+  while (value > current &&
+         !h.max.compare_exchange_weak(current, value,
+                                      std::memory_order_relaxed)) {
+  }
+}
+
+void Statistics::RecordCompaction(int level, uint64_t micros,
+                                  uint64_t bytes_read,
+                                  uint64_t bytes_written) {
+  assert(level >= 0 && level < kNumLevels);
+  LevelImpl& l = levels_[level];
+  l.compactions.fetch_add(1, std::memory_order_relaxed);
+  l.micros.fetch_add(micros, std::memory_order_relaxed);
+  l.bytes_read.fetch_add(bytes_read, std::memory_order_relaxed);
+  l.bytes_written.fetch_add(bytes_written, std::memory_order_relaxed);
+}
+
+double Statistics::Percentile(const uint64_t* buckets, uint64_t count,
+                              uint64_t min, uint64_t max, double p) {
+  if (count == 0) {
+    return 0;
+  }
+  const double threshold = count * (p / 100.0);
+  double seen = 0;
+  for (int b = 0; b < kNumBuckets; b++) {
+    if (buckets[b] == 0) {
+      continue;
+    }
+    seen += buckets[b];
+    if (seen >= threshold) {
+      // Interpolate within the bucket, clamped to the values seen.
+      double left = static_cast<double>(BucketStart(b));
+      double right = static_cast<double>(BucketLimit(b));
+      if (left < min) left = static_cast<double>(min);
+      if (right > max) right = static_cast<double>(max);
+      if (right < left) right = left;
+      const double before = seen - buckets[b];
+      const double pos = (threshold - before) / buckets[b];
+      return left + (right - left) * pos;
+    }
+  }
+  return static_cast<double>(max);
+}
+
+Statistics::HistogramData Statistics::GetHistogram(Histogram histogram) const {
+  const HistogramImpl& h = histograms_[histogram];
+  uint64_t buckets[kNumBuckets];
+  uint64_t count = 0;
+  for (int b = 0; b < kNumBuckets; b++) {
+    buckets[b] = h.buckets[b].load(std::memory_order_relaxed);
+    count += buckets[b];
+  }
+
+  HistogramData data;
+  data.count = count;
+  data.sum = h.sum.load(std::memory_order_relaxed);
+  data.min = h.min.load(std::memory_order_relaxed);
+  data.max = h.max.load(std::memory_order_relaxed);
+  if (count == 0 || data.min == kNoMin) {
+    data.min = 0;
+  }
+  data.average = count == 0 ? 0 : static_cast<double>(data.sum) / count;
+  data.median = Percentile(buckets, count, data.min, data.max, 50);
+  data.p95 = Percentile(buckets, count, data.min, data.max, 95);
+  data.p99 = Percentile(buckets, count, data.min, data.max, 99);
+  return data;
+}
+
+Statistics::LevelStats Statistics::GetLevelStats(int level) const {
+  assert(level >= 0 && level < kNumLevels);
+  const LevelImpl& l = levels_[level];
+  LevelStats stats;
+  stats.compactions = l.compactions.load(std::memory_order_relaxed);
+  stats.micros = l.micros.load(std::memory_order_relaxed);
+  stats.bytes_read = l.bytes_read.load(std::memory_order_relaxed);
+  stats.bytes_written = l.bytes_written.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void Statistics::Reset() {
+  for (int t = 0; t < kNumTickers; t++) {
+    tickers_[t].store(0, std::memory_order_relaxed);
+  }
+  for (int i = 0; i < kNumHistograms; i++) {
+    HistogramImpl& h = histograms_[i];
+    h.sum.store(0, std::memory_order_relaxed);
+    h.min.store(kNoMin, std::memory_order_relaxed);
+    h.max.store(0, std::memory_order_relaxed);
+    for (int b = 0; b < kNumBuckets; b++) {
+      h.buckets[b].store(0, std::memory_order_relaxed);
+    }
+  }
+  for (int level = 0; level < kNumLevels; level++) {
+    LevelImpl& l = levels_[level];
+    l.compactions.store(0, std::memory_order_relaxed);
+    l.micros.store(0, std::memory_order_relaxed);
+    l.bytes_read.store(0, std::memory_order_relaxed);
+    l.bytes_written.store(0, std::memory_order_relaxed);
+  }
+}
+
+const char* Statistics::TickerName(Ticker ticker) {
+  switch (ticker) {
+    case kBlockCacheHits:
+      return "block_cache_hits";
+    case kBlockCacheMisses:
+      return "block_cache_misses";
+    case kTableCacheHits:
+      return "table_cache_hits";
+    case kTableCacheMisses:
+      return "table_cache_misses";
+    case kBlockBytesRead:
+      return "block_bytes_read";
+    case kBytesRead:
+      return "bytes_read";
+    case kBytesWritten:
+      return "bytes_written";
+    case kWriteStalls:
+      return "write_stalls";
+    case kWriteStallMicros:
+      return "write_stall_micros";
+    case kRateLimitedBytes:
+      return "rate_limited_bytes";
+    case kRateLimitMicros:
+      return "rate_limit_micros";
+    case kNumTickers:
+      break;
+  }
+  return "unknown";
+}
+
+const char* Statistics::HistogramName(Histogram histogram) {
+  switch (histogram) {
+    case kGetMicros:
+      return "get_micros";
+    case kPutMicros:
+      return "put_micros";
+    case kWriteMicros:
+      return "write_micros";
+    case kFlushMicros:
+      return "flush_micros";
+    case kCompactionMicros:
+      return "compaction_micros";
+    case kNumHistograms:
+      break;
+  }
+  return "unknown";
+}
+
+}  // namespace leveldb